@@ -0,0 +1,262 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace bdr
+{
+    // Fence-based recycling for objects that can only be reused once the GPU is done with them and that keep
+    // the memory of their largest use around (command allocators). Knows nothing about D3D12; see
+    // CommandAllocatorPool for how it's driven.
+    //
+    // Returned objects are parked in the bucket of the thread that originally acquired them, so a recording
+    // thread tends to get its own allocators back. Within a bucket any object whose fence has passed can be
+    // reused (not just the oldest), preferring the smallest one whose peak recorded size covers the request so
+    // heavy passes keep reusing the same heavy allocators. If the thread's bucket has nothing ready the other
+    // buckets are searched before giving up.
+    //
+    // The total number of live objects can be capped, and `trim` releases objects that have sat unused for a
+    // number of frames.
+    template <typename T>
+    class AllocatorRecyclerT
+    {
+    public:
+        static constexpr uint32_t THREAD_BUCKETS = 8u;
+        static constexpr uint32_t SIZE_CLASS_COUNT = 8u;
+        static constexpr uint64_t SMALLEST_SIZE_CLASS = 64ull * 1024ull;
+        static constexpr uint64_t INVALID_FENCE = UINT64_MAX;
+
+        // Size classes grow by 4x: < 64 KB, < 256 KB, < 1 MB, ...
+        static uint32_t getSizeClass(uint64_t bytes)
+        {
+            uint32_t sizeClass = 0;
+            for (bytes /= SMALLEST_SIZE_CLASS; bytes > 0 && sizeClass < SIZE_CLASS_COUNT - 1; bytes >>= 2) {
+                sizeClass++;
+            }
+            return sizeClass;
+        }
+
+        // 0 means no ceiling
+        void setMaxCount(const uint32_t maxCount)
+        {
+            m_maxCount.store(maxCount, std::memory_order_relaxed);
+        }
+
+        void setIdleFrameLimit(const uint32_t idleFrameLimit)
+        {
+            m_idleFrameLimit.store(idleFrameLimit, std::memory_order_relaxed);
+        }
+
+        // Returns a ready object for the calling thread, or nullptr if none of them has completed.
+        T* acquire(const uint64_t completedFenceValue, const uint64_t expectedSize = 0)
+        {
+            const uint32_t wantedClass = getSizeClass(expectedSize);
+            const uint32_t ownBucket = getThreadBucket();
+
+            for (uint32_t i = 0; i < THREAD_BUCKETS; i++) {
+                const uint32_t bucketIdx = (ownBucket + i) % THREAD_BUCKETS;
+                Entry entry;
+                if (takeReady(m_buckets[bucketIdx], completedFenceValue, wantedClass, entry)) {
+                    std::lock_guard<std::mutex> lockGuard{ m_outstandingMutex };
+                    m_outstanding[entry.pItem] = Outstanding{ entry.peakSize, ownBucket };
+                    return entry.pItem;
+                }
+            }
+            return nullptr;
+        }
+
+        // Call before creating a new object. Returns false at the ceiling, in which case the caller should
+        // wait for `getOldestPendingFence` and try to acquire again.
+        bool tryReserveNew()
+        {
+            const uint32_t maxCount = m_maxCount.load(std::memory_order_relaxed);
+            uint32_t count = m_count.load(std::memory_order_relaxed);
+            do {
+                if (maxCount != 0 && count >= maxCount) {
+                    return false;
+                }
+            } while (!m_count.compare_exchange_weak(count, count + 1, std::memory_order_relaxed));
+            return true;
+        }
+
+        // Registers an object created after a successful `tryReserveNew`
+        void addNew(T* pItem)
+        {
+            std::lock_guard<std::mutex> lockGuard{ m_outstandingMutex };
+            m_outstanding[pItem] = Outstanding{ 0, getThreadBucket() };
+        }
+
+        // `recordedSize` is an estimate of how much was recorded with it this time; 0 if unknown
+        void release(T* pItem, const uint64_t fenceValue, const uint64_t recordedSize = 0)
+        {
+            Outstanding outstanding;
+            {
+                std::lock_guard<std::mutex> lockGuard{ m_outstandingMutex };
+                auto it = m_outstanding.find(pItem);
+                assert(it != m_outstanding.end() && "Releasing an object this recycler didn't hand out");
+                outstanding = it->second;
+                m_outstanding.erase(it);
+            }
+
+            Entry entry;
+            entry.pItem = pItem;
+            entry.fenceValue = fenceValue;
+            entry.peakSize = recordedSize > outstanding.peakSize ? recordedSize : outstanding.peakSize;
+            entry.lastUsedFrame = m_frameIndex.load(std::memory_order_relaxed);
+
+            Bucket& bucket = m_buckets[outstanding.bucket];
+            std::lock_guard<std::mutex> lockGuard{ bucket.mutex };
+            bucket.entries.push_back(entry);
+        }
+
+        // Advances the frame counter and destroys ready objects that went unused for the idle frame limit.
+        // While over the ceiling (after lowering it) ready objects are destroyed regardless of age.
+        template <typename Destroy>
+        uint32_t trim(const uint64_t completedFenceValue, Destroy&& destroy)
+        {
+            const uint64_t frameIndex = m_frameIndex.fetch_add(1, std::memory_order_relaxed) + 1;
+            const uint32_t idleFrameLimit = m_idleFrameLimit.load(std::memory_order_relaxed);
+
+            uint32_t destroyed = 0;
+            for (Bucket& bucket : m_buckets) {
+                std::lock_guard<std::mutex> lockGuard{ bucket.mutex };
+                for (size_t i = 0; i < bucket.entries.size();) {
+                    const Entry& entry = bucket.entries[i];
+                    const bool isIdle = frameIndex - entry.lastUsedFrame >= idleFrameLimit;
+                    if (entry.fenceValue <= completedFenceValue && (isIdle || isOverCeiling())) {
+                        destroy(entry.pItem);
+                        m_count.fetch_sub(1, std::memory_order_relaxed);
+                        destroyed++;
+                        bucket.entries[i] = bucket.entries.back();
+                        bucket.entries.pop_back();
+                    }
+                    else {
+                        ++i;
+                    }
+                }
+            }
+            return destroyed;
+        }
+
+        // Destroys everything, in use or not. The GPU must be idle.
+        template <typename Destroy>
+        void clear(Destroy&& destroy)
+        {
+            for (Bucket& bucket : m_buckets) {
+                std::lock_guard<std::mutex> lockGuard{ bucket.mutex };
+                for (const Entry& entry : bucket.entries) {
+                    destroy(entry.pItem);
+                }
+                bucket.entries.clear();
+            }
+
+            std::lock_guard<std::mutex> lockGuard{ m_outstandingMutex };
+            for (const auto& outstanding : m_outstanding) {
+                destroy(outstanding.first);
+            }
+            m_outstanding.clear();
+            m_count.store(0, std::memory_order_relaxed);
+        }
+
+        // Oldest fence among returned objects that aren't ready yet; INVALID_FENCE if there are none
+        uint64_t getOldestPendingFence(const uint64_t completedFenceValue)
+        {
+            uint64_t oldest = INVALID_FENCE;
+            for (Bucket& bucket : m_buckets) {
+                std::lock_guard<std::mutex> lockGuard{ bucket.mutex };
+                for (const Entry& entry : bucket.entries) {
+                    if (entry.fenceValue > completedFenceValue && entry.fenceValue < oldest) {
+                        oldest = entry.fenceValue;
+                    }
+                }
+            }
+            return oldest;
+        }
+
+        inline uint32_t getCount() const
+        {
+            return m_count.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Entry
+        {
+            T* pItem = nullptr;
+            uint64_t fenceValue = 0;
+            uint64_t peakSize = 0;
+            uint64_t lastUsedFrame = 0;
+        };
+
+        struct Outstanding
+        {
+            uint64_t peakSize = 0;
+            uint32_t bucket = 0;
+        };
+
+        struct Bucket
+        {
+            std::mutex mutex;
+            std::vector<Entry> entries;
+        };
+
+        static uint32_t getThreadBucket()
+        {
+            static std::atomic<uint32_t> s_nextBucket{ 0 };
+            thread_local const uint32_t t_bucket = s_nextBucket.fetch_add(1, std::memory_order_relaxed) % THREAD_BUCKETS;
+            return t_bucket;
+        }
+
+        // Picks the smallest ready entry that covers `wantedClass`, or failing that the largest ready one
+        static bool takeReady(Bucket& bucket, const uint64_t completedFenceValue, const uint32_t wantedClass, Entry& out)
+        {
+            std::lock_guard<std::mutex> lockGuard{ bucket.mutex };
+
+            size_t best = SIZE_MAX;
+            uint32_t bestClass = 0;
+            for (size_t i = 0; i < bucket.entries.size(); i++) {
+                const Entry& entry = bucket.entries[i];
+                if (entry.fenceValue > completedFenceValue) {
+                    continue;
+                }
+                const uint32_t sizeClass = getSizeClass(entry.peakSize);
+                const bool isBetter = best == SIZE_MAX
+                    || (sizeClass >= wantedClass && (bestClass < wantedClass || sizeClass < bestClass))
+                    || (sizeClass < wantedClass && bestClass < wantedClass && sizeClass > bestClass);
+                if (isBetter) {
+                    best = i;
+                    bestClass = sizeClass;
+                    if (sizeClass == wantedClass) {
+                        break;
+                    }
+                }
+            }
+
+            if (best == SIZE_MAX) {
+                return false;
+            }
+            out = bucket.entries[best];
+            bucket.entries[best] = bucket.entries.back();
+            bucket.entries.pop_back();
+            return true;
+        }
+
+        inline bool isOverCeiling() const
+        {
+            const uint32_t maxCount = m_maxCount.load(std::memory_order_relaxed);
+            return maxCount != 0 && m_count.load(std::memory_order_relaxed) > maxCount;
+        }
+
+        Bucket m_buckets[THREAD_BUCKETS];
+
+        std::mutex m_outstandingMutex;
+        std::unordered_map<T*, Outstanding> m_outstanding;
+
+        std::atomic<uint32_t> m_count{ 0 };
+        std::atomic<uint32_t> m_maxCount{ 0 };
+        std::atomic<uint32_t> m_idleFrameLimit{ 120 };
+        std::atomic<uint64_t> m_frameIndex{ 0 };
+    };
+}
@@ -0,0 +1,233 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace bdr
+{
+    enum class BarrierSplit : uint8_t
+    {
+        None,
+        Begin,
+        End,
+    };
+
+    template <typename Resource>
+    struct PlannedBarrier
+    {
+        Resource resource;
+        // ALL_SUBRESOURCES or a single subresource
+        uint32_t subresource;
+        uint32_t stateBefore;
+        uint32_t stateAfter;
+        BarrierSplit split;
+    };
+
+    // Works out the transitions for a frame from the states each pass needs, instead of every pass issuing its
+    // own. A frame is a sequence of passes (in practice one per command list, in submission order). Each pass
+    // declares the state it needs every resource it touches in, `plan` walks the passes in order and produces
+    // one batch of barriers per pass to record before its work, so every pass costs a single ResourceBarrier
+    // call at most.
+    //
+    // - Uses that the current state already satisfies don't get a barrier. That covers repeated uses in the same
+    //   state and read states the resource is already in as part of a combined read state.
+    // - Read states needed by the same pass are merged into one combined state.
+    // - When passes that don't touch the resource sit between its previous use and the one that needs the new
+    //   state, the transition is split: it begins right after the previous use and ends right before the new
+    //   one, so the GPU can do it while those passes run.
+    // - Subresources are tracked individually once they diverge; whole-resource uses of a resource whose
+    //   subresources all agree get a single ALL_SUBRESOURCES barrier.
+    //
+    // States are bitmasks (D3D12_RESOURCE_STATES values in practice, with 0 as COMMON/PRESENT). Which bits are
+    // read-only is passed in, so none of this depends on D3D12; see makeBarrierPlanner in GPUResource.h.
+    template <typename Resource>
+    class BarrierPlannerT
+    {
+    public:
+        using Barrier = PlannedBarrier<Resource>;
+
+        static constexpr uint32_t ALL_SUBRESOURCES = UINT32_MAX;
+
+        explicit BarrierPlannerT(const uint32_t readOnlyStates) :
+            m_readOnlyStates{ readOnlyStates }
+        { }
+
+        // Starts a new frame. Registered resources are forgotten, so register them again with their current state.
+        void reset(const uint32_t passCount)
+        {
+            m_resources.clear();
+            m_resourceIndices.clear();
+            m_uses.clear();
+            m_passBarriers.resize(passCount);
+            for (std::vector<Barrier>& barriers : m_passBarriers) {
+                barriers.clear();
+            }
+            m_isPlanned = false;
+        }
+
+        // The state the resource is in at the start of the frame, e.g. GPUResource::usageState
+        void registerResource(const Resource resource, const uint32_t state, const uint32_t subresourceCount = 1)
+        {
+            assert(subresourceCount > 0);
+            assert(m_resourceIndices.find(resource) == m_resourceIndices.end());
+            m_resourceIndices.emplace(resource, uint32_t(m_resources.size()));
+            m_resources.push_back(TrackedResource{ resource, std::vector<uint32_t>(subresourceCount, state), std::vector<uint32_t>(subresourceCount, NO_PASS) });
+        }
+
+        // Declares that `pass` needs the resource in `state`. Uses can be added in any order; within a pass they
+        // may only disagree if they're all read states.
+        void use(const uint32_t pass, const Resource resource, const uint32_t state, const uint32_t subresource = ALL_SUBRESOURCES)
+        {
+            assert(pass < m_passBarriers.size());
+            assert(m_resourceIndices.find(resource) != m_resourceIndices.end());
+            m_uses.push_back(Use{ pass, m_resourceIndices[resource], subresource, state });
+            m_isPlanned = false;
+        }
+
+        void plan()
+        {
+            // Pass order, and within a pass group same resource uses together so read states can be merged
+            std::sort(m_uses.begin(), m_uses.end(), [](const Use& lhs, const Use& rhs) {
+                if (lhs.pass != rhs.pass) {
+                    return lhs.pass < rhs.pass;
+                }
+                return lhs.resourceIdx != rhs.resourceIdx ? lhs.resourceIdx < rhs.resourceIdx : lhs.subresource < rhs.subresource;
+            });
+
+            for (size_t i = 0; i < m_uses.size();) {
+                Use merged = m_uses[i++];
+                while (i < m_uses.size()
+                    && m_uses[i].pass == merged.pass
+                    && m_uses[i].resourceIdx == merged.resourceIdx
+                    && m_uses[i].subresource == merged.subresource) {
+                    assert(merged.state == m_uses[i].state || (isReadOnly(merged.state) && isReadOnly(m_uses[i].state)));
+                    merged.state |= m_uses[i].state;
+                    i++;
+                }
+                applyUse(merged);
+            }
+            m_isPlanned = true;
+        }
+
+        // Barriers to record before `pass`, in the order they should be recorded
+        inline const std::vector<Barrier>& getBarriers(const uint32_t pass) const
+        {
+            assert(m_isPlanned);
+            return m_passBarriers[pass];
+        }
+
+        // State after the last pass, to carry into the next frame
+        inline uint32_t getFinalState(const Resource resource, const uint32_t subresource = 0) const
+        {
+            assert(m_isPlanned);
+            return m_resources[m_resourceIndices.at(resource)].states[subresource];
+        }
+
+        inline size_t getBarrierCount() const
+        {
+            size_t count = 0;
+            for (const std::vector<Barrier>& barriers : m_passBarriers) {
+                count += barriers.size();
+            }
+            return count;
+        }
+
+    private:
+        static constexpr uint32_t NO_PASS = UINT32_MAX;
+
+        struct TrackedResource
+        {
+            Resource resource;
+            std::vector<uint32_t> states;
+            // Last pass each subresource was used in this frame
+            std::vector<uint32_t> lastUsePasses;
+        };
+
+        struct Use
+        {
+            uint32_t pass;
+            uint32_t resourceIdx;
+            uint32_t subresource;
+            uint32_t state;
+        };
+
+        inline bool isReadOnly(const uint32_t state) const
+        {
+            return state != 0 && (state & ~m_readOnlyStates) == 0;
+        }
+
+        inline bool isSatisfied(const uint32_t currentState, const uint32_t state) const
+        {
+            return currentState == state || (isReadOnly(currentState) && isReadOnly(state) && (currentState & state) == state);
+        }
+
+        void applyUse(const Use& use)
+        {
+            TrackedResource& tracked = m_resources[use.resourceIdx];
+            const uint32_t subresourceCount = uint32_t(tracked.states.size());
+
+            if (use.subresource != ALL_SUBRESOURCES) {
+                assert(use.subresource < subresourceCount);
+                transition(tracked, use.pass, use.subresource, use.subresource, use.state);
+                return;
+            }
+
+            const bool isUniform = std::all_of(tracked.states.begin(), tracked.states.end(), [&](const uint32_t state) {
+                return state == tracked.states[0];
+            });
+            if (isUniform || subresourceCount == 1) {
+                transition(tracked, use.pass, ALL_SUBRESOURCES, 0, use.state);
+                return;
+            }
+            for (uint32_t subresource = 0; subresource < subresourceCount; subresource++) {
+                transition(tracked, use.pass, subresource, subresource, use.state);
+            }
+        }
+
+        // `firstSubresource` is the one whose state stands for the barrier; for ALL_SUBRESOURCES they all agree
+        void transition(TrackedResource& tracked, const uint32_t pass, const uint32_t subresource, const uint32_t firstSubresource, const uint32_t state)
+        {
+            const bool isAll = subresource == ALL_SUBRESOURCES;
+            const uint32_t currentState = tracked.states[firstSubresource];
+            uint32_t lastUsePass = tracked.lastUsePasses[firstSubresource];
+            if (isAll) {
+                for (const uint32_t subresourceLastUse : tracked.lastUsePasses) {
+                    if (lastUsePass == NO_PASS || (subresourceLastUse != NO_PASS && subresourceLastUse > lastUsePass)) {
+                        lastUsePass = subresourceLastUse;
+                    }
+                }
+            }
+
+            if (!isSatisfied(currentState, state)) {
+                // Anything not used yet this frame can start transitioning from the first pass
+                const uint32_t beginPass = lastUsePass == NO_PASS ? 0 : lastUsePass + 1;
+                if (beginPass < pass) {
+                    m_passBarriers[beginPass].push_back(Barrier{ tracked.resource, subresource, currentState, state, BarrierSplit::Begin });
+                    m_passBarriers[pass].push_back(Barrier{ tracked.resource, subresource, currentState, state, BarrierSplit::End });
+                }
+                else {
+                    m_passBarriers[pass].push_back(Barrier{ tracked.resource, subresource, currentState, state, BarrierSplit::None });
+                }
+            }
+
+            const uint32_t newState = isSatisfied(currentState, state) ? currentState : state;
+            if (isAll) {
+                std::fill(tracked.states.begin(), tracked.states.end(), newState);
+                std::fill(tracked.lastUsePasses.begin(), tracked.lastUsePasses.end(), pass);
+            }
+            else {
+                tracked.states[subresource] = newState;
+                tracked.lastUsePasses[subresource] = pass;
+            }
+        }
+
+        uint32_t m_readOnlyStates;
+        std::vector<TrackedResource> m_resources;
+        std::unordered_map<Resource, uint32_t> m_resourceIndices;
+        std::vector<Use> m_uses;
+        std::vector<std::vector<Barrier>> m_passBarriers;
+        bool m_isPlanned = false;
+    };
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace bdr
+{
+    // Buffer copies waiting to be recorded, coalesced as they're added. Uploads into neighbouring ranges of the
+    // same resource usually come from neighbouring staging space too, so a copy that carries on exactly where
+    // the previous one stopped, on both sides, extends it.
+    //
+    // A gap can be copied along as well, but only when the destination bytes in it can be overwritten: the
+    // previous copy has to fill its buffer to the end (`ownsTrailingPadding`), so the gap is that buffer's
+    // padding up to the next `paddingAlignment` boundary, and the staging side has to be padded identically.
+    // Partial updates never own their trailing bytes, which hold data the GPU already has.
+    template <typename Resource>
+    class BufferCopyListT
+    {
+    public:
+        struct Copy
+        {
+            Resource* pDest;
+            uint64_t destOffset;
+            uint64_t srcOffset;
+            uint64_t size;
+            bool ownsTrailingPadding;
+        };
+
+        explicit BufferCopyListT(const uint64_t paddingAlignment) :
+            m_paddingAlignment{ paddingAlignment }
+        { }
+
+        void add(Resource* pDest, const uint64_t destOffset, const uint64_t srcOffset, const uint64_t size, const bool ownsTrailingPadding)
+        {
+            if (!m_copies.empty()) {
+                Copy& last = m_copies.back();
+                const uint64_t lastDestEnd = last.destOffset + last.size;
+                const uint64_t lastSrcEnd = last.srcOffset + last.size;
+
+                if (last.pDest == pDest
+                    && destOffset >= lastDestEnd && srcOffset >= lastSrcEnd
+                    && destOffset - lastDestEnd == srcOffset - lastSrcEnd
+                    && (destOffset == lastDestEnd || (last.ownsTrailingPadding && destOffset - lastDestEnd < m_paddingAlignment))) {
+                    last.size = destOffset + size - last.destOffset;
+                    last.ownsTrailingPadding = ownsTrailingPadding;
+                    return;
+                }
+            }
+
+            m_copies.push_back(Copy{ pDest, destOffset, srcOffset, size, ownsTrailingPadding });
+        }
+
+        inline void clear()
+        {
+            m_copies.clear();
+        }
+
+        inline bool empty() const
+        {
+            return m_copies.empty();
+        }
+
+        inline size_t size() const
+        {
+            return m_copies.size();
+        }
+
+        inline typename std::vector<Copy>::const_iterator begin() const
+        {
+            return m_copies.begin();
+        }
+
+        inline typename std::vector<Copy>::const_iterator end() const
+        {
+            return m_copies.end();
+        }
+
+    private:
+        uint64_t m_paddingAlignment;
+        std::vector<Copy> m_copies;
+    };
+}
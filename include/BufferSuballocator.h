@@ -0,0 +1,138 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "TLSFAllocator.h"
+
+namespace bdr
+{
+    // Hands out ranges from a growable list of equally sized heaps, each managed by a TLSFAllocator. The
+    // bookkeeping knows nothing about D3D12: whoever owns it creates the backing memory for a heap when
+    // `allocate` reports that a new one was added (see GPUBufferManager), so it can be driven entirely on the
+    // CPU against a simulated heap.
+    class BufferSuballocator
+    {
+    public:
+        static constexpr uint64_t DEFAULT_HEAP_SIZE = 64ull * 1024ull * 1024ull;
+        static constexpr uint64_t DEFAULT_GRANULARITY = 256ull;
+        static constexpr uint32_t INVALID_HEAP = UINT32_MAX;
+
+        struct Allocation
+        {
+            uint32_t heapIndex = INVALID_HEAP;
+            TLSFAllocator::Allocation range;
+
+            inline bool isValid() const
+            {
+                return heapIndex != INVALID_HEAP;
+            }
+        };
+
+        struct Stats
+        {
+            uint32_t heapCount = 0;
+            uint32_t allocationCount = 0;
+            uint32_t freeBlockCount = 0;
+            uint64_t totalSize = 0;
+            uint64_t usedSize = 0;
+            uint64_t freeSize = 0;
+            uint64_t largestFreeBlock = 0;
+
+            // Across all heaps: 0 when each heap's free space is one block, approaching 1 as it scatters
+            inline float getFragmentation() const
+            {
+                return freeSize == 0 ? 0.0f : 1.0f - float(largestFreeBlock) / float(freeSize);
+            }
+
+            // Space lost to rounding allocations up to the granularity is counted as used
+            inline float getUtilization() const
+            {
+                return totalSize == 0 ? 0.0f : float(usedSize) / float(totalSize);
+            }
+        };
+
+        BufferSuballocator(const uint64_t heapSize = DEFAULT_HEAP_SIZE, const uint64_t granularity = DEFAULT_GRANULARITY) :
+            m_heapSize{ heapSize },
+            m_granularity{ granularity }
+        { }
+
+        // Tries the existing heaps first, in creation order. If none of them has room a new heap is added and
+        // `*pCreatedHeap` is set so the caller can create its backing memory (`getHeapSize(heapIndex)` bytes).
+        // Requests larger than the heap size get a dedicated heap of their own.
+        Allocation allocate(const uint64_t size, const uint64_t alignment = 0, bool* pCreatedHeap = nullptr)
+        {
+            if (pCreatedHeap != nullptr) {
+                *pCreatedHeap = false;
+            }
+
+            Allocation allocation;
+            for (uint32_t i = 0; i < m_heaps.size(); i++) {
+                allocation.range = m_heaps[i].allocate(size, alignment);
+                if (allocation.range.isValid()) {
+                    allocation.heapIndex = i;
+                    return allocation;
+                }
+            }
+
+            const uint64_t alignedSize = size + (alignment > m_granularity ? alignment : 0);
+            const uint64_t heapSize = alignedSize > m_heapSize
+                ? ((alignedSize + m_heapSize - 1) / m_heapSize) * m_heapSize
+                : m_heapSize;
+            m_heaps.emplace_back(heapSize, m_granularity);
+
+            allocation.heapIndex = uint32_t(m_heaps.size() - 1);
+            allocation.range = m_heaps.back().allocate(size, alignment);
+            assert(allocation.range.isValid());
+
+            if (pCreatedHeap != nullptr) {
+                *pCreatedHeap = true;
+            }
+            return allocation;
+        }
+
+        void free(const Allocation& allocation)
+        {
+            assert(allocation.isValid() && allocation.heapIndex < m_heaps.size());
+            m_heaps[allocation.heapIndex].free(allocation.range);
+        }
+
+        Stats getStats() const
+        {
+            Stats stats;
+            stats.heapCount = uint32_t(m_heaps.size());
+            for (const TLSFAllocator& heap : m_heaps) {
+                const TLSFAllocator::Stats heapStats = heap.getStats();
+                stats.allocationCount += heapStats.allocationCount;
+                stats.freeBlockCount += heapStats.freeBlockCount;
+                stats.totalSize += heapStats.totalSize;
+                stats.usedSize += heapStats.usedSize;
+                stats.freeSize += heapStats.freeSize;
+                if (heapStats.largestFreeBlock > stats.largestFreeBlock) {
+                    stats.largestFreeBlock = heapStats.largestFreeBlock;
+                }
+            }
+            return stats;
+        }
+
+        inline uint32_t getHeapCount() const
+        {
+            return uint32_t(m_heaps.size());
+        }
+
+        inline uint64_t getHeapSize(const uint32_t heapIndex) const
+        {
+            return m_heaps[heapIndex].getSize();
+        }
+
+        void reset()
+        {
+            m_heaps.clear();
+        }
+
+    private:
+        uint64_t m_heapSize;
+        uint64_t m_granularity;
+        std::vector<TLSFAllocator> m_heaps;
+    };
+}
@@ -1,21 +1,30 @@
 #pragma once
 #include <stdafx.h>
-#include <vector>
-#include <queue>
-#include <mutex>
+#include <atomic>
 
 #include "dx_helpers.h"
+#include "AllocatorRecycler.h"
+#include "MemoryStats.h"
 
 namespace bdr
 {
-    // Based off the miniEngine example
+    // Based off the miniEngine example. Recycling (per thread buckets, size matching, ceiling and trimming)
+    // is done by AllocatorRecyclerT.
     class CommandAllocatorPool
     {
     public:
+        static constexpr uint32_t DEFAULT_MAX_ALLOCATORS = 256u;
+        static constexpr uint32_t DEFAULT_IDLE_FRAME_LIMIT = 120u;
+
         CommandAllocatorPool(const D3D12_COMMAND_LIST_TYPE commandListType) :
             m_listType{ commandListType },
-            m_pDevice{ nullptr }
-        { }
+            m_pDevice{ nullptr },
+            m_pStats{ nullptr },
+            m_createdCount{ 0 }
+        {
+            m_recycler.setMaxCount(DEFAULT_MAX_ALLOCATORS);
+            m_recycler.setIdleFrameLimit(DEFAULT_IDLE_FRAME_LIMIT);
+        }
 
         ~CommandAllocatorPool()
         {
@@ -26,62 +35,94 @@ namespace bdr
         {
             m_pDevice = pDevice;
 
+            // The driver doesn't tell us how big an allocator is, so only the counts are tracked
+            const char* name = "CommandAllocators/Direct";
+            if (m_listType == D3D12_COMMAND_LIST_TYPE_COMPUTE) {
+                name = "CommandAllocators/Compute";
+            }
+            else if (m_listType == D3D12_COMMAND_LIST_TYPE_COPY) {
+                name = "CommandAllocators/Copy";
+            }
+            m_pStats = MemoryStatsRegistry::get().getCategory(name);
         }
+
         void shutdown()
         {
-            for (size_t i = 0; i < m_allocatorPool.size(); i++) {
-                m_allocatorPool[i]->Release();
-            }
-            m_allocatorPool.clear();
+            m_recycler.clear([this](ID3D12CommandAllocator* pAllocator) {
+                releaseAllocator(pAllocator);
+            });
         }
 
-        ID3D12CommandAllocator* requestAllocator(uint64_t completedFenceValue)
+        // Returns nullptr if no allocator has completed and the pool is at its ceiling; wait for
+        // `getOldestPendingFence` and try again. `expectedSize` is a rough estimate of how much will be
+        // recorded, used to hand out an allocator that has already grown to that size.
+        ID3D12CommandAllocator* requestAllocator(const uint64_t completedFenceValue, const uint64_t expectedSize = 0)
         {
-            std::lock_guard<std::mutex> lockGuard{ m_allocatorMutex };
-
-            ID3D12CommandAllocator* pAllocator = nullptr;
-            
-            if (!m_readyAllocators.empty()) {
-                auto& allocatorPair = m_readyAllocators.front();
-
-                if (allocatorPair.first <= completedFenceValue) {
-                    pAllocator = allocatorPair.second;
-                    ThrowIfFailed(pAllocator->Reset());
-                    m_readyAllocators.pop();
-                }
+            ID3D12CommandAllocator* pAllocator = m_recycler.acquire(completedFenceValue, expectedSize);
+            if (pAllocator != nullptr) {
+                ThrowIfFailed(pAllocator->Reset());
+                return pAllocator;
             }
-            
-            if (pAllocator == nullptr) {
-                ThrowIfFailed(m_pDevice->CreateCommandAllocator(m_listType, IID_PPV_ARGS(&pAllocator)));
-                wchar_t name[32];
-                swprintf(name, 32, L"CommandAllocator %zu", m_allocatorPool.size());
-                pAllocator->SetName(name);
-                m_allocatorPool.push_back(pAllocator);
+
+            if (!m_recycler.tryReserveNew()) {
+                return nullptr;
             }
 
+            ThrowIfFailed(m_pDevice->CreateCommandAllocator(m_listType, IID_PPV_ARGS(&pAllocator)));
+            wchar_t name[32];
+            swprintf(name, 32, L"CommandAllocator %u", m_createdCount.fetch_add(1, std::memory_order_relaxed));
+            pAllocator->SetName(name);
+            m_pStats->onAllocate(0);
+
+            m_recycler.addNew(pAllocator);
             return pAllocator;
         };
 
-        void returnAllocator(const uint64_t fenceValue, ID3D12CommandAllocator* allocator)
+        // `recordedSize` is an estimate of what was recorded with the allocator this time, 0 if unknown
+        void returnAllocator(const uint64_t fenceValue, ID3D12CommandAllocator* allocator, const uint64_t recordedSize = 0)
+        {
+            m_recycler.release(allocator, fenceValue, recordedSize);
+        }
+
+        // Call once per frame. Releases allocators that have been idle for the idle frame limit.
+        void trim(const uint64_t completedFenceValue)
+        {
+            m_recycler.trim(completedFenceValue, [this](ID3D12CommandAllocator* pAllocator) {
+                releaseAllocator(pAllocator);
+            });
+        }
+
+        inline uint64_t getOldestPendingFence(const uint64_t completedFenceValue)
         {
-            std::lock_guard<std::mutex> lockGuard{ m_allocatorMutex };
+            return m_recycler.getOldestPendingFence(completedFenceValue);
+        }
 
-            m_readyAllocators.push(std::make_pair(fenceValue, allocator));
+        // 0 removes the ceiling
+        inline void setLimits(const uint32_t maxAllocators, const uint32_t idleFrameLimit)
+        {
+            m_recycler.setMaxCount(maxAllocators);
+            m_recycler.setIdleFrameLimit(idleFrameLimit);
         }
 
         inline size_t size() const
         {
-            return m_allocatorPool.size();
+            return m_recycler.getCount();
         }
 
 
     private:
+        void releaseAllocator(ID3D12CommandAllocator* pAllocator)
+        {
+            pAllocator->Release();
+            m_pStats->onFree(0);
+        }
+
         const D3D12_COMMAND_LIST_TYPE m_listType;
 
         ID3D12Device* m_pDevice;
-        std::vector<ID3D12CommandAllocator*> m_allocatorPool;
-        std::queue<std::pair<uint64_t, ID3D12CommandAllocator*>> m_readyAllocators;
-        std::mutex m_allocatorMutex;
+        AllocatorRecyclerT<ID3D12CommandAllocator> m_recycler;
+        MemoryStatsRegistry::Category* m_pStats;
+        std::atomic<uint32_t> m_createdCount;
     };
 
-}
\ No newline at end of file
+}
@@ -1,9 +1,26 @@
 #pragma once
+#include <atomic>
 #include <mutex>
 #include "dx_helpers.h"
 #include "CommandAllocatorPool.h"
+#include "DeferredReleaseQueue.h"
+#include "FenceValues.h"
+#include "FenceCompletionCache.h"
+#include "FenceCompletionService.h"
+#include "QueueDependencySolver.h"
+#include "SubmissionBatch.h"
+#include "GPUResource.h"
 namespace bdr
 {
+    using CommandListBatch = SubmissionBatchT<ID3D12CommandList>;
+
+    struct SubmissionStats
+    {
+        uint64_t submits = 0;       // ExecuteCommandLists calls
+        uint64_t signals = 0;       // Fence signals
+        uint64_t commandLists = 0;  // Lists across all submits
+    };
+
     // Based off the MiniEngine Example
     // And Alex Tardif's Example: http://www.alextardif.com/D3D11To12P1.html
     class CommandQueue
@@ -29,6 +46,7 @@ namespace bdr
         {
             std::lock_guard<std::mutex> lockGuard(m_fenceMutex);
             m_pQueue->Signal(m_pFence, m_nextFenceValue);
+            m_signalCount.fetch_add(1, std::memory_order_relaxed);
             return m_nextFenceValue++;
         }
 
@@ -45,25 +63,42 @@ namespace bdr
         };
 
         uint64_t executeCommandList(ID3D12CommandList* commandList);
+        // One ExecuteCommandLists call and one fence signal for all of them, in order
+        uint64_t executeCommandLists(ID3D12CommandList* const* ppCommandLists, const uint32_t count);
+        // Flushes the batch through executeCommandLists and returns its fence. An empty batch submits nothing
+        // and returns the last value signalled on this queue.
+        uint64_t executeBatch(CommandListBatch& batch);
 
-        inline ID3D12CommandAllocator* requestAllocator()
+        // Counters for the previous frame, rolled over by `endFrame`
+        inline SubmissionStats getLastFrameStats() const
         {
-            uint64_t completedValue = m_pFence->GetCompletedValue();
-            return m_allocatorPool.requestAllocator(completedValue);
+            return m_lastFrameStats;
         }
+        void endFrame();
+
+        // CPU blocking if the allocator pool is at its ceiling and none of its allocators have completed
+        ID3D12CommandAllocator* requestAllocator(const uint64_t expectedSize = 0);
 
-        inline void returnAllocator(const uint64_t fenceValue, ID3D12CommandAllocator* allocator)
+        inline void returnAllocator(const uint64_t fenceValue, ID3D12CommandAllocator* allocator, const uint64_t recordedSize = 0)
         {
-            m_allocatorPool.returnAllocator(fenceValue, allocator);
+            m_allocatorPool.returnAllocator(fenceValue, allocator, recordedSize);
         }
 
+        inline CommandAllocatorPool& getAllocatorPool()
+        {
+            return m_allocatorPool;
+        }
+
+        // Safe to call from any thread
         inline uint64_t getNextFenceValue() {
+            std::lock_guard<std::mutex> lockGuard(m_fenceMutex);
             return m_nextFenceValue;
         }
         
-        inline uint64_t getCompletedFenceValue() const {
-            uint64_t completedValue = m_pFence->GetCompletedValue();
-            return m_lastCompletedValue > completedValue ? m_lastCompletedValue : completedValue;
+        // Safe to call from any thread. Polls the fence and updates the shared completion cache.
+        inline uint64_t getCompletedFenceValue()
+        {
+            return m_completedCache.refresh([this]() { return m_pFence->GetCompletedValue(); });
         }
         
         ID3D12CommandQueue* m_pQueue;
@@ -77,26 +112,103 @@ namespace bdr
         std::mutex m_eventMutex;
 
         uint64_t m_nextFenceValue;
-        uint64_t m_lastCompletedValue;
+        FenceCompletionCache m_completedCache;
         HANDLE m_fenceEventHandle;
+
+        std::atomic<uint64_t> m_submitCount;
+        std::atomic<uint64_t> m_signalCount;
+        std::atomic<uint64_t> m_commandListCount;
+        SubmissionStats m_lastFrameStats;
     };
 
+    class CommandQueueManager;
+
+    // Lets FenceCompletionServiceT wait on the manager's queues. A single auto-reset event is armed on the fence
+    // of every queue with a target, so whichever completes first (or `wake`) ends the wait. Only called from the
+    // service's waiter thread.
+    class D3D12FenceWaiter
+    {
+    public:
+        explicit D3D12FenceWaiter(CommandQueueManager* pQueueManager);
+        ~D3D12FenceWaiter();
+
+        uint64_t getCompletedFenceValue(const uint32_t timeline);
+        void waitForAny(const uint64_t* targets);
+        void wake();
+
+    private:
+        CommandQueueManager* m_pQueueManager;
+        HANDLE m_eventHandle;
+        // Last value SetEventOnCompletion was called with per queue, so waits with the same target don't pile
+        // up registrations on the fence
+        uint64_t m_armedTargets[MAX_FENCE_TIMELINES];
+    };
+
+    using FenceCompletionService = FenceCompletionServiceT<D3D12FenceWaiter>;
+
     class CommandQueueManager
     {
     public:
         CommandQueueManager();
+        ~CommandQueueManager();
         
         void init(ID3D12Device* pDevice);
         void createNewCommandList(
             D3D12_COMMAND_LIST_TYPE type,
             ID3D12GraphicsCommandList** list,
             ID3D12CommandAllocator** allocator);
+
+        CommandQueue& getQueue(D3D12_COMMAND_LIST_TYPE type);
+
+        // Fence values carry their queue type in the upper bits, so this works for a fence from any queue
+        bool isFenceComplete(const uint64_t fenceValue);
+
+        // Submits on the queue of `type` after making it wait on `dependencies` (fence values from any queue).
+        // Only the waits that aren't already implied are inserted; see QueueDependencySolver. Returns the
+        // submission's fence, which later work can depend on in turn.
+        uint64_t submit(
+            const D3D12_COMMAND_LIST_TYPE type,
+            ID3D12CommandList* const* ppCommandLists,
+            const uint32_t count,
+            const uint64_t* dependencies = nullptr,
+            const uint32_t dependencyCount = 0);
+        // Same for a whole batch. An empty batch submits nothing and returns the last value signalled on the queue.
+        uint64_t submitBatch(
+            const D3D12_COMMAND_LIST_TYPE type,
+            CommandListBatch& batch,
+            const uint64_t* dependencies = nullptr,
+            const uint32_t dependencyCount = 0);
+
         void waitForIdle()
         {
             m_graphicsQueue.waitForIdle();
             m_computeQueue.waitForIdle();
             m_copyQueue.waitForIdle();
         }
+
+        void endFrame()
+        {
+            releaseCompletedResources();
+            m_graphicsQueue.endFrame();
+            m_computeQueue.endFrame();
+            m_copyQueue.endFrame();
+
+            m_dependencySolver.prune(m_graphicsQueue.getCompletedFenceValue());
+            m_dependencySolver.prune(m_computeQueue.getCompletedFenceValue());
+            m_dependencySolver.prune(m_copyQueue.getCompletedFenceValue());
+        }
+
+        // Takes ownership of the resource and releases it once `fenceValue` has passed, instead of straight
+        // away. `resource` is left empty.
+        void deferRelease(GPUResource& resource, const uint64_t fenceValue);
+        // Releases every deferred resource whose fence has passed. Called by endFrame.
+        void releaseCompletedResources();
+
+        // For acting on a fence from any of the queues without blocking; see FenceCompletionServiceT
+        inline FenceCompletionService& getCompletionService()
+        {
+            return m_completionService;
+        }
         
         CommandQueue m_graphicsQueue;
         CommandQueue m_computeQueue;
@@ -105,6 +217,16 @@ namespace bdr
     private:
         ID3D12Device* m_pDevice;
 
+        // Declared after the queues so the waiter thread is stopped before they go away
+        D3D12FenceWaiter m_fenceWaiter;
+        FenceCompletionService m_completionService;
+
+        DeferredReleaseQueueT<ID3D12Resource*> m_deferredReleases;
+
+        // Held from resolving a submission's waits until it's been recorded, so the solver sees each queue's
+        // submissions in fence order
+        std::mutex m_submitMutex;
+        QueueDependencySolver m_dependencySolver;
     };
 }
 
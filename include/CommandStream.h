@@ -0,0 +1,283 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace bdr
+{
+    // 64 bit keys that commands are sorted by, most significant first:
+    //   | pass (8) | pipeline (12) | material (20) | depth (24) |
+    // so a pass is drawn as a unit, pipeline changes are minimised within it, then material changes, and draws
+    // sharing all three go front to back (or back to front for blending).
+    namespace SortKey
+    {
+        constexpr uint32_t PASS_BITS = 8u;
+        constexpr uint32_t PIPELINE_BITS = 12u;
+        constexpr uint32_t MATERIAL_BITS = 20u;
+        constexpr uint32_t DEPTH_BITS = 24u;
+
+        constexpr uint32_t DEPTH_SHIFT = 0u;
+        constexpr uint32_t MATERIAL_SHIFT = DEPTH_SHIFT + DEPTH_BITS;
+        constexpr uint32_t PIPELINE_SHIFT = MATERIAL_SHIFT + MATERIAL_BITS;
+        constexpr uint32_t PASS_SHIFT = PIPELINE_SHIFT + PIPELINE_BITS;
+        static_assert(PASS_SHIFT + PASS_BITS == 64u, "Sort key fields must fill 64 bits");
+
+        // `depth` is normalised view depth, clamped to [0, 1]
+        inline uint64_t make(const uint32_t pass, const uint32_t pipeline, const uint32_t material, const float depth, const bool isBackToFront = false)
+        {
+            assert(pass < (1u << PASS_BITS) && pipeline < (1u << PIPELINE_BITS) && material < (1u << MATERIAL_BITS));
+            constexpr uint32_t maxDepth = (1u << DEPTH_BITS) - 1u;
+            const float clampedDepth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+            uint32_t quantizedDepth = uint32_t(clampedDepth * float(maxDepth));
+            if (isBackToFront) {
+                quantizedDepth = maxDepth - quantizedDepth;
+            }
+            return (uint64_t(pass) << PASS_SHIFT)
+                | (uint64_t(pipeline) << PIPELINE_SHIFT)
+                | (uint64_t(material) << MATERIAL_SHIFT)
+                | (uint64_t(quantizedDepth) << DEPTH_SHIFT);
+        }
+
+        inline uint32_t getPass(const uint64_t key)
+        {
+            return uint32_t(key >> PASS_SHIFT);
+        }
+
+        inline uint32_t getPipeline(const uint64_t key)
+        {
+            return uint32_t(key >> PIPELINE_SHIFT) & ((1u << PIPELINE_BITS) - 1u);
+        }
+    }
+
+    // Packets refer to pipelines, meshes etc. by index into tables the backend owns, so recording needs no
+    // device. Every packet is a multiple of 8 bytes and starts with its type.
+    enum class PacketType : uint32_t
+    {
+        SetPipeline,
+        SetMesh,
+        SetConstants,
+        DrawIndexed,
+    };
+
+    struct SetPipelinePacket
+    {
+        static constexpr PacketType TYPE = PacketType::SetPipeline;
+        PacketType type = TYPE;
+        uint32_t pipelineId;
+    };
+
+    struct SetMeshPacket
+    {
+        static constexpr PacketType TYPE = PacketType::SetMesh;
+        PacketType type = TYPE;
+        uint32_t meshId;
+    };
+
+    // Root constant buffer for the draws that follow
+    struct SetConstantsPacket
+    {
+        static constexpr PacketType TYPE = PacketType::SetConstants;
+        PacketType type = TYPE;
+        uint32_t padding = 0;
+        uint64_t gpuAddress;
+    };
+
+    struct DrawIndexedPacket
+    {
+        static constexpr PacketType TYPE = PacketType::DrawIndexed;
+        PacketType type = TYPE;
+        uint32_t indexCount;
+        uint32_t startIndex = 0;
+        int32_t baseVertex = 0;
+        uint32_t instanceCount = 1;
+        uint32_t padding = 0;
+    };
+
+    // A linear buffer of commands, each a short run of state packets ending in a draw, with a sort key per
+    // command. Commands are recorded in any order, radix sorted by key, then walked in key order by a backend
+    // translator that skips state which is already set. Commands with equal keys keep their recording order.
+    //
+    // Not thread safe while recording; record into one stream per thread or guard it. Sorting and reading the
+    // sorted commands from several threads at once (e.g. a range per command list) is fine.
+    class CommandStream
+    {
+    public:
+        void reserve(const size_t commandCount, const size_t bytes)
+        {
+            m_commands.reserve(commandCount);
+            m_words.reserve(bytes / sizeof(uint64_t));
+        }
+
+        void clear()
+        {
+            m_commands.clear();
+            m_words.clear();
+            m_isRecording = false;
+            m_isSorted = true;
+        }
+
+        void beginCommand(const uint64_t sortKey)
+        {
+            assert(!m_isRecording);
+            m_isRecording = true;
+            m_isSorted = false;
+            m_commands.push_back(Command{ sortKey, uint32_t(m_words.size()), 0 });
+        }
+
+        template <typename Packet>
+        void push(const Packet& packet)
+        {
+            static_assert(sizeof(Packet) % sizeof(uint64_t) == 0, "Packets must be a multiple of 8 bytes");
+            assert(m_isRecording);
+            const size_t offset = m_words.size();
+            m_words.resize(offset + sizeof(Packet) / sizeof(uint64_t));
+            std::memcpy(&m_words[offset], &packet, sizeof(Packet));
+        }
+
+        void endCommand()
+        {
+            assert(m_isRecording);
+            Command& command = m_commands.back();
+            command.wordCount = uint32_t(m_words.size()) - command.wordOffset;
+            m_isRecording = false;
+        }
+
+        // LSD radix sort, 8 bits at a time. Passes where every key has the same digit are skipped, so streams
+        // that only use a few of the key fields sort in fewer passes.
+        void sort()
+        {
+            assert(!m_isRecording);
+            if (m_isSorted) {
+                return;
+            }
+            m_isSorted = true;
+
+            const size_t count = m_commands.size();
+            if (count < 2) {
+                return;
+            }
+
+            constexpr uint32_t RADIX_BITS = 8u;
+            constexpr uint32_t RADIX_SIZE = 1u << RADIX_BITS;
+            constexpr uint32_t PASS_COUNT = 64u / RADIX_BITS;
+
+            // All the histograms in one read of the keys
+            uint32_t histograms[PASS_COUNT][RADIX_SIZE] = {};
+            for (const Command& command : m_commands) {
+                for (uint32_t pass = 0; pass < PASS_COUNT; pass++) {
+                    histograms[pass][(command.sortKey >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1u)]++;
+                }
+            }
+
+            m_scratch.resize(count);
+            Command* pSrc = m_commands.data();
+            Command* pDst = m_scratch.data();
+            for (uint32_t pass = 0; pass < PASS_COUNT; pass++) {
+                uint32_t* histogram = histograms[pass];
+                const uint32_t shift = pass * RADIX_BITS;
+                if (histogram[(pSrc[0].sortKey >> shift) & (RADIX_SIZE - 1u)] == count) {
+                    continue;
+                }
+
+                uint32_t offset = 0;
+                for (uint32_t i = 0; i < RADIX_SIZE; i++) {
+                    const uint32_t digitCount = histogram[i];
+                    histogram[i] = offset;
+                    offset += digitCount;
+                }
+
+                for (size_t i = 0; i < count; i++) {
+                    const uint32_t digit = uint32_t(pSrc[i].sortKey >> shift) & (RADIX_SIZE - 1u);
+                    pDst[histogram[digit]++] = pSrc[i];
+                }
+                std::swap(pSrc, pDst);
+            }
+
+            if (pSrc != m_commands.data()) {
+                m_commands.swap(m_scratch);
+            }
+        }
+
+        // Calls `translator(const XPacket&)` for every packet of commands [first, first + count) in sorted
+        // order. Whatever state the translator tracks carries over from one command to the next.
+        template <typename Translator>
+        void translate(const uint32_t firstCommand, const uint32_t commandCount, Translator&& translator) const
+        {
+            assert(m_isSorted && firstCommand + commandCount <= m_commands.size());
+            const uint64_t* pWords = m_words.data();
+            for (uint32_t i = firstCommand; i < firstCommand + commandCount; i++) {
+                const Command& command = m_commands[i];
+                const uint64_t* pPacket = pWords + command.wordOffset;
+                const uint64_t* pEnd = pPacket + command.wordCount;
+                while (pPacket < pEnd) {
+                    switch (*reinterpret_cast<const PacketType*>(pPacket)) {
+                    case PacketType::SetPipeline:
+                        pPacket = dispatch<SetPipelinePacket>(pPacket, translator);
+                        break;
+                    case PacketType::SetMesh:
+                        pPacket = dispatch<SetMeshPacket>(pPacket, translator);
+                        break;
+                    case PacketType::SetConstants:
+                        pPacket = dispatch<SetConstantsPacket>(pPacket, translator);
+                        break;
+                    case PacketType::DrawIndexed:
+                        pPacket = dispatch<DrawIndexedPacket>(pPacket, translator);
+                        break;
+                    default:
+                        assert(false && "Unknown packet type");
+                        return;
+                    }
+                }
+            }
+        }
+
+        inline uint32_t getCommandCount() const
+        {
+            return uint32_t(m_commands.size());
+        }
+
+        inline uint64_t getSortKey(const uint32_t commandIdx) const
+        {
+            return m_commands[commandIdx].sortKey;
+        }
+
+        inline size_t getPacketBytes() const
+        {
+            return m_words.size() * sizeof(uint64_t);
+        }
+
+        // Packet bytes of commands [first, first + count) in sorted order, e.g. to size a command list
+        size_t getPacketBytes(const uint32_t firstCommand, const uint32_t commandCount) const
+        {
+            assert(m_isSorted && firstCommand + commandCount <= m_commands.size());
+            size_t wordCount = 0;
+            for (uint32_t i = firstCommand; i < firstCommand + commandCount; i++) {
+                wordCount += m_commands[i].wordCount;
+            }
+            return wordCount * sizeof(uint64_t);
+        }
+
+    private:
+        struct Command
+        {
+            uint64_t sortKey;
+            uint32_t wordOffset;
+            uint32_t wordCount;
+        };
+
+        template <typename Packet, typename Translator>
+        static const uint64_t* dispatch(const uint64_t* pPacket, Translator& translator)
+        {
+            translator(*reinterpret_cast<const Packet*>(pPacket));
+            return pPacket + sizeof(Packet) / sizeof(uint64_t);
+        }
+
+        std::vector<Command> m_commands;
+        std::vector<Command> m_scratch;
+        // Packets are stored as 8 byte words so every packet is suitably aligned
+        std::vector<uint64_t> m_words;
+        bool m_isRecording = false;
+        bool m_isSorted = true;
+    };
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "FenceValues.h"
+
+namespace bdr
+{
+    // Holds on to objects the GPU may still be using and destroys them once the fence they were last used with
+    // has passed. Each queue timeline is a min-heap on fence value, so collecting pops entries until the smallest
+    // remaining one hasn't completed, and objects handed over out of fence order (e.g. tagged with an older
+    // fence by another thread) don't hold back ones that are ready.
+    //
+    // Tag an object with the last fence of the queue that used it. If several queues touched it, use a queue
+    // that waits on the others (e.g. the graphics queue after insertWaitOnOtherQueueFence on the copy queue).
+    template <typename T>
+    class DeferredReleaseQueueT
+    {
+    public:
+        void release(T item, const uint64_t fenceValue)
+        {
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+            std::vector<Entry>& entries = m_timelines[getFenceTimeline(fenceValue)];
+            entries.push_back(Entry{ item, fenceValue });
+            std::push_heap(entries.begin(), entries.end(), Entry::isLater);
+        }
+
+        // `getCompletedFenceValue(uint32_t timeline)` returns how far a timeline has got; it is only called
+        // for timelines with something queued. Returns how many objects were destroyed.
+        template <typename GetCompletedFenceValue, typename Destroy>
+        uint32_t collect(GetCompletedFenceValue&& getCompletedFenceValue, Destroy&& destroy)
+        {
+            uint32_t destroyed = 0;
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+            for (uint32_t i = 0; i < MAX_FENCE_TIMELINES; i++) {
+                std::vector<Entry>& entries = m_timelines[i];
+                if (entries.empty()) {
+                    continue;
+                }
+
+                const uint64_t completedValue = getCompletedFenceValue(i);
+                while (!entries.empty() && entries.front().fenceValue <= completedValue) {
+                    std::pop_heap(entries.begin(), entries.end(), Entry::isLater);
+                    destroy(entries.back().item);
+                    entries.pop_back();
+                    destroyed++;
+                }
+            }
+            return destroyed;
+        }
+
+        // Destroys everything regardless of fences. The GPU must be idle.
+        template <typename Destroy>
+        void clear(Destroy&& destroy)
+        {
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+            for (std::vector<Entry>& entries : m_timelines) {
+                for (Entry& entry : entries) {
+                    destroy(entry.item);
+                }
+                entries.clear();
+            }
+        }
+
+        inline size_t getPendingCount() const
+        {
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+            size_t count = 0;
+            for (const std::vector<Entry>& entries : m_timelines) {
+                count += entries.size();
+            }
+            return count;
+        }
+
+    private:
+        struct Entry
+        {
+            T item;
+            uint64_t fenceValue;
+
+            // Heap order: smallest fence first
+            static bool isLater(const Entry& lhs, const Entry& rhs)
+            {
+                return lhs.fenceValue > rhs.fenceValue;
+            }
+        };
+
+        mutable std::mutex m_mutex;
+        std::vector<Entry> m_timelines[MAX_FENCE_TIMELINES];
+    };
+}
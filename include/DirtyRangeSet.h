@@ -0,0 +1,89 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace bdr
+{
+    // Byte ranges of a buffer written since it was last uploaded. Adding is a push (or an extension of the last
+    // range, for the common case of writes walking forward through the buffer); sorting and merging is left to
+    // `merge`, which runs once per upload.
+    class DirtyRangeSet
+    {
+    public:
+        struct Range
+        {
+            uint64_t begin;
+            uint64_t end;
+        };
+
+        void add(const uint64_t offset, const uint64_t size)
+        {
+            if (size == 0) {
+                return;
+            }
+            const uint64_t end = offset + size;
+            if (!m_ranges.empty()) {
+                Range& last = m_ranges.back();
+                if (offset >= last.begin && offset <= last.end) {
+                    last.end = std::max(last.end, end);
+                    return;
+                }
+                m_isSorted = m_isSorted && offset > last.end;
+            }
+            m_ranges.push_back(Range{ offset, end });
+        }
+
+        // Sorts the ranges and merges any that overlap or are less than `mergeGap` bytes apart. Copying a small
+        // gap along with its neighbours is cheaper than another copy command.
+        const std::vector<Range>& merge(const uint64_t mergeGap = 0)
+        {
+            if (!m_isSorted) {
+                std::sort(m_ranges.begin(), m_ranges.end(), [](const Range& lhs, const Range& rhs) {
+                    return lhs.begin < rhs.begin;
+                });
+                m_isSorted = true;
+            }
+
+            size_t mergedCount = 0;
+            for (size_t i = 0; i < m_ranges.size(); i++) {
+                const Range& range = m_ranges[i];
+                if (mergedCount > 0 && range.begin <= m_ranges[mergedCount - 1].end + mergeGap) {
+                    Range& merged = m_ranges[mergedCount - 1];
+                    merged.end = std::max(merged.end, range.end);
+                }
+                else {
+                    m_ranges[mergedCount++] = range;
+                }
+            }
+            m_ranges.resize(mergedCount);
+            return m_ranges;
+        }
+
+        inline void clear()
+        {
+            m_ranges.clear();
+            m_isSorted = true;
+        }
+
+        inline bool isEmpty() const
+        {
+            return m_ranges.empty();
+        }
+
+        // Total bytes covered, only exact after `merge`
+        inline uint64_t getDirtyBytes() const
+        {
+            uint64_t bytes = 0;
+            for (const Range& range : m_ranges) {
+                bytes += range.end - range.begin;
+            }
+            return bytes;
+        }
+
+    private:
+        std::vector<Range> m_ranges;
+        bool m_isSorted = true;
+    };
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace bdr
+{
+    // The last fence value known to have completed on one queue, shared by every thread that polls it. Updates
+    // are an atomic max, so a thread that read an older value can never move the cache backwards, and queries
+    // the cache can already answer never touch the fence itself.
+    class FenceCompletionCache
+    {
+    public:
+        explicit FenceCompletionCache(const uint64_t initialValue = 0) :
+            m_completedValue{ initialValue }
+        { }
+
+        // `pollFence` returns the fence's current completed value (e.g. ID3D12Fence::GetCompletedValue) and is
+        // only called when the cached value is not enough to answer
+        template <typename PollFence>
+        bool isComplete(const uint64_t fenceValue, PollFence&& pollFence)
+        {
+            if (fenceValue <= m_completedValue.load(std::memory_order_acquire)) {
+                return true;
+            }
+            return fenceValue <= advance(pollFence());
+        }
+
+        template <typename PollFence>
+        uint64_t refresh(PollFence&& pollFence)
+        {
+            return advance(pollFence());
+        }
+
+        // Raises the cached value to `completedValue` if it is newer. Returns the value after the update.
+        uint64_t advance(const uint64_t completedValue)
+        {
+            uint64_t current = m_completedValue.load(std::memory_order_relaxed);
+            while (current < completedValue
+                && !m_completedValue.compare_exchange_weak(current, completedValue, std::memory_order_release, std::memory_order_relaxed)) {}
+            return current < completedValue ? completedValue : current;
+        }
+
+        inline uint64_t get() const
+        {
+            return m_completedValue.load(std::memory_order_acquire);
+        }
+
+    private:
+        std::atomic<uint64_t> m_completedValue;
+    };
+}
@@ -0,0 +1,211 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "FenceValues.h"
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define BDR_FENCE_COROUTINES 1
+#endif
+
+namespace bdr
+{
+    // Runs work once a fence value has been reached, without the caller blocking on it. A single waiter thread
+    // sleeps until the earliest pending value on any timeline completes (or a new request comes in) and then
+    // runs every callback that became ready, in fence order per timeline.
+    //
+    // Callbacks, future continuations and resumed coroutines run on the waiter thread, so they should be short
+    // and must not wait on fences themselves; hand anything heavy off to another thread. Requests for a value
+    // that has already completed run straight away on the calling thread.
+    //
+    // `Fence` is what gets waited on. It needs:
+    //     uint64_t getCompletedFenceValue(uint32_t timeline);
+    //     void waitForAny(const uint64_t* targets);  // MAX_FENCE_TIMELINES targets, UINT64_MAX = not waited on.
+    //                                                // May return early.
+    //     void wake();                               // Makes the current or next waitForAny return
+    // SimulatedFence provides these for running without a device; D3D12FenceWaiter does for CommandQueueManager.
+    template <typename Fence>
+    class FenceCompletionServiceT
+    {
+    public:
+        using Callback = std::function<void()>;
+
+        explicit FenceCompletionServiceT(Fence& fence) :
+            m_fence{ fence }
+        { }
+
+        ~FenceCompletionServiceT()
+        {
+            stop();
+        }
+
+        FenceCompletionServiceT(const FenceCompletionServiceT&) = delete;
+        FenceCompletionServiceT& operator=(const FenceCompletionServiceT&) = delete;
+
+        void start()
+        {
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+            if (m_waiterThread.joinable()) {
+                return;
+            }
+            m_isStopping = false;
+            m_waiterThread = std::thread{ [this]() { waiterLoop(); } };
+        }
+
+        // Joins the waiter thread. Callbacks still pending are dropped without running, so their futures report
+        // a broken promise; make sure the GPU is idle (or nothing is pending) first.
+        void stop()
+        {
+            {
+                std::lock_guard<std::mutex> lockGuard{ m_mutex };
+                if (!m_waiterThread.joinable()) {
+                    return;
+                }
+                m_isStopping = true;
+            }
+            m_fence.wake();
+            m_waiterThread.join();
+
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+            for (std::vector<Pending>& pending : m_pending) {
+                pending.clear();
+            }
+        }
+
+        bool isComplete(const uint64_t fenceValue)
+        {
+            return m_fence.getCompletedFenceValue(getFenceTimeline(fenceValue)) >= fenceValue;
+        }
+
+        void onComplete(const uint64_t fenceValue, Callback callback)
+        {
+            if (isComplete(fenceValue)) {
+                callback();
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lockGuard{ m_mutex };
+                std::vector<Pending>& pending = m_pending[getFenceTimeline(fenceValue)];
+                pending.push_back(Pending{ fenceValue, m_nextSequence++, std::move(callback) });
+                std::push_heap(pending.begin(), pending.end(), Pending::isLater);
+            }
+            // The waiter may be asleep on a later value
+            m_fence.wake();
+        }
+
+        std::future<void> whenComplete(const uint64_t fenceValue)
+        {
+            std::shared_ptr<std::promise<void>> pPromise = std::make_shared<std::promise<void>>();
+            std::future<void> future = pPromise->get_future();
+            onComplete(fenceValue, [pPromise]() { pPromise->set_value(); });
+            return future;
+        }
+
+        inline size_t getPendingCount()
+        {
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+            size_t count = 0;
+            for (const std::vector<Pending>& pending : m_pending) {
+                count += pending.size();
+            }
+            return count;
+        }
+
+    #ifdef BDR_FENCE_COROUTINES
+        struct Awaiter
+        {
+            FenceCompletionServiceT* pService;
+            uint64_t fenceValue;
+
+            bool await_ready() const
+            {
+                return pService->isComplete(fenceValue);
+            }
+
+            void await_suspend(std::coroutine_handle<> handle) const
+            {
+                pService->onComplete(fenceValue, [handle]() { handle.resume(); });
+            }
+
+            void await_resume() const { }
+        };
+
+        // `co_await service.awaitFence(value);` The coroutine resumes on the waiter thread.
+        Awaiter awaitFence(const uint64_t fenceValue)
+        {
+            return Awaiter{ this, fenceValue };
+        }
+    #endif
+
+    private:
+        struct Pending
+        {
+            uint64_t fenceValue;
+            uint64_t sequence;
+            Callback callback;
+
+            // Heap order: smallest fence first, then first come first served
+            static bool isLater(const Pending& lhs, const Pending& rhs)
+            {
+                return lhs.fenceValue != rhs.fenceValue ? lhs.fenceValue > rhs.fenceValue : lhs.sequence > rhs.sequence;
+            }
+        };
+
+        void waiterLoop()
+        {
+            std::vector<Callback> ready;
+            for (;;) {
+                uint64_t targets[MAX_FENCE_TIMELINES];
+                {
+                    std::lock_guard<std::mutex> lockGuard{ m_mutex };
+                    if (m_isStopping) {
+                        return;
+                    }
+                    for (uint32_t i = 0; i < MAX_FENCE_TIMELINES; i++) {
+                        targets[i] = m_pending[i].empty() ? UINT64_MAX : m_pending[i].front().fenceValue;
+                    }
+                }
+
+                m_fence.waitForAny(targets);
+
+                {
+                    std::lock_guard<std::mutex> lockGuard{ m_mutex };
+                    for (uint32_t i = 0; i < MAX_FENCE_TIMELINES; i++) {
+                        std::vector<Pending>& pending = m_pending[i];
+                        if (pending.empty()) {
+                            continue;
+                        }
+                        const uint64_t completedValue = m_fence.getCompletedFenceValue(i);
+                        while (!pending.empty() && pending.front().fenceValue <= completedValue) {
+                            std::pop_heap(pending.begin(), pending.end(), Pending::isLater);
+                            ready.push_back(std::move(pending.back().callback));
+                            pending.pop_back();
+                        }
+                    }
+                }
+
+                // Outside the lock so callbacks can queue more work
+                for (Callback& callback : ready) {
+                    callback();
+                }
+                ready.clear();
+            }
+        }
+
+        Fence& m_fence;
+
+        std::mutex m_mutex;
+        std::vector<Pending> m_pending[MAX_FENCE_TIMELINES];
+        uint64_t m_nextSequence = 0;
+        bool m_isStopping = false;
+        std::thread m_waiterThread;
+    };
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+
+namespace bdr
+{
+    // Every CommandQueue starts its fence at (type << FENCE_QUEUE_SHIFT) + 1, so a fence value on its own
+    // tells you which queue timeline it belongs to.
+    constexpr uint32_t FENCE_QUEUE_SHIFT = 56u;
+    constexpr uint32_t MAX_FENCE_TIMELINES = 8u;
+
+    inline uint32_t getFenceTimeline(const uint64_t fenceValue)
+    {
+        return static_cast<uint32_t>(fenceValue >> FENCE_QUEUE_SHIFT);
+    }
+
+    inline uint64_t getFenceTimelineBase(const uint32_t timeline)
+    {
+        return static_cast<uint64_t>(timeline) << FENCE_QUEUE_SHIFT;
+    }
+}
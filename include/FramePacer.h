@@ -0,0 +1,179 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace bdr
+{
+    struct FrameTimings
+    {
+        uint64_t frameNumber = 0;
+        // How long beginFrame blocked waiting for the GPU to catch up
+        double cpuWaitMs = 0.0;
+        // How long the GPU sat idle between finishing the previous frame and starting this one
+        double gpuWaitMs = 0.0;
+        // From beginFrame (input is sampled right after) until the GPU finished the frame
+        double latencyMs = 0.0;
+    };
+
+    struct SteadyClock
+    {
+        static double nowMs()
+        {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+    };
+
+    // Bounds how far the CPU can run ahead of the GPU. Each frame in flight gets a slot holding the fence it was
+    // submitted with; beginFrame waits on the slot's previous fence before the slot is reused, so at most
+    // `maxFramesInFlight` frames are ever queued. One frame in flight means the CPU waits for the GPU to finish
+    // every frame (lowest latency), more trades latency for keeping the GPU fed.
+    //
+    // Once a slot's frame has completed, the caller reports when the GPU started and finished it (from
+    // timestamp queries, converted to `Clock`'s time base) through completeFrame, which turns that into the
+    // frame's GPU idle time and latency. Knows nothing about D3D12; `Clock` provides `static double nowMs()`.
+    template <typename Clock = SteadyClock>
+    class FramePacerT
+    {
+    public:
+        static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 4u;
+        static constexpr uint32_t DEFAULT_HISTORY_SIZE = 600u;
+
+        explicit FramePacerT(const uint32_t maxFramesInFlight = 2u, const uint32_t historySize = DEFAULT_HISTORY_SIZE) :
+            m_history(historySize)
+        {
+            setMaxFramesInFlight(maxFramesInFlight);
+        }
+
+        // Only while nothing is in flight
+        void setMaxFramesInFlight(const uint32_t maxFramesInFlight)
+        {
+            assert(maxFramesInFlight >= 1 && maxFramesInFlight <= MAX_FRAMES_IN_FLIGHT);
+            m_maxFramesInFlight = std::min(std::max(maxFramesInFlight, 1u), MAX_FRAMES_IN_FLIGHT);
+            for (Slot& slot : m_slots) {
+                slot = Slot{};
+            }
+        }
+
+        // `waitForFence(uint64_t)` blocks until the fence has passed. Afterwards everything used by the frame
+        // previously recorded in this slot can be reused.
+        template <typename WaitForFence>
+        void beginFrame(WaitForFence&& waitForFence)
+        {
+            const Slot& slot = m_slots[getFrameSlot()];
+            const double waitStartMs = Clock::nowMs();
+            if (slot.isInFlight) {
+                waitForFence(slot.fenceValue);
+            }
+            m_frameBeginMs = Clock::nowMs();
+            m_cpuWaitMs = m_frameBeginMs - waitStartMs;
+        }
+
+        // Whether the current slot holds a frame that completeFrame hasn't been called for yet. Only meaningful
+        // between beginFrame and endFrame.
+        inline bool hasCompletedFrame() const
+        {
+            return m_slots[getFrameSlot()].isInFlight;
+        }
+
+        // GPU start and end of the frame that previously used the current slot, in Clock's time base
+        void completeFrame(const double gpuBeginMs, const double gpuEndMs)
+        {
+            Slot& slot = m_slots[getFrameSlot()];
+            assert(slot.isInFlight);
+
+            FrameTimings timings;
+            timings.frameNumber = slot.frameNumber;
+            timings.cpuWaitMs = slot.cpuWaitMs;
+            // Frames complete in order, so the previous one has always been reported if it ran
+            if (m_hasLastGpuEnd && m_lastGpuEndFrame + 1 == slot.frameNumber && gpuBeginMs > m_lastGpuEndMs) {
+                timings.gpuWaitMs = gpuBeginMs - m_lastGpuEndMs;
+            }
+            timings.latencyMs = gpuEndMs - slot.frameBeginMs;
+
+            m_hasLastGpuEnd = true;
+            m_lastGpuEndMs = gpuEndMs;
+            m_lastGpuEndFrame = slot.frameNumber;
+            slot.isInFlight = false;
+
+            m_lastTimings = timings;
+            if (!m_history.empty()) {
+                m_history[m_historyCount % m_history.size()] = timings;
+                m_historyCount++;
+            }
+        }
+
+        void endFrame(const uint64_t fenceValue)
+        {
+            Slot& slot = m_slots[getFrameSlot()];
+            slot.isInFlight = true;
+            slot.fenceValue = fenceValue;
+            slot.frameNumber = m_frameNumber;
+            slot.frameBeginMs = m_frameBeginMs;
+            slot.cpuWaitMs = m_cpuWaitMs;
+            m_frameNumber++;
+        }
+
+        // Which of the `maxFramesInFlight` slots the frame being recorded uses
+        inline uint32_t getFrameSlot() const
+        {
+            return uint32_t(m_frameNumber % m_maxFramesInFlight);
+        }
+
+        inline uint32_t getMaxFramesInFlight() const
+        {
+            return m_maxFramesInFlight;
+        }
+
+        inline uint64_t getFrameNumber() const
+        {
+            return m_frameNumber;
+        }
+
+        // Timings of the most recently completed frame
+        inline const FrameTimings& getLastFrameTimings() const
+        {
+            return m_lastTimings;
+        }
+
+        // One line per completed frame still in the history, oldest first
+        void writeCsv(std::ostream& out) const
+        {
+            out << "frame,cpuWaitMs,gpuWaitMs,latencyMs\n";
+            const size_t historySize = m_history.size();
+            const size_t count = m_historyCount < historySize ? size_t(m_historyCount) : historySize;
+            for (size_t i = 0; i < count; i++) {
+                const FrameTimings& timings = m_history[(m_historyCount - count + i) % historySize];
+                out << timings.frameNumber << ',' << timings.cpuWaitMs << ',' << timings.gpuWaitMs << ',' << timings.latencyMs << '\n';
+            }
+        }
+
+    private:
+        struct Slot
+        {
+            bool isInFlight = false;
+            uint64_t fenceValue = 0;
+            uint64_t frameNumber = 0;
+            double frameBeginMs = 0.0;
+            double cpuWaitMs = 0.0;
+        };
+
+        Slot m_slots[MAX_FRAMES_IN_FLIGHT];
+        uint32_t m_maxFramesInFlight = 2u;
+        uint64_t m_frameNumber = 0;
+
+        double m_frameBeginMs = 0.0;
+        double m_cpuWaitMs = 0.0;
+
+        bool m_hasLastGpuEnd = false;
+        double m_lastGpuEndMs = 0.0;
+        uint64_t m_lastGpuEndFrame = 0;
+
+        FrameTimings m_lastTimings;
+        std::vector<FrameTimings> m_history;
+        uint64_t m_historyCount = 0;
+    };
+}
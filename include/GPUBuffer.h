@@ -1,11 +1,26 @@
 #pragma once
 #include "CommandQueue.h"
 #include "GPUResource.h"
-#include <array>
+#include "GPUTexture.h"
+#include "BufferSuballocator.h"
+#include "UploadRing.h"
+#include "BufferCopyList.h"
+#include "DeferredReleaseQueue.h"
+#include "UploadStreamQueue.h"
+#include "DirtyRangeSet.h"
+#include "MemoryStats.h"
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 
 namespace bdr
 {
+    // Identifies a streamed upload, see GPUBufferManager::createOnGPUStreamed
+    using UploadTicket = uint64_t;
+
     struct GPUBuffer : GPUResource
     {
         GPUBuffer() = default;
@@ -25,12 +40,28 @@ namespace bdr
         uint32_t numElements = 0;
         uint32_t elementSize = 0;
         size_t bufferSize = 0;
+        // Buffers created through GPUBufferManager live in a shared heap resource, starting at `offset`.
+        // They must be released with GPUBufferManager::destroy rather than GPUResource::destroy.
+        size_t offset = 0;
+        BufferSuballocator::Allocation allocation;
     };
 
+    // Uploads go through one persistently mapped UPLOAD buffer used as a ring (see UploadRing). Staging
+    // space is bump-allocated from it, copies are queued and coalesced, and `execute` records them all into
+    // one copy command list. Ring space is recycled once the copy queue fence for that batch has passed.
+    //
+    // With streaming started, uploads can also come from any thread through `createOnGPUStreamed`: the buffer is
+    // allocated right away and its data handed to a background thread, which stages and submits everything
+    // queued since it last ran as one copy list. The render thread then never records, submits or blocks on
+    // streamed copies; `execute` just wakes the background thread unless something was staged outside it.
     class GPUBufferManager
     {
     public:
-        constexpr static size_t STAGING_MAX = 256;
+        constexpr static size_t UPLOAD_RING_SIZE = 32ull * 1024ull * 1024ull;
+        // Matches the BufferSuballocator granularity so neighbouring uploads can be merged into one copy
+        constexpr static size_t UPLOAD_ALIGNMENT = BufferSuballocator::DEFAULT_GRANULARITY;
+        // Larger uploads are split so a single buffer can't monopolise the ring
+        constexpr static size_t UPLOAD_MAX_CHUNK = UPLOAD_RING_SIZE / 4;
 
         GPUBufferManager() = default;
         ~GPUBufferManager()
@@ -41,14 +72,30 @@ namespace bdr
         void init(ID3D12Device* pDevice, CommandQueueManager* pCmdQueueManager);
         void shutdown();
 
-        // This is CPU blocking
+        // Recycles ring space for uploads the copy queue has finished and returns the ranges of buffers destroyed
+        // with a fence that has since passed. Not CPU blocking.
         void reset();
 
-        // Executes copy commands on the copy queue, and also adds the resource barriers to the input
-        // graphicsCmdList. This function must be called before using any of the resources returned
-        // from the `createOnGPU` function
+        // Records every queued copy into a single command list and executes it on the copy queue. This must be
+        // called before using any of the resources returned from `createOnGPU`, and work that uses them has to
+        // depend on `getLastUploadFence` (see CommandQueueManager::submit). No queue waits on it otherwise.
+        // While streaming, only copies staged outside the background thread and buffer updates are submitted here,
+        // the rest is left to the background thread unless `waitForCompletion` is set.
         void execute(bool waitForCompletion = false);
 
+        inline uint64_t getLastUploadFence() const
+        {
+            return m_currentFence.load(std::memory_order_acquire);
+        }
+
+        // Starts the background upload thread. Call after init, from the thread that owns the manager.
+        void startStreaming();
+        // Submits anything still queued and joins the background thread
+        void stopStreaming();
+
+        // The buffer is sub-allocated from a shared DEFAULT heap buffer, so `name` can no longer be attached
+        // to a D3D12 object of its own. If the upload ring is full this will execute the queued copies and
+        // block until enough of them have completed.
         GPUBuffer createOnGPU(
             const std::wstring& name,
             const uint32_t numElements,
@@ -56,20 +103,170 @@ namespace bdr
             const void* userData = nullptr
         );
 
+        struct InPlaceBufferDesc
+        {
+            uint32_t numElements;
+            uint32_t elementSize;
+        };
+
+        // Staging space a buffer takes up in `createOnGPUInPlace`
+        static inline uint64_t getInPlaceStagingSize(const InPlaceBufferDesc& desc)
+        {
+            return Math::AlignUp(uint64_t(desc.numElements) * desc.elementSize, uint64_t(UPLOAD_ALIGNMENT));
+        }
+
+        // Creates `count` buffers and calls `write` once with a pointer to each one's staging memory, for the
+        // caller to fill in place (from as many threads as it likes) instead of handing over a CPU copy. The
+        // upload lock is held until `write` returns, so the copies can't be submitted before the data is there.
+        // Everything is staged in one allocation: the getInPlaceStagingSize of all the buffers can add up to at
+        // most UPLOAD_MAX_CHUNK, like any other single piece of the ring, so one batch can't wait for the whole ring
+        // to drain. Staging is usually write-combined, so write it front to back and never read it.
+        void createOnGPUInPlace(
+            const InPlaceBufferDesc* pDescs,
+            const uint32_t count,
+            GPUBuffer* pOutBuffers,
+            const std::function<void(uint8_t* const* ppStaging)>& write
+        );
+
+        // Safe to call from any thread while streaming. The buffer can be used once `getUploadFence(ticket)`
+        // is submitted, by depending on that fence, or polled with `isUploadComplete`. `data` is moved into
+        // the request, so the caller can let go of it straight away.
+        GPUBuffer createOnGPUStreamed(
+            const std::wstring& name,
+            const uint32_t numElements,
+            const uint32_t elementSize,
+            std::vector<uint8_t> data,
+            UploadTicket* pOutTicket
+        );
+
+        // Copy queue fence the ticket's upload went out with, or UploadStreamQueue::NOT_SUBMITTED while it's
+        // still queued. INVALID_TICKET (no data) reports a fence that has already passed.
+        uint64_t getUploadFence(const UploadTicket ticket) const;
+        bool isUploadComplete(const UploadTicket ticket) const;
+
+        // Overwrites `size` bytes of the buffer at `offset`. The bytes go into a CPU copy of the buffer (made on
+        // the first update) and only the dirty ranges, merged, are uploaded on the next `execute`, so writing the
+        // same bytes several times in a frame uploads them once. Any thread.
+        //
+        // The buffer is updated in place, so the copy waits on the GPU for all graphics and compute work
+        // submitted before it, and work submitted after `execute` that reads the buffer must depend on
+        // `getLastUploadFence` as usual. While streaming, `execute` submits pending updates on the calling thread
+        // so they're in before that thread's next submission.
+        void update(GPUBuffer& buffer, const uint64_t offset, const void* pData, const uint64_t size);
+
+        // Creates a texture of its own (textures aren't sub-allocated) and queues uploads for every subresource
+        // in `pSubresources` with data, indexed like D3D12 subresources. Rows are laid out with the footprints
+        // CopyTextureRegion expects and go through the upload ring like buffer data, in the same copy list.
+        // The texture stays in COMMON: readers can promote it to a shader resource state without a barrier.
+        GPUTexture createTexture(const std::wstring& name, const TextureDesc& desc, const SubresourceData* pSubresources = nullptr);
+        // Releases the texture once `lastUsedFence` has passed
+        void destroy(GPUTexture& texture, const uint64_t lastUsedFence);
+
+        // Returns the buffer's range to its heap. The caller must make sure the GPU is done with it.
+        void destroy(GPUBuffer& buffer);
+        // Returns the buffer's range to its heap once `lastUsedFence` has passed (see `reset`)
+        void destroy(GPUBuffer& buffer, const uint64_t lastUsedFence);
+
         bool isComplete() const;
 
+        inline BufferSuballocator::Stats getHeapStats() const
+        {
+            return m_heapAllocator.getStats();
+        }
+
         // Don't own these
         ID3D12Device* m_device = nullptr;
         CommandQueueManager* m_cmdQueueManager = nullptr;
         // Do own these
         ID3D12GraphicsCommandList* m_commandList = nullptr;
-        ID3D12CommandAllocator* m_commandAllocator = nullptr;
 
-        std::array<GPUResource, STAGING_MAX> m_stagingBuffers;
-        std::array<D3D12_RESOURCE_BARRIER, STAGING_MAX> m_resourceBarriers;
-        size_t m_stagedEndIdx = 0;
+        // One DEFAULT heap buffer per heap in m_heapAllocator
+        BufferSuballocator m_heapAllocator;
+        std::vector<ID3D12Resource*> m_heapBuffers;
+
+    private:
+        // Rough command allocator bytes per recorded copy, only used to pick an allocator of the right size
+        constexpr static uint64_t COPY_COMMAND_SIZE_ESTIMATE = 64ull;
+
+        struct PendingTextureCopy
+        {
+            ID3D12Resource* pDest;
+            uint32_t subresource;
+            uint32_t destY;
+            uint32_t destZ;
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT source;
+        };
+
+        struct StreamedUpload
+        {
+            ID3D12Resource* pDest;
+            uint64_t destOffset;
+            std::vector<uint8_t> data;
+        };
+
+        using UploadStreamQueue = UploadStreamQueueT<StreamedUpload>;
+
+        struct BufferShadow
+        {
+            ID3D12Resource* pDest;
+            uint64_t destOffset;
+            std::vector<uint8_t> data;
+            DirtyRangeSet dirtyRanges;
+        };
+
+        // Sub-allocates the buffer's range, creating a heap if needed. Takes m_heapMutex. A zero sized buffer comes
+        // back empty, with no resource or allocation.
+        GPUBuffer allocateBuffer(const uint32_t numElements, const uint32_t elementSize);
+
+        // The rest expect m_uploadMutex to be held
+        // `isWholeBuffer`: the data fills the destination buffer to its end, so its padding may be copied over
+        void stageUpload(ID3D12Resource* pDest, const uint64_t destOffset, const uint8_t* pSrc, const uint64_t size, const bool isWholeBuffer);
+        uint64_t allocateUploadSpace(const uint64_t size, const uint64_t alignment = UPLOAD_ALIGNMENT);
+        // Uploads rows [firstRow, firstRow + rowCount) of depth slices [firstSlice, firstSlice + sliceCount)
+        void stageTextureRegion(
+            GPUTexture& texture,
+            const uint32_t subresource,
+            const SubresourceFootprint& footprint,
+            const SubresourceData& data,
+            const uint32_t firstSlice,
+            const uint32_t sliceCount,
+            const uint32_t firstRow,
+            const uint32_t rowCount
+        );
+        // Stages the dirty ranges of every updated buffer
+        void stageBufferUpdates();
+        // Returns the fence the copies went out with, or the last upload fence if there were none
+        uint64_t submitPendingCopies();
+        void forgetShadow(const GPUBuffer& buffer);
+
+        GPUResource m_uploadBuffer;
+        uint8_t* m_pUploadData = nullptr;
+        UploadRing m_uploadRing;
+        BufferCopyListT<ID3D12Resource> m_pendingCopies{ UPLOAD_ALIGNMENT };
+        std::vector<PendingTextureCopy> m_pendingTextureCopies;
+        DeferredReleaseQueueT<BufferSuballocator::Allocation> m_deferredFrees;
+
+        UploadStreamQueue m_streamQueue;
+
+        // CPU copies of updated buffers, by GPU address. Guarded by m_updateMutex, which is taken after
+        // m_uploadMutex when both are needed.
+        std::unordered_map<D3D12_GPU_VIRTUAL_ADDRESS, BufferShadow> m_shadows;
+        std::vector<BufferShadow*> m_dirtyShadows;
+        std::mutex m_updateMutex;
+        // Set while buffer updates are among the pending copies, which then have to wait for earlier readers
+        bool m_hasPendingUpdates = false;
+
+        // Producers only take m_heapMutex, and only briefly. m_uploadMutex covers the ring, the pending copies
+        // and the copy list, and may be held across a wait for ring space, so the render thread only try-locks it.
+        std::mutex m_heapMutex;
+        std::mutex m_uploadMutex;
+
         bool m_isReady = false;
-        uint64_t m_currentFence = 0;
-    };
-}
+        std::atomic<uint64_t> m_currentFence{ getFenceTimelineBase(D3D12_COMMAND_LIST_TYPE_COPY) };
 
+        MemoryStatsRegistry::Category* m_pHeapStats = nullptr;
+        MemoryStatsRegistry::Category* m_pBufferStats = nullptr;
+        MemoryStatsRegistry::Category* m_pUploadStats = nullptr;
+        MemoryStatsRegistry::Category* m_pTextureStats = nullptr;
+    };
+}
\ No newline at end of file
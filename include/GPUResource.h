@@ -2,6 +2,7 @@
 #include <d3d12.h>
 #include "d3dx12.h"
 #include "dx_helpers.h"
+#include "BarrierPlanner.h"
 
 
 namespace bdr
@@ -12,13 +13,11 @@ namespace bdr
         GPUResource(ID3D12Resource* resource) :
             pResource(resource),
             usageState(D3D12_RESOURCE_STATE_COMMON),
-            transitioningState(D3D12_RESOURCE_STATE_COMMON),
             gpuVirtualAddress(D3D12_GPU_VIRTUAL_ADDRESS_NULL)
         { }
         GPUResource(ID3D12Resource* resource, D3D12_RESOURCE_STATES currentState) :
             pResource(resource),
             usageState(currentState),
-            transitioningState(currentState),
             gpuVirtualAddress(D3D12_GPU_VIRTUAL_ADDRESS_NULL)
         { }
 
@@ -50,7 +49,20 @@ namespace bdr
         }
         ID3D12Resource* pResource = nullptr;
         D3D12_RESOURCE_STATES usageState = D3D12_RESOURCE_STATE_COMMON;
-        D3D12_RESOURCE_STATES transitioningState = D3D12_RESOURCE_STATE_COMMON;
         D3D12_GPU_VIRTUAL_ADDRESS gpuVirtualAddress = D3D12_GPU_VIRTUAL_ADDRESS_NULL;
     };
+
+    using BarrierPlanner = BarrierPlannerT<ID3D12Resource*>;
+
+    // States that several readers can share, so combined read states are kept instead of being transitioned away
+    constexpr D3D12_RESOURCE_STATES READ_ONLY_RESOURCE_STATES =
+        D3D12_RESOURCE_STATE_GENERIC_READ | D3D12_RESOURCE_STATE_DEPTH_READ | D3D12_RESOURCE_STATE_RESOLVE_SOURCE;
+
+    inline BarrierPlanner makeBarrierPlanner()
+    {
+        return BarrierPlanner{ uint32_t(READ_ONLY_RESOURCE_STATES) };
+    }
+
+    // Records a planned batch with as few ResourceBarrier calls as possible (one unless it's unusually large)
+    void recordBarriers(ID3D12GraphicsCommandList* pCommandList, const std::vector<BarrierPlanner::Barrier>& barriers);
 }
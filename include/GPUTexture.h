@@ -0,0 +1,33 @@
+#pragma once
+#include "GPUResource.h"
+#include "TextureLayout.h"
+
+namespace bdr
+{
+    struct TextureDesc
+    {
+        D3D12_RESOURCE_DIMENSION dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+        DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        uint32_t width = 1;
+        uint32_t height = 1;
+        // Depth for 3D textures, array size otherwise (6 per cube)
+        uint16_t depthOrArraySize = 1;
+        // 0 for a full chain
+        uint16_t mipCount = 1;
+    };
+
+    struct GPUTexture : GPUResource
+    {
+        TextureDesc desc;
+
+        inline uint32_t getSubresourceCount() const
+        {
+            return desc.dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? desc.mipCount : uint32_t(desc.mipCount) * desc.depthOrArraySize;
+        }
+    };
+
+    // Block size of the formats textures are uploaded in. Asserts on formats it doesn't know.
+    TextureFormatInfo getTextureFormatInfo(const DXGI_FORMAT format);
+
+    TextureLayoutDesc getTextureLayoutDesc(const TextureDesc& desc);
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+namespace bdr
+{
+    class JsonValue;
+
+    // Same layout as Vertex in renderer.h, which needs DirectXMath: a float3 position and an RGBA8 color with
+    // red in the low byte
+    struct GltfVertex
+    {
+        float position[3];
+        uint32_t color;
+    };
+
+    // A glTF mesh primitive. Every primitive becomes one vertex and one index buffer.
+    struct GltfPrimitive
+    {
+        static constexpr uint32_t NO_ACCESSOR = UINT32_MAX;
+
+        uint32_t meshIndex;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        // 2 or 4. 8 and 16 bit indices come out as 16 bit; non-indexed primitives get 0..vertexCount-1.
+        uint32_t indexSize;
+        uint32_t positionAccessor;
+        uint32_t colorAccessor;
+        uint32_t indexAccessor;
+
+        inline uint64_t getVertexBytes() const
+        {
+            return uint64_t(vertexCount) * sizeof(GltfVertex);
+        }
+
+        inline uint64_t getIndexBytes() const
+        {
+            return uint64_t(indexCount) * indexSize;
+        }
+    };
+
+    // Wall clock time spent in each stage of a load, in milliseconds
+    struct GltfLoadTimings
+    {
+        // Opening and mapping the .gltf/.glb file
+        double mapMs = 0.0;
+        // Parsing the JSON
+        double parseMs = 0.0;
+        // Mapping or decoding buffers and validating accessors and primitives
+        double resolveMs = 0.0;
+        // Decoding accessors into vertices and indices, summed over `decode` calls
+        double decodeMs = 0.0;
+    };
+
+    // Loads the triangle geometry of a glTF 2.0 file, .gltf (with external or base64 data: buffers) or .glb,
+    // without a device. `load` maps the file and every buffer it references and works out the size of each
+    // primitive's vertices and indices; `decode` then writes them straight into memory the caller provides,
+    // e.g. upload staging, split into jobs across a thread pool. Binary data is read from the mapped files in
+    // place, never copied in between.
+    //
+    // Only meshes are loaded: no node transforms, materials or textures. Primitives that aren't triangle lists
+    // are skipped. POSITION must be float3 (no KHR_mesh_quantization) and COLOR_0 is optional, white without
+    // it. Sparse accessors aren't supported.
+    class GltfAsset
+    {
+    public:
+        // Returns false and describes the problem in `pError` if the file can't be read or isn't valid glTF
+        bool load(const std::filesystem::path& path, std::string* pError = nullptr);
+
+        // Decodes primitives [first, first + count). `ppVertices[i]` and `ppIndices[i]` receive primitive
+        // first + i and must have room for its getVertexBytes and getIndexBytes. Both are written front to back
+        // only, so they can point at write-combined memory.
+        void decode(ThreadPool& pool, const uint32_t firstPrimitive, const uint32_t count, GltfVertex* const* ppVertices, void* const* ppIndices);
+
+        // Single threaded versions of the jobs `decode` runs, for a range of one primitive. `pDest` points at
+        // the start of the primitive's vertices or indices, not the range's.
+        void decodeVertices(const GltfPrimitive& primitive, const uint32_t firstVertex, const uint32_t vertexCount, GltfVertex* pDest) const;
+        void decodeIndices(const GltfPrimitive& primitive, const uint32_t firstIndex, const uint32_t indexCount, void* pDest) const;
+
+        inline const std::vector<GltfPrimitive>& getPrimitives() const
+        {
+            return m_primitives;
+        }
+
+        inline const std::vector<std::string>& getMeshNames() const
+        {
+            return m_meshNames;
+        }
+
+        inline const GltfLoadTimings& getTimings() const
+        {
+            return m_timings;
+        }
+
+    private:
+        // Vertices or indices per decode job. Large enough that a job is worth handing out, small enough that
+        // a model made of one huge primitive still spreads across the pool.
+        static constexpr uint32_t DECODE_JOB_SIZE = 64u * 1024u;
+
+        struct Accessor
+        {
+            // Null for accessors without a buffer view, which are all zeros
+            const uint8_t* pData;
+            uint32_t count;
+            uint32_t stride;
+            uint32_t componentType;
+            uint32_t componentCount;
+            bool isNormalized;
+        };
+
+        struct BufferData
+        {
+            const uint8_t* pData;
+            uint64_t size;
+        };
+
+        bool resolveBuffers(const JsonValue& document, const std::filesystem::path& basePath, const BufferData& glbChunk, std::vector<BufferData>& buffers, std::string& error);
+        bool resolveAccessors(const JsonValue& document, const std::vector<BufferData>& buffers, std::string& error);
+        bool resolvePrimitives(const JsonValue& document, std::string& error);
+
+        // The glTF/GLB file, then any external buffers
+        std::vector<MappedFile> m_files;
+        // Buffers embedded as base64 data: URIs, decoded
+        std::vector<std::vector<uint8_t>> m_embeddedBuffers;
+        std::vector<Accessor> m_accessors;
+        std::vector<GltfPrimitive> m_primitives;
+        std::vector<std::string> m_meshNames;
+        GltfLoadTimings m_timings;
+    };
+}
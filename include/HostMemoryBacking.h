@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdlib>
+#include <new>
+
+#include "LinearAllocatorCore.h"
+#include "SimulatedFence.h"
+
+namespace bdr
+{
+    // Backs linear allocator pages with plain (aligned) system memory. The "GPU address" of a page is just its
+    // CPU address, which keeps DynAlloc math identical to the D3D12 path while running without a device.
+    struct HostMemoryBacking
+    {
+        // Matches D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT
+        static constexpr size_t PAGE_ALIGNMENT = 0x10000;
+
+        struct Resource
+        {
+            void* pMemory = nullptr;
+            size_t size = 0;
+        };
+
+        Resource Create(LinearAllocatorType, size_t sizeInBytes)
+        {
+            Resource resource;
+            resource.pMemory = ::operator new(sizeInBytes, std::align_val_t{ PAGE_ALIGNMENT });
+            resource.size = sizeInBytes;
+            return resource;
+        }
+
+        void Destroy(Resource& resource)
+        {
+            ::operator delete(resource.pMemory, std::align_val_t{ PAGE_ALIGNMENT });
+            resource = Resource{};
+        }
+
+        void* Map(Resource& resource)
+        {
+            return resource.pMemory;
+        }
+
+        void Unmap(Resource&)
+        { }
+
+        uint64_t GetGpuAddress(Resource& resource)
+        {
+            return reinterpret_cast<uint64_t>(resource.pMemory);
+        }
+    };
+
+    struct SimulatedFencePolicy
+    {
+        const SimulatedFence* pFence = nullptr;
+
+        bool IsFenceComplete(const uint64_t fenceValue) const
+        {
+            return pFence->isFenceComplete(fenceValue);
+        }
+    };
+
+    using HostDynAlloc = DynAllocT<HostMemoryBacking>;
+    using HostLinearAllocator = LinearAllocatorT<HostMemoryBacking, SimulatedFencePolicy>;
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bdr
+{
+    enum class JsonType : uint8_t
+    {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object,
+    };
+
+    struct JsonMember;
+
+    // A parsed JSON document, as a tree of values. Lookups that miss (wrong type, missing key, index out of
+    // range) return a null value rather than failing, so optional properties can be read with a default:
+    // `value["byteOffset"].getUint(0)`.
+    class JsonValue
+    {
+    public:
+        inline JsonType getType() const
+        {
+            return m_type;
+        }
+
+        inline bool isNull() const
+        {
+            return m_type == JsonType::Null;
+        }
+
+        inline bool isObject() const
+        {
+            return m_type == JsonType::Object;
+        }
+
+        inline bool isArray() const
+        {
+            return m_type == JsonType::Array;
+        }
+
+        inline bool getBool(const bool defaultValue = false) const
+        {
+            return m_type == JsonType::Bool ? m_bool : defaultValue;
+        }
+
+        inline double getNumber(const double defaultValue = 0.0) const
+        {
+            return m_type == JsonType::Number ? m_number : defaultValue;
+        }
+
+        // Negative and fractional numbers count as missing
+        uint32_t getUint(const uint32_t defaultValue = 0) const;
+        // For byte offsets and sizes, which can pass 4 GB
+        uint64_t getUint64(const uint64_t defaultValue = 0) const;
+
+        // Empty unless the value is a string
+        inline const std::string& getString() const
+        {
+            return m_string;
+        }
+
+        // Element count for arrays, member count for objects, 0 otherwise
+        size_t getSize() const;
+
+        const JsonValue& operator[](const size_t index) const;
+        const JsonValue& operator[](const std::string_view key) const;
+
+        inline const std::vector<JsonMember>& getMembers() const
+        {
+            return m_members;
+        }
+
+    private:
+        friend class JsonParser;
+
+        JsonType m_type = JsonType::Null;
+        bool m_bool = false;
+        double m_number = 0.0;
+        std::string m_string;
+        std::vector<JsonValue> m_elements;
+        std::vector<JsonMember> m_members;
+    };
+
+    struct JsonMember
+    {
+        std::string key;
+        JsonValue value;
+    };
+
+    // Parses `length` bytes of UTF-8 JSON, which don't need to be null terminated (e.g. a GLB chunk straight
+    // out of a mapped file). On failure returns false and describes the first error, with its byte offset, in
+    // `pError` if given.
+    bool parseJson(const char* pText, const size_t length, JsonValue& out, std::string* pError = nullptr);
+}
@@ -0,0 +1,76 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Author:  James Stanard 
+//
+// Additional modifications made by Bruno Opsenica
+//
+// D3D12 policies for the allocator in LinearAllocatorCore.h.  Pages are committed buffer resources and
+// retirement is keyed off the CommandQueueManager's fences.  Call LinearAllocator::InitAll once the device
+// and queues exist.
+
+#pragma once
+
+#include "LinearAllocatorCore.h"
+#include "CommandQueue.h"
+#include "GPUResource.h"
+
+namespace bdr
+{
+    struct D3D12PageBacking
+    {
+        using Resource = GPUResource;
+
+        Resource Create(LinearAllocatorType Type, size_t SizeInBytes);
+
+        void Destroy(Resource& Res)
+        {
+            Res.destroy();
+        }
+
+        void* Map(Resource& Res)
+        {
+            // DEFAULT heap pages are never CPU visible
+            if (Res.usageState != D3D12_RESOURCE_STATE_GENERIC_READ)
+                return nullptr;
+
+            void* CpuVirtualAddress = nullptr;
+            ASSERT_SUCCEEDED(Res->Map(0, nullptr, &CpuVirtualAddress));
+            return CpuVirtualAddress;
+        }
+
+        void Unmap(Resource& Res)
+        {
+            Res->Unmap(0, nullptr);
+        }
+
+        uint64_t GetGpuAddress(Resource& Res)
+        {
+            return Res.gpuVirtualAddress;
+        }
+
+        ID3D12Device* pDevice = nullptr;
+    };
+
+    struct D3D12FencePolicy
+    {
+        bool IsFenceComplete(uint64_t FenceValue) const
+        {
+            return pQueueManager->isFenceComplete(FenceValue);
+        }
+
+        CommandQueueManager* pQueueManager = nullptr;
+    };
+
+    using DynAlloc = DynAllocT<D3D12PageBacking>;
+    using LinearAllocationPage = LinearAllocationPageT<D3D12PageBacking>;
+    using LinearAllocatorPageManager = LinearAllocatorPageManagerT<D3D12PageBacking, D3D12FencePolicy>;
+    using LinearAllocator = LinearAllocatorT<D3D12PageBacking, D3D12FencePolicy>;
+}
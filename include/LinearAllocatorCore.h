@@ -0,0 +1,753 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Author:  James Stanard
+//
+// Description:  This is a dynamic graphics memory allocator for DX12.  It's designed to work in concert
+// with the CommandContext class and to do so in a thread-safe manner.  There may be many command contexts,
+// each with its own linear allocators.  They act as windows into a global memory pool by reserving a
+// context-local memory page.  Requesting a new page first consults a per-thread magazine of ready pages,
+// which needs no locking.  Only when the magazine runs dry is the manager's mutex taken to drain retired
+// pages and refill it.  Within a page, allocations are bumped with an atomic offset so a single
+// LinearAllocator may also be shared by several recording threads.
+//
+// When a command context is finished, it will receive a fence ID that indicates when it's safe to reclaim
+// used resources.  The CleanupUsedPages() method must be invoked at this time so that the used pages can be
+// scheduled for reuse after the fence has cleared.  Retired pages are kept per queue timeline (see
+// FenceValues.h), ordered by fence, so a page waiting on a slow queue never blocks pages from a fast one.
+//
+// Allocations larger than a page are carved out of big, reusable heaps with a TLSF allocator instead of
+// getting a resource of their own.  Their ranges are returned to the heap once their fence has passed.
+//
+// The pool no longer only grows: TrimIdle() should be called once per frame and releases free pages and empty
+// large heaps that went unused for a number of frames (or immediately, while over the per-type budget).
+// GetStats() reports current, peak and trimmed bytes.
+//
+// Additional modifications made by Bruno Opsenica
+//
+// The page and retirement logic is templated over two policies so it can run without a device:
+//
+//   BackingPolicy
+//       using Resource = ...;                                   // What a page owns
+//       Resource Create(LinearAllocatorType Type, size_t SizeInBytes);
+//       void Destroy(Resource& Res);
+//       void* Map(Resource& Res);                               // nullptr if not CPU visible
+//       void Unmap(Resource& Res);
+//       uint64_t GetGpuAddress(Resource& Res);
+//
+//   FencePolicy
+//       bool IsFenceComplete(uint64_t FenceValue) const;
+//
+// See LinearAllocator.h for the D3D12 policies and HostMemoryBacking.h for the headless ones.
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include <queue>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <functional>
+
+#include "MathCommon.h"
+#include "FenceValues.h"
+#include "TLSFAllocator.h"
+#include "MemoryStats.h"
+
+// Constant blocks must be multiples of 16 constants @ 16 bytes each
+#define DEFAULT_ALIGN 256
+
+namespace bdr
+{
+    enum LinearAllocatorType
+    {
+        kInvalidAllocator = -1,
+
+        kGpuExclusive = 0,        // DEFAULT   GPU-writeable (via UAV)
+        kCpuWritable = 1,        // UPLOAD CPU-writeable (but write combined)
+
+        kNumAllocatorTypes
+    };
+
+    enum
+    {
+        kGpuAllocatorPageSize = 0x10000,    // 64K
+        kCpuAllocatorPageSize = 0x200000    // 2MB
+    };
+
+    enum
+    {
+        kLargeHeapSize = 0x4000000,         // 64MB, or the allocation rounded up to a multiple of this
+        kLargeHeapGranularity = DEFAULT_ALIGN
+    };
+
+    enum
+    {
+        kPageMagazineSize = 8,      // Ready pages a thread may hold without touching the manager's lock
+        kPageMagazineRefill = 4     // Pages moved into a magazine per refill
+    };
+
+    struct LinearAllocatorStats
+    {
+        uint64_t CurrentBytes;      // Pages and large heaps currently held, in use or not
+        uint64_t PeakBytes;         // High-water mark of CurrentBytes
+        uint64_t TrimmedBytes;      // Total released by TrimIdle() so far
+        uint64_t BudgetBytes;       // 0 means unlimited
+    };
+
+    inline size_t GetDefaultPageSize(LinearAllocatorType Type)
+    {
+        return Type == kGpuExclusive ? kGpuAllocatorPageSize : kCpuAllocatorPageSize;
+    }
+
+    // Various types of allocations may contain NULL pointers.  Check before dereferencing if you are unsure.
+    template <typename BackingPolicy>
+    struct DynAllocT
+    {
+        using Resource = typename BackingPolicy::Resource;
+
+        DynAllocT(Resource& baseResource, size_t ThisOffset, size_t ThisSize)
+            : Buffer(baseResource), Offset(ThisOffset), Size(ThisSize), DataPtr(nullptr), GpuAddress(0)
+        { }
+
+        Resource& Buffer;       // The backing resource associated with this memory.
+        size_t Offset;          // Offset from start of buffer resource
+        size_t Size;            // Reserved size of this allocation
+        void* DataPtr;          // The CPU-writeable address
+        uint64_t GpuAddress;    // The GPU-visible address
+    };
+
+    template <typename BackingPolicy>
+    class LinearAllocationPageT
+    {
+    public:
+        using Resource = typename BackingPolicy::Resource;
+
+        static constexpr size_t kInvalidOffset = ~(size_t)0;
+
+        LinearAllocationPageT(BackingPolicy& Backing, LinearAllocatorType Type, size_t PageSize)
+            : m_Backing(Backing), m_Resource(Backing.Create(Type, PageSize)), m_PageSize(PageSize), m_Offset(0), m_LastUsedFrame(0)
+        {
+            m_GpuVirtualAddress = m_Backing.GetGpuAddress(m_Resource);
+            m_CpuVirtualAddress = m_Backing.Map(m_Resource);
+        }
+
+        ~LinearAllocationPageT()
+        {
+            Unmap();
+            m_Backing.Destroy(m_Resource);
+        }
+
+        LinearAllocationPageT(const LinearAllocationPageT&) = delete;
+        LinearAllocationPageT& operator=(const LinearAllocationPageT&) = delete;
+
+        void Map(void)
+        {
+            if (m_CpuVirtualAddress == nullptr) {
+                m_CpuVirtualAddress = m_Backing.Map(m_Resource);
+            }
+        }
+
+        void Unmap(void)
+        {
+            if (m_CpuVirtualAddress != nullptr) {
+                m_Backing.Unmap(m_Resource);
+                m_CpuVirtualAddress = nullptr;
+            }
+        }
+
+        // Bumps the page offset without locking.  Returns kInvalidOffset if the request does not fit, in which
+        // case the caller must turn over to a new page.
+        size_t Suballocate(size_t SizeInBytes, size_t Alignment)
+        {
+            size_t CurOffset = m_Offset.load(std::memory_order_relaxed);
+            size_t AlignedOffset;
+            do {
+                AlignedOffset = Math::AlignUp(CurOffset, Alignment);
+                if (AlignedOffset + SizeInBytes > m_PageSize)
+                    return kInvalidOffset;
+            } while (!m_Offset.compare_exchange_weak(CurOffset, AlignedOffset + SizeInBytes, std::memory_order_relaxed));
+
+            return AlignedOffset;
+        }
+
+        void ResetOffset(void)
+        {
+            m_Offset.store(0, std::memory_order_relaxed);
+        }
+
+        size_t GetSize(void) const
+        {
+            return m_PageSize;
+        }
+
+        BackingPolicy& m_Backing;
+        Resource m_Resource;
+        void* m_CpuVirtualAddress;
+        uint64_t m_GpuVirtualAddress;
+        const size_t m_PageSize;
+        std::atomic<size_t> m_Offset;
+        uint64_t m_LastUsedFrame;   // Frame the page last became available; only touched under the manager's lock
+    };
+
+    template <typename BackingPolicy, typename FencePolicy>
+    class LinearAllocatorPageManagerT
+    {
+    public:
+        using Page = LinearAllocationPageT<BackingPolicy>;
+
+        LinearAllocatorPageManagerT() : m_AllocationType(kInvalidAllocator), m_Generation(1), m_FrameIndex(0),
+            m_CurrentBytes(0), m_PeakBytes(0), m_TrimmedBytes(0), m_BudgetBytes(0), m_pStats(nullptr)
+        { }
+
+        void Init(LinearAllocatorType Type, const BackingPolicy& Backing, const FencePolicy& Fence)
+        {
+            std::lock_guard<std::mutex> LockGuard(m_Mutex);
+            assert(Type > kInvalidAllocator && Type < kNumAllocatorTypes);
+            m_AllocationType = Type;
+            m_Backing = Backing;
+            m_Fence = Fence;
+            m_pStats = MemoryStatsRegistry::get().getCategory(
+                Type == kGpuExclusive ? "LinearAllocator/GpuExclusive" : "LinearAllocator/CpuWritable");
+        }
+
+        Page* RequestPage(void);
+        Page* CreateNewPage(size_t PageSize = 0);
+
+        // Discarded pages will get recycled.  This is for fixed size pages.
+        void DiscardPages(uint64_t FenceID, const std::vector<Page*>& Pages);
+
+        struct LargeHeap
+        {
+            std::unique_ptr<Page> Memory;
+            TLSFAllocator Allocator;
+            uint64_t LastUsedFrame = 0;
+        };
+
+        struct LargeAllocation
+        {
+            LargeHeap* Heap;
+            TLSFAllocator::Allocation Range;
+        };
+
+        // Sub-allocates from an existing large heap, creating a new one only if none has room.
+        LargeAllocation AllocateLarge(size_t SizeInBytes, size_t Alignment);
+
+        // Freed ranges are returned to their heap once their fence has passed.
+        void FreeLarge(uint64_t FenceID, const std::vector<LargeAllocation>& Allocations);
+
+        void Destroy(void);
+
+        // Advances the manager's frame counter and releases free pages and empty large heaps that have been
+        // idle for at least IdleFrameLimit frames.  While over budget, idle resources are released regardless
+        // of age until the manager is back under it.  Pages parked in thread magazines are not considered.
+        void TrimIdle(uint32_t IdleFrameLimit);
+
+        void SetBudget(uint64_t BudgetBytes)
+        {
+            m_BudgetBytes.store(BudgetBytes, std::memory_order_relaxed);
+        }
+
+        LinearAllocatorStats GetStats(void) const
+        {
+            LinearAllocatorStats Stats;
+            Stats.CurrentBytes = m_CurrentBytes.load(std::memory_order_relaxed);
+            Stats.PeakBytes = m_PeakBytes.load(std::memory_order_relaxed);
+            Stats.TrimmedBytes = m_TrimmedBytes.load(std::memory_order_relaxed);
+            Stats.BudgetBytes = m_BudgetBytes.load(std::memory_order_relaxed);
+            return Stats;
+        }
+
+    private:
+
+        // A small per-thread stash of pages that are ready for immediate reuse.  Pages held here are still
+        // owned by m_PagePool; the generation lets a magazine notice that Destroy() has invalidated them.
+        struct PageMagazine
+        {
+            ~PageMagazine();
+
+            Page* Pages[kPageMagazineSize];
+            uint32_t Count = 0;
+            uint64_t Generation = 0;
+            LinearAllocatorPageManagerT* Owner = nullptr;
+        };
+
+        // Oldest fence on top.  One heap per queue timeline; within a timeline fences complete in order.
+        using RetiredPage = std::pair<uint64_t, Page*>;
+        using RetiredHeap = std::priority_queue<RetiredPage, std::vector<RetiredPage>, std::greater<RetiredPage> >;
+
+        struct PendingLargeFree
+        {
+            uint64_t FenceValue;
+            LargeAllocation Allocation;
+
+            bool operator>(const PendingLargeFree& Other) const
+            {
+                return FenceValue > Other.FenceValue;
+            }
+        };
+        using PendingLargeFreeHeap = std::priority_queue<PendingLargeFree, std::vector<PendingLargeFree>, std::greater<PendingLargeFree> >;
+
+        Page* RefillMagazine(PageMagazine& Magazine);
+        void ReclaimRetiredPages(void);
+        void ReclaimLargeAllocations(void);
+        void ReleasePage(Page* PagePtr);
+        bool IsOverBudget(void) const;
+
+        static thread_local PageMagazine t_Magazines[kNumAllocatorTypes];
+
+        LinearAllocatorType m_AllocationType;
+        BackingPolicy m_Backing;
+        FencePolicy m_Fence;
+        std::atomic<uint64_t> m_Generation;
+        std::vector<std::unique_ptr<Page> > m_PagePool;
+        RetiredHeap m_RetiredPages[MAX_FENCE_TIMELINES];
+        // Reused from the back (most recently freed, likely still warm) and trimmed from the front
+        std::deque<Page*> m_AvailablePages;
+        std::mutex m_Mutex;
+
+        // Kept apart from m_Mutex so large allocations don't stall page turnover
+        std::vector<std::unique_ptr<LargeHeap> > m_LargeHeaps;
+        PendingLargeFreeHeap m_PendingLargeFrees[MAX_FENCE_TIMELINES];
+        std::mutex m_LargeMutex;
+
+        std::atomic<uint64_t> m_FrameIndex;
+        std::atomic<uint64_t> m_CurrentBytes;
+        std::atomic<uint64_t> m_PeakBytes;
+        std::atomic<uint64_t> m_TrimmedBytes;
+        std::atomic<uint64_t> m_BudgetBytes;
+        MemoryStatsRegistry::Category* m_pStats;
+    };
+
+    template <typename BackingPolicy, typename FencePolicy>
+    class LinearAllocatorT
+    {
+    public:
+        using PageManager = LinearAllocatorPageManagerT<BackingPolicy, FencePolicy>;
+        using Page = LinearAllocationPageT<BackingPolicy>;
+        using LargeAllocation = typename PageManager::LargeAllocation;
+        using Allocation = DynAllocT<BackingPolicy>;
+
+        LinearAllocatorT(LinearAllocatorType Type) : m_AllocationType(Type), m_PageSize(0), m_CurPage(nullptr)
+        {
+            assert(Type > kInvalidAllocator && Type < kNumAllocatorTypes);
+            m_PageSize = GetDefaultPageSize(Type);
+        }
+
+        // Safe to call from several threads at once.  The common case is a lock-free bump within the current
+        // page; only page turnover takes this allocator's (not the page manager's) lock.
+        Allocation Allocate(size_t SizeInBytes, size_t Alignment = DEFAULT_ALIGN);
+
+        // Must not race with Allocate().
+        void CleanupUsedPages(uint64_t FenceID);
+
+        static void InitAll(const BackingPolicy& Backing, const FencePolicy& Fence)
+        {
+            for (int i = 0; i < kNumAllocatorTypes; ++i)
+                sm_PageManager[i].Init((LinearAllocatorType)i, Backing, Fence);
+        }
+
+        static void DestroyAll(void)
+        {
+            for (int i = 0; i < kNumAllocatorTypes; ++i)
+                sm_PageManager[i].Destroy();
+        }
+
+        // Call once per frame, after CleanupUsedPages
+        static void TrimIdleAll(uint32_t IdleFrameLimit)
+        {
+            for (int i = 0; i < kNumAllocatorTypes; ++i)
+                sm_PageManager[i].TrimIdle(IdleFrameLimit);
+        }
+
+        static void SetBudget(LinearAllocatorType Type, uint64_t BudgetBytes)
+        {
+            sm_PageManager[Type].SetBudget(BudgetBytes);
+        }
+
+        static LinearAllocatorStats GetStats(LinearAllocatorType Type)
+        {
+            return sm_PageManager[Type].GetStats();
+        }
+
+    private:
+
+        Allocation AllocateLarge(size_t SizeInBytes, size_t Alignment);
+
+        static PageManager sm_PageManager[kNumAllocatorTypes];
+
+        LinearAllocatorType m_AllocationType;
+        size_t m_PageSize;
+        std::atomic<Page*> m_CurPage;
+        std::mutex m_PageMutex;
+        std::vector<Page*> m_RetiredPages;
+        std::vector<LargeAllocation> m_LargeAllocations;
+    };
+
+    //
+    // LinearAllocatorPageManagerT
+    //
+
+    template <typename BackingPolicy, typename FencePolicy>
+    thread_local typename LinearAllocatorPageManagerT<BackingPolicy, FencePolicy>::PageMagazine
+        LinearAllocatorPageManagerT<BackingPolicy, FencePolicy>::t_Magazines[kNumAllocatorTypes];
+
+    template <typename BackingPolicy, typename FencePolicy>
+    LinearAllocatorPageManagerT<BackingPolicy, FencePolicy>::PageMagazine::~PageMagazine()
+    {
+        // Hand any unused pages back when the thread exits so they aren't stranded until Destroy()
+        if (Owner == nullptr || Count == 0)
+            return;
+
+        std::lock_guard<std::mutex> LockGuard(Owner->m_Mutex);
+        if (Generation != Owner->m_Generation.load(std::memory_order_relaxed))
+            return;
+
+        for (uint32_t i = 0; i < Count; ++i) {
+            Pages[i]->m_LastUsedFrame = Owner->m_FrameIndex.load(std::memory_order_relaxed);
+            Owner->m_AvailablePages.push_back(Pages[i]);
+        }
+        Count = 0;
+    }
+
+    template <typename BackingPolicy, typename FencePolicy>
+    typename LinearAllocatorPageManagerT<BackingPolicy, FencePolicy>::Page*
+        LinearAllocatorPageManagerT<BackingPolicy, FencePolicy>::RequestPage(void)
+    {
+        PageMagazine& Magazine = t_Magazines[m_AllocationType];
+
+        // Fast path: no lock, just pop a page this thread already owns
+        if (Magazine.Count > 0 && Magazine.Generation == m_Generation.load(std::memory_order_acquire)) {
+            Page* PagePtr = Magazine.Pages[--Magazine.Count];
+            PagePtr->ResetOffset();
+            return PagePtr;
+        }
+
+        return RefillMagazine(Magazine);
+    }
+
+    template <typename BackingPolicy, typename FencePolicy>
+    typename LinearAllocatorPageManagerT<BackingPolicy, FencePolicy>::Page*
+        LinearAllocatorPageManagerT<BackingPolicy, FencePolicy>::RefillMagazine(PageMagazine& Magazine)
+    {
+        {
+            std::lock_guard<std::mutex> LockGuard(m_Mutex);
+
+            const uint64_t Generation = m_Generation.load(std::memory_order_relaxed);
+            if (Magazine.Generation != Generation) {
+                // Anything left over belongs to a destroyed pool
+                Magazine.Count = 0;
+                Magazine.Generation = Generation;
+                Magazine.Owner = this;
+            }
+
+            ReclaimRetiredPages();
+
+            // Keep one page for the caller and stash a few more for the next turnovers
+            if (!m_AvailablePages.empty()) {
+                Page* PagePtr = m_AvailablePages.back();
+                m_AvailablePages.pop_back();
+
+                while (!m_AvailablePages.empty() && Magazine.Count < kPageMagazineRefill) {
+                    Magazine.Pages[Magazine.Count++] = m_AvailablePages.back();
+                    m_AvailablePages.pop_back();
+                }
+
+                PagePtr->ResetOffset();
+                return PagePtr;
+            }
+        }
+
+        // Nothing to recycle.  Create the page outside the lock so other threads can keep recycling.
+        Page* PagePtr = CreateNewPage();
+
+        std::lock_guard<std::mutex> LockGuard(m_Mutex);
+        m_PagePool.emplace_back(PagePtr);
+
+        return PagePtr;
+    }
+
+    template <typename BackingPolicy, typename FencePolicy>
+    void LinearAllocatorPageManagerT<BackingPolicy, FencePolicy>::ReclaimRetiredPages(void)
+    {
+        // Caller holds m_Mutex
+        for (uint32_t Timeline = 0; Timeline < MAX_FENCE_TIMELINES; ++Timeline) {
+            RetiredHeap& Retired = m_RetiredPages[Timeline];
+            while (!Retired.empty() && m_Fence.IsFenceComplete(Retired.top().first)) {
+                Page* PagePtr = Retired.top().second;
+                PagePtr->m_LastUsedFrame = m_FrameIndex.load(std::memory_order_relaxed);
+                m_AvailablePages.push_back(PagePtr);
+                Retired.pop();
+            }
+        }
+    }
+
+    template <typename BackingPolicy, typename FencePolicy>
+    void LinearAllocatorPageManagerT<BackingPolicy, FencePolicy>::DiscardPages(uint64_t FenceValue, const std::vector<Page*>& UsedPages)
+    {
+        std::lock_guard<std::mutex> LockGuard(m_Mutex);
+        RetiredHeap& Retired = m_RetiredPages[getFenceTimeline(FenceValue)];
+        for (auto iter = UsedPages.begin(); iter != UsedPages.end(); ++iter)
+            Retired.push(std::make_pair(FenceValue, *iter));
+    }
+
+    template <typename BackingPolicy, typename FencePolicy>
+    void LinearAllocatorPageManagerT<BackingPolicy, FencePolicy>::ReclaimLargeAllocations(void)
+    {
+        // Caller holds m_LargeMutex
+        for (uint32_t Timeline = 0; Timeline < MAX_FENCE_TIMELINES; ++Timeline) {
+            PendingLargeFreeHeap& Pending = m_PendingLargeFrees[Timeline];
+            while (!Pending.empty() && m_Fence.IsFenceComplete(Pending.top().FenceValue)) {
+                const LargeAllocation& Allocation = Pending.top().Allocation;
+                Allocation.Heap->Allocator.free(Allocation.Range);
+                Allocation.Heap->LastUsedFrame = m_FrameIndex.load(std::memory_order_relaxed);
+                Pending.pop();
+            }
+        }
+    }
+
+    template <typename BackingPolicy, typename FencePolicy>
+    typename LinearAllocatorPageManagerT<BackingPolicy, FencePolicy>::LargeAllocation
+        LinearAllocatorPageManagerT<BackingPolicy, FencePolicy>::AllocateLarge(size_t SizeInBytes, size_t Alignment)
+    {
+        {
+            std::lock_guard<std::mutex> LockGuard(m_LargeMutex);
+
+            ReclaimLargeAllocations();
+
+            for (auto& Heap : m_LargeHeaps) {
+                TLSFAllocator::Allocation Range = Heap->Allocator.allocate(SizeInBytes, Alignment);
+                if (Range.isValid()) {
+                    Heap->LastUsedFrame = m_FrameIndex.load(std::memory_order_relaxed);
+                    return LargeAllocation{ Heap.get(), Range };
+                }
+            }
+        }
+
+        // No heap has room.  Create the backing memory outside the lock, it is by far the slowest part.
+        const size_t HeapSize = Math::AlignUp(SizeInBytes, (size_t)kLargeHeapSize);
+        std::unique_ptr<LargeHeap> NewHeap(new LargeHeap);
+        NewHeap->Memory.reset(CreateNewPage(HeapSize));
+        NewHeap->Allocator.init(HeapSize, kLargeHeapGranularity);
+        NewHeap->LastUsedFrame = m_FrameIndex.load(std::memory_order_relaxed);
+
+        LargeAllocation Allocation{ NewHeap.get(), NewHeap->Allocator.allocate(SizeInBytes, Alignment) };
+        assert(Allocation.Range.isValid());
+
+        std::lock_guard<std::mutex> LockGuard(m_LargeMutex);
+        m_LargeHeaps.push_back(std::move(NewHeap));
+
+        return Allocation;
+    }
+
+    template <typename BackingPolicy, typename FencePolicy>
+    void LinearAllocatorPageManagerT<BackingPolicy, FencePolicy>::FreeLarge(uint64_t FenceValue, const std::vector<LargeAllocation>& Allocations)
+    {
+        std::lock_guard<std::mutex> LockGuard(m_LargeMutex);
+
+        ReclaimLargeAllocations();
+
+        PendingLargeFreeHeap& Pending = m_PendingLargeFrees[getFenceTimeline(FenceValue)];
+        for (auto iter = Allocations.begin(); iter != Allocations.end(); ++iter)
+            Pending.push(PendingLargeFree{ FenceValue, *iter });
+    }
+
+    template <typename BackingPolicy, typename FencePolicy>
+    typename LinearAllocatorPageManagerT<BackingPolicy, FencePolicy>::Page*
+        LinearAllocatorPageManagerT<BackingPolicy, FencePolicy>::CreateNewPage(size_t PageSize)
+    {
+        assert(m_AllocationType != kInvalidAllocator);
+        Page* PagePtr = new Page(m_Backing, m_AllocationType, PageSize == 0 ? GetDefaultPageSize(m_AllocationType) : PageSize);
+
+        const uint64_t CurrentBytes = m_CurrentBytes.fetch_add(PagePtr->GetSize(), std::memory_order_relaxed) + PagePtr->GetSize();
+        uint64_t PeakBytes = m_PeakBytes.load(std::memory_order_relaxed);
+        while (PeakBytes < CurrentBytes && !m_PeakBytes.compare_exchange_weak(PeakBytes, CurrentBytes, std::memory_order_relaxed)) {}
+        m_pStats->onAllocate(PagePtr->GetSize());
+
+        return PagePtr;
+    }
+
+    template <typename BackingPolicy, typename FencePolicy>
+    void LinearAllocatorPageManagerT<BackingPolicy, FencePolicy>::ReleasePage(Page* PagePtr)
+    {
+        m_CurrentBytes.fetch_sub(PagePtr->GetSize(), std::memory_order_relaxed);
+        m_TrimmedBytes.fetch_add(PagePtr->GetSize(), std::memory_order_relaxed);
+        m_pStats->onFree(PagePtr->GetSize());
+    }
+
+    template <typename BackingPolicy, typename FencePolicy>
+    bool LinearAllocatorPageManagerT<BackingPolicy, FencePolicy>::IsOverBudget(void) const
+    {
+        const uint64_t BudgetBytes = m_BudgetBytes.load(std::memory_order_relaxed);
+        return BudgetBytes != 0 && m_CurrentBytes.load(std::memory_order_relaxed) > BudgetBytes;
+    }
+
+    template <typename BackingPolicy, typename FencePolicy>
+    void LinearAllocatorPageManagerT<BackingPolicy, FencePolicy>::TrimIdle(uint32_t IdleFrameLimit)
+    {
+        const uint64_t FrameIndex = m_FrameIndex.fetch_add(1, std::memory_order_relaxed) + 1;
+
+        {
+            std::lock_guard<std::mutex> LockGuard(m_Mutex);
+
+            ReclaimRetiredPages();
+
+            // Pages are reused from the back, so the ones that have been idle longest sit at the front
+            while (!m_AvailablePages.empty()) {
+                Page* PagePtr = m_AvailablePages.front();
+                if (FrameIndex - PagePtr->m_LastUsedFrame < IdleFrameLimit && !IsOverBudget())
+                    break;
+
+                m_AvailablePages.pop_front();
+                ReleasePage(PagePtr);
+                for (auto iter = m_PagePool.begin(); iter != m_PagePool.end(); ++iter) {
+                    if (iter->get() == PagePtr) {
+                        std::swap(*iter, m_PagePool.back());
+                        m_PagePool.pop_back();
+                        break;
+                    }
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> LockGuard(m_LargeMutex);
+
+        ReclaimLargeAllocations();
+
+        for (size_t i = 0; i < m_LargeHeaps.size();) {
+            LargeHeap& Heap = *m_LargeHeaps[i];
+            if (Heap.Allocator.isEmpty() && (FrameIndex - Heap.LastUsedFrame >= IdleFrameLimit || IsOverBudget())) {
+                ReleasePage(Heap.Memory.get());
+                std::swap(m_LargeHeaps[i], m_LargeHeaps.back());
+                m_LargeHeaps.pop_back();
+            }
+            else {
+                ++i;
+            }
+        }
+    }
+
+    template <typename BackingPolicy, typename FencePolicy>
+    void LinearAllocatorPageManagerT<BackingPolicy, FencePolicy>::Destroy(void)
+    {
+        std::lock_guard<std::mutex> LockGuard(m_Mutex);
+
+        // Invalidate every thread's magazine before the pages they point to go away
+        m_Generation.fetch_add(1, std::memory_order_release);
+
+        for (uint32_t Timeline = 0; Timeline < MAX_FENCE_TIMELINES; ++Timeline)
+            m_RetiredPages[Timeline] = {};
+
+        std::lock_guard<std::mutex> LargeLockGuard(m_LargeMutex);
+
+        if (m_pStats != nullptr)
+            m_pStats->onFree(m_CurrentBytes.load(std::memory_order_relaxed), m_PagePool.size() + m_LargeHeaps.size());
+
+        m_AvailablePages = {};
+        m_PagePool.clear();
+        m_CurrentBytes.store(0, std::memory_order_relaxed);
+
+        for (uint32_t Timeline = 0; Timeline < MAX_FENCE_TIMELINES; ++Timeline)
+            m_PendingLargeFrees[Timeline] = {};
+        m_LargeHeaps.clear();
+    }
+
+    //
+    // LinearAllocatorT
+    //
+
+    template <typename BackingPolicy, typename FencePolicy>
+    typename LinearAllocatorT<BackingPolicy, FencePolicy>::PageManager
+        LinearAllocatorT<BackingPolicy, FencePolicy>::sm_PageManager[kNumAllocatorTypes];
+
+    template <typename BackingPolicy, typename FencePolicy>
+    void LinearAllocatorT<BackingPolicy, FencePolicy>::CleanupUsedPages(uint64_t FenceID)
+    {
+        std::lock_guard<std::mutex> LockGuard(m_PageMutex);
+
+        // Large allocations must be released even if no regular page was ever requested
+        Page* CurPage = m_CurPage.exchange(nullptr, std::memory_order_acq_rel);
+        if (CurPage != nullptr)
+            m_RetiredPages.push_back(CurPage);
+
+        sm_PageManager[m_AllocationType].DiscardPages(FenceID, m_RetiredPages);
+        m_RetiredPages.clear();
+
+        sm_PageManager[m_AllocationType].FreeLarge(FenceID, m_LargeAllocations);
+        m_LargeAllocations.clear();
+    }
+
+    template <typename BackingPolicy, typename FencePolicy>
+    typename LinearAllocatorT<BackingPolicy, FencePolicy>::Allocation
+        LinearAllocatorT<BackingPolicy, FencePolicy>::AllocateLarge(size_t SizeInBytes, size_t Alignment)
+    {
+        LargeAllocation Large = sm_PageManager[m_AllocationType].AllocateLarge(SizeInBytes, Alignment);
+
+        {
+            std::lock_guard<std::mutex> LockGuard(m_PageMutex);
+            m_LargeAllocations.push_back(Large);
+        }
+
+        Page* Heap = Large.Heap->Memory.get();
+        const size_t Offset = (size_t)Large.Range.offset;
+
+        Allocation ret(Heap->m_Resource, Offset, SizeInBytes);
+        ret.DataPtr = Heap->m_CpuVirtualAddress == nullptr ? nullptr : (uint8_t*)Heap->m_CpuVirtualAddress + Offset;
+        ret.GpuAddress = Heap->m_GpuVirtualAddress + Offset;
+
+        return ret;
+    }
+
+    template <typename BackingPolicy, typename FencePolicy>
+    typename LinearAllocatorT<BackingPolicy, FencePolicy>::Allocation
+        LinearAllocatorT<BackingPolicy, FencePolicy>::Allocate(size_t SizeInBytes, size_t Alignment)
+    {
+        const size_t AlignmentMask = Alignment - 1;
+
+        // Assert that it's a power of two.
+        assert((AlignmentMask & Alignment) == 0);
+
+        // Align the allocation
+        const size_t AlignedSize = Math::AlignUpWithMask(SizeInBytes, AlignmentMask);
+
+        if (AlignedSize > m_PageSize)
+            return AllocateLarge(AlignedSize, Alignment);
+
+        for (;;) {
+            Page* CurPage = m_CurPage.load(std::memory_order_acquire);
+
+            if (CurPage != nullptr) {
+                const size_t Offset = CurPage->Suballocate(AlignedSize, Alignment);
+
+                if (Offset != Page::kInvalidOffset) {
+                    Allocation ret(CurPage->m_Resource, Offset, AlignedSize);
+                    ret.DataPtr = CurPage->m_CpuVirtualAddress == nullptr ? nullptr : (uint8_t*)CurPage->m_CpuVirtualAddress + Offset;
+                    ret.GpuAddress = CurPage->m_GpuVirtualAddress + Offset;
+                    return ret;
+                }
+            }
+
+            // The page is full (or we never had one).  Only one thread turns it over; the others retry
+            // against whatever page it installs.
+            std::lock_guard<std::mutex> LockGuard(m_PageMutex);
+
+            if (m_CurPage.load(std::memory_order_relaxed) != CurPage)
+                continue;
+
+            if (CurPage != nullptr)
+                m_RetiredPages.push_back(CurPage);
+
+            m_CurPage.store(sm_PageManager[m_AllocationType].RequestPage(), std::memory_order_release);
+        }
+    }
+}
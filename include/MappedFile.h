@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+
+namespace bdr
+{
+    // How a mapping is going to be read, passed on to the OS so it can size its read-ahead
+    enum class FileAccessHint : uint8_t
+    {
+        Normal,
+        // Read front to back once, e.g. parsing or uploading a whole file
+        Sequential,
+        // Jumping around, e.g. pulling individual chunks out of an archive
+        Random,
+    };
+
+    // A read-only view of a whole file, mapped with MapViewOfFile on Windows and mmap elsewhere. Nothing is read
+    // up front: pages fault in from the page cache as they're touched, so uploads can copy straight from the
+    // view into staging memory without an intermediate heap buffer. Sizes are 64 bit.
+    //
+    // The view is unmapped when the object is destroyed; file handles are closed as soon as the view exists.
+    // Empty files open successfully with a null view.
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        // Returns false if the file couldn't be opened or mapped; the previous view, if any, is closed either way
+        bool open(const std::filesystem::path& path, const FileAccessHint hint = FileAccessHint::Sequential);
+        void close();
+
+        // Asks the OS to start reading [offset, offset + size) in the background, so a scan that reaches it
+        // doesn't stall on page faults. Only a hint; the range is clamped to the file.
+        void prefetch(const uint64_t offset, const uint64_t size) const;
+
+        inline bool isOpen() const
+        {
+            return m_isOpen;
+        }
+
+        inline const uint8_t* getData() const
+        {
+            return m_pData;
+        }
+
+        inline uint64_t getSize() const
+        {
+            return m_size;
+        }
+
+    private:
+        const uint8_t* m_pData = nullptr;
+        uint64_t m_size = 0;
+        bool m_isOpen = false;
+    };
+}
@@ -0,0 +1,56 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Author:  James Stanard 
+//
+// Trimmed down to the integer helpers we use; no DirectXMath dependency so it can be used headless.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Math
+{
+    template <typename T> inline T AlignUpWithMask(T value, size_t mask)
+    {
+        return (T)(((size_t)value + mask) & ~mask);
+    }
+
+    template <typename T> inline T AlignDownWithMask(T value, size_t mask)
+    {
+        return (T)((size_t)value & ~mask);
+    }
+
+    template <typename T> inline T AlignUp(T value, size_t alignment)
+    {
+        return AlignUpWithMask(value, alignment - 1);
+    }
+
+    template <typename T> inline T AlignDown(T value, size_t alignment)
+    {
+        return AlignDownWithMask(value, alignment - 1);
+    }
+
+    template <typename T> inline bool IsAligned(T value, size_t alignment)
+    {
+        return 0 == ((size_t)value & (alignment - 1));
+    }
+
+    template <typename T> inline T DivideByMultiple(T value, size_t alignment)
+    {
+        return (T)((value + alignment - 1) / alignment);
+    }
+
+    template <typename T> inline bool IsPowerOfTwo(T value)
+    {
+        return 0 == (value & (value - 1));
+    }
+}
@@ -0,0 +1,203 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace bdr
+{
+    // Process wide registry that anything owning GPU (or GPU visible) memory reports into. Each owner grabs a
+    // category once and calls `onAllocate`/`onFree` whenever it creates or releases backing memory; those
+    // calls are lock free. `endFrame` is called once per frame to roll the per-frame and per-second counters.
+    //
+    // Bytes are what the owner holds from the device, not what it has handed out, so a pooled allocator counts
+    // its pages rather than every sub-allocation. Owners that can't know the size (command allocators) report 0.
+    class MemoryStatsRegistry
+    {
+    public:
+        class Category
+        {
+        public:
+            Category(const std::string& name) : m_name{ name }
+            { }
+
+            void onAllocate(const uint64_t bytes, const uint64_t count = 1)
+            {
+                const uint64_t liveBytes = m_liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+                uint64_t peakBytes = m_peakBytes.load(std::memory_order_relaxed);
+                while (peakBytes < liveBytes && !m_peakBytes.compare_exchange_weak(peakBytes, liveBytes, std::memory_order_relaxed)) {}
+
+                m_liveAllocations.fetch_add(count, std::memory_order_relaxed);
+                m_totalAllocations.fetch_add(count, std::memory_order_relaxed);
+            }
+
+            void onFree(const uint64_t bytes, const uint64_t count = 1)
+            {
+                m_liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+                m_liveAllocations.fetch_sub(count, std::memory_order_relaxed);
+            }
+
+            inline const std::string& getName() const
+            {
+                return m_name;
+            }
+
+        private:
+            friend class MemoryStatsRegistry;
+
+            const std::string m_name;
+            std::atomic<uint64_t> m_liveBytes{ 0 };
+            std::atomic<uint64_t> m_peakBytes{ 0 };
+            std::atomic<uint64_t> m_liveAllocations{ 0 };
+            std::atomic<uint64_t> m_totalAllocations{ 0 };
+
+            // Only touched by endFrame, under the registry's lock
+            uint64_t m_totalAtFrameStart = 0;
+            uint64_t m_allocationsLastFrame = 0;
+            uint64_t m_totalAtRateStart = 0;
+            double m_allocationsPerSecond = 0.0;
+        };
+
+        struct Snapshot
+        {
+            std::string name;
+            uint64_t liveBytes;
+            uint64_t peakBytes;
+            uint64_t liveAllocations;
+            uint64_t totalAllocations;
+            uint64_t allocationsLastFrame;
+            double allocationsPerSecond;
+        };
+
+        using Clock = std::chrono::steady_clock;
+
+        // Owners report into the process wide instance from `get`; separate registries are for tests and tools
+        MemoryStatsRegistry() = default;
+        MemoryStatsRegistry(const MemoryStatsRegistry&) = delete;
+        MemoryStatsRegistry& operator=(const MemoryStatsRegistry&) = delete;
+
+        static MemoryStatsRegistry& get()
+        {
+            static MemoryStatsRegistry s_registry;
+            return s_registry;
+        }
+
+        // Returns the category with this name, creating it on first use. The pointer stays valid for the life
+        // of the registry, so owners should look it up once rather than on every allocation.
+        Category* getCategory(const std::string& name)
+        {
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+            for (Category& category : m_categories) {
+                if (category.m_name == name) {
+                    return &category;
+                }
+            }
+            m_categories.emplace_back(name);
+            return &m_categories.back();
+        }
+
+        // Allocations per second are averaged over windows of at least a second
+        void endFrame(const Clock::time_point now = Clock::now())
+        {
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+
+            if (m_frameCount == 0) {
+                m_rateStart = now;
+            }
+            m_frameCount++;
+
+            const double elapsed = std::chrono::duration<double>(now - m_rateStart).count();
+            const bool updateRate = elapsed >= 1.0;
+
+            for (Category& category : m_categories) {
+                const uint64_t total = category.m_totalAllocations.load(std::memory_order_relaxed);
+                category.m_allocationsLastFrame = total - category.m_totalAtFrameStart;
+                category.m_totalAtFrameStart = total;
+
+                if (updateRate) {
+                    category.m_allocationsPerSecond = double(total - category.m_totalAtRateStart) / elapsed;
+                    category.m_totalAtRateStart = total;
+                }
+            }
+
+            if (updateRate) {
+                m_rateStart = now;
+            }
+        }
+
+        std::vector<Snapshot> getSnapshots() const
+        {
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+
+            std::vector<Snapshot> snapshots;
+            snapshots.reserve(m_categories.size());
+            for (const Category& category : m_categories) {
+                Snapshot snapshot;
+                snapshot.name = category.m_name;
+                snapshot.liveBytes = category.m_liveBytes.load(std::memory_order_relaxed);
+                snapshot.peakBytes = category.m_peakBytes.load(std::memory_order_relaxed);
+                snapshot.liveAllocations = category.m_liveAllocations.load(std::memory_order_relaxed);
+                snapshot.totalAllocations = category.m_totalAllocations.load(std::memory_order_relaxed);
+                snapshot.allocationsLastFrame = category.m_allocationsLastFrame;
+                snapshot.allocationsPerSecond = category.m_allocationsPerSecond;
+                snapshots.push_back(snapshot);
+            }
+            return snapshots;
+        }
+
+        inline uint64_t getFrameCount() const
+        {
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+            return m_frameCount;
+        }
+
+        // {"frames": N, "categories": [{"name": ..., "liveBytes": ..., ...}, ...]}
+        void writeJson(std::ostream& out) const
+        {
+            const std::vector<Snapshot> snapshots = getSnapshots();
+
+            out << "{\n  \"frames\": " << getFrameCount() << ",\n  \"categories\": [";
+            for (size_t i = 0; i < snapshots.size(); i++) {
+                const Snapshot& snapshot = snapshots[i];
+                out << (i == 0 ? "\n" : ",\n");
+                out << "    { \"name\": \"";
+                writeEscaped(out, snapshot.name);
+                out << "\", \"liveBytes\": " << snapshot.liveBytes
+                    << ", \"peakBytes\": " << snapshot.peakBytes
+                    << ", \"liveAllocations\": " << snapshot.liveAllocations
+                    << ", \"totalAllocations\": " << snapshot.totalAllocations
+                    << ", \"allocationsLastFrame\": " << snapshot.allocationsLastFrame
+                    << ", \"allocationsPerSecond\": " << snapshot.allocationsPerSecond
+                    << " }";
+            }
+            out << (snapshots.empty() ? "]\n}\n" : "\n  ]\n}\n");
+        }
+
+    private:
+        static void writeEscaped(std::ostream& out, const std::string& str)
+        {
+            for (const char c : str) {
+                if (c == '"' || c == '\\') {
+                    out << '\\' << c;
+                }
+                else if (uint8_t(c) < 0x20) {
+                    const char* hex = "0123456789abcdef";
+                    out << "\\u00" << hex[(c >> 4) & 0xf] << hex[c & 0xf];
+                }
+                else {
+                    out << c;
+                }
+            }
+        }
+
+        mutable std::mutex m_mutex;
+        // A deque so category pointers stay valid as more are added
+        std::deque<Category> m_categories;
+        uint64_t m_frameCount = 0;
+        Clock::time_point m_rateStart;
+    };
+}
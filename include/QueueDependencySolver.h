@@ -0,0 +1,184 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "FenceValues.h"
+
+namespace bdr
+{
+    // Works out which cross-queue waits a submission actually needs. Dependencies are plain fence values from
+    // any queue (the timeline is encoded in the value, see FenceValues.h).
+    //
+    // Every timeline keeps a vector clock: for each other timeline, the highest fence value it has already
+    // waited on, directly or through a queue it waited on. Each recorded submission stores a copy of its
+    // queue's clock, so waiting on that submission also inherits everything it waited for. A dependency is
+    // dropped if it has completed, if the queue's clock already covers it, or if another wait being inserted
+    // covers it (transitive reduction). What's left is at most one wait per other timeline, on the highest
+    // value needed.
+    //
+    // Submissions made without going through the solver are fine: a lookup falls back to the newest recorded
+    // submission at or before the value, whose clock can only be smaller, so the worst case is a redundant wait.
+    class QueueDependencySolver
+    {
+    public:
+        struct Wait
+        {
+            uint32_t timeline;
+            uint64_t fenceValue;
+        };
+
+        QueueDependencySolver()
+        {
+            for (uint32_t i = 0; i < MAX_FENCE_TIMELINES; i++) {
+                for (uint32_t j = 0; j < MAX_FENCE_TIMELINES; j++) {
+                    m_clocks[i].values[j] = getFenceTimelineBase(j);
+                }
+            }
+        }
+
+        // Fills `outWaits` (room for MAX_FENCE_TIMELINES) with the waits `timeline` must insert before its
+        // next submission and returns how many. The waits are assumed to be inserted: call `recordSubmission`
+        // with the submission's fence once it's made, and keep resolve, the waits and the submit together
+        // under the caller's own per-queue ordering. `getCompletedFenceValue(uint32_t timeline)` lets
+        // dependencies that have already finished be skipped; it may return a stale value.
+        template <typename GetCompletedFenceValue>
+        uint32_t resolve(
+            const uint32_t timeline,
+            const uint64_t* dependencies,
+            const uint32_t dependencyCount,
+            GetCompletedFenceValue&& getCompletedFenceValue,
+            Wait* outWaits)
+        {
+            assert(timeline < MAX_FENCE_TIMELINES);
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+            Clock& clock = m_clocks[timeline];
+
+            // Highest value needed per timeline, skipping what this queue already knows about
+            uint64_t needed[MAX_FENCE_TIMELINES];
+            bool isNeeded[MAX_FENCE_TIMELINES] = {};
+            for (uint32_t i = 0; i < dependencyCount; i++) {
+                const uint64_t fenceValue = dependencies[i];
+                const uint32_t dependencyTimeline = getFenceTimeline(fenceValue);
+                assert(dependencyTimeline < MAX_FENCE_TIMELINES);
+                // Same queue work is already ordered
+                if (dependencyTimeline == timeline || fenceValue <= clock.values[dependencyTimeline]) {
+                    continue;
+                }
+                if (!isNeeded[dependencyTimeline] || fenceValue > needed[dependencyTimeline]) {
+                    needed[dependencyTimeline] = fenceValue;
+                    isNeeded[dependencyTimeline] = true;
+                }
+            }
+
+            for (uint32_t i = 0; i < MAX_FENCE_TIMELINES; i++) {
+                if (isNeeded[i] && needed[i] <= getCompletedFenceValue(i)) {
+                    isNeeded[i] = false;
+                    // Finished work is visible to every queue
+                    clock.values[i] = std::max(clock.values[i], needed[i]);
+                }
+            }
+
+            // Drop any wait that another wait already implies
+            const Clock* pImplied[MAX_FENCE_TIMELINES] = {};
+            for (uint32_t i = 0; i < MAX_FENCE_TIMELINES; i++) {
+                if (isNeeded[i]) {
+                    pImplied[i] = findSubmissionClock(i, needed[i]);
+                }
+            }
+            for (uint32_t i = 0; i < MAX_FENCE_TIMELINES; i++) {
+                if (!isNeeded[i]) {
+                    continue;
+                }
+                for (uint32_t j = 0; j < MAX_FENCE_TIMELINES; j++) {
+                    if (j != i && isNeeded[j] && pImplied[j] != nullptr && pImplied[j]->values[i] >= needed[i]) {
+                        isNeeded[i] = false;
+                        break;
+                    }
+                }
+            }
+
+            uint32_t waitCount = 0;
+            for (uint32_t i = 0; i < MAX_FENCE_TIMELINES; i++) {
+                if (!isNeeded[i]) {
+                    continue;
+                }
+                outWaits[waitCount++] = Wait{ i, needed[i] };
+
+                clock.values[i] = std::max(clock.values[i], needed[i]);
+                if (pImplied[i] != nullptr) {
+                    for (uint32_t j = 0; j < MAX_FENCE_TIMELINES; j++) {
+                        clock.values[j] = std::max(clock.values[j], pImplied[i]->values[j]);
+                    }
+                }
+            }
+            return waitCount;
+        }
+
+        // Records that a submission on the fence's timeline was made after the waits from the last resolve
+        void recordSubmission(const uint64_t fenceValue)
+        {
+            const uint32_t timeline = getFenceTimeline(fenceValue);
+            assert(timeline < MAX_FENCE_TIMELINES);
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+
+            Clock& clock = m_clocks[timeline];
+            clock.values[timeline] = fenceValue;
+
+            std::vector<Submission>& submissions = m_submissions[timeline];
+            assert(submissions.empty() || submissions.back().fenceValue < fenceValue);
+            submissions.push_back(Submission{ fenceValue, clock });
+        }
+
+        // Forgets submissions that no longer matter: anything up to `completedFenceValue` on its timeline is
+        // skipped by resolve anyway, apart from the newest of them, which still serves as a lower bound.
+        void prune(const uint64_t completedFenceValue)
+        {
+            const uint32_t timeline = getFenceTimeline(completedFenceValue);
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+
+            std::vector<Submission>& submissions = m_submissions[timeline];
+            auto it = std::upper_bound(submissions.begin(), submissions.end(), completedFenceValue, isBeforeSubmission);
+            if (it != submissions.begin()) {
+                submissions.erase(submissions.begin(), it - 1);
+            }
+        }
+
+        inline size_t getRecordedSubmissionCount(const uint32_t timeline) const
+        {
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+            return m_submissions[timeline].size();
+        }
+
+    private:
+        struct Clock
+        {
+            uint64_t values[MAX_FENCE_TIMELINES];
+        };
+
+        struct Submission
+        {
+            uint64_t fenceValue;
+            Clock clock;
+        };
+
+        static bool isBeforeSubmission(const uint64_t fenceValue, const Submission& submission)
+        {
+            return fenceValue < submission.fenceValue;
+        }
+
+        // Clock of the newest recorded submission at or before `fenceValue`, nullptr if there is none
+        const Clock* findSubmissionClock(const uint32_t timeline, const uint64_t fenceValue) const
+        {
+            const std::vector<Submission>& submissions = m_submissions[timeline];
+            auto it = std::upper_bound(submissions.begin(), submissions.end(), fenceValue, isBeforeSubmission);
+            return it == submissions.begin() ? nullptr : &(it - 1)->clock;
+        }
+
+        mutable std::mutex m_mutex;
+        Clock m_clocks[MAX_FENCE_TIMELINES];
+        std::vector<Submission> m_submissions[MAX_FENCE_TIMELINES];
+    };
+}
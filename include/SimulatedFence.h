@@ -0,0 +1,94 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include "FenceValues.h"
+
+namespace bdr
+{
+    // A CPU-only stand-in for the per-queue ID3D12Fences owned by CommandQueueManager. Values follow the same
+    // (timeline << FENCE_QUEUE_SHIFT) encoding, so code written against fence values can be driven without a
+    // device: hand out values with `incrementFence` and "finish the GPU work" with `complete`.
+    class SimulatedFence
+    {
+    public:
+        SimulatedFence()
+        {
+            for (uint32_t i = 0; i < MAX_FENCE_TIMELINES; i++) {
+                m_nextValues[i].store(getFenceTimelineBase(i) + 1);
+                m_completedValues[i].store(getFenceTimelineBase(i));
+            }
+        }
+
+        uint64_t incrementFence(const uint32_t timeline)
+        {
+            return m_nextValues[timeline].fetch_add(1);
+        }
+
+        uint64_t getNextFenceValue(const uint32_t timeline) const
+        {
+            return m_nextValues[timeline].load();
+        }
+
+        // Marks everything up to and including `fenceValue` on its timeline as done. Never moves backwards.
+        void complete(const uint64_t fenceValue)
+        {
+            std::atomic<uint64_t>& completed = m_completedValues[getFenceTimeline(fenceValue)];
+            uint64_t current = completed.load(std::memory_order_relaxed);
+            while (current < fenceValue && !completed.compare_exchange_weak(current, fenceValue, std::memory_order_release)) {}
+
+            // Taking the lock orders this against a waiter that has just checked its targets
+            std::lock_guard<std::mutex> lockGuard{ m_waitMutex };
+            m_waitCondition.notify_all();
+        }
+
+        void completeAll(const uint32_t timeline)
+        {
+            complete(m_nextValues[timeline].load() - 1);
+        }
+
+        uint64_t getCompletedFenceValue(const uint32_t timeline) const
+        {
+            return m_completedValues[timeline].load(std::memory_order_acquire);
+        }
+
+        bool isFenceComplete(const uint64_t fenceValue) const
+        {
+            return getCompletedFenceValue(getFenceTimeline(fenceValue)) >= fenceValue;
+        }
+
+        // Blocks until some timeline reaches its entry in `targets` (MAX_FENCE_TIMELINES values, UINT64_MAX for
+        // timelines that aren't waited on) or until `wake` is called. A `wake` with nobody waiting is kept for
+        // the next call, like an auto-reset event.
+        void waitForAny(const uint64_t* targets)
+        {
+            std::unique_lock<std::mutex> lock{ m_waitMutex };
+            m_waitCondition.wait(lock, [&]() {
+                for (uint32_t i = 0; i < MAX_FENCE_TIMELINES; i++) {
+                    if (targets[i] != UINT64_MAX && getCompletedFenceValue(i) >= targets[i]) {
+                        return true;
+                    }
+                }
+                return m_isWakePending;
+            });
+            m_isWakePending = false;
+        }
+
+        void wake()
+        {
+            std::lock_guard<std::mutex> lockGuard{ m_waitMutex };
+            m_isWakePending = true;
+            m_waitCondition.notify_all();
+        }
+
+    private:
+        std::atomic<uint64_t> m_nextValues[MAX_FENCE_TIMELINES];
+        std::atomic<uint64_t> m_completedValues[MAX_FENCE_TIMELINES];
+
+        std::mutex m_waitMutex;
+        std::condition_variable m_waitCondition;
+        bool m_isWakePending = false;
+    };
+}
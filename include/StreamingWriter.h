@@ -0,0 +1,200 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+#include <emmintrin.h>
+
+#include "MathCommon.h"
+#include "LinearAllocatorCore.h"
+
+// Defined in Utils.cpp
+void SIMDMemCopy(void* __restrict Dest, const void* __restrict Source, size_t NumQuadwords);
+
+// Non-sequential writes (seeking backwards) assert when this is enabled
+#ifndef STREAMING_WRITER_CHECKS
+#if defined(NDEBUG)
+#define STREAMING_WRITER_CHECKS 0
+#else
+#define STREAMING_WRITER_CHECKS 1
+#endif
+#endif
+
+namespace bdr
+{
+    // Appends data to write-combined (UPLOAD heap) memory with non-temporal stores. Small writes are gathered
+    // into a cache line on the stack and only go out once the line is full, so the destination sees each line
+    // written once, front to back, in whole 16 byte stores. Writes of a line or more that start on a line
+    // boundary skip the staging line and are streamed straight out, through SIMDMemCopy when they're large.
+    // The destination is never read.
+    //
+    // Only the first and last lines of the range, or lines that are `flush`ed early, can end up partially
+    // written. Call `flush` (or let the writer go out of scope) before the GPU consumes the data.
+    class StreamingWriter
+    {
+    public:
+        static constexpr size_t CACHE_LINE_SIZE = 64;
+        // Bulk writes at least this large go through SIMDMemCopy
+        static constexpr size_t SIMD_MEMCOPY_MIN_SIZE = 4096;
+
+        StreamingWriter(void* pDest, const size_t capacity) :
+            m_pDest{ reinterpret_cast<uint8_t*>(pDest) },
+            m_capacity{ capacity }
+        {
+            assert(pDest != nullptr);
+            seekLine(0);
+        }
+
+        template <typename BackingPolicy>
+        explicit StreamingWriter(const DynAllocT<BackingPolicy>& allocation) :
+            StreamingWriter{ allocation.DataPtr, allocation.Size }
+        { }
+
+        ~StreamingWriter()
+        {
+            flush();
+        }
+
+        StreamingWriter(const StreamingWriter&) = delete;
+        StreamingWriter& operator=(const StreamingWriter&) = delete;
+
+        template <typename T>
+        inline void write(const T& value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be streamed");
+            write(&value, sizeof(T));
+        }
+
+        template <typename T>
+        inline void writeArray(const T* pValues, const size_t count)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be streamed");
+            write(pValues, sizeof(T) * count);
+        }
+
+        void write(const void* pData, size_t size)
+        {
+            assert(getOffset() + size <= m_capacity);
+            const uint8_t* pSrc = reinterpret_cast<const uint8_t*>(pData);
+
+            while (size > 0) {
+                if (m_lineEnd == 0 && size >= CACHE_LINE_SIZE) {
+                    const size_t bulkSize = Math::AlignDown(size, CACHE_LINE_SIZE);
+                    streamLines(m_pLine, pSrc, bulkSize);
+                    m_pLine += bulkSize;
+                    pSrc += bulkSize;
+                    size -= bulkSize;
+                    continue;
+                }
+
+                const size_t count = std::min(CACHE_LINE_SIZE - m_lineEnd, size);
+                memcpy(m_line + m_lineEnd, pSrc, count);
+                m_lineEnd += count;
+                pSrc += count;
+                size -= count;
+
+                if (m_lineEnd == CACHE_LINE_SIZE) {
+                    storeLine();
+                    m_pLine += CACHE_LINE_SIZE;
+                    m_lineBegin = 0;
+                    m_lineEnd = 0;
+                }
+            }
+        }
+
+        // Moves the write position. Going forward is fine (the gap is left untouched) but going backwards
+        // rewrites lines that have already been streamed out, which defeats write combining.
+        void seek(const size_t offset)
+        {
+        #if STREAMING_WRITER_CHECKS
+            assert(offset >= getOffset() && "Non-sequential write to write-combined memory");
+        #endif
+            assert(offset <= m_capacity);
+            storeLine();
+            seekLine(offset);
+        }
+
+        // Writes out the partially filled line and fences the non-temporal stores
+        void flush()
+        {
+            storeLine();
+            m_lineBegin = m_lineEnd;
+            _mm_sfence();
+        }
+
+        inline size_t getOffset() const
+        {
+            return size_t(m_pLine + m_lineEnd - m_pDest);
+        }
+
+        inline size_t getCapacity() const
+        {
+            return m_capacity;
+        }
+
+    private:
+        void seekLine(const size_t offset)
+        {
+            uint8_t* pAddress = m_pDest + offset;
+            m_pLine = Math::AlignDown(pAddress, CACHE_LINE_SIZE);
+            m_lineBegin = size_t(pAddress - m_pLine);
+            m_lineEnd = m_lineBegin;
+        }
+
+        // Streams the valid part of the staging line, [m_lineBegin, m_lineEnd), to its destination line. Only
+        // the 16 byte chunks that are entirely valid can be streamed, the edges of a partial line are copied.
+        void storeLine()
+        {
+            if (m_lineEnd == m_lineBegin) {
+                return;
+            }
+
+            const size_t firstQuad = Math::AlignUp(m_lineBegin, size_t(16));
+            const size_t lastQuad = Math::AlignDown(m_lineEnd, size_t(16));
+            if (firstQuad >= lastQuad) {
+                memcpy(m_pLine + m_lineBegin, m_line + m_lineBegin, m_lineEnd - m_lineBegin);
+                return;
+            }
+
+            memcpy(m_pLine + m_lineBegin, m_line + m_lineBegin, firstQuad - m_lineBegin);
+            for (size_t i = firstQuad; i < lastQuad; i += 16) {
+                _mm_stream_si128(
+                    reinterpret_cast<__m128i*>(m_pLine + i),
+                    _mm_load_si128(reinterpret_cast<const __m128i*>(m_line + i))
+                );
+            }
+            memcpy(m_pLine + lastQuad, m_line + lastQuad, m_lineEnd - lastQuad);
+        }
+
+        // `pDest` is line aligned and `size` a whole number of lines
+        static void streamLines(uint8_t* pDest, const uint8_t* pSrc, const size_t size)
+        {
+            // SIMDMemCopy prefetches ahead and fences on the way out, which only pays off for big copies. For a
+            // few lines the fence dominates, and `flush` fences once for everything anyway.
+            if (size >= SIMD_MEMCOPY_MIN_SIZE && Math::IsAligned(pSrc, 16)) {
+                SIMDMemCopy(pDest, pSrc, size / 16);
+                return;
+            }
+
+            __m128i* pDestQuads = reinterpret_cast<__m128i*>(pDest);
+            const __m128i* pSrcQuads = reinterpret_cast<const __m128i*>(pSrc);
+            for (size_t i = size / CACHE_LINE_SIZE; i > 0; --i) {
+                _mm_stream_si128(pDestQuads + 0, _mm_loadu_si128(pSrcQuads + 0));
+                _mm_stream_si128(pDestQuads + 1, _mm_loadu_si128(pSrcQuads + 1));
+                _mm_stream_si128(pDestQuads + 2, _mm_loadu_si128(pSrcQuads + 2));
+                _mm_stream_si128(pDestQuads + 3, _mm_loadu_si128(pSrcQuads + 3));
+                pDestQuads += 4;
+                pSrcQuads += 4;
+            }
+        }
+
+        uint8_t* m_pDest;
+        size_t m_capacity;
+        // Destination line the staging line maps to, and which of its bytes have been written
+        uint8_t* m_pLine = nullptr;
+        size_t m_lineBegin = 0;
+        size_t m_lineEnd = 0;
+        alignas(16) uint8_t m_line[CACHE_LINE_SIZE];
+    };
+}
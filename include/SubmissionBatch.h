@@ -0,0 +1,76 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace bdr
+{
+    // Collects command lists, possibly recorded on several threads, so they can go to the queue in a single
+    // ExecuteCommandLists call with a single fence signal (see CommandQueue::executeBatch).
+    //
+    // Submission order is the order slots were reserved in, not the order lists were finished in. Whoever
+    // hands out the recording work reserves a slot per job up front; each job fills its slot when done.
+    template <typename CommandList>
+    class SubmissionBatchT
+    {
+    public:
+        // Reserves the next position in submission order
+        uint32_t reserve()
+        {
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+            m_slots.push_back(nullptr);
+            return uint32_t(m_slots.size() - 1);
+        }
+
+        void set(const uint32_t slot, CommandList* pList)
+        {
+            assert(pList != nullptr);
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+            assert(slot < m_slots.size() && m_slots[slot] == nullptr);
+            m_slots[slot] = pList;
+        }
+
+        // Reserve and fill in one go, for lists that are already recorded
+        void add(CommandList* pList)
+        {
+            assert(pList != nullptr);
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+            m_slots.push_back(pList);
+        }
+
+        // Calls `submit(CommandList* const* ppLists, uint32_t count)` with every list in slot order and empties
+        // the batch. All reserved slots must have been filled. Does nothing if the batch is empty.
+        template <typename Submit>
+        void flush(Submit&& submit)
+        {
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+            if (m_slots.empty()) {
+                return;
+            }
+        #ifndef NDEBUG
+            for (CommandList* pList : m_slots) {
+                assert(pList != nullptr && "Flushing a batch with a reserved slot that was never filled");
+            }
+        #endif
+            submit(m_slots.data(), uint32_t(m_slots.size()));
+            m_slots.clear();
+        }
+
+        inline bool isEmpty() const
+        {
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+            return m_slots.empty();
+        }
+
+        inline uint32_t size() const
+        {
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+            return uint32_t(m_slots.size());
+        }
+
+    private:
+        mutable std::mutex m_mutex;
+        std::vector<CommandList*> m_slots;
+    };
+}
@@ -0,0 +1,380 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace bdr
+{
+    // Two-Level Segregated Fit allocator over an abstract range of offsets [0, size). It only hands out
+    // offsets, so the same bookkeeping can carve up an ID3D12Heap, one large buffer resource or plain memory.
+    //
+    // Free blocks are bucketed by size into FL_COUNT power-of-two classes, each split into SL_COUNT linear
+    // sub-classes. Two bitmaps record which buckets are non-empty, so finding a block that fits and
+    // freeing (with coalescing of physical neighbours) are both O(1).
+    class TLSFAllocator
+    {
+    public:
+        static constexpr uint32_t SL_LOG2 = 4u;
+        static constexpr uint32_t SL_COUNT = 1u << SL_LOG2;
+        static constexpr uint32_t FL_COUNT = 64u - SL_LOG2 + 1u;
+        static constexpr uint32_t INVALID_NODE = UINT32_MAX;
+        static constexpr uint64_t INVALID_OFFSET = UINT64_MAX;
+
+        struct Allocation
+        {
+            uint64_t offset = INVALID_OFFSET;
+            uint64_t size = 0;
+            uint32_t node = INVALID_NODE;
+
+            inline bool isValid() const
+            {
+                return node != INVALID_NODE;
+            }
+        };
+
+        struct Stats
+        {
+            uint64_t totalSize = 0;
+            uint64_t usedSize = 0;
+            uint64_t freeSize = 0;
+            uint64_t largestFreeBlock = 0;
+            uint32_t allocationCount = 0;
+            uint32_t freeBlockCount = 0;
+
+            // 0 when all free space is one contiguous block, approaching 1 as it gets scattered
+            inline float getFragmentation() const
+            {
+                return freeSize == 0 ? 0.0f : 1.0f - float(largestFreeBlock) / float(freeSize);
+            }
+        };
+
+        TLSFAllocator() = default;
+        TLSFAllocator(const uint64_t size, const uint64_t granularity = 256)
+        {
+            init(size, granularity);
+        }
+
+        void init(const uint64_t size, const uint64_t granularity = 256)
+        {
+            assert(granularity != 0 && (granularity & (granularity - 1)) == 0);
+            assert(size >= granularity);
+
+            m_size = size - (size % granularity);
+            m_granularity = granularity;
+            m_usedSize = 0;
+            m_allocationCount = 0;
+            m_nodes.clear();
+            m_unusedNodes.clear();
+            m_flBitmap = 0;
+            for (uint32_t fl = 0; fl < FL_COUNT; fl++) {
+                m_slBitmaps[fl] = 0;
+                for (uint32_t sl = 0; sl < SL_COUNT; sl++) {
+                    m_freeHeads[fl][sl] = INVALID_NODE;
+                }
+            }
+
+            const uint32_t node = createNode(0, m_size);
+            insertFreeNode(node);
+        }
+
+        // Returns an invalid allocation (check `isValid`) if no free block is large enough.
+        Allocation allocate(uint64_t size, uint64_t alignment = 0)
+        {
+            assert(size > 0);
+            assert((alignment & (alignment - 1)) == 0);
+
+            size = alignUp(size, m_granularity);
+            alignment = alignment < m_granularity ? m_granularity : alignment;
+            // Over-ask so whatever block we find still fits after aligning its start
+            const uint64_t searchSize = size + (alignment - m_granularity);
+
+            uint32_t node = findFreeNode(searchSize);
+            if (node == INVALID_NODE) {
+                return Allocation{};
+            }
+            removeFreeNode(node);
+
+            // Give back the leading padding. Its physical predecessor is in use (free neighbours are always
+            // merged), so no coalescing is needed.
+            const uint64_t alignedOffset = alignUp(m_nodes[node].offset, alignment);
+            const uint64_t padding = alignedOffset - m_nodes[node].offset;
+            if (padding > 0) {
+                const uint32_t aligned = splitNode(node, padding);
+                insertFreeNode(node);
+                node = aligned;
+            }
+
+            // Give back the tail
+            if (m_nodes[node].size > size) {
+                const uint32_t tail = splitNode(node, size);
+                insertFreeNode(tail);
+            }
+
+            Node& allocated = m_nodes[node];
+            allocated.isFree = false;
+            m_usedSize += allocated.size;
+            m_allocationCount++;
+
+            Allocation allocation;
+            allocation.offset = allocated.offset;
+            allocation.size = allocated.size;
+            allocation.node = node;
+            return allocation;
+        }
+
+        void free(const Allocation& allocation)
+        {
+            assert(allocation.isValid());
+            uint32_t node = allocation.node;
+            assert(!m_nodes[node].isFree);
+
+            m_usedSize -= m_nodes[node].size;
+            m_allocationCount--;
+
+            const uint32_t next = m_nodes[node].nextPhysical;
+            if (next != INVALID_NODE && m_nodes[next].isFree) {
+                removeFreeNode(next);
+                mergeWithNext(node);
+            }
+
+            const uint32_t prev = m_nodes[node].prevPhysical;
+            if (prev != INVALID_NODE && m_nodes[prev].isFree) {
+                removeFreeNode(prev);
+                mergeWithNext(prev);
+                node = prev;
+            }
+
+            insertFreeNode(node);
+        }
+
+        Stats getStats() const
+        {
+            Stats stats;
+            stats.totalSize = m_size;
+            stats.usedSize = m_usedSize;
+            stats.freeSize = m_size - m_usedSize;
+            stats.allocationCount = m_allocationCount;
+
+            for (uint32_t fl = 0; fl < FL_COUNT; fl++) {
+                for (uint32_t sl = 0; sl < SL_COUNT; sl++) {
+                    for (uint32_t node = m_freeHeads[fl][sl]; node != INVALID_NODE; node = m_nodes[node].nextFree) {
+                        stats.freeBlockCount++;
+                        if (m_nodes[node].size > stats.largestFreeBlock) {
+                            stats.largestFreeBlock = m_nodes[node].size;
+                        }
+                    }
+                }
+            }
+            return stats;
+        }
+
+        inline bool isEmpty() const
+        {
+            return m_allocationCount == 0;
+        }
+
+        inline uint64_t getSize() const
+        {
+            return m_size;
+        }
+
+        inline uint64_t getUsedSize() const
+        {
+            return m_usedSize;
+        }
+
+        inline uint64_t getGranularity() const
+        {
+            return m_granularity;
+        }
+
+        // The first and second level class a free block of `size` bytes is bucketed in
+        static inline void mapping(const uint64_t size, uint32_t& fl, uint32_t& sl)
+        {
+            if (size < SL_COUNT) {
+                fl = 0;
+                sl = uint32_t(size);
+            }
+            else {
+                const uint32_t msb = findMSB(size);
+                fl = msb - SL_LOG2 + 1;
+                sl = uint32_t(size >> (msb - SL_LOG2)) ^ SL_COUNT;
+            }
+        }
+
+    private:
+        struct Node
+        {
+            uint64_t offset = 0;
+            uint64_t size = 0;
+            uint32_t prevPhysical = INVALID_NODE;
+            uint32_t nextPhysical = INVALID_NODE;
+            uint32_t prevFree = INVALID_NODE;
+            uint32_t nextFree = INVALID_NODE;
+            bool isFree = false;
+        };
+
+        static inline uint64_t alignUp(const uint64_t value, const uint64_t alignment)
+        {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+        static inline uint32_t findMSB(const uint64_t value)
+        {
+        #if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanReverse64(&index, value);
+            return uint32_t(index);
+        #else
+            return 63u - uint32_t(__builtin_clzll(value));
+        #endif
+        }
+
+        static inline uint32_t findLSB(const uint64_t value)
+        {
+        #if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward64(&index, value);
+            return uint32_t(index);
+        #else
+            return uint32_t(__builtin_ctzll(value));
+        #endif
+        }
+
+        uint32_t findFreeNode(uint64_t size) const
+        {
+            // Round up to the next sub-class boundary so any block in the bucket we land in is big enough
+            if (size >= SL_COUNT) {
+                size += (uint64_t(1) << (findMSB(size) - SL_LOG2)) - 1;
+            }
+            uint32_t fl, sl;
+            mapping(size, fl, sl);
+            if (fl >= FL_COUNT) {
+                return INVALID_NODE;
+            }
+
+            uint32_t slMap = m_slBitmaps[fl] & (~0u << sl);
+            if (slMap == 0) {
+                const uint64_t flMap = (fl + 1 < 64) ? (m_flBitmap & (~uint64_t(0) << (fl + 1))) : 0;
+                if (flMap == 0) {
+                    return INVALID_NODE;
+                }
+                fl = findLSB(flMap);
+                slMap = m_slBitmaps[fl];
+            }
+            sl = findLSB(slMap);
+            return m_freeHeads[fl][sl];
+        }
+
+        void insertFreeNode(const uint32_t node)
+        {
+            uint32_t fl, sl;
+            mapping(m_nodes[node].size, fl, sl);
+
+            Node& n = m_nodes[node];
+            n.isFree = true;
+            n.prevFree = INVALID_NODE;
+            n.nextFree = m_freeHeads[fl][sl];
+            if (n.nextFree != INVALID_NODE) {
+                m_nodes[n.nextFree].prevFree = node;
+            }
+            m_freeHeads[fl][sl] = node;
+            m_flBitmap |= uint64_t(1) << fl;
+            m_slBitmaps[fl] |= 1u << sl;
+        }
+
+        void removeFreeNode(const uint32_t node)
+        {
+            uint32_t fl, sl;
+            mapping(m_nodes[node].size, fl, sl);
+
+            Node& n = m_nodes[node];
+            if (n.prevFree != INVALID_NODE) {
+                m_nodes[n.prevFree].nextFree = n.nextFree;
+            }
+            else {
+                m_freeHeads[fl][sl] = n.nextFree;
+            }
+            if (n.nextFree != INVALID_NODE) {
+                m_nodes[n.nextFree].prevFree = n.prevFree;
+            }
+            n.prevFree = INVALID_NODE;
+            n.nextFree = INVALID_NODE;
+            n.isFree = false;
+
+            if (m_freeHeads[fl][sl] == INVALID_NODE) {
+                m_slBitmaps[fl] &= ~(1u << sl);
+                if (m_slBitmaps[fl] == 0) {
+                    m_flBitmap &= ~(uint64_t(1) << fl);
+                }
+            }
+        }
+
+        // Splits `node` so that it keeps the first `size` bytes; returns the node holding the remainder
+        uint32_t splitNode(const uint32_t node, const uint64_t size)
+        {
+            const uint32_t remainder = createNode(m_nodes[node].offset + size, m_nodes[node].size - size);
+            Node& n = m_nodes[node];
+            Node& r = m_nodes[remainder];
+            n.size = size;
+            r.prevPhysical = node;
+            r.nextPhysical = n.nextPhysical;
+            if (r.nextPhysical != INVALID_NODE) {
+                m_nodes[r.nextPhysical].prevPhysical = remainder;
+            }
+            n.nextPhysical = remainder;
+            return remainder;
+        }
+
+        void mergeWithNext(const uint32_t node)
+        {
+            const uint32_t next = m_nodes[node].nextPhysical;
+            Node& n = m_nodes[node];
+            n.size += m_nodes[next].size;
+            n.nextPhysical = m_nodes[next].nextPhysical;
+            if (n.nextPhysical != INVALID_NODE) {
+                m_nodes[n.nextPhysical].prevPhysical = node;
+            }
+            releaseNode(next);
+        }
+
+        uint32_t createNode(const uint64_t offset, const uint64_t size)
+        {
+            uint32_t node;
+            if (!m_unusedNodes.empty()) {
+                node = m_unusedNodes.back();
+                m_unusedNodes.pop_back();
+                m_nodes[node] = Node{};
+            }
+            else {
+                node = uint32_t(m_nodes.size());
+                m_nodes.emplace_back();
+            }
+            m_nodes[node].offset = offset;
+            m_nodes[node].size = size;
+            return node;
+        }
+
+        void releaseNode(const uint32_t node)
+        {
+            m_nodes[node] = Node{};
+            m_unusedNodes.push_back(node);
+        }
+
+        uint64_t m_size = 0;
+        uint64_t m_granularity = 256;
+        uint64_t m_usedSize = 0;
+        uint32_t m_allocationCount = 0;
+
+        std::vector<Node> m_nodes;
+        std::vector<uint32_t> m_unusedNodes;
+
+        uint64_t m_flBitmap = 0;
+        uint32_t m_slBitmaps[FL_COUNT] = {};
+        uint32_t m_freeHeads[FL_COUNT][SL_COUNT] = {};
+    };
+}
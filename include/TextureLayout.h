@@ -0,0 +1,148 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+#include "StreamingWriter.h"
+
+namespace bdr
+{
+    // Matches D3D12_TEXTURE_DATA_PITCH_ALIGNMENT and D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT
+    constexpr uint32_t TEXTURE_ROW_PITCH_ALIGNMENT = 256u;
+    constexpr uint32_t TEXTURE_PLACEMENT_ALIGNMENT = 512u;
+
+    // Size of a format's smallest addressable unit: a texel, or a block for block-compressed formats
+    struct TextureFormatInfo
+    {
+        uint32_t bytesPerBlock = 0;
+        uint32_t blockWidth = 1;
+        uint32_t blockHeight = 1;
+    };
+
+    // Subresources are numbered like D3D12CalcSubresource for a single plane: mip + arraySlice * mipCount.
+    // 3D textures have an array size of 1 and `depth` slices in mip 0.
+    struct TextureLayoutDesc
+    {
+        uint32_t width = 1;
+        uint32_t height = 1;
+        uint32_t depth = 1;
+        uint32_t arraySize = 1;
+        uint32_t mipCount = 1;
+        TextureFormatInfo format;
+    };
+
+    // Where a subresource sits in staging memory, as D3D12_PLACED_SUBRESOURCE_FOOTPRINT describes it, plus
+    // the row count and unpadded row size GetCopyableFootprints also reports
+    struct SubresourceFootprint
+    {
+        uint64_t offset;
+        // In texels, rounded up to whole blocks
+        uint32_t width;
+        uint32_t height;
+        uint32_t depth;
+        uint32_t rowPitch;
+        // Rows of blocks per depth slice
+        uint32_t rowCount;
+        uint32_t rowSizeInBytes;
+
+        inline uint64_t getSlicePitch() const
+        {
+            return uint64_t(rowPitch) * rowCount;
+        }
+
+        inline uint64_t getTotalBytes() const
+        {
+            return getSlicePitch() * depth;
+        }
+    };
+
+    // One subresource of CPU image data, like D3D12_SUBRESOURCE_DATA
+    struct SubresourceData
+    {
+        const void* pData = nullptr;
+        uint64_t rowPitch = 0;
+        uint64_t slicePitch = 0;
+    };
+
+    inline uint32_t getFullMipCount(const uint32_t width, const uint32_t height, const uint32_t depth = 1)
+    {
+        uint32_t largest = std::max(width, std::max(height, depth));
+        uint32_t mipCount = 1;
+        while (largest > 1) {
+            largest >>= 1;
+            mipCount++;
+        }
+        return mipCount;
+    }
+
+    inline SubresourceFootprint getSubresourceFootprint(const TextureLayoutDesc& desc, const uint32_t subresource)
+    {
+        assert(desc.format.bytesPerBlock != 0);
+        assert(subresource < desc.mipCount * desc.arraySize);
+        const TextureFormatInfo& format = desc.format;
+        const uint32_t mip = subresource % desc.mipCount;
+
+        const uint32_t mipWidth = std::max(1u, desc.width >> mip);
+        const uint32_t mipHeight = std::max(1u, desc.height >> mip);
+        const uint32_t blocksWide = (mipWidth + format.blockWidth - 1) / format.blockWidth;
+        const uint32_t blocksHigh = (mipHeight + format.blockHeight - 1) / format.blockHeight;
+
+        SubresourceFootprint footprint;
+        footprint.offset = 0;
+        footprint.width = blocksWide * format.blockWidth;
+        footprint.height = blocksHigh * format.blockHeight;
+        footprint.depth = std::max(1u, desc.depth >> mip);
+        footprint.rowSizeInBytes = blocksWide * format.bytesPerBlock;
+        footprint.rowPitch = Math::AlignUp(footprint.rowSizeInBytes, TEXTURE_ROW_PITCH_ALIGNMENT);
+        footprint.rowCount = blocksHigh;
+        return footprint;
+    }
+
+    // Fills `pFootprints` with `count` subresources starting at `firstSubresource`, packed one after another
+    // from `baseOffset` like GetCopyableFootprints does. Returns the total staging size.
+    inline uint64_t computeSubresourceFootprints(
+        const TextureLayoutDesc& desc,
+        const uint32_t firstSubresource,
+        const uint32_t count,
+        SubresourceFootprint* pFootprints,
+        const uint64_t baseOffset = 0)
+    {
+        uint64_t offset = baseOffset;
+        for (uint32_t i = 0; i < count; i++) {
+            offset = Math::AlignUp(offset, uint64_t(TEXTURE_PLACEMENT_ALIGNMENT));
+            pFootprints[i] = getSubresourceFootprint(desc, firstSubresource + i);
+            pFootprints[i].offset = offset;
+            offset += pFootprints[i].getTotalBytes();
+        }
+        return offset - baseOffset;
+    }
+
+    // Copies `rowCount` rows of each of `sliceCount` depth slices, starting at `firstRow`/`firstSlice` of the
+    // source, into staging laid out with the footprint's row pitch. The rows are packed from the writer's
+    // current position, which must be TEXTURE_PLACEMENT_ALIGNMENT aligned for the copy to be usable. Row pitch
+    // is a multiple of a cache line, so every row goes out as whole streamed lines; the padding is skipped.
+    inline void writeSubresourceRows(
+        StreamingWriter& writer,
+        const SubresourceFootprint& footprint,
+        const SubresourceData& source,
+        const uint32_t firstSlice,
+        const uint32_t sliceCount,
+        const uint32_t firstRow,
+        const uint32_t rowCount)
+    {
+        assert(firstSlice + sliceCount <= footprint.depth && firstRow + rowCount <= footprint.rowCount);
+        assert(source.rowPitch >= footprint.rowSizeInBytes);
+        const size_t baseOffset = writer.getOffset();
+        const uint8_t* pSource = reinterpret_cast<const uint8_t*>(source.pData);
+
+        for (uint32_t slice = 0; slice < sliceCount; slice++) {
+            const uint8_t* pSourceSlice = pSource + (firstSlice + slice) * source.slicePitch + firstRow * source.rowPitch;
+            const size_t sliceOffset = baseOffset + size_t(slice) * rowCount * footprint.rowPitch;
+            for (uint32_t row = 0; row < rowCount; row++) {
+                writer.seek(sliceOffset + size_t(row) * footprint.rowPitch);
+                writer.write(pSourceSlice + row * source.rowPitch, footprint.rowSizeInBytes);
+            }
+        }
+        writer.flush();
+    }
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bdr
+{
+    // A fixed set of worker threads for fork/join work within a frame. `parallelFor` hands indices out to the
+    // workers and the calling thread alike and returns once every one of them has run, so there is no job
+    // object to keep alive and no ordering between indices; anything that must happen in order has to be
+    // sorted out by the caller (e.g. with SubmissionBatchT slots). If jobs throw, the first exception is
+    // rethrown from parallelFor once every index has run.
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(const uint32_t workerCount)
+        {
+            m_workers.reserve(workerCount);
+            for (uint32_t i = 0; i < workerCount; i++) {
+                m_workers.emplace_back([this]() { workerLoop(); });
+            }
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lockGuard{ m_mutex };
+                m_isShuttingDown = true;
+            }
+            m_workAvailable.notify_all();
+            for (std::thread& worker : m_workers) {
+                worker.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Not re-entrant: `job` must not call parallelFor on the same pool
+        void parallelFor(const uint32_t count, const std::function<void(uint32_t)>& job)
+        {
+            if (count == 0) {
+                return;
+            }
+
+            uint64_t generation;
+            {
+                std::lock_guard<std::mutex> lockGuard{ m_mutex };
+                m_pJob = &job;
+                m_jobCount = count;
+                m_nextIndex = 0;
+                m_remaining = count;
+                generation = ++m_generation;
+            }
+            m_workAvailable.notify_all();
+
+            runJobs(generation);
+
+            std::unique_lock<std::mutex> lock{ m_mutex };
+            m_workDone.wait(lock, [this]() { return m_remaining == 0; });
+            m_pJob = nullptr;
+            if (m_exception) {
+                std::exception_ptr exception = m_exception;
+                m_exception = nullptr;
+                std::rethrow_exception(exception);
+            }
+        }
+
+        inline uint32_t getWorkerCount() const
+        {
+            return uint32_t(m_workers.size());
+        }
+
+    private:
+        void workerLoop()
+        {
+            uint64_t seenGeneration = 0;
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> lock{ m_mutex };
+                    m_workAvailable.wait(lock, [&]() { return m_isShuttingDown || m_generation != seenGeneration; });
+                    if (m_isShuttingDown) {
+                        return;
+                    }
+                    seenGeneration = m_generation;
+                }
+                runJobs(seenGeneration);
+            }
+        }
+
+        // Indices are claimed under the lock and tagged with the generation, so a worker that wakes up late
+        // can't pick up an index of the next parallelFor and run it with the previous job. Jobs are meant to
+        // be coarse (a command list each), so the lock isn't a concern.
+        void runJobs(const uint64_t generation)
+        {
+            std::unique_lock<std::mutex> lock{ m_mutex };
+            while (m_generation == generation && m_nextIndex < m_jobCount) {
+                const uint32_t index = m_nextIndex++;
+                const std::function<void(uint32_t)>& job = *m_pJob;
+                lock.unlock();
+
+                std::exception_ptr exception;
+                try {
+                    job(index);
+                }
+                catch (...) {
+                    exception = std::current_exception();
+                }
+
+                lock.lock();
+                if (exception && !m_exception) {
+                    m_exception = exception;
+                }
+                if (--m_remaining == 0) {
+                    m_workDone.notify_all();
+                }
+            }
+        }
+
+        std::vector<std::thread> m_workers;
+        std::mutex m_mutex;
+        std::condition_variable m_workAvailable;
+        std::condition_variable m_workDone;
+
+        const std::function<void(uint32_t)>* m_pJob = nullptr;
+        uint32_t m_jobCount = 0;
+        uint32_t m_nextIndex = 0;
+        uint32_t m_remaining = 0;
+        uint64_t m_generation = 0;
+        bool m_isShuttingDown = false;
+        std::exception_ptr m_exception;
+    };
+}
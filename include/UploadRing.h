@@ -0,0 +1,120 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <deque>
+
+namespace bdr
+{
+    // Offset bookkeeping for a persistently mapped upload buffer used as a ring. Allocations are bumped from
+    // the head; `submit` tags everything allocated since the previous submit with the fence that will signal
+    // when the GPU has consumed it, and `reclaim` moves the tail past every submission whose fence has passed.
+    //
+    // Head and tail are monotonic byte counters (offset = counter % capacity), so "used" is simply
+    // head - tail and a wrap just skips the unused bytes at the end of the buffer.
+    class UploadRing
+    {
+    public:
+        static constexpr uint64_t INVALID_OFFSET = UINT64_MAX;
+
+        UploadRing() = default;
+        UploadRing(const uint64_t capacity)
+        {
+            init(capacity);
+        }
+
+        void init(const uint64_t capacity)
+        {
+            m_capacity = capacity;
+            m_head = 0;
+            m_tail = 0;
+            m_submissions.clear();
+        }
+
+        // Returns INVALID_OFFSET if the ring does not currently have room; reclaim (or wait on
+        // `getOldestPendingFence`) and try again. `size` must not exceed the capacity.
+        uint64_t allocate(const uint64_t size, const uint64_t alignment)
+        {
+            assert(size > 0 && size <= m_capacity);
+            assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+            assert(m_capacity % alignment == 0);
+
+            // Nothing in flight: restart at the beginning of the buffer so even a full-capacity request fits,
+            // rather than failing forever because the head happens to sit mid-buffer
+            if (m_head == m_tail) {
+                m_head = ((m_head + m_capacity - 1) / m_capacity) * m_capacity;
+                m_tail = m_head;
+            }
+
+            uint64_t start = (m_head + alignment - 1) & ~(alignment - 1);
+            // Don't straddle the end of the buffer, skip to the start instead
+            if ((start % m_capacity) + size > m_capacity) {
+                start = ((start / m_capacity) + 1) * m_capacity;
+            }
+            if (start + size - m_tail > m_capacity) {
+                return INVALID_OFFSET;
+            }
+
+            m_head = start + size;
+            return start % m_capacity;
+        }
+
+        // Everything allocated since the last submit becomes reusable once `fenceValue` completes. A submit with
+        // nothing new allocated is dropped, so a fully reclaimed ring never has submissions pending.
+        void submit(const uint64_t fenceValue)
+        {
+            if (hasUnsubmittedAllocations()) {
+                m_submissions.push_back(Submission{ fenceValue, m_head });
+            }
+        }
+
+        // `isFenceComplete` is any callable taking a fence value. Submissions are retired in order, which
+        // holds as long as they all go to the same queue.
+        template <typename IsFenceComplete>
+        void reclaim(IsFenceComplete&& isFenceComplete)
+        {
+            while (!m_submissions.empty() && isFenceComplete(m_submissions.front().fenceValue)) {
+                m_tail = m_submissions.front().head;
+                m_submissions.pop_front();
+            }
+        }
+
+        inline bool hasPendingSubmissions() const
+        {
+            return !m_submissions.empty();
+        }
+
+        inline uint64_t getOldestPendingFence() const
+        {
+            assert(hasPendingSubmissions());
+            return m_submissions.front().fenceValue;
+        }
+
+        // True if there are allocations that haven't been covered by a `submit` yet
+        inline bool hasUnsubmittedAllocations() const
+        {
+            return m_head != (m_submissions.empty() ? m_tail : m_submissions.back().head);
+        }
+
+        inline uint64_t getUsedSize() const
+        {
+            return m_head - m_tail;
+        }
+
+        inline uint64_t getCapacity() const
+        {
+            return m_capacity;
+        }
+
+    private:
+        struct Submission
+        {
+            uint64_t fenceValue;
+            uint64_t head;
+        };
+
+        uint64_t m_capacity = 0;
+        uint64_t m_head = 0;
+        uint64_t m_tail = 0;
+        std::deque<Submission> m_submissions;
+    };
+}
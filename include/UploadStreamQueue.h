@@ -0,0 +1,195 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bdr
+{
+    // Hands uploads from any number of producer threads to one background thread, which takes everything queued
+    // since it last ran as a single batch and submits it (one copy list, one fence). Every request gets a
+    // ticket that later maps to the fence of the batch it went out in, so consumers can either depend on that
+    // fence on the GPU or poll it on the CPU. Nothing here touches D3D12; `processBatch` does the recording.
+    //
+    // Tickets start at 1 and increase in push order; batches are submitted in ticket order.
+    template <typename Request>
+    class UploadStreamQueueT
+    {
+    public:
+        static constexpr uint64_t INVALID_TICKET = 0;
+        // Returned by getFence for tickets that haven't been submitted yet
+        static constexpr uint64_t NOT_SUBMITTED = 0;
+
+        // Called on the background thread with the requests to submit, possibly none (see `wake`). Returns the
+        // fence the batch was submitted with, or NOT_SUBMITTED if there was nothing to do.
+        using ProcessBatch = std::function<uint64_t(std::vector<Request>& batch)>;
+
+        ~UploadStreamQueueT()
+        {
+            stop();
+        }
+
+        void start(ProcessBatch processBatch)
+        {
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+            if (m_thread.joinable()) {
+                return;
+            }
+            m_processBatch = std::move(processBatch);
+            m_isStopping = false;
+            m_thread = std::thread{ [this]() { threadLoop(); } };
+        }
+
+        // Submits whatever is still queued, then joins the background thread
+        void stop()
+        {
+            {
+                std::lock_guard<std::mutex> lockGuard{ m_mutex };
+                if (!m_thread.joinable()) {
+                    return;
+                }
+                m_isStopping = true;
+            }
+            m_workAvailable.notify_all();
+            m_thread.join();
+        }
+
+        inline bool isRunning() const
+        {
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+            return m_thread.joinable();
+        }
+
+        uint64_t push(Request request)
+        {
+            uint64_t ticket;
+            {
+                std::lock_guard<std::mutex> lockGuard{ m_mutex };
+                assert(m_thread.joinable());
+                m_queued.push_back(std::move(request));
+                ticket = ++m_lastPushedTicket;
+            }
+            m_workAvailable.notify_one();
+            return ticket;
+        }
+
+        // Runs `processBatch` even if nothing is queued, for work that was staged some other way
+        void wake()
+        {
+            {
+                std::lock_guard<std::mutex> lockGuard{ m_mutex };
+                m_isWakeRequested = true;
+            }
+            m_workAvailable.notify_one();
+        }
+
+        // Blocks until every request pushed before the call has been submitted. Only waits on the CPU side
+        // recording; use the fence to wait for the copies themselves.
+        void flush()
+        {
+            std::unique_lock<std::mutex> lock{ m_mutex };
+            const uint64_t ticket = m_lastPushedTicket;
+            m_batchSubmitted.wait(lock, [&]() { return m_lastSubmittedTicket >= ticket || !m_thread.joinable(); });
+        }
+
+        // Fence the ticket's batch was submitted with, or NOT_SUBMITTED. Tickets older than a `prune` report the
+        // fence that was pruned up to, which has completed.
+        uint64_t getFence(const uint64_t ticket) const
+        {
+            assert(ticket != INVALID_TICKET);
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+            if (ticket > m_lastSubmittedTicket) {
+                return NOT_SUBMITTED;
+            }
+            if (ticket <= m_prunedTicket) {
+                return m_prunedFence;
+            }
+            auto it = std::lower_bound(m_batches.begin(), m_batches.end(), ticket, [](const Batch& batch, const uint64_t value) {
+                return batch.lastTicket < value;
+            });
+            assert(it != m_batches.end());
+            return it->fenceValue;
+        }
+
+        // Drops the bookkeeping for batches whose fence is at or before `completedFenceValue`
+        void prune(const uint64_t completedFenceValue)
+        {
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+            while (!m_batches.empty() && m_batches.front().fenceValue <= completedFenceValue) {
+                m_prunedTicket = m_batches.front().lastTicket;
+                m_prunedFence = m_batches.front().fenceValue;
+                m_batches.pop_front();
+            }
+        }
+
+        inline size_t getQueuedCount() const
+        {
+            std::lock_guard<std::mutex> lockGuard{ m_mutex };
+            return m_queued.size();
+        }
+
+    private:
+        struct Batch
+        {
+            uint64_t lastTicket;
+            uint64_t fenceValue;
+        };
+
+        void threadLoop()
+        {
+            std::vector<Request> batch;
+            for (;;) {
+                uint64_t lastTicket;
+                bool isStopping;
+                {
+                    std::unique_lock<std::mutex> lock{ m_mutex };
+                    m_workAvailable.wait(lock, [this]() { return m_isStopping || m_isWakeRequested || !m_queued.empty(); });
+                    isStopping = m_isStopping;
+                    m_isWakeRequested = false;
+                    // `batch` is empty, so producers carry on into its storage
+                    batch.swap(m_queued);
+                    lastTicket = m_lastPushedTicket;
+                }
+
+                // Recording and staging happen outside the lock so producers never wait on them
+                const uint64_t fenceValue = m_processBatch(batch);
+                assert(batch.empty() || fenceValue != NOT_SUBMITTED);
+                const bool hadRequests = !batch.empty();
+                batch.clear();
+
+                {
+                    std::lock_guard<std::mutex> lockGuard{ m_mutex };
+                    if (hadRequests) {
+                        m_batches.push_back(Batch{ lastTicket, fenceValue });
+                    }
+                    m_lastSubmittedTicket = lastTicket;
+                }
+                m_batchSubmitted.notify_all();
+
+                if (isStopping) {
+                    return;
+                }
+            }
+        }
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_workAvailable;
+        std::condition_variable m_batchSubmitted;
+        std::thread m_thread;
+        ProcessBatch m_processBatch;
+
+        std::vector<Request> m_queued;
+        std::deque<Batch> m_batches;
+        uint64_t m_lastPushedTicket = INVALID_TICKET;
+        uint64_t m_lastSubmittedTicket = INVALID_TICKET;
+        uint64_t m_prunedTicket = INVALID_TICKET;
+        uint64_t m_prunedFence = NOT_SUBMITTED;
+        bool m_isWakeRequested = false;
+        bool m_isStopping = false;
+    };
+}
@@ -1,10 +1,17 @@
 #pragma once
 #include <cstdint>
+#include <vector>
 #include "stdafx.h"
 
 #include "CommandQueue.h"
 #include "GPUResource.h"
 #include "GPUBuffer.h"
+#include "LinearAllocator.h"
+#include "MemoryStats.h"
+#include "ThreadPool.h"
+#include "FramePacer.h"
+#include "CommandStream.h"
+#include "GltfLoader.h"
 #include "Camera.h"
 
 
@@ -18,6 +25,8 @@ namespace bdr
         DirectX::XMFLOAT3 position;
         uint32_t color;
     };
+    // glTF primitives are decoded straight into vertex buffers
+    static_assert(sizeof(Vertex) == sizeof(GltfVertex) && offsetof(Vertex, color) == offsetof(GltfVertex, color), "GltfVertex must match Vertex");
 
     const Vertex cubeVertices[] = {
         { DirectX::XMFLOAT3(-0.5f, 0.5f, -0.5f), 0xff00ff00 }, // +Y (top face)
@@ -62,13 +71,15 @@ namespace bdr
         GPUBuffer indexBuffer;
         D3D12_VERTEX_BUFFER_VIEW vertexBufferView;
         D3D12_INDEX_BUFFER_VIEW indexBufferView;
+        uint32_t indexCount;
         
-        inline void destroy()
+        inline void destroy(GPUBufferManager& bufferManager)
         {
-            vertexBuffer.destroy();
-            indexBuffer.destroy();
+            bufferManager.destroy(vertexBuffer);
+            bufferManager.destroy(indexBuffer);
             vertexBufferView = D3D12_VERTEX_BUFFER_VIEW{};
             indexBufferView = D3D12_INDEX_BUFFER_VIEW{};
+            indexCount = 0;
         }
     };
 
@@ -76,9 +87,9 @@ namespace bdr
     {
         Mesh mesh;
 
-        inline void destroy()
+        inline void destroy(GPUBufferManager& bufferManager)
         {
-            mesh.destroy();
+            mesh.destroy(bufferManager);
         }
     };
 
@@ -95,8 +106,23 @@ namespace bdr
         uint16_t width;
         uint16_t height;
         std::wstring assetsPath;
+        // Worker threads used to record command lists, on top of the main thread. 0 picks one per spare core.
+        uint32_t recordingThreadCount = 0;
+        // How many frames the CPU may queue ahead of the GPU, 1 to FramePacer::MAX_FRAMES_IN_FLIGHT. Fewer means
+        // lower latency, more keeps the GPU busier when CPU frame times vary.
+        uint32_t framesInFlight = 2;
+        // glTF or GLB file to draw instead of the cube
+        std::wstring modelPath;
     };
 
+    // QueryPerformanceCounter in milliseconds, the time base ID3D12CommandQueue::GetClockCalibration reports in
+    struct QpcClock
+    {
+        static double nowMs();
+    };
+
+    using FramePacer = FramePacerT<QpcClock>;
+
     class Renderer
     {
     public:
@@ -105,12 +131,22 @@ namespace bdr
         void init(HWND windowHandle);
         void initPipeline();
         void initAssets();
+        // Creates a mesh per triangle primitive of the file and adds them to m_meshes. Throws if it can't be loaded.
+        void loadModel(const std::wstring& path);
 
+        // Waits until the frame may start, so call it before sampling input. Also collects the timings of the
+        // frame that last used this frame's slot.
+        void beginFrame();
 
         void onUpdate(float deltaTime, float timeElapsed);
         void onRender();
         void onResize(uint16_t width, uint16_t height);
 
+        inline const FrameTimings& getLastFrameTimings() const
+        {
+            return m_framePacer.getLastFrameTimings();
+        }
+
         inline std::wstring GetAssetFullPath(LPCWSTR assetFileName)
         {
             return m_renderConfig.assetsPath + assetFileName;
@@ -121,12 +157,31 @@ namespace bdr
         Camera m_camera;
 
     private:
-        static constexpr uint32_t FRAME_COUNT = 2u;
+        // Flip model swap chains need at least two buffers; beyond that there's one per frame in flight
+        static constexpr uint32_t MAX_BACK_BUFFERS = FramePacer::MAX_FRAMES_IN_FLIGHT;
+        // Linear allocator pages that go unused for this many frames are released
+        static constexpr uint32_t IDLE_PAGE_FRAME_LIMIT = 120u;
+        // Draws are split into at most this many recording jobs, each with its own command list
+        static constexpr uint32_t MAX_DRAW_JOBS = 8u;
+        // Fewer draws than this aren't worth a command list of their own
+        static constexpr uint32_t MIN_DRAWS_PER_JOB = 64u;
+        // A list that opens the frame, the draw lists, and a list that closes it
+        static constexpr uint32_t MAX_FRAME_COMMAND_LISTS = MAX_DRAW_JOBS + 2u;
 
         void recreateRenderTargetViews();
-        void populateCommandList();
+        // Depth buffers are released once `lastUsedFence` passes; back buffers are waited for and released now
+        void releaseRenderTargets(const uint64_t lastUsedFence);
+        // Allocates the draw's constants and records it into m_commandStream
+        void recordMeshDraw(const uint32_t pipelineId, const uint32_t materialId, const uint32_t meshId, const uint32_t indexCount, const MVPTransforms& transforms);
+        void populateCommandLists();
+        // Plans the transitions for this frame's command lists, one batch per list
+        void planFrameBarriers();
+        void recordFrameBegin(ID3D12GraphicsCommandList* pCommandList);
+        void recordDraws(ID3D12GraphicsCommandList* pCommandList, const uint32_t firstCommand, const uint32_t commandCount);
+        void recordFrameEnd(ID3D12GraphicsCommandList* pCommandList);
+        CD3DX12_CPU_DESCRIPTOR_HANDLE getCurrentRtvHandle() const;
+        CD3DX12_CPU_DESCRIPTOR_HANDLE getCurrentDsvHandle() const;
         void waitForGPU();
-        void moveToNextFrame();
         void getHardwareAdapter(_In_ IDXGIFactory2* pFactory, _Outptr_result_maybenull_ IDXGIAdapter1** ppAdapter);
 
         CD3DX12_VIEWPORT m_viewport;
@@ -136,28 +191,56 @@ namespace bdr
         CommandQueueManager m_cmdQueueManager;
         GPUBufferManager m_gpuBufferManager;
 
-        ComPtr<ID3D12CommandAllocator> m_commandAllocators[FRAME_COUNT];
-        ComPtr<ID3D12GraphicsCommandList> m_commandList;
+        // Each frame is recorded as several jobs across m_recordingPool. Job i records into m_commandLists[i]
+        // with an allocator from the graphics queue's pool, and the lists are submitted in job order no matter
+        // which finishes first. Lists can be reset as soon as they've been submitted, so one set is enough for
+        // every frame in flight; the allocators are what the GPU holds on to.
+        ThreadPool m_recordingPool;
+        ComPtr<ID3D12GraphicsCommandList> m_commandLists[MAX_FRAME_COMMAND_LISTS];
+        ID3D12CommandAllocator* m_frameAllocators[MAX_FRAME_COMMAND_LISTS];
+        // What each job expected to record, so its allocator is returned to the pool under the right size class
+        uint64_t m_frameAllocatorSizes[MAX_FRAME_COMMAND_LISTS];
+        uint32_t m_frameCommandListCount = 0;
+        BarrierPlanner m_barrierPlanner = makeBarrierPlanner();
+        CommandListBatch m_frameBatch;
         ComPtr<IDXGISwapChain3> m_swapChain;
         ComPtr<ID3D12DescriptorHeap> m_rtvHeap;
         ComPtr<ID3D12DescriptorHeap> m_dsvHeap;
-        GPUResource m_renderTargets[FRAME_COUNT];
-        GPUResource m_depthBuffers[FRAME_COUNT];
+        GPUResource m_renderTargets[MAX_BACK_BUFFERS];
+        GPUResource m_depthBuffers[MAX_BACK_BUFFERS];
+        uint32_t m_backBufferCount;
         ComPtr<ID3D12RootSignature> m_rootSignature;
         ComPtr<ID3D12PipelineState> m_pipelineState;
 
-        ComPtr<ID3D12DescriptorHeap> m_cbvHeap;
-        ComPtr<ID3D12Resource> m_constantBuffer;
+        // Per draw constants are written into fresh UPLOAD memory every frame and bound as root CBVs. The pages
+        // are only recycled once the frame's fence has passed, so frames in flight never see each other's data.
+        LinearAllocator m_constantAllocator{ kCpuWritable };
         MVPTransforms m_mvpTransforms;
-        uint8_t* m_pCbvDataBegin;
 
-        uint64_t m_fenceValues[FRAME_COUNT];
+        // Draws are recorded in onUpdate as sorted packets, then translated into the frame's command lists.
+        // Packets refer to pipelines and meshes by their index in these tables.
+        CommandStream m_commandStream;
+        std::vector<ID3D12PipelineState*> m_pipelines;
+        std::vector<const Mesh*> m_meshes;
+
+        // m_frameIndex is the back buffer being rendered to; per frame CPU resources follow the pacer's slot
         uint32_t m_frameIndex = 0;
+        FramePacer m_framePacer;
+
+        // A begin and end timestamp per frame slot, resolved into a persistently mapped readback buffer
+        ComPtr<ID3D12QueryHeap> m_timestampHeap;
+        GPUResource m_timestampReadback;
+        const uint64_t* m_pTimestamps = nullptr;
+        uint64_t m_gpuTimestampFrequency = 0;
 
         Model m_cube;
+        std::vector<Mesh> m_modelMeshes;
 
         uint32_t m_rtvDescriptorSize = 0;
 
+        MemoryStatsRegistry::Category* m_pRenderTargetStats = nullptr;
+        uint64_t m_renderTargetBytes = 0;
+
         float m_aspectRatio;
     };
 }
\ No newline at end of file
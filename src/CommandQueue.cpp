@@ -7,9 +7,12 @@ namespace bdr
         m_type{ type },
         m_pFence{ nullptr },
         m_allocatorPool{ m_type },
-        m_nextFenceValue{ (static_cast<uint64_t>(type) << 56) + 1 },
-        m_lastCompletedValue{ (static_cast<uint64_t>(type) << 56) + 1 },
-        m_fenceEventHandle{ INVALID_HANDLE_VALUE }
+        m_nextFenceValue{ getFenceTimelineBase(type) + 1 },
+        m_completedCache{ getFenceTimelineBase(type) },
+        m_fenceEventHandle{ INVALID_HANDLE_VALUE },
+        m_submitCount{ 0 },
+        m_signalCount{ 0 },
+        m_commandListCount{ 0 }
     {
     }
 
@@ -32,7 +35,8 @@ namespace bdr
 
         ASSERT_SUCCEEDED(pDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_pFence)));
         
-        m_pFence->Signal(m_lastCompletedValue);
+        // Nothing has been submitted yet, so the first value we hand out must not read as complete
+        m_pFence->Signal(m_completedCache.get());
 
         switch (m_type) {
         case D3D12_COMMAND_LIST_TYPE_DIRECT:
@@ -68,10 +72,8 @@ namespace bdr
 
     bool CommandQueue::isFenceComplete(const uint64_t fenceValue)
     {
-        if (fenceValue > m_lastCompletedValue) {
-            m_lastCompletedValue = getCompletedFenceValue();
-        }
-        return m_lastCompletedValue >= fenceValue;
+        // Only asks the fence when the cache can't answer
+        return m_completedCache.isComplete(fenceValue, [this]() { return m_pFence->GetCompletedValue(); });
     }
 
     void CommandQueue::insertWait(const uint64_t fenceValue)
@@ -100,27 +102,82 @@ namespace bdr
 
             m_pFence->SetEventOnCompletion(fenceValue, m_fenceEventHandle);
             WaitForSingleObjectEx(m_fenceEventHandle, INFINITE, false);
-            m_lastCompletedValue = fenceValue;
+            m_completedCache.advance(fenceValue);
         }
     }
 
     uint64_t CommandQueue::executeCommandList(ID3D12CommandList* commandList)
     {
-        ID3D12CommandList* ppCommandLists[]{ commandList };
-        m_pQueue->ExecuteCommandLists(1, ppCommandLists);
+        return executeCommandLists(&commandList, 1);
+    }
+
+    uint64_t CommandQueue::executeCommandLists(ID3D12CommandList* const* ppCommandLists, const uint32_t count)
+    {
+        ASSERT(count > 0);
 
+        // Submit and signal under the same lock so that concurrent submissions can't end up with their fence
+        // values out of order with respect to the work they cover
         std::lock_guard<std::mutex> lockGuard(m_fenceMutex);
+        m_pQueue->ExecuteCommandLists(count, ppCommandLists);
         ASSERT_SUCCEEDED(m_pQueue->Signal(m_pFence, m_nextFenceValue));
+
+        m_submitCount.fetch_add(1, std::memory_order_relaxed);
+        m_signalCount.fetch_add(1, std::memory_order_relaxed);
+        m_commandListCount.fetch_add(count, std::memory_order_relaxed);
         return m_nextFenceValue++;
     }
 
+    uint64_t CommandQueue::executeBatch(CommandListBatch& batch)
+    {
+        uint64_t fenceValue = m_nextFenceValue - 1;
+        batch.flush([&](ID3D12CommandList* const* ppCommandLists, const uint32_t count) {
+            fenceValue = executeCommandLists(ppCommandLists, count);
+        });
+        return fenceValue;
+    }
+
+    ID3D12CommandAllocator* CommandQueue::requestAllocator(const uint64_t expectedSize)
+    {
+        ID3D12CommandAllocator* pAllocator = m_allocatorPool.requestAllocator(getCompletedFenceValue(), expectedSize);
+        while (pAllocator == nullptr) {
+            const uint64_t oldestFence = m_allocatorPool.getOldestPendingFence(getCompletedFenceValue());
+            ASSERT(oldestFence != AllocatorRecyclerT<ID3D12CommandAllocator>::INVALID_FENCE,
+                "Command allocator ceiling reached with every allocator still recording");
+            waitForFence(oldestFence);
+            pAllocator = m_allocatorPool.requestAllocator(getCompletedFenceValue(), expectedSize);
+        }
+        return pAllocator;
+    }
+
+    void CommandQueue::endFrame()
+    {
+        m_allocatorPool.trim(getCompletedFenceValue());
+
+        m_lastFrameStats.submits = m_submitCount.exchange(0, std::memory_order_relaxed);
+        m_lastFrameStats.signals = m_signalCount.exchange(0, std::memory_order_relaxed);
+        m_lastFrameStats.commandLists = m_commandListCount.exchange(0, std::memory_order_relaxed);
+    }
+
     // COMMAND QUEUE MANAGER
     CommandQueueManager::CommandQueueManager() :
         m_graphicsQueue{ D3D12_COMMAND_LIST_TYPE_DIRECT },
         m_computeQueue{ D3D12_COMMAND_LIST_TYPE_COMPUTE },
         m_copyQueue{ D3D12_COMMAND_LIST_TYPE_COPY },
-        m_pDevice{ nullptr }
+        m_pDevice{ nullptr },
+        m_fenceWaiter{ this },
+        m_completionService{ m_fenceWaiter }
     { }
+
+    CommandQueueManager::~CommandQueueManager()
+    {
+        if (m_deferredReleases.getPendingCount() > 0) {
+            // Shutting down, so whatever hasn't completed yet is waited for once here rather than by its owner
+            waitForIdle();
+            m_deferredReleases.clear([](ID3D12Resource* pResource) {
+                pResource->Release();
+            });
+        }
+    }
     
     void CommandQueueManager::init(ID3D12Device* pDevice)
     {
@@ -128,8 +185,90 @@ namespace bdr
         m_graphicsQueue.init(pDevice);
         m_computeQueue.init(pDevice);
         m_copyQueue.init(pDevice);
+
+        m_completionService.start();
     }
     
+    CommandQueue& CommandQueueManager::getQueue(D3D12_COMMAND_LIST_TYPE type)
+    {
+        switch (type) {
+        case D3D12_COMMAND_LIST_TYPE_COMPUTE: return m_computeQueue;
+        case D3D12_COMMAND_LIST_TYPE_COPY: return m_copyQueue;
+        default: return m_graphicsQueue;
+        }
+    }
+
+    bool CommandQueueManager::isFenceComplete(const uint64_t fenceValue)
+    {
+        const D3D12_COMMAND_LIST_TYPE type = static_cast<D3D12_COMMAND_LIST_TYPE>(getFenceTimeline(fenceValue));
+        return getQueue(type).isFenceComplete(fenceValue);
+    }
+
+    uint64_t CommandQueueManager::submit(
+        const D3D12_COMMAND_LIST_TYPE type,
+        ID3D12CommandList* const* ppCommandLists,
+        const uint32_t count,
+        const uint64_t* dependencies,
+        const uint32_t dependencyCount)
+    {
+        CommandQueue& queue = getQueue(type);
+
+        std::lock_guard<std::mutex> lockGuard(m_submitMutex);
+        QueueDependencySolver::Wait waits[MAX_FENCE_TIMELINES];
+        const uint32_t waitCount = m_dependencySolver.resolve(
+            static_cast<uint32_t>(type),
+            dependencies,
+            dependencyCount,
+            [this](const uint32_t timeline) {
+                return getQueue(static_cast<D3D12_COMMAND_LIST_TYPE>(timeline)).getCompletedFenceValue();
+            },
+            waits
+        );
+        for (uint32_t i = 0; i < waitCount; i++) {
+            const CommandQueue& otherQueue = getQueue(static_cast<D3D12_COMMAND_LIST_TYPE>(waits[i].timeline));
+            queue.insertWaitOnOtherQueueFence(&otherQueue, waits[i].fenceValue);
+        }
+
+        const uint64_t fenceValue = queue.executeCommandLists(ppCommandLists, count);
+        m_dependencySolver.recordSubmission(fenceValue);
+        return fenceValue;
+    }
+
+    uint64_t CommandQueueManager::submitBatch(
+        const D3D12_COMMAND_LIST_TYPE type,
+        CommandListBatch& batch,
+        const uint64_t* dependencies,
+        const uint32_t dependencyCount)
+    {
+        uint64_t fenceValue = getQueue(type).getNextFenceValue() - 1;
+        batch.flush([&](ID3D12CommandList* const* ppCommandLists, const uint32_t count) {
+            fenceValue = submit(type, ppCommandLists, count, dependencies, dependencyCount);
+        });
+        return fenceValue;
+    }
+
+    void CommandQueueManager::deferRelease(GPUResource& resource, const uint64_t fenceValue)
+    {
+        if (resource.pResource == nullptr) {
+            return;
+        }
+        m_deferredReleases.release(resource.pResource, fenceValue);
+        resource.pResource = nullptr;
+        resource.gpuVirtualAddress = D3D12_GPU_VIRTUAL_ADDRESS_NULL;
+    }
+
+    void CommandQueueManager::releaseCompletedResources()
+    {
+        m_deferredReleases.collect(
+            [this](const uint32_t timeline) {
+                return getQueue(static_cast<D3D12_COMMAND_LIST_TYPE>(timeline)).getCompletedFenceValue();
+            },
+            [](ID3D12Resource* pResource) {
+                pResource->Release();
+            }
+        );
+    }
+
     void CommandQueueManager::createNewCommandList(D3D12_COMMAND_LIST_TYPE type, ID3D12GraphicsCommandList** list, ID3D12CommandAllocator** allocator)
     {
         switch (type) {
@@ -141,4 +280,45 @@ namespace bdr
         ASSERT_SUCCEEDED(m_pDevice->CreateCommandList(1, type, *allocator, nullptr, IID_PPV_ARGS(list)));
         (*list)->SetName(L"CommandList");
     }
+
+    // D3D12 FENCE WAITER
+    D3D12FenceWaiter::D3D12FenceWaiter(CommandQueueManager* pQueueManager) :
+        m_pQueueManager{ pQueueManager },
+        m_eventHandle{ CreateEventEx(NULL, false, false, EVENT_ALL_ACCESS) }
+    {
+        ASSERT(m_eventHandle != NULL);
+        std::fill(std::begin(m_armedTargets), std::end(m_armedTargets), UINT64_MAX);
+    }
+
+    D3D12FenceWaiter::~D3D12FenceWaiter()
+    {
+        CloseHandle(m_eventHandle);
+    }
+
+    uint64_t D3D12FenceWaiter::getCompletedFenceValue(const uint32_t timeline)
+    {
+        return m_pQueueManager->getQueue(static_cast<D3D12_COMMAND_LIST_TYPE>(timeline)).getCompletedFenceValue();
+    }
+
+    void D3D12FenceWaiter::waitForAny(const uint64_t* targets)
+    {
+        for (uint32_t i = 0; i < MAX_FENCE_TIMELINES; i++) {
+            // A registration stays armed until its value is reached, and once it is the service moves on to a
+            // later target, so an unchanged target is still armed from an earlier wait. Anything that fired in
+            // between left the event set and just makes this wait return early, which the service handles.
+            if (targets[i] == UINT64_MAX || targets[i] == m_armedTargets[i]) {
+                continue;
+            }
+            // Fires straight away if the value has already been reached
+            CommandQueue& queue = m_pQueueManager->getQueue(static_cast<D3D12_COMMAND_LIST_TYPE>(i));
+            ASSERT_SUCCEEDED(queue.m_pFence->SetEventOnCompletion(targets[i], m_eventHandle));
+            m_armedTargets[i] = targets[i];
+        }
+        WaitForSingleObjectEx(m_eventHandle, INFINITE, false);
+    }
+
+    void D3D12FenceWaiter::wake()
+    {
+        SetEvent(m_eventHandle);
+    }
 }
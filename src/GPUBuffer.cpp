@@ -1,71 +1,333 @@
 #include "GPUBuffer.h"
 #include <dx_helpers.h>
+#include "StreamingWriter.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 
 using Microsoft::WRL::ComPtr;
 
 namespace bdr
 {
     GPUBuffer GPUBufferManager::createOnGPU(
-        const std::wstring& name,
+        const std::wstring& /*name*/,
         const uint32_t numElements,
         const uint32_t elementSize,
         const void* userData
     )
     {
+        GPUBuffer buffer = allocateBuffer(numElements, elementSize);
+
+        if (userData != nullptr && buffer.bufferSize > 0) {
+            std::lock_guard<std::mutex> lockGuard{ m_uploadMutex };
+            stageUpload(buffer.get(), buffer.offset, reinterpret_cast<const uint8_t*>(userData), buffer.bufferSize, true);
+        }
+
+        return buffer;
+    }
+
+    void GPUBufferManager::createOnGPUInPlace(
+        const InPlaceBufferDesc* pDescs,
+        const uint32_t count,
+        GPUBuffer* pOutBuffers,
+        const std::function<void(uint8_t* const* ppStaging)>& write
+    )
+    {
+        uint64_t totalSize = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            pOutBuffers[i] = allocateBuffer(pDescs[i].numElements, pDescs[i].elementSize);
+            totalSize += getInPlaceStagingSize(pDescs[i]);
+        }
+        ASSERT(totalSize <= UPLOAD_MAX_CHUNK);
+        if (totalSize == 0) {
+            return;
+        }
+
+        std::vector<uint8_t*> staging(count);
+        std::lock_guard<std::mutex> lockGuard{ m_uploadMutex };
+        // One allocation, so making room for it can't submit copies of buffers that haven't been written yet
+        const uint64_t baseOffset = allocateUploadSpace(totalSize);
+        uint64_t srcOffset = baseOffset;
+        for (uint32_t i = 0; i < count; i++) {
+            staging[i] = m_pUploadData + srcOffset;
+            srcOffset += getInPlaceStagingSize(pDescs[i]);
+        }
+
+        write(staging.data());
+
+        srcOffset = baseOffset;
+        for (uint32_t i = 0; i < count; i++) {
+            if (pOutBuffers[i].bufferSize > 0) {
+                m_pendingCopies.add(pOutBuffers[i].get(), pOutBuffers[i].offset, srcOffset, pOutBuffers[i].bufferSize, true);
+            }
+            srcOffset += getInPlaceStagingSize(pDescs[i]);
+        }
+    }
+
+    GPUBuffer GPUBufferManager::createOnGPUStreamed(
+        const std::wstring& /*name*/,
+        const uint32_t numElements,
+        const uint32_t elementSize,
+        std::vector<uint8_t> data,
+        UploadTicket* pOutTicket
+    )
+    {
+        ASSERT(m_streamQueue.isRunning());
+        GPUBuffer buffer = allocateBuffer(numElements, elementSize);
+
+        *pOutTicket = UploadStreamQueue::INVALID_TICKET;
+        if (!data.empty()) {
+            ASSERT(data.size() <= buffer.bufferSize);
+            *pOutTicket = m_streamQueue.push(StreamedUpload{ buffer.get(), buffer.offset, std::move(data) });
+        }
+        return buffer;
+    }
+
+    uint64_t GPUBufferManager::getUploadFence(const UploadTicket ticket) const
+    {
+        if (ticket == UploadStreamQueue::INVALID_TICKET) {
+            return getFenceTimelineBase(D3D12_COMMAND_LIST_TYPE_COPY);
+        }
+        return m_streamQueue.getFence(ticket);
+    }
+
+    bool GPUBufferManager::isUploadComplete(const UploadTicket ticket) const
+    {
+        const uint64_t fenceValue = getUploadFence(ticket);
+        return fenceValue != UploadStreamQueue::NOT_SUBMITTED && m_cmdQueueManager->m_copyQueue.isFenceComplete(fenceValue);
+    }
+
+    GPUBuffer GPUBufferManager::allocateBuffer(const uint32_t numElements, const uint32_t elementSize)
+    {
+        // Multiplied in 64 bits: two 32 bit counts easily overflow 4 GB between them
         GPUBuffer buffer{
             numElements,
             elementSize,
-            numElements * elementSize
+            size_t(uint64_t(numElements) * elementSize)
         };
+        if (buffer.bufferSize == 0) {
+            // Nothing to allocate; destroy and the upload paths all treat this as a no-op
+            return buffer;
+        }
 
-        ASSERT_SUCCEEDED(m_device->CreateCommittedResource(
-            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT, 1, 1),
-            D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(buffer.bufferSize),
-            D3D12_RESOURCE_STATE_COPY_DEST,
-            nullptr,
-            IID_PPV_ARGS(&buffer.pResource)
-        ));
-        buffer->SetName(name.c_str());
-        buffer.gpuVirtualAddress = buffer->GetGPUVirtualAddress();
-
-        if (userData != nullptr) {
-            ASSERT(isComplete());
-            if (m_stagedEndIdx == STAGING_MAX - 1) {
-                execute(true);
-                reset();
-            };
+        std::lock_guard<std::mutex> lockGuard{ m_heapMutex };
+        bool createdHeap = false;
+        buffer.allocation = m_heapAllocator.allocate(buffer.bufferSize, 0, &createdHeap);
+        ASSERT(buffer.allocation.isValid());
 
-            // Create staging buffer
-            D3D12_RESOURCE_BARRIER barrierDesc = m_resourceBarriers[m_stagedEndIdx];
-            GPUResource& stagingBuffer = m_stagingBuffers[m_stagedEndIdx++];
-            ID3D12Resource** pResource = stagingBuffer.getPPtr();
+        if (createdHeap) {
+            // Buffers live in COMMON so they can be implicitly promoted on the copy queue and by readers on the
+            // other queues, and decay back once each ExecuteCommandLists completes.
+            ID3D12Resource* pHeapBuffer = nullptr;
             ASSERT_SUCCEEDED(m_device->CreateCommittedResource(
-                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT, 1, 1),
                 D3D12_HEAP_FLAG_NONE,
-                &CD3DX12_RESOURCE_DESC::Buffer(buffer.bufferSize),
-                D3D12_RESOURCE_STATE_GENERIC_READ,
+                &CD3DX12_RESOURCE_DESC::Buffer(m_heapAllocator.getHeapSize(buffer.allocation.heapIndex)),
+                D3D12_RESOURCE_STATE_COMMON,
                 nullptr,
-                IID_PPV_ARGS(pResource)
+                IID_PPV_ARGS(&pHeapBuffer)
             ));
+            pHeapBuffer->SetName(L"GPUBufferManager Heap");
+            m_heapBuffers.push_back(pHeapBuffer);
+            m_pHeapStats->onAllocate(m_heapAllocator.getHeapSize(buffer.allocation.heapIndex));
+        }
+
+        // The shared heap buffer is not owned by `buffer`
+        buffer.pResource = m_heapBuffers[buffer.allocation.heapIndex];
+        buffer.offset = buffer.allocation.range.offset;
+        buffer.gpuVirtualAddress = buffer->GetGPUVirtualAddress() + buffer.offset;
+        buffer.usageState = D3D12_RESOURCE_STATE_COMMON;
+        m_pBufferStats->onAllocate(buffer.allocation.range.size);
 
-            // Copy our memory
-            uint8_t* pDataBegin = nullptr;
-            CD3DX12_RANGE readRange{ 0, 0 };
-            ASSERT_SUCCEEDED(stagingBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pDataBegin)));
-            memcpy(pDataBegin, userData, buffer.bufferSize);
-            stagingBuffer->Unmap(0, nullptr);
+        return buffer;
+    }
 
-            // Issue the copy call to the command list
-            m_commandList->CopyBufferRegion(buffer.get(), 0, stagingBuffer.get(), 0, buffer.bufferSize);
+    GPUTexture GPUBufferManager::createTexture(const std::wstring& name, const TextureDesc& desc, const SubresourceData* pSubresources)
+    {
+        const bool is3D = desc.dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D;
+
+        GPUTexture texture;
+        texture.desc = desc;
+        if (texture.desc.mipCount == 0) {
+            texture.desc.mipCount = uint16_t(getFullMipCount(desc.width, desc.height, is3D ? desc.depthOrArraySize : 1u));
         }
+        const TextureLayoutDesc layout = getTextureLayoutDesc(texture.desc);
 
-        return buffer;
+        D3D12_RESOURCE_DESC resourceDesc = {};
+        resourceDesc.Dimension = desc.dimension;
+        resourceDesc.Width = desc.width;
+        resourceDesc.Height = desc.height;
+        resourceDesc.DepthOrArraySize = desc.depthOrArraySize;
+        resourceDesc.MipLevels = texture.desc.mipCount;
+        resourceDesc.Format = desc.format;
+        resourceDesc.SampleDesc.Count = 1;
+        resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+
+        ASSERT_SUCCEEDED(m_device->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+            D3D12_HEAP_FLAG_NONE,
+            &resourceDesc,
+            D3D12_RESOURCE_STATE_COMMON,
+            nullptr,
+            IID_PPV_ARGS(texture.getPPtr())
+        ));
+        texture->SetName(name.c_str());
+        texture.usageState = D3D12_RESOURCE_STATE_COMMON;
+        m_pTextureStats->onAllocate(m_device->GetResourceAllocationInfo(0, 1, &resourceDesc).SizeInBytes);
+
+        if (pSubresources == nullptr) {
+            return texture;
+        }
+
+        const uint32_t subresourceCount = texture.getSubresourceCount();
+        std::vector<SubresourceFootprint> footprints(subresourceCount);
+        const uint64_t totalSize = computeSubresourceFootprints(layout, 0, subresourceCount, footprints.data());
+
+        std::lock_guard<std::mutex> lockGuard{ m_uploadMutex };
+        if (totalSize <= UPLOAD_MAX_CHUNK) {
+            // Small enough to stage every subresource in one allocation, packed like GetCopyableFootprints
+            const uint64_t baseOffset = allocateUploadSpace(totalSize, TEXTURE_PLACEMENT_ALIGNMENT);
+            StreamingWriter writer{ m_pUploadData + baseOffset, totalSize };
+            for (uint32_t i = 0; i < subresourceCount; i++) {
+                const SubresourceFootprint& footprint = footprints[i];
+                if (pSubresources[i].pData == nullptr) {
+                    continue;
+                }
+                writer.seek(footprint.offset);
+                writeSubresourceRows(writer, footprint, pSubresources[i], 0, footprint.depth, 0, footprint.rowCount);
+
+                PendingTextureCopy copy;
+                copy.pDest = texture.get();
+                copy.subresource = i;
+                copy.destY = 0;
+                copy.destZ = 0;
+                copy.source.Offset = baseOffset + footprint.offset;
+                copy.source.Footprint = CD3DX12_SUBRESOURCE_FOOTPRINT(desc.format, footprint.width, footprint.height, footprint.depth, footprint.rowPitch);
+                m_pendingTextureCopies.push_back(copy);
+            }
+            return texture;
+        }
+
+        // Otherwise each subresource goes up in bands of rows (of depth slices for volumes) that fit in a chunk
+        for (uint32_t i = 0; i < subresourceCount; i++) {
+            const SubresourceFootprint& footprint = footprints[i];
+            if (pSubresources[i].pData == nullptr) {
+                continue;
+            }
+
+            const bool isVolume = footprint.depth > 1;
+            const uint64_t bandUnitSize = isVolume ? footprint.getSlicePitch() : footprint.rowPitch;
+            const uint32_t bandUnitCount = isVolume ? footprint.depth : footprint.rowCount;
+            ASSERT(bandUnitSize <= UPLOAD_RING_SIZE);
+            const uint32_t unitsPerBand = uint32_t(std::max<uint64_t>(1, UPLOAD_MAX_CHUNK / bandUnitSize));
+
+            for (uint32_t first = 0; first < bandUnitCount; first += unitsPerBand) {
+                const uint32_t count = std::min(unitsPerBand, bandUnitCount - first);
+                if (isVolume) {
+                    stageTextureRegion(texture, i, footprint, pSubresources[i], first, count, 0, footprint.rowCount);
+                }
+                else {
+                    stageTextureRegion(texture, i, footprint, pSubresources[i], 0, 1, first, count);
+                }
+            }
+        }
+        return texture;
+    }
+
+    void GPUBufferManager::stageTextureRegion(
+        GPUTexture& texture,
+        const uint32_t subresource,
+        const SubresourceFootprint& footprint,
+        const SubresourceData& data,
+        const uint32_t firstSlice,
+        const uint32_t sliceCount,
+        const uint32_t firstRow,
+        const uint32_t rowCount
+    )
+    {
+        const uint32_t blockHeight = footprint.height / footprint.rowCount;
+        const uint64_t size = uint64_t(footprint.rowPitch) * rowCount * sliceCount;
+        const uint64_t srcOffset = allocateUploadSpace(size, TEXTURE_PLACEMENT_ALIGNMENT);
+        {
+            StreamingWriter writer{ m_pUploadData + srcOffset, size };
+            writeSubresourceRows(writer, footprint, data, firstSlice, sliceCount, firstRow, rowCount);
+        }
+
+        PendingTextureCopy copy;
+        copy.pDest = texture.get();
+        copy.subresource = subresource;
+        copy.destY = firstRow * blockHeight;
+        copy.destZ = firstSlice;
+        copy.source.Offset = srcOffset;
+        copy.source.Footprint = CD3DX12_SUBRESOURCE_FOOTPRINT(texture.desc.format, footprint.width, rowCount * blockHeight, sliceCount, footprint.rowPitch);
+        m_pendingTextureCopies.push_back(copy);
+    }
+
+    void GPUBufferManager::destroy(GPUTexture& texture, const uint64_t lastUsedFence)
+    {
+        if (texture.pResource != nullptr) {
+            const D3D12_RESOURCE_DESC resourceDesc = texture->GetDesc();
+            m_pTextureStats->onFree(m_device->GetResourceAllocationInfo(0, 1, &resourceDesc).SizeInBytes);
+            m_cmdQueueManager->deferRelease(texture, lastUsedFence);
+        }
+        texture = GPUTexture{};
+    }
+
+    void GPUBufferManager::update(GPUBuffer& buffer, const uint64_t offset, const void* pData, const uint64_t size)
+    {
+        ASSERT(buffer.allocation.isValid() && offset + size <= buffer.bufferSize);
+
+        std::lock_guard<std::mutex> lockGuard{ m_updateMutex };
+        auto result = m_shadows.try_emplace(buffer.gpuVirtualAddress);
+        BufferShadow& shadow = result.first->second;
+        if (result.second) {
+            shadow.pDest = buffer.get();
+            shadow.destOffset = buffer.offset;
+            shadow.data.resize(buffer.bufferSize);
+        }
+
+        if (shadow.dirtyRanges.isEmpty()) {
+            m_dirtyShadows.push_back(&shadow);
+        }
+        std::memcpy(shadow.data.data() + offset, pData, size);
+        shadow.dirtyRanges.add(offset, size);
+    }
+
+    void GPUBufferManager::forgetShadow(const GPUBuffer& buffer)
+    {
+        std::lock_guard<std::mutex> lockGuard{ m_updateMutex };
+        auto it = m_shadows.find(buffer.gpuVirtualAddress);
+        if (it == m_shadows.end()) {
+            return;
+        }
+        // Writes that were never uploaded don't matter any more
+        m_dirtyShadows.erase(std::remove(m_dirtyShadows.begin(), m_dirtyShadows.end(), &it->second), m_dirtyShadows.end());
+        m_shadows.erase(it);
+    }
+
+    void GPUBufferManager::destroy(GPUBuffer& buffer)
+    {
+        forgetShadow(buffer);
+        if (buffer.allocation.isValid()) {
+            std::lock_guard<std::mutex> lockGuard{ m_heapMutex };
+            m_pBufferStats->onFree(buffer.allocation.range.size);
+            m_heapAllocator.free(buffer.allocation);
+        }
+        buffer = GPUBuffer{};
+    }
+
+    void GPUBufferManager::destroy(GPUBuffer& buffer, const uint64_t lastUsedFence)
+    {
+        forgetShadow(buffer);
+        if (buffer.allocation.isValid()) {
+            m_deferredFrees.release(buffer.allocation, lastUsedFence);
+        }
+        buffer = GPUBuffer{};
     }
 
     bool GPUBufferManager::isComplete() const
     {
-        return m_cmdQueueManager->m_copyQueue.isFenceComplete(m_currentFence);
+        return m_cmdQueueManager->m_copyQueue.isFenceComplete(getLastUploadFence());
     }
 
     void GPUBufferManager::init(ID3D12Device* pDevice, CommandQueueManager* pCmdQueueManager)
@@ -74,62 +336,249 @@ namespace bdr
         m_device = pDevice;
         m_cmdQueueManager = pCmdQueueManager;
 
-        m_cmdQueueManager->createNewCommandList(D3D12_COMMAND_LIST_TYPE_COPY, &m_commandList, &m_commandAllocator);
+        // Heaps are what we hold from the device, buffers what has been handed out of them
+        m_pHeapStats = MemoryStatsRegistry::get().getCategory("GPUBufferManager/Heaps");
+        m_pBufferStats = MemoryStatsRegistry::get().getCategory("GPUBufferManager/Buffers");
+        m_pUploadStats = MemoryStatsRegistry::get().getCategory("GPUBufferManager/UploadRing");
+        m_pTextureStats = MemoryStatsRegistry::get().getCategory("GPUBufferManager/Textures");
+
+        // Lists are reset with a fresh allocator on every execute, so hand this first one straight back
+        ID3D12CommandAllocator* pAllocator = nullptr;
+        m_cmdQueueManager->createNewCommandList(D3D12_COMMAND_LIST_TYPE_COPY, &m_commandList, &pAllocator);
+        ASSERT_SUCCEEDED(m_commandList->Close());
+        m_cmdQueueManager->m_copyQueue.returnAllocator(0, pAllocator);
+
+        ID3D12Resource** ppUploadBuffer = m_uploadBuffer.getPPtr();
+        ASSERT_SUCCEEDED(m_device->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+            D3D12_HEAP_FLAG_NONE,
+            &CD3DX12_RESOURCE_DESC::Buffer(UPLOAD_RING_SIZE),
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(ppUploadBuffer)
+        ));
+        m_uploadBuffer->SetName(L"GPUBufferManager Upload Ring");
+        m_uploadBuffer.usageState = D3D12_RESOURCE_STATE_GENERIC_READ;
+
+        // Persistently mapped, we never read from it
+        CD3DX12_RANGE readRange{ 0, 0 };
+        ASSERT_SUCCEEDED(m_uploadBuffer->Map(0, &readRange, reinterpret_cast<void**>(&m_pUploadData)));
+        m_uploadRing.init(UPLOAD_RING_SIZE);
+        m_pUploadStats->onAllocate(UPLOAD_RING_SIZE);
+
         m_isReady = true;
     }
 
+    void GPUBufferManager::startStreaming()
+    {
+        ASSERT(m_isReady);
+        m_streamQueue.start([this](std::vector<StreamedUpload>& batch) {
+            std::lock_guard<std::mutex> lockGuard{ m_uploadMutex };
+            for (const StreamedUpload& upload : batch) {
+                stageUpload(upload.pDest, upload.destOffset, upload.data.data(), upload.data.size(), true);
+            }
+            stageBufferUpdates();
+            return submitPendingCopies();
+        });
+    }
+
+    void GPUBufferManager::stopStreaming()
+    {
+        m_streamQueue.stop();
+    }
+
     void GPUBufferManager::shutdown()
     {
         if (!m_isReady) {
             return;
         }
-        
-        for (size_t i = 0; i < m_stagedEndIdx; i++) {
-            m_stagingBuffers[i]->Release();
+
+        // Anything the background thread submits from here on must be done before the heaps go away
+        stopStreaming();
+        m_cmdQueueManager->m_copyQueue.waitForFence(getLastUploadFence());
+
+        m_uploadBuffer->Unmap(0, nullptr);
+        m_uploadBuffer.destroy();
+        m_pUploadStats->onFree(UPLOAD_RING_SIZE);
+        m_pUploadData = nullptr;
+        m_pendingCopies.clear();
+        m_pendingTextureCopies.clear();
+        m_hasPendingUpdates = false;
+        m_dirtyShadows.clear();
+        m_shadows.clear();
+
+        // The heaps are going away, so the ranges don't need to go back to them
+        m_deferredFrees.clear([this](const BufferSuballocator::Allocation& allocation) {
+            m_pBufferStats->onFree(allocation.range.size);
+        });
+
+        for (uint32_t i = 0; i < m_heapBuffers.size(); i++) {
+            m_pHeapStats->onFree(m_heapAllocator.getHeapSize(i));
+            m_heapBuffers[i]->Release();
         }
-        m_stagedEndIdx = 0;
+        m_heapBuffers.clear();
+        m_heapAllocator.reset();
+
+        SAFE_RELEASE(m_commandList);
+        m_commandList = nullptr;
+        m_isReady = false;
     }
 
     void GPUBufferManager::reset()
     {
-        ASSERT(isComplete());
-        if (m_stagedEndIdx == 0) {
+        CommandQueue& copyQueue = m_cmdQueueManager->m_copyQueue;
+        m_streamQueue.prune(copyQueue.getCompletedFenceValue());
+
+        // If the background thread is busy it reclaims the ring itself when it runs short
+        std::unique_lock<std::mutex> uploadLock{ m_uploadMutex, std::try_to_lock };
+        if (uploadLock.owns_lock()) {
+            m_uploadRing.reclaim([&copyQueue](const uint64_t fenceValue) {
+                return copyQueue.isFenceComplete(fenceValue);
+            });
+            uploadLock.unlock();
+        }
+
+        std::lock_guard<std::mutex> lockGuard{ m_heapMutex };
+        m_deferredFrees.collect(
+            [this](const uint32_t timeline) {
+                return m_cmdQueueManager->getQueue(static_cast<D3D12_COMMAND_LIST_TYPE>(timeline)).getCompletedFenceValue();
+            },
+            [this](const BufferSuballocator::Allocation& allocation) {
+                m_pBufferStats->onFree(allocation.range.size);
+                m_heapAllocator.free(allocation);
+            }
+        );
+    }
+
+    void GPUBufferManager::execute(bool waitForCompletion)
+    {
+        bool hasBufferUpdates;
+        {
+            std::lock_guard<std::mutex> lockGuard{ m_updateMutex };
+            hasBufferUpdates = !m_dirtyShadows.empty();
+        }
+
+        // Updates and copies staged on this thread (createOnGPU, createTexture) are wanted by its next submission,
+        // so they can't be left to the streaming thread. Anything the streaming thread staged is submitted by the
+        // time it lets go of the lock, so whatever is pending here came from another thread.
+        std::unique_lock<std::mutex> uploadLock{ m_uploadMutex };
+        const bool hasPendingCopies = !m_pendingCopies.empty() || !m_pendingTextureCopies.empty();
+        if (!waitForCompletion && !hasBufferUpdates && !hasPendingCopies && m_streamQueue.isRunning()) {
+            uploadLock.unlock();
+            m_streamQueue.wake();
             return;
         }
-        m_commandAllocator = m_cmdQueueManager->m_copyQueue.requestAllocator();
-        ASSERT_SUCCEEDED(m_commandList->Reset(m_commandAllocator, nullptr));
 
-        for (size_t i = 0; i < m_stagedEndIdx; i++) {
-            m_stagingBuffers[i]->Release();
+        stageBufferUpdates();
+        const uint64_t fenceValue = submitPendingCopies();
+        if (waitForCompletion) {
+            m_cmdQueueManager->m_copyQueue.waitForFence(fenceValue);
         }
-        m_stagedEndIdx = 0;
     }
 
-
-    void GPUBufferManager::execute(bool waitForCompletion)
+    uint64_t GPUBufferManager::submitPendingCopies()
     {
-        ASSERT(isComplete());
         // Don't execute if we don't have any resources to copy/transition
-        if (m_stagedEndIdx == 0) {
-            return;
+        if (m_pendingCopies.empty() && m_pendingTextureCopies.empty()) {
+            return getLastUploadFence();
         }
 
         CommandQueue& copyQueue = m_cmdQueueManager->m_copyQueue;
-        CommandQueue& graphicsQueue = m_cmdQueueManager->m_graphicsQueue;
 
-        // First deal with executing the copy commands
-        // Our command list is already populated through calls to createOnGPU
+        // Big batches (e.g. a model load) keep reusing the allocators that have already grown to hold them
+        const uint64_t recordedSize = (m_pendingCopies.size() + m_pendingTextureCopies.size()) * COPY_COMMAND_SIZE_ESTIMATE;
+        ID3D12CommandAllocator* pAllocator = copyQueue.requestAllocator(recordedSize);
+        ASSERT_SUCCEEDED(m_commandList->Reset(pAllocator, nullptr));
+
+        for (const BufferCopyListT<ID3D12Resource>::Copy& copy : m_pendingCopies) {
+            m_commandList->CopyBufferRegion(copy.pDest, copy.destOffset, m_uploadBuffer.get(), copy.srcOffset, copy.size);
+        }
+        m_pendingCopies.clear();
+
+        for (const PendingTextureCopy& copy : m_pendingTextureCopies) {
+            const CD3DX12_TEXTURE_COPY_LOCATION dest{ copy.pDest, copy.subresource };
+            const CD3DX12_TEXTURE_COPY_LOCATION source{ m_uploadBuffer.get(), copy.source };
+            m_commandList->CopyTextureRegion(&dest, 0, copy.destY, copy.destZ, &source, nullptr);
+        }
+        m_pendingTextureCopies.clear();
+
         ASSERT_SUCCEEDED(m_commandList->Close());
-        m_currentFence = copyQueue.executeCommandList(m_commandList);
-        
-        copyQueue.returnAllocator(m_currentFence, m_commandAllocator);
-        m_commandAllocator = nullptr;
+        uint64_t fenceValue;
+        if (m_hasPendingUpdates) {
+            // Updated buffers are overwritten in place, so whatever was submitted before that may read them
+            // has to be done first
+            const uint64_t readerFences[] = {
+                m_cmdQueueManager->m_graphicsQueue.getNextFenceValue() - 1,
+                m_cmdQueueManager->m_computeQueue.getNextFenceValue() - 1,
+            };
+            ID3D12CommandList* pCommandList = m_commandList;
+            fenceValue = m_cmdQueueManager->submit(D3D12_COMMAND_LIST_TYPE_COPY, &pCommandList, 1, readerFences, _countof(readerFences));
+            m_hasPendingUpdates = false;
+        }
+        else {
+            fenceValue = copyQueue.executeCommandList(m_commandList);
+        }
+        m_currentFence.store(fenceValue, std::memory_order_release);
+        m_uploadRing.submit(fenceValue);
 
-        // Now deal with Resource Barriers on the graphics queue
-        graphicsQueue.insertWaitOnOtherQueueFence(&copyQueue, m_currentFence);
+        copyQueue.returnAllocator(fenceValue, pAllocator, recordedSize);
+        return fenceValue;
+    }
 
-        if (waitForCompletion) {
-            copyQueue.waitForFence(m_currentFence);
+    void GPUBufferManager::stageBufferUpdates()
+    {
+        std::lock_guard<std::mutex> lockGuard{ m_updateMutex };
+        if (m_dirtyShadows.empty()) {
+            return;
+        }
+
+        // Set first, staging may run out of ring space and submit part of the updates
+        m_hasPendingUpdates = true;
+        for (BufferShadow* pShadow : m_dirtyShadows) {
+            // Bytes that were never written aren't valid in the CPU copy, so only ranges that touch are merged, and
+            // the copies don't own the bytes after them even when a range runs to the end of the buffer (its
+            // padding is never written)
+            for (const DirtyRangeSet::Range& range : pShadow->dirtyRanges.merge()) {
+                stageUpload(pShadow->pDest, pShadow->destOffset + range.begin, pShadow->data.data() + range.begin, range.end - range.begin, false);
+            }
+            pShadow->dirtyRanges.clear();
         }
-    }   
-}
\ No newline at end of file
+        m_dirtyShadows.clear();
+    }
+
+    void GPUBufferManager::stageUpload(ID3D12Resource* pDest, const uint64_t destOffset, const uint8_t* pSrc, const uint64_t size, const bool isWholeBuffer)
+    {
+        for (uint64_t copied = 0; copied < size; copied += UPLOAD_MAX_CHUNK) {
+            const uint64_t chunkSize = std::min<uint64_t>(UPLOAD_MAX_CHUNK, size - copied);
+            const uint64_t srcOffset = allocateUploadSpace(chunkSize);
+
+            StreamingWriter writer{ m_pUploadData + srcOffset, chunkSize };
+            writer.write(pSrc + copied, chunkSize);
+            const bool isLastChunk = copied + chunkSize == size;
+            m_pendingCopies.add(pDest, destOffset + copied, srcOffset, chunkSize, isWholeBuffer && isLastChunk);
+        }
+    }
+
+    uint64_t GPUBufferManager::allocateUploadSpace(const uint64_t size, const uint64_t alignment)
+    {
+        uint64_t offset = m_uploadRing.allocate(size, alignment);
+        while (offset == UploadRing::INVALID_OFFSET) {
+            // The ring is full of work we either haven't submitted or the GPU hasn't finished yet
+            CommandQueue& copyQueue = m_cmdQueueManager->m_copyQueue;
+            if (m_uploadRing.hasUnsubmittedAllocations()) {
+                submitPendingCopies();
+            }
+            if (!m_uploadRing.hasPendingSubmissions()) {
+                // An empty ring fits anything up to its capacity, so with nothing to wait on this never will
+                throw std::runtime_error("Upload allocation larger than the upload ring");
+            }
+            copyQueue.waitForFence(m_uploadRing.getOldestPendingFence());
+            m_uploadRing.reclaim([&copyQueue](const uint64_t fenceValue) {
+                return copyQueue.isFenceComplete(fenceValue);
+            });
+
+            offset = m_uploadRing.allocate(size, alignment);
+        }
+        return offset;
+    }
+}
@@ -1 +1,37 @@
 #include "GPUResource.h"
+
+namespace bdr
+{
+    void recordBarriers(ID3D12GraphicsCommandList* pCommandList, const std::vector<BarrierPlanner::Barrier>& barriers)
+    {
+        constexpr uint32_t MAX_BATCH_SIZE = 32u;
+        D3D12_RESOURCE_BARRIER batch[MAX_BATCH_SIZE];
+        uint32_t batchSize = 0;
+
+        for (const BarrierPlanner::Barrier& barrier : barriers) {
+            D3D12_RESOURCE_BARRIER_FLAGS flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+            if (barrier.split == BarrierSplit::Begin) {
+                flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+            }
+            else if (barrier.split == BarrierSplit::End) {
+                flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+            }
+
+            batch[batchSize++] = CD3DX12_RESOURCE_BARRIER::Transition(
+                barrier.resource,
+                static_cast<D3D12_RESOURCE_STATES>(barrier.stateBefore),
+                static_cast<D3D12_RESOURCE_STATES>(barrier.stateAfter),
+                barrier.subresource,
+                flags
+            );
+            if (batchSize == MAX_BATCH_SIZE) {
+                pCommandList->ResourceBarrier(batchSize, batch);
+                batchSize = 0;
+            }
+        }
+
+        if (batchSize > 0) {
+            pCommandList->ResourceBarrier(batchSize, batch);
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#include "GPUTexture.h"
+
+namespace bdr
+{
+    TextureFormatInfo getTextureFormatInfo(const DXGI_FORMAT format)
+    {
+        switch (format) {
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:
+        case DXGI_FORMAT_R32G32B32A32_UINT:
+            return TextureFormatInfo{ 16 };
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        case DXGI_FORMAT_R16G16B16A16_UNORM:
+        case DXGI_FORMAT_R32G32_FLOAT:
+            return TextureFormatInfo{ 8 };
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        case DXGI_FORMAT_R10G10B10A2_UNORM:
+        case DXGI_FORMAT_R11G11B10_FLOAT:
+        case DXGI_FORMAT_R16G16_FLOAT:
+        case DXGI_FORMAT_R32_FLOAT:
+            return TextureFormatInfo{ 4 };
+        case DXGI_FORMAT_R8G8_UNORM:
+        case DXGI_FORMAT_R16_FLOAT:
+        case DXGI_FORMAT_R16_UNORM:
+            return TextureFormatInfo{ 2 };
+        case DXGI_FORMAT_R8_UNORM:
+            return TextureFormatInfo{ 1 };
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+        case DXGI_FORMAT_BC4_UNORM:
+        case DXGI_FORMAT_BC4_SNORM:
+            return TextureFormatInfo{ 8, 4, 4 };
+        case DXGI_FORMAT_BC2_UNORM:
+        case DXGI_FORMAT_BC2_UNORM_SRGB:
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+        case DXGI_FORMAT_BC5_UNORM:
+        case DXGI_FORMAT_BC5_SNORM:
+        case DXGI_FORMAT_BC6H_UF16:
+        case DXGI_FORMAT_BC6H_SF16:
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            return TextureFormatInfo{ 16, 4, 4 };
+        default:
+            ASSERT(false, "Unsupported texture format");
+            return TextureFormatInfo{};
+        }
+    }
+
+    TextureLayoutDesc getTextureLayoutDesc(const TextureDesc& desc)
+    {
+        const bool is3D = desc.dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D;
+
+        TextureLayoutDesc layout;
+        layout.width = desc.width;
+        layout.height = desc.height;
+        layout.depth = is3D ? desc.depthOrArraySize : 1u;
+        layout.arraySize = is3D ? 1u : desc.depthOrArraySize;
+        layout.mipCount = desc.mipCount;
+        layout.format = getTextureFormatInfo(desc.format);
+        return layout;
+    }
+}
@@ -0,0 +1,573 @@
+#include "GltfLoader.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+
+#include "Json.h"
+
+namespace bdr
+{
+    namespace
+    {
+        constexpr uint32_t GLB_MAGIC = 0x46546C67u; // "glTF"
+        constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534Au;
+        constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942u;
+        constexpr uint32_t GLB_HEADER_SIZE = 12u;
+        constexpr uint32_t GLB_CHUNK_HEADER_SIZE = 8u;
+
+        constexpr uint32_t COMPONENT_BYTE = 5120u;
+        constexpr uint32_t COMPONENT_UNSIGNED_BYTE = 5121u;
+        constexpr uint32_t COMPONENT_SHORT = 5122u;
+        constexpr uint32_t COMPONENT_UNSIGNED_SHORT = 5123u;
+        constexpr uint32_t COMPONENT_UNSIGNED_INT = 5125u;
+        constexpr uint32_t COMPONENT_FLOAT = 5126u;
+
+        constexpr uint32_t MODE_TRIANGLES = 4u;
+
+        using Clock = std::chrono::steady_clock;
+
+        inline double getElapsedMs(const Clock::time_point start)
+        {
+            return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        }
+
+        inline uint32_t readUint32(const uint8_t* p)
+        {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        uint32_t getComponentSize(const uint32_t componentType)
+        {
+            switch (componentType) {
+            case COMPONENT_BYTE:
+            case COMPONENT_UNSIGNED_BYTE:
+                return 1;
+            case COMPONENT_SHORT:
+            case COMPONENT_UNSIGNED_SHORT:
+                return 2;
+            case COMPONENT_UNSIGNED_INT:
+            case COMPONENT_FLOAT:
+                return 4;
+            default:
+                return 0;
+            }
+        }
+
+        uint32_t getComponentCount(const std::string& type)
+        {
+            if (type == "SCALAR") return 1;
+            if (type == "VEC2") return 2;
+            if (type == "VEC3") return 3;
+            if (type == "VEC4") return 4;
+            if (type == "MAT2") return 4;
+            if (type == "MAT3") return 9;
+            if (type == "MAT4") return 16;
+            return 0;
+        }
+
+        bool decodeBase64(const char* pText, const size_t length, std::vector<uint8_t>& out)
+        {
+            auto decodeChar = [](const char c) -> int32_t {
+                if (c >= 'A' && c <= 'Z') return c - 'A';
+                if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+                if (c >= '0' && c <= '9') return c - '0' + 52;
+                if (c == '+') return 62;
+                if (c == '/') return 63;
+                return -1;
+            };
+
+            out.clear();
+            out.reserve(length / 4 * 3);
+            uint32_t bits = 0;
+            uint32_t bitCount = 0;
+            for (size_t i = 0; i < length; i++) {
+                if (pText[i] == '=') {
+                    break;
+                }
+                const int32_t value = decodeChar(pText[i]);
+                if (value < 0) {
+                    return false;
+                }
+                bits = (bits << 6) | uint32_t(value);
+                bitCount += 6;
+                if (bitCount >= 8) {
+                    bitCount -= 8;
+                    out.push_back(uint8_t(bits >> bitCount));
+                }
+            }
+            return true;
+        }
+
+        // URIs of external buffers are relative references, so spaces and the like come percent encoded
+        std::string decodeUriPath(const std::string& uri)
+        {
+            std::string path;
+            path.reserve(uri.size());
+            for (size_t i = 0; i < uri.size(); i++) {
+                if (uri[i] == '%' && i + 2 < uri.size() && std::isxdigit(uint8_t(uri[i + 1])) && std::isxdigit(uint8_t(uri[i + 2]))) {
+                    path.push_back(char(std::stoi(uri.substr(i + 1, 2), nullptr, 16)));
+                    i += 2;
+                }
+                else {
+                    path.push_back(uri[i]);
+                }
+            }
+            return path;
+        }
+
+        inline uint32_t packColorChannel(const float value)
+        {
+            const float clamped = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+            return uint32_t(clamped * 255.0f + 0.5f);
+        }
+
+        // Packs a normalized COLOR_0 element into RGBA8, with an alpha of 1 for three components
+        template <uint32_t ComponentType, uint32_t ComponentCount>
+        inline uint32_t readColor(const uint8_t* pElement)
+        {
+            uint32_t color = 0xff000000u;
+            for (uint32_t c = 0; c < ComponentCount; c++) {
+                uint32_t channel;
+                if constexpr (ComponentType == COMPONENT_UNSIGNED_BYTE) {
+                    channel = pElement[c];
+                }
+                else if constexpr (ComponentType == COMPONENT_UNSIGNED_SHORT) {
+                    uint16_t value;
+                    std::memcpy(&value, pElement + c * sizeof(value), sizeof(value));
+                    channel = (uint32_t(value) * 255u + 32767u) / 65535u;
+                }
+                else {
+                    float value;
+                    std::memcpy(&value, pElement + c * sizeof(value), sizeof(value));
+                    channel = packColorChannel(value);
+                }
+                color = (color & ~(0xffu << (8u * c))) | (channel << (8u * c));
+            }
+            return color;
+        }
+
+        template <typename ReadColor>
+        void decodeVertexRange(
+            const uint8_t* pPositions,
+            const uint32_t positionStride,
+            const uint8_t* pColors,
+            const uint32_t colorStride,
+            const uint32_t vertexCount,
+            GltfVertex* pDest,
+            ReadColor&& readColor)
+        {
+            for (uint32_t i = 0; i < vertexCount; i++) {
+                // Built on the stack and stored whole, so write-combined destinations see full writes
+                GltfVertex vertex;
+                std::memcpy(vertex.position, pPositions + uint64_t(i) * positionStride, sizeof(vertex.position));
+                vertex.color = readColor(pColors + uint64_t(i) * colorStride);
+                pDest[i] = vertex;
+            }
+        }
+    }
+
+    bool GltfAsset::load(const std::filesystem::path& path, std::string* pError)
+    {
+        m_files.clear();
+        m_embeddedBuffers.clear();
+        m_accessors.clear();
+        m_primitives.clear();
+        m_meshNames.clear();
+        m_timings = GltfLoadTimings{};
+
+        std::string error;
+        auto fail = [&](const std::string& message) {
+            if (pError != nullptr) {
+                *pError = path.u8string() + ": " + message;
+            }
+            return false;
+        };
+
+        Clock::time_point stageStart = Clock::now();
+        MappedFile file;
+        if (!file.open(path, FileAccessHint::Sequential)) {
+            return fail("Couldn't open the file");
+        }
+        const uint8_t* pFile = file.getData();
+        const uint64_t fileSize = file.getSize();
+        m_files.push_back(std::move(file));
+        m_timings.mapMs = getElapsedMs(stageStart);
+
+        // A GLB is a JSON chunk and an optional binary chunk, used in place for the first buffer
+        const char* pJson = reinterpret_cast<const char*>(pFile);
+        uint64_t jsonSize = fileSize;
+        BufferData glbChunk{ nullptr, 0 };
+        if (fileSize >= GLB_HEADER_SIZE && readUint32(pFile) == GLB_MAGIC) {
+            const uint32_t version = readUint32(pFile + 4);
+            const uint64_t length = std::min<uint64_t>(readUint32(pFile + 8), fileSize);
+            if (version != 2) {
+                return fail("Unsupported GLB version " + std::to_string(version));
+            }
+            if (length < GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE || readUint32(pFile + GLB_HEADER_SIZE + 4) != GLB_CHUNK_JSON) {
+                return fail("GLB doesn't start with a JSON chunk");
+            }
+            jsonSize = readUint32(pFile + GLB_HEADER_SIZE);
+            const uint64_t jsonOffset = GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE;
+            if (jsonOffset + jsonSize > length) {
+                return fail("GLB JSON chunk is truncated");
+            }
+            pJson = reinterpret_cast<const char*>(pFile + jsonOffset);
+
+            const uint64_t binOffset = jsonOffset + jsonSize;
+            if (binOffset + GLB_CHUNK_HEADER_SIZE <= length && readUint32(pFile + binOffset + 4) == GLB_CHUNK_BIN) {
+                glbChunk.pData = pFile + binOffset + GLB_CHUNK_HEADER_SIZE;
+                glbChunk.size = std::min<uint64_t>(readUint32(pFile + binOffset), length - binOffset - GLB_CHUNK_HEADER_SIZE);
+            }
+        }
+        else if (jsonSize >= 3 && std::memcmp(pJson, "\xEF\xBB\xBF", 3) == 0) {
+            // Not allowed by the spec, but some exporters write a byte order mark anyway
+            pJson += 3;
+            jsonSize -= 3;
+        }
+
+        stageStart = Clock::now();
+        JsonValue document;
+        if (!parseJson(pJson, size_t(jsonSize), document, &error)) {
+            return fail("Invalid JSON: " + error);
+        }
+        m_timings.parseMs = getElapsedMs(stageStart);
+
+        const std::string& version = document["asset"]["version"].getString();
+        if (version.compare(0, 2, "2.") != 0) {
+            return fail("Not a glTF 2.0 asset");
+        }
+
+        stageStart = Clock::now();
+        std::vector<BufferData> buffers;
+        if (!resolveBuffers(document, path.parent_path(), glbChunk, buffers, error)
+            || !resolveAccessors(document, buffers, error)
+            || !resolvePrimitives(document, error)) {
+            return fail(error);
+        }
+        m_timings.resolveMs = getElapsedMs(stageStart);
+        return true;
+    }
+
+    bool GltfAsset::resolveBuffers(const JsonValue& document, const std::filesystem::path& basePath, const BufferData& glbChunk, std::vector<BufferData>& buffers, std::string& error)
+    {
+        const JsonValue& jsonBuffers = document["buffers"];
+        buffers.resize(jsonBuffers.getSize());
+        for (size_t i = 0; i < buffers.size(); i++) {
+            const JsonValue& jsonBuffer = jsonBuffers[i];
+            const std::string prefix = "buffers[" + std::to_string(i) + "]: ";
+            const uint64_t byteLength = jsonBuffer["byteLength"].getUint64(UINT64_MAX);
+            if (byteLength == UINT64_MAX) {
+                error = prefix + "Missing byteLength";
+                return false;
+            }
+
+            const std::string& uri = jsonBuffer["uri"].getString();
+            BufferData data{ nullptr, 0 };
+            if (uri.empty()) {
+                data = glbChunk;
+                if (data.pData == nullptr) {
+                    error = prefix + "No uri and no GLB binary chunk";
+                    return false;
+                }
+            }
+            else if (uri.compare(0, 5, "data:") == 0) {
+                const size_t dataStart = uri.find(";base64,");
+                if (dataStart == std::string::npos) {
+                    error = prefix + "Only base64 data URIs are supported";
+                    return false;
+                }
+                std::vector<uint8_t>& embedded = m_embeddedBuffers.emplace_back();
+                if (!decodeBase64(uri.data() + dataStart + 8, uri.size() - dataStart - 8, embedded)) {
+                    error = prefix + "Invalid base64 data";
+                    return false;
+                }
+                data = BufferData{ embedded.data(), embedded.size() };
+            }
+            else {
+                MappedFile file;
+                const std::filesystem::path bufferPath = basePath / std::filesystem::u8path(decodeUriPath(uri));
+                if (!file.open(bufferPath, FileAccessHint::Sequential)) {
+                    error = prefix + "Couldn't open " + bufferPath.u8string();
+                    return false;
+                }
+                data = BufferData{ file.getData(), file.getSize() };
+                m_files.push_back(std::move(file));
+            }
+
+            if (data.size < byteLength) {
+                error = prefix + "Has less data than its byteLength";
+                return false;
+            }
+            data.size = byteLength;
+            buffers[i] = data;
+        }
+        return true;
+    }
+
+    bool GltfAsset::resolveAccessors(const JsonValue& document, const std::vector<BufferData>& buffers, std::string& error)
+    {
+        const JsonValue& jsonViews = document["bufferViews"];
+        const JsonValue& jsonAccessors = document["accessors"];
+        m_accessors.resize(jsonAccessors.getSize());
+        for (size_t i = 0; i < m_accessors.size(); i++) {
+            const JsonValue& jsonAccessor = jsonAccessors[i];
+            const std::string prefix = "accessors[" + std::to_string(i) + "]: ";
+            Accessor& accessor = m_accessors[i];
+
+            accessor.componentType = jsonAccessor["componentType"].getUint();
+            accessor.componentCount = getComponentCount(jsonAccessor["type"].getString());
+            accessor.isNormalized = jsonAccessor["normalized"].getBool();
+            accessor.count = jsonAccessor["count"].getUint(UINT32_MAX);
+            const uint32_t componentSize = getComponentSize(accessor.componentType);
+            if (componentSize == 0 || accessor.componentCount == 0 || accessor.count == UINT32_MAX) {
+                error = prefix + "Invalid componentType, type or count";
+                return false;
+            }
+            if (!jsonAccessor["sparse"].isNull()) {
+                error = prefix + "Sparse accessors aren't supported";
+                return false;
+            }
+
+            const uint32_t elementSize = componentSize * accessor.componentCount;
+            accessor.stride = elementSize;
+            accessor.pData = nullptr;
+
+            const JsonValue& viewIndex = jsonAccessor["bufferView"];
+            if (viewIndex.isNull()) {
+                continue;
+            }
+            const JsonValue& jsonView = jsonViews[viewIndex.getUint(UINT32_MAX)];
+            const uint32_t bufferIndex = jsonView["buffer"].getUint(UINT32_MAX);
+            if (bufferIndex >= buffers.size()) {
+                error = prefix + "Invalid bufferView";
+                return false;
+            }
+            const uint64_t viewOffset = jsonView["byteOffset"].getUint64(0);
+            const uint64_t viewLength = jsonView["byteLength"].getUint64(0);
+            accessor.stride = jsonView["byteStride"].getUint(elementSize);
+            const uint64_t accessorOffset = jsonAccessor["byteOffset"].getUint64(0);
+
+            const uint64_t accessorEnd = accessor.count == 0 ? accessorOffset : accessorOffset + uint64_t(accessor.stride) * (accessor.count - 1) + elementSize;
+            if (viewOffset + viewLength > buffers[bufferIndex].size || accessorEnd > viewLength) {
+                error = prefix + "Reads past the end of its bufferView or buffer";
+                return false;
+            }
+            accessor.pData = buffers[bufferIndex].pData + viewOffset + accessorOffset;
+        }
+        return true;
+    }
+
+    bool GltfAsset::resolvePrimitives(const JsonValue& document, std::string& error)
+    {
+        auto getAccessor = [&](const JsonValue& index, uint32_t& out) {
+            if (index.isNull()) {
+                out = GltfPrimitive::NO_ACCESSOR;
+                return true;
+            }
+            out = index.getUint(UINT32_MAX);
+            return out < m_accessors.size();
+        };
+
+        const JsonValue& jsonMeshes = document["meshes"];
+        m_meshNames.resize(jsonMeshes.getSize());
+        for (uint32_t meshIdx = 0; meshIdx < m_meshNames.size(); meshIdx++) {
+            const JsonValue& jsonMesh = jsonMeshes[meshIdx];
+            m_meshNames[meshIdx] = jsonMesh["name"].getString();
+            if (m_meshNames[meshIdx].empty()) {
+                m_meshNames[meshIdx] = "mesh " + std::to_string(meshIdx);
+            }
+
+            const JsonValue& jsonPrimitives = jsonMesh["primitives"];
+            for (uint32_t i = 0; i < jsonPrimitives.getSize(); i++) {
+                const JsonValue& jsonPrimitive = jsonPrimitives[i];
+                const std::string prefix = "meshes[" + std::to_string(meshIdx) + "].primitives[" + std::to_string(i) + "]: ";
+                if (jsonPrimitive["mode"].getUint(MODE_TRIANGLES) != MODE_TRIANGLES) {
+                    continue;
+                }
+
+                GltfPrimitive primitive;
+                primitive.meshIndex = meshIdx;
+                const JsonValue& attributes = jsonPrimitive["attributes"];
+                if (!getAccessor(attributes["POSITION"], primitive.positionAccessor)
+                    || !getAccessor(attributes["COLOR_0"], primitive.colorAccessor)
+                    || !getAccessor(jsonPrimitive["indices"], primitive.indexAccessor)) {
+                    error = prefix + "Invalid accessor index";
+                    return false;
+                }
+
+                if (primitive.positionAccessor == GltfPrimitive::NO_ACCESSOR) {
+                    error = prefix + "No POSITION attribute";
+                    return false;
+                }
+                const Accessor& position = m_accessors[primitive.positionAccessor];
+                if (position.componentType != COMPONENT_FLOAT || position.componentCount != 3) {
+                    error = prefix + "POSITION isn't float3";
+                    return false;
+                }
+                primitive.vertexCount = position.count;
+
+                if (primitive.colorAccessor != GltfPrimitive::NO_ACCESSOR) {
+                    const Accessor& color = m_accessors[primitive.colorAccessor];
+                    const bool isValidType = color.componentType == COMPONENT_FLOAT
+                        || ((color.componentType == COMPONENT_UNSIGNED_BYTE || color.componentType == COMPONENT_UNSIGNED_SHORT) && color.isNormalized);
+                    if (!isValidType || (color.componentCount != 3 && color.componentCount != 4) || color.count != primitive.vertexCount) {
+                        error = prefix + "Invalid COLOR_0 accessor";
+                        return false;
+                    }
+                }
+
+                if (primitive.indexAccessor != GltfPrimitive::NO_ACCESSOR) {
+                    const Accessor& indices = m_accessors[primitive.indexAccessor];
+                    if (indices.componentCount != 1
+                        || (indices.componentType != COMPONENT_UNSIGNED_BYTE && indices.componentType != COMPONENT_UNSIGNED_SHORT && indices.componentType != COMPONENT_UNSIGNED_INT)) {
+                        error = prefix + "Invalid indices accessor";
+                        return false;
+                    }
+                    primitive.indexCount = indices.count;
+                    primitive.indexSize = indices.componentType == COMPONENT_UNSIGNED_INT ? 4u : 2u;
+                }
+                else {
+                    primitive.indexCount = primitive.vertexCount;
+                    primitive.indexSize = primitive.vertexCount > 0x10000u ? 4u : 2u;
+                }
+
+                if (primitive.vertexCount > 0 && primitive.indexCount > 0) {
+                    m_primitives.push_back(primitive);
+                }
+            }
+        }
+        return true;
+    }
+
+    void GltfAsset::decode(ThreadPool& pool, const uint32_t firstPrimitive, const uint32_t count, GltfVertex* const* ppVertices, void* const* ppIndices)
+    {
+        struct DecodeJob
+        {
+            uint32_t primitiveIdx;
+            uint32_t first;
+            uint32_t count;
+            bool isIndices;
+        };
+
+        const Clock::time_point start = Clock::now();
+        std::vector<DecodeJob> jobs;
+        for (uint32_t i = 0; i < count; i++) {
+            const GltfPrimitive& primitive = m_primitives[firstPrimitive + i];
+            for (uint32_t first = 0; first < primitive.vertexCount; first += DECODE_JOB_SIZE) {
+                jobs.push_back(DecodeJob{ i, first, std::min(DECODE_JOB_SIZE, primitive.vertexCount - first), false });
+            }
+            for (uint32_t first = 0; first < primitive.indexCount; first += DECODE_JOB_SIZE) {
+                jobs.push_back(DecodeJob{ i, first, std::min(DECODE_JOB_SIZE, primitive.indexCount - first), true });
+            }
+        }
+
+        pool.parallelFor(uint32_t(jobs.size()), [&](const uint32_t jobIdx) {
+            const DecodeJob& job = jobs[jobIdx];
+            const GltfPrimitive& primitive = m_primitives[firstPrimitive + job.primitiveIdx];
+            if (job.isIndices) {
+                decodeIndices(primitive, job.first, job.count, ppIndices[job.primitiveIdx]);
+            }
+            else {
+                decodeVertices(primitive, job.first, job.count, ppVertices[job.primitiveIdx]);
+            }
+        });
+        m_timings.decodeMs += getElapsedMs(start);
+    }
+
+    void GltfAsset::decodeVertices(const GltfPrimitive& primitive, const uint32_t firstVertex, const uint32_t vertexCount, GltfVertex* pDest) const
+    {
+        // Accessors without a buffer view read as zeros, from one zero element with no stride
+        static const uint8_t s_zeros[16] = {};
+        const Accessor& position = m_accessors[primitive.positionAccessor];
+        const uint8_t* pPositions = position.pData != nullptr ? position.pData + uint64_t(firstVertex) * position.stride : s_zeros;
+        const uint32_t positionStride = position.pData != nullptr ? position.stride : 0;
+        GltfVertex* pVertices = pDest + firstVertex;
+
+        if (primitive.colorAccessor == GltfPrimitive::NO_ACCESSOR) {
+            decodeVertexRange(pPositions, positionStride, nullptr, 0, vertexCount, pVertices, [](const uint8_t*) {
+                return 0xffffffffu;
+            });
+            return;
+        }
+
+        const Accessor& color = m_accessors[primitive.colorAccessor];
+        const uint8_t* pColors = color.pData != nullptr ? color.pData + uint64_t(firstVertex) * color.stride : s_zeros;
+        const uint32_t colorStride = color.pData != nullptr ? color.stride : 0;
+        // One loop per color format, so the inner loop has no per component branches
+        const bool isVec4 = color.componentCount == 4;
+        switch (color.componentType) {
+        case COMPONENT_UNSIGNED_BYTE:
+            if (isVec4) {
+                decodeVertexRange(pPositions, positionStride, pColors, colorStride, vertexCount, pVertices, readColor<COMPONENT_UNSIGNED_BYTE, 4>);
+            }
+            else {
+                decodeVertexRange(pPositions, positionStride, pColors, colorStride, vertexCount, pVertices, readColor<COMPONENT_UNSIGNED_BYTE, 3>);
+            }
+            break;
+        case COMPONENT_UNSIGNED_SHORT:
+            if (isVec4) {
+                decodeVertexRange(pPositions, positionStride, pColors, colorStride, vertexCount, pVertices, readColor<COMPONENT_UNSIGNED_SHORT, 4>);
+            }
+            else {
+                decodeVertexRange(pPositions, positionStride, pColors, colorStride, vertexCount, pVertices, readColor<COMPONENT_UNSIGNED_SHORT, 3>);
+            }
+            break;
+        default:
+            if (isVec4) {
+                decodeVertexRange(pPositions, positionStride, pColors, colorStride, vertexCount, pVertices, readColor<COMPONENT_FLOAT, 4>);
+            }
+            else {
+                decodeVertexRange(pPositions, positionStride, pColors, colorStride, vertexCount, pVertices, readColor<COMPONENT_FLOAT, 3>);
+            }
+            break;
+        }
+    }
+
+    void GltfAsset::decodeIndices(const GltfPrimitive& primitive, const uint32_t firstIndex, const uint32_t indexCount, void* pDest) const
+    {
+        const uint32_t endIndex = firstIndex + indexCount;
+        if (primitive.indexAccessor == GltfPrimitive::NO_ACCESSOR) {
+            if (primitive.indexSize == 2) {
+                uint16_t* pIndices = reinterpret_cast<uint16_t*>(pDest);
+                for (uint32_t i = firstIndex; i < endIndex; i++) {
+                    pIndices[i] = uint16_t(i);
+                }
+            }
+            else {
+                uint32_t* pIndices = reinterpret_cast<uint32_t*>(pDest);
+                for (uint32_t i = firstIndex; i < endIndex; i++) {
+                    pIndices[i] = i;
+                }
+            }
+            return;
+        }
+
+        const Accessor& indices = m_accessors[primitive.indexAccessor];
+        uint8_t* pDestBytes = reinterpret_cast<uint8_t*>(pDest) + uint64_t(firstIndex) * primitive.indexSize;
+        if (indices.pData == nullptr) {
+            std::memset(pDestBytes, 0, uint64_t(indexCount) * primitive.indexSize);
+            return;
+        }
+
+        const uint8_t* pSource = indices.pData + uint64_t(firstIndex) * indices.stride;
+        const uint32_t sourceSize = getComponentSize(indices.componentType);
+        if (sourceSize == primitive.indexSize && indices.stride == sourceSize) {
+            // Tightly packed and already the right size, the common case
+            std::memcpy(pDestBytes, pSource, uint64_t(indexCount) * sourceSize);
+        }
+        else if (indices.componentType == COMPONENT_UNSIGNED_BYTE) {
+            uint16_t* pIndices = reinterpret_cast<uint16_t*>(pDestBytes);
+            for (uint32_t i = 0; i < indexCount; i++) {
+                pIndices[i] = pSource[uint64_t(i) * indices.stride];
+            }
+        }
+        else {
+            for (uint32_t i = 0; i < indexCount; i++) {
+                std::memcpy(pDestBytes + uint64_t(i) * sourceSize, pSource + uint64_t(i) * indices.stride, sourceSize);
+            }
+        }
+    }
+}
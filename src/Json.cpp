@@ -0,0 +1,398 @@
+#include "Json.h"
+#include <charconv>
+#include <cmath>
+
+namespace bdr
+{
+    namespace
+    {
+        const JsonValue s_nullValue{};
+
+        // Deep enough for any glTF file, shallow enough not to overflow the stack on hostile input
+        constexpr uint32_t MAX_DEPTH = 256u;
+
+        void appendUtf8(std::string& out, const uint32_t codePoint)
+        {
+            if (codePoint < 0x80) {
+                out.push_back(char(codePoint));
+            }
+            else if (codePoint < 0x800) {
+                out.push_back(char(0xC0 | (codePoint >> 6)));
+                out.push_back(char(0x80 | (codePoint & 0x3F)));
+            }
+            else if (codePoint < 0x10000) {
+                out.push_back(char(0xE0 | (codePoint >> 12)));
+                out.push_back(char(0x80 | ((codePoint >> 6) & 0x3F)));
+                out.push_back(char(0x80 | (codePoint & 0x3F)));
+            }
+            else {
+                out.push_back(char(0xF0 | (codePoint >> 18)));
+                out.push_back(char(0x80 | ((codePoint >> 12) & 0x3F)));
+                out.push_back(char(0x80 | ((codePoint >> 6) & 0x3F)));
+                out.push_back(char(0x80 | (codePoint & 0x3F)));
+            }
+        }
+    }
+
+    uint32_t JsonValue::getUint(const uint32_t defaultValue) const
+    {
+        if (m_type != JsonType::Number || m_number < 0.0 || m_number > double(UINT32_MAX) || std::floor(m_number) != m_number) {
+            return defaultValue;
+        }
+        return uint32_t(m_number);
+    }
+
+    uint64_t JsonValue::getUint64(const uint64_t defaultValue) const
+    {
+        // Doubles hold integers exactly up to 2^53
+        if (m_type != JsonType::Number || m_number < 0.0 || m_number > 9007199254740992.0 || std::floor(m_number) != m_number) {
+            return defaultValue;
+        }
+        return uint64_t(m_number);
+    }
+
+    size_t JsonValue::getSize() const
+    {
+        if (m_type == JsonType::Array) {
+            return m_elements.size();
+        }
+        return m_type == JsonType::Object ? m_members.size() : 0;
+    }
+
+    const JsonValue& JsonValue::operator[](const size_t index) const
+    {
+        if (m_type != JsonType::Array || index >= m_elements.size()) {
+            return s_nullValue;
+        }
+        return m_elements[index];
+    }
+
+    const JsonValue& JsonValue::operator[](const std::string_view key) const
+    {
+        // glTF objects have a handful of members, a linear search beats building a map for each
+        for (const JsonMember& member : m_members) {
+            if (member.key == key) {
+                return member.value;
+            }
+        }
+        return s_nullValue;
+    }
+
+    // Recursive descent over the whole document, building the tree as it goes
+    class JsonParser
+    {
+    public:
+        JsonParser(const char* pText, const size_t length) :
+            m_pCursor{ pText },
+            m_pBegin{ pText },
+            m_pEnd{ pText + length }
+        { }
+
+        bool parse(JsonValue& out, std::string* pError)
+        {
+            skipWhitespace();
+            bool isValid = parseValue(out, 0);
+            if (isValid) {
+                skipWhitespace();
+                if (m_pCursor != m_pEnd) {
+                    isValid = fail("Unexpected data after the document");
+                }
+            }
+            if (!isValid && pError != nullptr) {
+                *pError = m_error + " at byte " + std::to_string(m_errorOffset);
+            }
+            return isValid;
+        }
+
+    private:
+        bool fail(const char* message)
+        {
+            m_error = message;
+            m_errorOffset = size_t(m_pCursor - m_pBegin);
+            return false;
+        }
+
+        void skipWhitespace()
+        {
+            while (m_pCursor < m_pEnd && (*m_pCursor == ' ' || *m_pCursor == '\t' || *m_pCursor == '\n' || *m_pCursor == '\r')) {
+                m_pCursor++;
+            }
+        }
+
+        bool consumeLiteral(const std::string_view literal)
+        {
+            if (size_t(m_pEnd - m_pCursor) < literal.size() || std::string_view{ m_pCursor, literal.size() } != literal) {
+                return fail("Invalid literal");
+            }
+            m_pCursor += literal.size();
+            return true;
+        }
+
+        bool parseValue(JsonValue& out, const uint32_t depth)
+        {
+            if (m_pCursor == m_pEnd) {
+                return fail("Unexpected end of input");
+            }
+            switch (*m_pCursor) {
+            case '{':
+                return parseObject(out, depth);
+            case '[':
+                return parseArray(out, depth);
+            case '"':
+                out.m_type = JsonType::String;
+                return parseString(out.m_string);
+            case 't':
+                out.m_type = JsonType::Bool;
+                out.m_bool = true;
+                return consumeLiteral("true");
+            case 'f':
+                out.m_type = JsonType::Bool;
+                out.m_bool = false;
+                return consumeLiteral("false");
+            case 'n':
+                out.m_type = JsonType::Null;
+                return consumeLiteral("null");
+            default:
+                return parseNumber(out);
+            }
+        }
+
+        bool parseObject(JsonValue& out, const uint32_t depth)
+        {
+            if (depth >= MAX_DEPTH) {
+                return fail("Nested too deeply");
+            }
+            out.m_type = JsonType::Object;
+            m_pCursor++;
+            skipWhitespace();
+            if (m_pCursor < m_pEnd && *m_pCursor == '}') {
+                m_pCursor++;
+                return true;
+            }
+
+            for (;;) {
+                if (m_pCursor == m_pEnd || *m_pCursor != '"') {
+                    return fail("Expected a member name");
+                }
+                JsonMember& member = out.m_members.emplace_back();
+                if (!parseString(member.key)) {
+                    return false;
+                }
+                skipWhitespace();
+                if (m_pCursor == m_pEnd || *m_pCursor != ':') {
+                    return fail("Expected ':'");
+                }
+                m_pCursor++;
+                skipWhitespace();
+                if (!parseValue(member.value, depth + 1)) {
+                    return false;
+                }
+                skipWhitespace();
+                if (m_pCursor == m_pEnd) {
+                    return fail("Unterminated object");
+                }
+                if (*m_pCursor == '}') {
+                    m_pCursor++;
+                    return true;
+                }
+                if (*m_pCursor != ',') {
+                    return fail("Expected ',' or '}'");
+                }
+                m_pCursor++;
+                skipWhitespace();
+            }
+        }
+
+        bool parseArray(JsonValue& out, const uint32_t depth)
+        {
+            if (depth >= MAX_DEPTH) {
+                return fail("Nested too deeply");
+            }
+            out.m_type = JsonType::Array;
+            m_pCursor++;
+            skipWhitespace();
+            if (m_pCursor < m_pEnd && *m_pCursor == ']') {
+                m_pCursor++;
+                return true;
+            }
+
+            for (;;) {
+                if (!parseValue(out.m_elements.emplace_back(), depth + 1)) {
+                    return false;
+                }
+                skipWhitespace();
+                if (m_pCursor == m_pEnd) {
+                    return fail("Unterminated array");
+                }
+                if (*m_pCursor == ']') {
+                    m_pCursor++;
+                    return true;
+                }
+                if (*m_pCursor != ',') {
+                    return fail("Expected ',' or ']'");
+                }
+                m_pCursor++;
+                skipWhitespace();
+            }
+        }
+
+        bool parseHex4(uint32_t& out)
+        {
+            if (m_pEnd - m_pCursor < 4) {
+                return fail("Truncated \\u escape");
+            }
+            out = 0;
+            for (uint32_t i = 0; i < 4; i++) {
+                const char c = *m_pCursor++;
+                out <<= 4;
+                if (c >= '0' && c <= '9') {
+                    out |= uint32_t(c - '0');
+                }
+                else if (c >= 'a' && c <= 'f') {
+                    out |= uint32_t(c - 'a' + 10);
+                }
+                else if (c >= 'A' && c <= 'F') {
+                    out |= uint32_t(c - 'A' + 10);
+                }
+                else {
+                    return fail("Invalid \\u escape");
+                }
+            }
+            return true;
+        }
+
+        bool parseString(std::string& out)
+        {
+            m_pCursor++;
+            // Copy unescaped runs in one go; most strings have no escapes at all
+            const char* pRun = m_pCursor;
+            for (;;) {
+                if (m_pCursor == m_pEnd) {
+                    return fail("Unterminated string");
+                }
+                const char c = *m_pCursor;
+                if (c == '"') {
+                    out.append(pRun, m_pCursor);
+                    m_pCursor++;
+                    return true;
+                }
+                if (uint8_t(c) < 0x20) {
+                    return fail("Control character in string");
+                }
+                if (c != '\\') {
+                    m_pCursor++;
+                    continue;
+                }
+
+                out.append(pRun, m_pCursor);
+                m_pCursor++;
+                if (m_pCursor == m_pEnd) {
+                    return fail("Unterminated string");
+                }
+                const char escape = *m_pCursor++;
+                switch (escape) {
+                case '"': out.push_back('"'); break;
+                case '\\': out.push_back('\\'); break;
+                case '/': out.push_back('/'); break;
+                case 'b': out.push_back('\b'); break;
+                case 'f': out.push_back('\f'); break;
+                case 'n': out.push_back('\n'); break;
+                case 'r': out.push_back('\r'); break;
+                case 't': out.push_back('\t'); break;
+                case 'u': {
+                    uint32_t codePoint;
+                    if (!parseHex4(codePoint)) {
+                        return false;
+                    }
+                    // Characters outside the BMP come as a surrogate pair
+                    if (codePoint >= 0xD800 && codePoint < 0xDC00) {
+                        uint32_t low;
+                        if (m_pEnd - m_pCursor < 2 || m_pCursor[0] != '\\' || m_pCursor[1] != 'u') {
+                            return fail("Unpaired surrogate");
+                        }
+                        m_pCursor += 2;
+                        if (!parseHex4(low)) {
+                            return false;
+                        }
+                        if (low < 0xDC00 || low >= 0xE000) {
+                            return fail("Unpaired surrogate");
+                        }
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    else if (codePoint >= 0xDC00 && codePoint < 0xE000) {
+                        return fail("Unpaired surrogate");
+                    }
+                    appendUtf8(out, codePoint);
+                    break;
+                }
+                default:
+                    return fail("Invalid escape");
+                }
+                pRun = m_pCursor;
+            }
+        }
+
+        bool parseNumber(JsonValue& out)
+        {
+            // Validate the JSON grammar first: from_chars also accepts things JSON doesn't (e.g. "inf")
+            const char* pStart = m_pCursor;
+            const char* p = m_pCursor;
+            if (p < m_pEnd && *p == '-') {
+                p++;
+            }
+            if (p == m_pEnd || *p < '0' || *p > '9') {
+                return fail("Invalid value");
+            }
+            if (*p == '0') {
+                p++;
+            }
+            else {
+                while (p < m_pEnd && *p >= '0' && *p <= '9') {
+                    p++;
+                }
+            }
+            if (p < m_pEnd && *p == '.') {
+                p++;
+                if (p == m_pEnd || *p < '0' || *p > '9') {
+                    return fail("Invalid number");
+                }
+                while (p < m_pEnd && *p >= '0' && *p <= '9') {
+                    p++;
+                }
+            }
+            if (p < m_pEnd && (*p == 'e' || *p == 'E')) {
+                p++;
+                if (p < m_pEnd && (*p == '+' || *p == '-')) {
+                    p++;
+                }
+                if (p == m_pEnd || *p < '0' || *p > '9') {
+                    return fail("Invalid number");
+                }
+                while (p < m_pEnd && *p >= '0' && *p <= '9') {
+                    p++;
+                }
+            }
+
+            out.m_type = JsonType::Number;
+            const std::from_chars_result result = std::from_chars(pStart, p, out.m_number);
+            if (result.ec == std::errc::result_out_of_range) {
+                return fail("Number out of range");
+            }
+            m_pCursor = p;
+            return true;
+        }
+
+        const char* m_pCursor;
+        const char* m_pBegin;
+        const char* m_pEnd;
+        std::string m_error;
+        size_t m_errorOffset = 0;
+    };
+
+    bool parseJson(const char* pText, const size_t length, JsonValue& out, std::string* pError)
+    {
+        out = JsonValue{};
+        JsonParser parser{ pText, length };
+        return parser.parse(out, pError);
+    }
+}
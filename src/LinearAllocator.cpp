@@ -0,0 +1,65 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Author(s):  James Stanard
+//             Alex Nankervis
+//
+
+
+#include "LinearAllocator.h"
+
+namespace bdr
+{
+    GPUResource D3D12PageBacking::Create(LinearAllocatorType Type, size_t SizeInBytes)
+    {
+        ASSERT(pDevice != nullptr);
+
+        D3D12_HEAP_PROPERTIES HeapProps;
+        HeapProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+        HeapProps.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+        HeapProps.CreationNodeMask = 1;
+        HeapProps.VisibleNodeMask = 1;
+
+        D3D12_RESOURCE_DESC ResourceDesc;
+        ResourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+        ResourceDesc.Alignment = 0;
+        ResourceDesc.Width = SizeInBytes;
+        ResourceDesc.Height = 1;
+        ResourceDesc.DepthOrArraySize = 1;
+        ResourceDesc.MipLevels = 1;
+        ResourceDesc.Format = DXGI_FORMAT_UNKNOWN;
+        ResourceDesc.SampleDesc.Count = 1;
+        ResourceDesc.SampleDesc.Quality = 0;
+        ResourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+        D3D12_RESOURCE_STATES DefaultUsage;
+
+        if (Type == kGpuExclusive) {
+            HeapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+            ResourceDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+            DefaultUsage = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+        }
+        else {
+            HeapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+            ResourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+            DefaultUsage = D3D12_RESOURCE_STATE_GENERIC_READ;
+        }
+
+        ID3D12Resource* pBuffer;
+        ASSERT_SUCCEEDED(pDevice->CreateCommittedResource(&HeapProps, D3D12_HEAP_FLAG_NONE,
+            &ResourceDesc, DefaultUsage, nullptr, IID_PPV_ARGS(&pBuffer)));
+
+        pBuffer->SetName(L"LinearAllocator Page");
+
+        GPUResource Page{ pBuffer, DefaultUsage };
+        Page.gpuVirtualAddress = pBuffer->GetGPUVirtualAddress();
+        return Page;
+    }
+}
@@ -0,0 +1,176 @@
+#include "MappedFile.h"
+#include <algorithm>
+#include <utility>
+
+#ifdef _WIN32
+#include "stdafx.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace bdr
+{
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept :
+        m_pData{ std::exchange(other.m_pData, nullptr) },
+        m_size{ std::exchange(other.m_size, 0) },
+        m_isOpen{ std::exchange(other.m_isOpen, false) }
+    { }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other) {
+            close();
+            m_pData = std::exchange(other.m_pData, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+            m_isOpen = std::exchange(other.m_isOpen, false);
+        }
+        return *this;
+    }
+
+#ifdef _WIN32
+
+    bool MappedFile::open(const std::filesystem::path& path, const FileAccessHint hint)
+    {
+        close();
+
+        CREATEFILE2_EXTENDED_PARAMETERS extendedParams = {};
+        extendedParams.dwSize = sizeof(CREATEFILE2_EXTENDED_PARAMETERS);
+        extendedParams.dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+        extendedParams.dwFileFlags = hint == FileAccessHint::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN
+            : (hint == FileAccessHint::Random ? FILE_FLAG_RANDOM_ACCESS : 0);
+        extendedParams.dwSecurityQosFlags = SECURITY_ANONYMOUS;
+
+        Microsoft::WRL::Wrappers::FileHandle file{ CreateFile2(path.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, &extendedParams) };
+        if (!file.IsValid()) {
+            return false;
+        }
+
+        FILE_STANDARD_INFO fileInfo = {};
+        if (!GetFileInformationByHandleEx(file.Get(), FileStandardInfo, &fileInfo, sizeof(fileInfo))) {
+            return false;
+        }
+
+        const uint64_t size = uint64_t(fileInfo.EndOfFile.QuadPart);
+        if (size == 0) {
+            // Empty files can't be mapped
+            m_isOpen = true;
+            return true;
+        }
+
+        // The view keeps the mapping alive, so neither handle has to outlive this function
+        Microsoft::WRL::Wrappers::HandleT<Microsoft::WRL::Wrappers::HandleTraits::HANDLENullTraits> mapping{
+            CreateFileMapping(file.Get(), nullptr, PAGE_READONLY, 0, 0, nullptr)
+        };
+        if (!mapping.IsValid()) {
+            return false;
+        }
+
+        void* pView = MapViewOfFile(mapping.Get(), FILE_MAP_READ, 0, 0, 0);
+        if (pView == nullptr) {
+            return false;
+        }
+
+        m_pData = reinterpret_cast<const uint8_t*>(pView);
+        m_size = size;
+        m_isOpen = true;
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if (m_pData != nullptr) {
+            UnmapViewOfFile(m_pData);
+        }
+        m_pData = nullptr;
+        m_size = 0;
+        m_isOpen = false;
+    }
+
+    void MappedFile::prefetch(const uint64_t offset, const uint64_t size) const
+    {
+        if (offset >= m_size || size == 0) {
+            return;
+        }
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = const_cast<uint8_t*>(m_pData + offset);
+        range.NumberOfBytes = SIZE_T(std::min(size, m_size - offset));
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+
+#else
+
+    bool MappedFile::open(const std::filesystem::path& path, const FileAccessHint hint)
+    {
+        close();
+
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat fileInfo;
+        if (fstat(fd, &fileInfo) != 0) {
+            ::close(fd);
+            return false;
+        }
+
+        const uint64_t size = uint64_t(fileInfo.st_size);
+        if (size == 0) {
+            // Empty files can't be mapped
+            ::close(fd);
+            m_isOpen = true;
+            return true;
+        }
+
+        // The mapping holds its own reference to the file
+        void* pView = mmap(nullptr, size_t(size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (pView == MAP_FAILED) {
+            return false;
+        }
+
+        if (hint == FileAccessHint::Sequential) {
+            madvise(pView, size_t(size), MADV_SEQUENTIAL);
+        }
+        else if (hint == FileAccessHint::Random) {
+            madvise(pView, size_t(size), MADV_RANDOM);
+        }
+
+        m_pData = reinterpret_cast<const uint8_t*>(pView);
+        m_size = size;
+        m_isOpen = true;
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if (m_pData != nullptr) {
+            munmap(const_cast<uint8_t*>(m_pData), size_t(m_size));
+        }
+        m_pData = nullptr;
+        m_size = 0;
+        m_isOpen = false;
+    }
+
+    void MappedFile::prefetch(const uint64_t offset, const uint64_t size) const
+    {
+        if (offset >= m_size || size == 0) {
+            return;
+        }
+        // madvise wants a page aligned start
+        const uint64_t pageSize = uint64_t(sysconf(_SC_PAGESIZE));
+        const uint64_t begin = offset & ~(pageSize - 1);
+        const uint64_t end = offset + std::min(size, m_size - offset);
+        madvise(const_cast<uint8_t*>(m_pData + begin), size_t(end - begin), MADV_WILLNEED);
+    }
+
+#endif
+}
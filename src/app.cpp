@@ -34,6 +34,9 @@ namespace bdr
 
     void App::update()
     {
+        // Frame pacing waits happen here, before time and input are read, to keep input-to-present latency down
+        m_renderer.beginFrame();
+
         auto now = std::chrono::high_resolution_clock::now();
         auto time = now - m_startTime;
         float frame = std::chrono::duration_cast<std::chrono::duration<float>>(time).count();
@@ -5,13 +5,16 @@
 
 //_Use_decl_annotations_
 //int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
-int wmain(/*int argc, wchar_t** argv*/)
+int wmain(int argc, wchar_t** argv)
 {
     bdr::RenderConfig config{
         1280,
         720,
         L"",
     };
+    if (argc > 1) {
+        config.modelPath = argv[1];
+    }
 
     bdr::App app{ config };
 
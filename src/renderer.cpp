@@ -1,6 +1,9 @@
 #include "renderer.h"
 
 #include "dx_helpers.h"
+#include "StreamingWriter.h"
+#include <fstream>
+#include <stdexcept>
 #include "..\include\Camera.h"
 
 
@@ -8,14 +11,92 @@ using namespace DirectX;
 
 namespace bdr
 {
+    namespace
+    {
+        uint32_t getRecordingWorkerCount(const uint32_t requested, const uint32_t maxJobCount)
+        {
+            if (requested != 0) {
+                return requested;
+            }
+            // The main thread records too, and there are never more jobs than command lists
+            const uint32_t coreCount = XMMax(1u, std::thread::hardware_concurrency());
+            return XMMin(coreCount - 1u, maxJobCount - 1u);
+        }
+
+        // Clamped rather than trusted: the back buffer arrays and the pacer's slots only have room for
+        // FramePacer::MAX_FRAMES_IN_FLIGHT, and asserts don't guard release builds
+        uint32_t getFramesInFlight(const uint32_t requested)
+        {
+            return XMMin(XMMax(1u, requested), FramePacer::MAX_FRAMES_IN_FLIGHT);
+        }
+
+        // Turns command stream packets into D3D12 calls, skipping state the list already has. The list is reset
+        // with the first pipeline bound, so that's what it starts from.
+        struct CommandListTranslator
+        {
+            ID3D12GraphicsCommandList* pCommandList;
+            ID3D12PipelineState* const* pipelines;
+            const Mesh* const* meshes;
+            uint32_t boundPipelineId = 0;
+            uint32_t boundMeshId = UINT32_MAX;
+            uint64_t boundConstants = 0;
+
+            void operator()(const SetPipelinePacket& packet)
+            {
+                if (packet.pipelineId != boundPipelineId) {
+                    pCommandList->SetPipelineState(pipelines[packet.pipelineId]);
+                    boundPipelineId = packet.pipelineId;
+                }
+            }
+
+            void operator()(const SetMeshPacket& packet)
+            {
+                if (packet.meshId != boundMeshId) {
+                    const Mesh* pMesh = meshes[packet.meshId];
+                    pCommandList->IASetVertexBuffers(0, 1, &pMesh->vertexBufferView);
+                    pCommandList->IASetIndexBuffer(&pMesh->indexBufferView);
+                    boundMeshId = packet.meshId;
+                }
+            }
+
+            void operator()(const SetConstantsPacket& packet)
+            {
+                if (packet.gpuAddress != boundConstants) {
+                    pCommandList->SetGraphicsRootConstantBufferView(0, packet.gpuAddress);
+                    boundConstants = packet.gpuAddress;
+                }
+            }
+
+            void operator()(const DrawIndexedPacket& packet)
+            {
+                pCommandList->DrawIndexedInstanced(packet.indexCount, packet.instanceCount, packet.startIndex, packet.baseVertex, 0);
+            }
+        };
+    }
+
+    double QpcClock::nowMs()
+    {
+        static const double s_msPerTick = []() {
+            LARGE_INTEGER frequency;
+            QueryPerformanceFrequency(&frequency);
+            return 1000.0 / double(frequency.QuadPart);
+        }();
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        return double(counter.QuadPart) * s_msPerTick;
+    }
+
     Renderer::Renderer(const RenderConfig& renderConfig) :
         m_renderConfig(renderConfig),
         m_camera{ },
         m_rtvDescriptorSize{ 0 },
         m_frameIndex{ 0 },
+        m_backBufferCount{ XMMax(2u, getFramesInFlight(renderConfig.framesInFlight)) },
+        m_framePacer{ getFramesInFlight(renderConfig.framesInFlight) },
         m_aspectRatio{ static_cast<float>(renderConfig.width) / static_cast<float>(renderConfig.height) },
         m_viewport{ 0.0f, 0.0f, static_cast<FLOAT>(renderConfig.width), static_cast<FLOAT>(renderConfig.height) },
-        m_scissorRect{ 0, 0, LONG_MAX, LONG_MAX }
+        m_scissorRect{ 0, 0, LONG_MAX, LONG_MAX },
+        m_recordingPool{ getRecordingWorkerCount(renderConfig.recordingThreadCount, MAX_FRAME_COMMAND_LISTS) }
     {
         m_camera.position = XMVECTOR{ 0.0f, 0.0f, 5.0f, 1.0f };
         m_camera.updateProjection(60.0f, m_aspectRatio, 1.0f, 1000.0f);
@@ -26,14 +107,35 @@ namespace bdr
     {
         OutputDebugString(L"Cleaning up renderer\n");
 
+        // No more copies can be submitted behind the wait
+        m_gpuBufferManager.stopStreaming();
         waitForGPU();
 
-        m_cube.destroy();
+        std::ofstream frameTimingsFile{ GetAssetFullPath(L"frame_timings.csv") };
+        if (frameTimingsFile) {
+            m_framePacer.writeCsv(frameTimingsFile);
+        }
+        if (m_pTimestamps != nullptr) {
+            m_timestampReadback->Unmap(0, nullptr);
+            m_pTimestamps = nullptr;
+        }
+        m_timestampReadback.destroy();
 
-        for (size_t i = 0; i < FRAME_COUNT; i++) {
-            m_renderTargets[i].destroy();
-            m_depthBuffers[i].destroy();
+        // Dumped before anything is torn down so live bytes reflect the steady state
+        std::ofstream memoryStatsFile{ GetAssetFullPath(L"memory_stats.json") };
+        if (memoryStatsFile) {
+            MemoryStatsRegistry::get().writeJson(memoryStatsFile);
         }
+
+        m_cube.destroy(m_gpuBufferManager);
+        for (Mesh& mesh : m_modelMeshes) {
+            mesh.destroy(m_gpuBufferManager);
+        }
+
+        // The GPU is idle, so every page can go regardless of fences
+        LinearAllocator::DestroyAll();
+
+        releaseRenderTargets(m_cmdQueueManager.m_graphicsQueue.getNextFenceValue() - 1);
     }
 
 
@@ -43,6 +145,9 @@ namespace bdr
         m_windowHandle = windowHandle;
         initPipeline();
         initAssets();
+
+        // From here on uploads are recorded and submitted off the render thread
+        m_gpuBufferManager.startStreaming();
     }
 
     void Renderer::initPipeline()
@@ -81,12 +186,19 @@ namespace bdr
         ));
 
         m_cmdQueueManager.init(m_device.Get());
+        m_pRenderTargetStats = MemoryStatsRegistry::get().getCategory("Renderer/RenderTargets");
+
+        D3D12PageBacking pageBacking;
+        pageBacking.pDevice = m_device.Get();
+        D3D12FencePolicy fencePolicy;
+        fencePolicy.pQueueManager = &m_cmdQueueManager;
+        LinearAllocator::InitAll(pageBacking, fencePolicy);
 
         m_gpuBufferManager.init(m_device.Get(), &m_cmdQueueManager);
 
         // Swap Chain
         DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
-        swapChainDesc.BufferCount = FRAME_COUNT;
+        swapChainDesc.BufferCount = m_backBufferCount;
         swapChainDesc.Width = uint32_t{ m_renderConfig.width };
         swapChainDesc.Height = uint32_t{ m_renderConfig.height };
         swapChainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -117,7 +229,7 @@ namespace bdr
         {
             // Render Target View (rtv) heap
             D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {};
-            rtvHeapDesc.NumDescriptors = FRAME_COUNT;
+            rtvHeapDesc.NumDescriptors = m_backBufferCount;
             rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
             rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
             ThrowIfFailed(m_device->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&m_rtvHeap)));
@@ -125,28 +237,13 @@ namespace bdr
             m_rtvDescriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 
             D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc{};
-            dsvHeapDesc.NumDescriptors = FRAME_COUNT;
+            dsvHeapDesc.NumDescriptors = m_backBufferCount;
             dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
             dsvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
             ThrowIfFailed(m_device->CreateDescriptorHeap(&dsvHeapDesc, IID_PPV_ARGS(&m_dsvHeap)));
-
-            // CBV Heaps
-            D3D12_DESCRIPTOR_HEAP_DESC cbvHeapDesc = {};
-            cbvHeapDesc.NumDescriptors = 1;
-            cbvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-            cbvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-            ThrowIfFailed(m_device->CreateDescriptorHeap(
-                &cbvHeapDesc,
-                IID_PPV_ARGS(&m_cbvHeap)
-            ));
         }
         // Initialize our render target views
         recreateRenderTargetViews();
-
-        // Create command allocators for each frame
-        for (uint32_t i = 0; i < FRAME_COUNT; ++i) {
-            ThrowIfFailed(m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_commandAllocators[i])));
-        }
     }
 
 
@@ -161,17 +258,15 @@ namespace bdr
                 featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
             }
 
-            CD3DX12_DESCRIPTOR_RANGE1 ranges[1]{};
             CD3DX12_ROOT_PARAMETER1 rootParameters[1]{};
 
-            ranges[0].Init(
-                D3D12_DESCRIPTOR_RANGE_TYPE_CBV,
-                1,
+            // Constants are bound per draw straight from their GPU address, no descriptors needed
+            rootParameters[0].InitAsConstantBufferView(
                 0,
                 0,
-                D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC
+                D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE,
+                D3D12_SHADER_VISIBILITY_VERTEX
             );
-            rootParameters[0].InitAsDescriptorTable(1, &ranges[0], D3D12_SHADER_VISIBILITY_VERTEX);
 
             D3D12_ROOT_SIGNATURE_FLAGS flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT
                 | D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS
@@ -270,23 +365,60 @@ namespace bdr
             psoDesc.SampleDesc.Count = 1;
 
             ThrowIfFailed(m_device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_pipelineState)));
+            m_pipelines.push_back(m_pipelineState.Get());
             }
 
-        // Command List
-        ThrowIfFailed(m_device->CreateCommandList(
-            0,
-            D3D12_COMMAND_LIST_TYPE_DIRECT,
-            m_commandAllocators[m_frameIndex].Get(),
-            m_pipelineState.Get(),
-            IID_PPV_ARGS(&m_commandList)
-        ));
-
-        // CommandLists are created in the recording state, but we're not recording yet.
-        // Let's close it!
-        ThrowIfFailed(m_commandList->Close());
+        // Command Lists
+        {
+            CommandQueue& graphicsQueue = m_cmdQueueManager.m_graphicsQueue;
+            ID3D12CommandAllocator* pAllocator = graphicsQueue.requestAllocator();
+            for (uint32_t i = 0; i < MAX_FRAME_COMMAND_LISTS; ++i) {
+                ThrowIfFailed(m_device->CreateCommandList(
+                    0,
+                    D3D12_COMMAND_LIST_TYPE_DIRECT,
+                    pAllocator,
+                    m_pipelineState.Get(),
+                    IID_PPV_ARGS(&m_commandLists[i])
+                ));
+                m_commandLists[i]->SetName(L"Frame CommandList");
+
+                // CommandLists are created in the recording state, but we're not recording yet.
+                // Let's close it! Only one list can be recording into an allocator at a time anyway.
+                ThrowIfFailed(m_commandLists[i]->Close());
+            }
+            // Nothing was recorded, so it can be handed out again straight away
+            graphicsQueue.returnAllocator(0, pAllocator);
+        }
 
-        // Vertex Buffer
+        // Timestamp queries
         {
+            D3D12_QUERY_HEAP_DESC queryHeapDesc{};
+            queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+            queryHeapDesc.Count = 2 * FramePacer::MAX_FRAMES_IN_FLIGHT;
+            ThrowIfFailed(m_device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_timestampHeap)));
+
+            ThrowIfFailed(m_device->CreateCommittedResource(
+                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+                D3D12_HEAP_FLAG_NONE,
+                &CD3DX12_RESOURCE_DESC::Buffer(queryHeapDesc.Count * sizeof(uint64_t)),
+                D3D12_RESOURCE_STATE_COPY_DEST,
+                nullptr,
+                IID_PPV_ARGS(m_timestampReadback.getPPtr())
+            ));
+            m_timestampReadback->SetName(L"Timestamp Readback");
+            m_timestampReadback.usageState = D3D12_RESOURCE_STATE_COPY_DEST;
+
+            // Slots are only read once the frame that wrote them has completed
+            void* pTimestamps = nullptr;
+            ThrowIfFailed(m_timestampReadback->Map(0, nullptr, &pTimestamps));
+            m_pTimestamps = static_cast<const uint64_t*>(pTimestamps);
+            ThrowIfFailed(m_cmdQueueManager.m_graphicsQueue.get()->GetTimestampFrequency(&m_gpuTimestampFrequency));
+        }
+
+        if (!m_renderConfig.modelPath.empty()) {
+            loadModel(m_renderConfig.modelPath);
+        }
+        else {
             const UINT vertexBufferSize = sizeof(cubeVertices);
             const UINT indexBufferSize = sizeof(cubeIndices);
 
@@ -313,36 +445,155 @@ namespace bdr
             m_cube.mesh.indexBufferView.BufferLocation = m_cube.mesh.indexBuffer.gpuVirtualAddress;
             m_cube.mesh.indexBufferView.SizeInBytes = indexBufferSize;
             m_cube.mesh.indexBufferView.Format = DXGI_FORMAT_R16_UINT;
+            m_cube.mesh.indexCount = _countof(cubeIndices);
+            m_meshes.push_back(&m_cube.mesh);
         }
 
-        // Constant Buffer
-        {
-            // TODO: What is the deal with the third argument
-            ThrowIfFailed(m_device->CreateCommittedResource(
-                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-                D3D12_HEAP_FLAG_NONE,
-                &CD3DX12_RESOURCE_DESC::Buffer(1024 * 64),
-                D3D12_RESOURCE_STATE_GENERIC_READ,
-                nullptr,
-                IID_PPV_ARGS(&m_constantBuffer)
-            ));
+        // Wait for our setup to complete before continuing
+        waitForGPU();
+        }
 
-            // Describe and create the constant buffer view
-            D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc{ };
-            cbvDesc.BufferLocation = m_constantBuffer->GetGPUVirtualAddress();
-            cbvDesc.SizeInBytes = (sizeof(MVPTransforms) + 255) & ~255; // CB size is required to be 256-byte aligned
-            m_device->CreateConstantBufferView(&cbvDesc, m_cbvHeap->GetCPUDescriptorHandleForHeapStart());
-
-            // Map and initialize the constant buffer. Since we update this each frame, we won't unmap until we close the application
-            // e.g. the full lifetime of the resource
-            CD3DX12_RANGE readRange(0, 0);
-            ThrowIfFailed(m_constantBuffer->Map(0, &readRange, reinterpret_cast<void**>(&m_pCbvDataBegin)));
-            memcpy(m_pCbvDataBegin, &m_mvpTransforms, sizeof(m_mvpTransforms));
+    void Renderer::loadModel(const std::wstring& path)
+    {
+        GltfAsset asset;
+        std::string error;
+        if (!asset.load(path, &error)) {
+            throw std::runtime_error(error);
         }
 
-        // Wait for our setup to complete before continuing
-        waitForGPU();
+        const double stageStart = QpcClock::nowMs();
+        const std::vector<GltfPrimitive>& primitives = asset.getPrimitives();
+        const uint32_t primitiveCount = uint32_t(primitives.size());
+        // m_meshes points into m_modelMeshes, so it can't grow after this
+        m_modelMeshes.resize(primitiveCount);
+
+        auto initMesh = [](Mesh& mesh, const GltfPrimitive& primitive) {
+            mesh.vertexBufferView.BufferLocation = mesh.vertexBuffer.gpuVirtualAddress;
+            mesh.vertexBufferView.StrideInBytes = sizeof(Vertex);
+            mesh.vertexBufferView.SizeInBytes = UINT(primitive.getVertexBytes());
+            mesh.indexBufferView.BufferLocation = mesh.indexBuffer.gpuVirtualAddress;
+            mesh.indexBufferView.SizeInBytes = UINT(primitive.getIndexBytes());
+            mesh.indexBufferView.Format = primitive.indexSize == 4 ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+            mesh.indexCount = primitive.indexCount;
+        };
+        auto getBufferDescs = [](const GltfPrimitive& primitive, GPUBufferManager::InPlaceBufferDesc* pDescs) {
+            pDescs[0] = GPUBufferManager::InPlaceBufferDesc{ primitive.vertexCount, sizeof(Vertex) };
+            pDescs[1] = GPUBufferManager::InPlaceBufferDesc{ primitive.indexCount, primitive.indexSize };
+            return GPUBufferManager::getInPlaceStagingSize(pDescs[0]) + GPUBufferManager::getInPlaceStagingSize(pDescs[1]);
+        };
+
+        // Primitives are decoded across the recording pool straight into upload staging, in batches of up to
+        // a chunk of the upload ring
+        std::vector<GPUBufferManager::InPlaceBufferDesc> descs;
+        std::vector<GPUBuffer> buffers;
+        std::vector<GltfVertex*> vertexDests;
+        std::vector<void*> indexDests;
+        for (uint32_t first = 0; first < primitiveCount;) {
+            GPUBufferManager::InPlaceBufferDesc primitiveDescs[2];
+            uint64_t batchSize = getBufferDescs(primitives[first], primitiveDescs);
+
+            if (batchSize > GPUBufferManager::UPLOAD_MAX_CHUNK) {
+                // Too big to stage in one piece of the ring, so decode it on the heap and let createOnGPU split
+                // the upload into chunks
+                const GltfPrimitive& primitive = primitives[first];
+                std::vector<GltfVertex> vertices(primitive.vertexCount);
+                std::vector<uint8_t> indices(primitive.getIndexBytes());
+                GltfVertex* pVertices = vertices.data();
+                void* pIndices = indices.data();
+                asset.decode(m_recordingPool, first, 1, &pVertices, &pIndices);
+
+                Mesh& mesh = m_modelMeshes[first];
+                mesh.vertexBuffer = m_gpuBufferManager.createOnGPU(L"vertex buffer", primitive.vertexCount, sizeof(Vertex), pVertices);
+                mesh.indexBuffer = m_gpuBufferManager.createOnGPU(L"index buffer", primitive.indexCount, primitive.indexSize, pIndices);
+                initMesh(mesh, primitive);
+                first++;
+                continue;
+            }
+
+            descs.assign(primitiveDescs, primitiveDescs + 2);
+            uint32_t count = 1;
+            while (first + count < primitiveCount) {
+                const uint64_t size = getBufferDescs(primitives[first + count], primitiveDescs);
+                if (batchSize + size > GPUBufferManager::UPLOAD_MAX_CHUNK) {
+                    break;
+                }
+                descs.insert(descs.end(), primitiveDescs, primitiveDescs + 2);
+                batchSize += size;
+                count++;
+            }
+
+            buffers.resize(descs.size());
+            m_gpuBufferManager.createOnGPUInPlace(descs.data(), uint32_t(descs.size()), buffers.data(), [&](uint8_t* const* ppStaging) {
+                vertexDests.resize(count);
+                indexDests.resize(count);
+                for (uint32_t i = 0; i < count; i++) {
+                    vertexDests[i] = reinterpret_cast<GltfVertex*>(ppStaging[2 * i]);
+                    indexDests[i] = ppStaging[2 * i + 1];
+                }
+                asset.decode(m_recordingPool, first, count, vertexDests.data(), indexDests.data());
+            });
+
+            for (uint32_t i = 0; i < count; i++) {
+                Mesh& mesh = m_modelMeshes[first + i];
+                mesh.vertexBuffer = buffers[2 * i];
+                mesh.indexBuffer = buffers[2 * i + 1];
+                initMesh(mesh, primitives[first + i]);
+            }
+            first += count;
         }
+        const double stagedMs = QpcClock::nowMs();
+
+        m_gpuBufferManager.execute(true);
+        const double uploadedMs = QpcClock::nowMs();
+
+        for (const Mesh& mesh : m_modelMeshes) {
+            m_meshes.push_back(&mesh);
+        }
+
+        const GltfLoadTimings& timings = asset.getTimings();
+        char message[256];
+        snprintf(
+            message,
+            sizeof(message),
+            "Loaded %u primitives: map %.2f ms, parse %.2f ms, resolve %.2f ms, decode %.2f ms, stage %.2f ms, upload %.2f ms\n",
+            primitiveCount,
+            timings.mapMs,
+            timings.parseMs,
+            timings.resolveMs,
+            timings.decodeMs,
+            stagedMs - stageStart - timings.decodeMs,
+            uploadedMs - stagedMs
+        );
+        OutputDebugStringA(message);
+    }
+
+    void Renderer::beginFrame()
+    {
+        CommandQueue& graphicsQueue = m_cmdQueueManager.m_graphicsQueue;
+        m_framePacer.beginFrame([&graphicsQueue](const uint64_t fenceValue) {
+            graphicsQueue.waitForFence(fenceValue);
+        });
+
+        if (m_framePacer.hasCompletedFrame()) {
+            // The slot's previous frame has finished, so its timestamps have landed in the readback buffer
+            const uint32_t slot = m_framePacer.getFrameSlot();
+            const uint64_t gpuBegin = m_pTimestamps[2 * slot];
+            const uint64_t gpuEnd = m_pTimestamps[2 * slot + 1];
+
+            // Maps GPU ticks onto QPC so they can be compared with the CPU side of the frame
+            uint64_t calibrationGpu = 0;
+            uint64_t calibrationCpu = 0;
+            ThrowIfFailed(graphicsQueue.get()->GetClockCalibration(&calibrationGpu, &calibrationCpu));
+            LARGE_INTEGER qpcFrequency;
+            QueryPerformanceFrequency(&qpcFrequency);
+            const double calibrationMs = double(calibrationCpu) * 1000.0 / double(qpcFrequency.QuadPart);
+            const double msPerTick = 1000.0 / double(m_gpuTimestampFrequency);
+            m_framePacer.completeFrame(
+                calibrationMs - double(calibrationGpu - gpuBegin) * msPerTick,
+                calibrationMs - double(calibrationGpu - gpuEnd) * msPerTick
+            );
+        }
+    }
 
     void Renderer::onUpdate(float deltaTime, float timeElapsed)
     {
@@ -355,22 +606,66 @@ namespace bdr
             m_camera.storeViewProjectionAsFloat4x4(&m_mvpTransforms.viewProjection);
         }
 
-        memcpy(m_pCbvDataBegin, &m_mvpTransforms, sizeof(m_mvpTransforms));
+        m_commandStream.clear();
+        for (uint32_t meshId = 0; meshId < m_meshes.size(); meshId++) {
+            recordMeshDraw(0, 0, meshId, m_meshes[meshId]->indexCount, m_mvpTransforms);
+        }
+    }
+
+    void Renderer::recordMeshDraw(const uint32_t pipelineId, const uint32_t materialId, const uint32_t meshId, const uint32_t indexCount, const MVPTransforms& transforms)
+    {
+        // Each draw gets its own copy of its constants
+        DynAlloc constants = m_constantAllocator.Allocate(sizeof(MVPTransforms));
+        {
+            StreamingWriter writer{ constants };
+            writer.write(transforms);
+        }
+
+        // Front to back by the distance from the camera to the model's origin
+        const XMVECTOR origin = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&transforms.model.m[3]));
+        const float depth = XMVectorGetX(XMVector3Length(XMVectorSubtract(origin, m_camera.position))) / m_camera.far_;
+
+        m_commandStream.beginCommand(SortKey::make(0, pipelineId, materialId, depth));
+        m_commandStream.push(SetPipelinePacket{ SetPipelinePacket::TYPE, pipelineId });
+        m_commandStream.push(SetMeshPacket{ SetMeshPacket::TYPE, meshId });
+        m_commandStream.push(SetConstantsPacket{ SetConstantsPacket::TYPE, 0, constants.GpuAddress });
+        DrawIndexedPacket draw;
+        draw.indexCount = indexCount;
+        m_commandStream.push(draw);
+        m_commandStream.endCommand();
     }
 
     void Renderer::onRender()
     {
-        // Record all the commands we need to render the scene into the command list
-        populateCommandList();
+        // Record all the commands we need to render the scene, spread over the recording threads
+        populateCommandLists();
+
+        // Execute everything recorded for this frame with a single submit. The graphics queue only waits on the
+        // copy queue if this frame's uploads haven't finished and it hasn't already waited for them.
+        CommandQueue& graphicsQueue = m_cmdQueueManager.m_graphicsQueue;
+        const uint64_t uploadFence = m_gpuBufferManager.getLastUploadFence();
+        const uint64_t fenceValue = m_cmdQueueManager.submitBatch(D3D12_COMMAND_LIST_TYPE_DIRECT, m_frameBatch, &uploadFence, 1);
+        m_framePacer.endFrame(fenceValue);
+
+        // The lists can be reset right away, but their allocators are in use until the GPU gets through the frame
+        for (uint32_t i = 0; i < m_frameCommandListCount; ++i) {
+            graphicsQueue.returnAllocator(fenceValue, m_frameAllocators[i], m_frameAllocatorSizes[i]);
+            m_frameAllocators[i] = nullptr;
+        }
 
-        // Execute the command list
-        m_fenceValues[m_frameIndex] = m_cmdQueueManager.m_graphicsQueue.executeCommandList(m_commandList.Get());
+        // This frame's constants can be recycled once the GPU is done with it
+        m_constantAllocator.CleanupUsedPages(fenceValue);
+        LinearAllocator::TrimIdleAll(IDLE_PAGE_FRAME_LIMIT);
 
         // Present
         // TODO: Look up syncInterval parameter here
         ThrowIfFailed(m_swapChain->Present(1, 0));
 
-        moveToNextFrame();
+        MemoryStatsRegistry::get().endFrame();
+        m_cmdQueueManager.endFrame();
+
+        // beginFrame does the waiting, bounded by the number of frames in flight
+        m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
     }
 
     void Renderer::onResize(uint16_t width, uint16_t height)
@@ -387,14 +682,8 @@ namespace bdr
             m_aspectRatio = static_cast<float>(width) / static_cast<float>(height);
             m_camera.updateProjection(m_aspectRatio);
 
-            waitForGPU();
-
-            // Release existing references to the backbuffers and swapchain
-            for (uint32_t i = 0; i < FRAME_COUNT; ++i) {
-                m_renderTargets[i].destroy();
-                m_depthBuffers[i].destroy();
-
-            }
+            // Only the graphics queue touches the render targets, so there's no need to idle the whole device
+            releaseRenderTargets(m_cmdQueueManager.m_graphicsQueue.getNextFenceValue() - 1);
 
             DXGI_SWAP_CHAIN_DESC swapChainDesc = {};
             ThrowIfFailed(m_swapChain->GetDesc(&swapChainDesc));
@@ -414,12 +703,15 @@ namespace bdr
         CD3DX12_CPU_DESCRIPTOR_HANDLE dsvHandle(m_dsvHeap->GetCPUDescriptorHandleForHeapStart());
 
         // Create an RTV handle for each frame
-        for (uint32_t n = 0; n < FRAME_COUNT; n++) {
+        for (uint32_t n = 0; n < m_backBufferCount; n++) {
             ID3D12Resource** ppRenderTarget = m_renderTargets[n].getPPtr();
             ThrowIfFailed(m_swapChain->GetBuffer(n, IID_PPV_ARGS(ppRenderTarget)));
+            m_renderTargets[n].usageState = D3D12_RESOURCE_STATE_PRESENT;
             m_device->CreateRenderTargetView(*ppRenderTarget, nullptr, rtvHandle);
             rtvHandle.Offset(1, m_rtvDescriptorSize);
             (*ppRenderTarget)->SetName(L"Render Target");
+            const D3D12_RESOURCE_DESC renderTargetDesc = (*ppRenderTarget)->GetDesc();
+            m_renderTargetBytes += m_device->GetResourceAllocationInfo(0, 1, &renderTargetDesc).SizeInBytes;
 
             // Resize screen dependent resources.
             // Create a depth buffer.
@@ -443,6 +735,9 @@ namespace bdr
                 IID_PPV_ARGS(ppDepthBuffer)
             ));
             (*ppDepthBuffer)->SetName(L"Depth Buffer");
+            m_depthBuffers[n].usageState = D3D12_RESOURCE_STATE_DEPTH_WRITE;
+            const D3D12_RESOURCE_DESC depthBufferDesc = (*ppDepthBuffer)->GetDesc();
+            m_renderTargetBytes += m_device->GetResourceAllocationInfo(0, 1, &depthBufferDesc).SizeInBytes;
 
             // Update the depth-stencil view.
             D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
@@ -454,81 +749,153 @@ namespace bdr
             m_device->CreateDepthStencilView(*ppDepthBuffer, &dsvDesc, dsvHandle);
             dsvHandle.Offset(1, m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV));
         }
+        m_pRenderTargetStats->onAllocate(m_renderTargetBytes, 2 * m_backBufferCount);
     }
 
-    void Renderer::populateCommandList()
+    void Renderer::releaseRenderTargets(const uint64_t lastUsedFence)
     {
-        //
-        // Command list allocators can only be reset when the associated 
-        // command lists have finished execution on the GPU; apps should use 
-        // fences to determine GPU execution progress.
-        ThrowIfFailed(m_commandAllocators[m_frameIndex]->Reset());
+        for (uint32_t i = 0; i < m_backBufferCount; ++i) {
+            m_cmdQueueManager.deferRelease(m_depthBuffers[i], lastUsedFence);
+        }
 
-        // However, when ExecuteCommandList() is called on a particular command 
-        // list, that command list can then be reset at any time and must be before 
-        // re-recording.
-        ThrowIfFailed(m_commandList->Reset(m_commandAllocators[m_frameIndex].Get(), m_pipelineState.Get()));
+        // DXGI wants every reference to the back buffers gone before ResizeBuffers, so these can't be deferred
+        m_cmdQueueManager.m_graphicsQueue.waitForFence(lastUsedFence);
+        for (uint32_t i = 0; i < m_backBufferCount; ++i) {
+            m_renderTargets[i].destroy();
+        }
+        m_pRenderTargetStats->onFree(m_renderTargetBytes, 2 * m_backBufferCount);
+        m_renderTargetBytes = 0;
+    }
 
-        m_gpuBufferManager.execute(true);
+    void Renderer::populateCommandLists()
+    {
+        // Streamed uploads are submitted by the streaming thread; copies and updates staged on this thread go here.
+        // The graphics queue waits on the copy queue on the GPU, so nothing here blocks on the uploads.
+        m_gpuBufferManager.execute();
         // TODO: Figure out a better way to manage this thing's state
         m_gpuBufferManager.reset();
 
-        // Set necessary state.
-        m_commandList->SetGraphicsRootSignature(m_rootSignature.Get());
+        m_commandStream.sort();
+        const uint32_t drawCount = m_commandStream.getCommandCount();
+        const uint32_t drawJobCount = XMMax(1u, XMMin(MAX_DRAW_JOBS, (drawCount + MIN_DRAWS_PER_JOB - 1u) / MIN_DRAWS_PER_JOB));
+        m_frameCommandListCount = drawJobCount + 2u;
+        planFrameBarriers();
+
+        // Reserve a slot per job up front so the lists are submitted in job order, not in the order the
+        // threads happen to finish them
+        uint32_t batchSlots[MAX_FRAME_COMMAND_LISTS];
+        for (uint32_t i = 0; i < m_frameCommandListCount; ++i) {
+            batchSlots[i] = m_frameBatch.reserve();
+        }
 
-        ID3D12DescriptorHeap* ppHeaps[] = { m_cbvHeap.Get() };
-        m_commandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
-        m_commandList->SetGraphicsRootDescriptorTable(0, m_cbvHeap->GetGPUDescriptorHandleForHeapStart());
+        CommandQueue& graphicsQueue = m_cmdQueueManager.m_graphicsQueue;
+        m_recordingPool.parallelFor(m_frameCommandListCount, [&](const uint32_t jobIdx) {
+            const bool isDrawJob = jobIdx != 0 && jobIdx != m_frameCommandListCount - 1u;
+            const uint32_t firstDraw = isDrawJob ? uint32_t(uint64_t(drawCount) * (jobIdx - 1u) / drawJobCount) : 0u;
+            const uint32_t endDraw = isDrawJob ? uint32_t(uint64_t(drawCount) * jobIdx / drawJobCount) : 0u;
+            // The packets a job translates are a fair stand-in for what it records, so heavy draw jobs keep
+            // getting the allocators that have already grown to their size. The frame begin and end lists are tiny.
+            const uint64_t expectedSize = m_commandStream.getPacketBytes(firstDraw, endDraw - firstDraw);
+
+            // Requested on the recording thread so the pool hands this thread back its own allocators
+            ID3D12CommandAllocator* pAllocator = graphicsQueue.requestAllocator(expectedSize);
+            ID3D12GraphicsCommandList* pCommandList = m_commandLists[jobIdx].Get();
+            ThrowIfFailed(pCommandList->Reset(pAllocator, m_pipelineState.Get()));
+            recordBarriers(pCommandList, m_barrierPlanner.getBarriers(jobIdx));
+
+            if (jobIdx == 0) {
+                recordFrameBegin(pCommandList);
+            }
+            else if (isDrawJob) {
+                recordDraws(pCommandList, firstDraw, endDraw - firstDraw);
+            }
+            else {
+                recordFrameEnd(pCommandList);
+            }
 
-        m_commandList->RSSetViewports(1, &m_viewport);
-        m_commandList->RSSetScissorRects(1, &m_scissorRect);
+            ThrowIfFailed(pCommandList->Close());
+            m_frameAllocators[jobIdx] = pAllocator;
+            m_frameAllocatorSizes[jobIdx] = expectedSize;
+            m_frameBatch.set(batchSlots[jobIdx], pCommandList);
+        });
+    }
 
-        // Indicate that the back buffer will be used as a render target.
-        m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_frameIndex].get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
+    void Renderer::planFrameBarriers()
+    {
+        // One pass per command list: the list opening the frame clears, the draw lists render, and the closing
+        // list presents
+        const uint32_t passCount = m_frameCommandListCount;
+        GPUResource& backBuffer = m_renderTargets[m_frameIndex];
+        GPUResource& depthBuffer = m_depthBuffers[m_frameIndex];
+
+        m_barrierPlanner.reset(passCount);
+        m_barrierPlanner.registerResource(backBuffer.get(), backBuffer.usageState);
+        m_barrierPlanner.registerResource(depthBuffer.get(), depthBuffer.usageState);
+        for (uint32_t pass = 0; pass < passCount - 1u; ++pass) {
+            m_barrierPlanner.use(pass, backBuffer.get(), D3D12_RESOURCE_STATE_RENDER_TARGET);
+            m_barrierPlanner.use(pass, depthBuffer.get(), D3D12_RESOURCE_STATE_DEPTH_WRITE);
+        }
+        m_barrierPlanner.use(passCount - 1u, backBuffer.get(), D3D12_RESOURCE_STATE_PRESENT);
+        m_barrierPlanner.plan();
 
-        CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), m_frameIndex, m_rtvDescriptorSize);
-        CD3DX12_CPU_DESCRIPTOR_HANDLE dsvHandle(
-            m_dsvHeap->GetCPUDescriptorHandleForHeapStart(),
-            m_frameIndex,
-            m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV)
-        );
+        backBuffer.usageState = static_cast<D3D12_RESOURCE_STATES>(m_barrierPlanner.getFinalState(backBuffer.get()));
+        depthBuffer.usageState = static_cast<D3D12_RESOURCE_STATES>(m_barrierPlanner.getFinalState(depthBuffer.get()));
+    }
 
-        m_commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
+    void Renderer::recordFrameBegin(ID3D12GraphicsCommandList* pCommandList)
+    {
+        pCommandList->EndQuery(m_timestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 2 * m_framePacer.getFrameSlot());
+
+        const CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle = getCurrentRtvHandle();
+        const CD3DX12_CPU_DESCRIPTOR_HANDLE dsvHandle = getCurrentDsvHandle();
 
-        // Record commands.
         const float clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
-        m_commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
-        m_commandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
-        m_commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        m_commandList->IASetVertexBuffers(0, 1, &m_cube.mesh.vertexBufferView);
-        m_commandList->IASetIndexBuffer(&m_cube.mesh.indexBufferView);
-        m_commandList->DrawIndexedInstanced(_countof(cubeIndices), 1, 0, 0, 0);
+        pCommandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
+        pCommandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+    }
+
+    void Renderer::recordDraws(ID3D12GraphicsCommandList* pCommandList, const uint32_t firstCommand, const uint32_t commandCount)
+    {
+        // Command lists don't inherit state from the ones before them, so every draw list sets up its own
+        pCommandList->SetGraphicsRootSignature(m_rootSignature.Get());
 
-        // Indicate that the back buffer will now be used to present.
-        m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_frameIndex].get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
+        pCommandList->RSSetViewports(1, &m_viewport);
+        pCommandList->RSSetScissorRects(1, &m_scissorRect);
 
-        ThrowIfFailed(m_commandList->Close());
+        const CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle = getCurrentRtvHandle();
+        const CD3DX12_CPU_DESCRIPTOR_HANDLE dsvHandle = getCurrentDsvHandle();
+        pCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
+        pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
+        CommandListTranslator translator{ pCommandList, m_pipelines.data(), m_meshes.data() };
+        m_commandStream.translate(firstCommand, commandCount, translator);
     }
 
-    void Renderer::waitForGPU()
+    void Renderer::recordFrameEnd(ID3D12GraphicsCommandList* pCommandList)
     {
-        m_cmdQueueManager.m_graphicsQueue.incrementFence();
-        m_cmdQueueManager.waitForIdle();
+        const uint32_t firstQuery = 2 * m_framePacer.getFrameSlot();
+        pCommandList->EndQuery(m_timestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, firstQuery + 1);
+        pCommandList->ResolveQueryData(m_timestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, firstQuery, 2, m_timestampReadback.get(), firstQuery * sizeof(uint64_t));
     }
 
-    void Renderer::moveToNextFrame()
+    CD3DX12_CPU_DESCRIPTOR_HANDLE Renderer::getCurrentRtvHandle() const
     {
-        const uint64_t fenceValue = m_fenceValues[m_frameIndex];
-
-        // Update the frame index.
-        m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
+        return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), m_frameIndex, m_rtvDescriptorSize);
+    }
 
-        // If the next frame is not ready to be rendered yet, wait until it is ready.
-        m_cmdQueueManager.m_graphicsQueue.waitForFence(fenceValue);
+    CD3DX12_CPU_DESCRIPTOR_HANDLE Renderer::getCurrentDsvHandle() const
+    {
+        return CD3DX12_CPU_DESCRIPTOR_HANDLE(
+            m_dsvHeap->GetCPUDescriptorHandleForHeapStart(),
+            m_frameIndex,
+            m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV)
+        );
+    }
 
-        //// Set the fence value for the next frame.
-        //m_fenceValues[m_frameIndex] = fenceValue + 1;
+    void Renderer::waitForGPU()
+    {
+        m_cmdQueueManager.m_graphicsQueue.incrementFence();
+        m_cmdQueueManager.waitForIdle();
     }
 
     _Use_decl_annotations_
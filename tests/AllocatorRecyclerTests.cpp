@@ -0,0 +1,184 @@
+#include "TestHarness.h"
+#include <atomic>
+#include <thread>
+
+#include "AllocatorRecycler.h"
+#include "SimulatedFence.h"
+
+using namespace bdr;
+
+namespace
+{
+    // Stands in for a command allocator: remembers what it was last used for so the tests can check the
+    // recycler's choices
+    struct FakeAllocator
+    {
+        std::atomic<bool> isInUse{ false };
+        uint64_t lastFence = 0;
+        uint64_t lastRecordedSize = 0;
+    };
+
+    constexpr uint64_t HEAVY_SIZE = 4ull << 20;
+    constexpr uint64_t LIGHT_SIZE = 100ull << 10;
+}
+
+TEST(AllocatorRecycler_SizeClasses)
+{
+    using Recycler = AllocatorRecyclerT<FakeAllocator>;
+    CHECK_EQ(Recycler::getSizeClass(0), 0u);
+    CHECK_EQ(Recycler::getSizeClass(64 * 1024 - 1), 0u);
+    CHECK_EQ(Recycler::getSizeClass(64 * 1024), 1u);
+    CHECK_EQ(Recycler::getSizeClass(256 * 1024), 2u);
+    CHECK_EQ(Recycler::getSizeClass(HEAVY_SIZE), 4u);
+    CHECK_EQ(Recycler::getSizeClass(UINT64_MAX), Recycler::SIZE_CLASS_COUNT - 1);
+}
+
+// Recording from one thread, like the copy queue: a heavy request must get back the object that was used for
+// heavy work before, even when lighter ones are ready too, and light requests must leave it alone
+TEST(AllocatorRecycler_HeavyRequestsGetHeavyObjects)
+{
+    AllocatorRecyclerT<FakeAllocator> recycler;
+    std::vector<FakeAllocator*> created;
+    const uint64_t requests[] = { LIGHT_SIZE, LIGHT_SIZE, HEAVY_SIZE, LIGHT_SIZE };
+
+    uint64_t fenceValue = 0;
+    bool isMatched = true;
+    for (uint32_t frame = 0; frame < 100; frame++) {
+        std::vector<FakeAllocator*> acquired;
+        for (const uint64_t request : requests) {
+            FakeAllocator* pItem = recycler.acquire(fenceValue, request);
+            if (pItem == nullptr) {
+                CHECK(recycler.tryReserveNew());
+                pItem = new FakeAllocator{};
+                created.push_back(pItem);
+                recycler.addNew(pItem);
+            }
+            else if (frame > 0) {
+                isMatched &= (request == HEAVY_SIZE) == (pItem->lastRecordedSize == HEAVY_SIZE);
+            }
+            pItem->lastRecordedSize = request;
+            acquired.push_back(pItem);
+        }
+        fenceValue++;
+        for (FakeAllocator* pItem : acquired) {
+            recycler.release(pItem, fenceValue, pItem->lastRecordedSize);
+        }
+    }
+    CHECK(isMatched);
+    CHECK_EQ(recycler.getCount(), uint32_t(sizeof(requests) / sizeof(requests[0])));
+
+    uint32_t destroyedCount = 0;
+    recycler.clear([&](FakeAllocator*) { destroyedCount++; });
+    CHECK_EQ(destroyedCount, uint32_t(created.size()));
+    for (FakeAllocator* pItem : created) {
+        delete pItem;
+    }
+}
+
+// A few thousand frames of recording threads requesting and returning objects with a mix of heavy and light
+// jobs and a job count that changes over time, two frames in flight. Nothing may be handed out before its fence
+// completes or to two jobs at once, the pool has to stay under its ceiling and stop growing once it has seen the
+// largest frame, and trimming and clearing have to give everything back.
+TEST(AllocatorRecycler_SoakUnderVaryingLoad)
+{
+    const uint32_t frameCount = 3000;
+    const uint32_t maxCount = 64;
+    const uint32_t idleFrameLimit = 60;
+
+    AllocatorRecyclerT<FakeAllocator> recycler;
+    recycler.setMaxCount(maxCount);
+    recycler.setIdleFrameLimit(idleFrameLimit);
+
+    SimulatedFence fence;
+    std::atomic<int32_t> liveCount{ 0 };
+    std::atomic<uint32_t> prematureCount{ 0 };
+    std::atomic<uint32_t> doubleHandOutCount{ 0 };
+    std::atomic<uint32_t> ceilingHitCount{ 0 };
+    std::vector<uint64_t> inFlight;
+    uint32_t peakCount = 0;
+    uint32_t peakCountAfterWarmup = 0;
+    uint32_t countAtBusiestFrame = 0;
+    uint32_t trimmedCount = 0;
+
+    for (uint32_t frame = 0; frame < frameCount; frame++) {
+        const uint64_t completedFence = fence.getCompletedFenceValue(0);
+        // Four to eight jobs, stepping every hundred frames; job 0 is the heavy one
+        const uint32_t jobCount = 4 + (frame / 100) % 5;
+
+        std::vector<FakeAllocator*> acquired(jobCount);
+        std::vector<std::thread> jobs;
+        for (uint32_t job = 0; job < jobCount; job++) {
+            jobs.emplace_back([&, job]() {
+                const uint64_t request = job == 0 ? HEAVY_SIZE : LIGHT_SIZE;
+                FakeAllocator* pItem = recycler.acquire(completedFence, request);
+                if (pItem == nullptr) {
+                    if (!recycler.tryReserveNew()) {
+                        ceilingHitCount.fetch_add(1);
+                        return;
+                    }
+                    pItem = new FakeAllocator{};
+                    liveCount.fetch_add(1);
+                    recycler.addNew(pItem);
+                }
+                else if (!fence.isFenceComplete(pItem->lastFence)) {
+                    prematureCount.fetch_add(1);
+                }
+                if (pItem->isInUse.exchange(true)) {
+                    doubleHandOutCount.fetch_add(1);
+                }
+                pItem->lastRecordedSize = request;
+                acquired[job] = pItem;
+            });
+        }
+        for (std::thread& job : jobs) {
+            job.join();
+        }
+
+        const uint64_t fenceValue = fence.incrementFence(0);
+        for (FakeAllocator* pItem : acquired) {
+            if (pItem != nullptr) {
+                pItem->lastFence = fenceValue;
+                pItem->isInUse.store(false);
+                recycler.release(pItem, fenceValue, pItem->lastRecordedSize);
+            }
+        }
+
+        inFlight.push_back(fenceValue);
+        if (inFlight.size() > 2) {
+            fence.complete(inFlight.front());
+            inFlight.erase(inFlight.begin());
+        }
+        trimmedCount += recycler.trim(fence.getCompletedFenceValue(0), [&](FakeAllocator* pItem) {
+            delete pItem;
+            liveCount.fetch_sub(1);
+        });
+
+        const uint32_t count = recycler.getCount();
+        peakCount = count > peakCount ? count : peakCount;
+        // The first full cycle through the job counts is the warm-up
+        if (frame >= 500) {
+            peakCountAfterWarmup = count > peakCountAfterWarmup ? count : peakCountAfterWarmup;
+        }
+        if (frame == 499) {
+            countAtBusiestFrame = count;
+        }
+        CHECK_EQ(liveCount.load(), int32_t(count));
+    }
+
+    CHECK_EQ(prematureCount.load(), 0u);
+    CHECK_EQ(doubleHandOutCount.load(), 0u);
+    CHECK_EQ(ceilingHitCount.load(), 0u);
+    CHECK(peakCount <= maxCount);
+    // Three frames' worth of the busiest frame is all the pool can ever need; once it has them it stops growing
+    CHECK(peakCount <= 3 * 8);
+    CHECK(peakCountAfterWarmup <= countAtBusiestFrame);
+    // The quiet stretches after the busy ones leave objects idle for longer than the limit
+    CHECK(trimmedCount > 0);
+
+    recycler.clear([&](FakeAllocator* pItem) {
+        delete pItem;
+        liveCount.fetch_sub(1);
+    });
+    CHECK_EQ(liveCount.load(), 0);
+    CHECK_EQ(recycler.getCount(), 0u);
+}
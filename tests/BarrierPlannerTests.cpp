@@ -0,0 +1,290 @@
+#include "TestHarness.h"
+#include <map>
+
+#include "BarrierPlanner.h"
+
+using namespace bdr;
+
+namespace
+{
+    // The D3D12_RESOURCE_STATES bits the tests need, with the same read-only split as READ_ONLY_RESOURCE_STATES
+    constexpr uint32_t COMMON = 0x0;
+    constexpr uint32_t RENDER_TARGET = 0x4;
+    constexpr uint32_t UNORDERED_ACCESS = 0x8;
+    constexpr uint32_t DEPTH_WRITE = 0x10;
+    constexpr uint32_t DEPTH_READ = 0x20;
+    constexpr uint32_t NON_PIXEL_SHADER_RESOURCE = 0x40;
+    constexpr uint32_t PIXEL_SHADER_RESOURCE = 0x80;
+    constexpr uint32_t COPY_DEST = 0x400;
+    constexpr uint32_t COPY_SOURCE = 0x800;
+    constexpr uint32_t READ_ONLY_STATES = DEPTH_READ | NON_PIXEL_SHADER_RESOURCE | PIXEL_SHADER_RESOURCE | COPY_SOURCE;
+
+    using Planner = BarrierPlannerT<uint32_t>;
+    constexpr uint32_t ALL = Planner::ALL_SUBRESOURCES;
+
+    bool isBarrier(const std::vector<Planner::Barrier>& barriers, const size_t index, const uint32_t resource, const uint32_t subresource,
+        const uint32_t before, const uint32_t after, const BarrierSplit split)
+    {
+        if (index >= barriers.size()) {
+            return false;
+        }
+        const Planner::Barrier& barrier = barriers[index];
+        return barrier.resource == resource && barrier.subresource == subresource && barrier.stateBefore == before
+            && barrier.stateAfter == after && barrier.split == split;
+    }
+}
+
+TEST(BarrierPlanner_NoBarrierWhenTheStateAlreadySatisfiesTheUse)
+{
+    Planner planner{ READ_ONLY_STATES };
+    planner.reset(3);
+    planner.registerResource(1, PIXEL_SHADER_RESOURCE | NON_PIXEL_SHADER_RESOURCE);
+    planner.registerResource(2, RENDER_TARGET);
+
+    // Reads already inside the combined read state, and repeated uses in the same write state
+    planner.use(0, 1, PIXEL_SHADER_RESOURCE);
+    planner.use(1, 1, NON_PIXEL_SHADER_RESOURCE | PIXEL_SHADER_RESOURCE);
+    planner.use(2, 1, NON_PIXEL_SHADER_RESOURCE);
+    planner.use(0, 2, RENDER_TARGET);
+    planner.use(1, 2, RENDER_TARGET);
+    planner.plan();
+
+    CHECK_EQ(planner.getBarrierCount(), size_t(0));
+    // The combined state is kept rather than narrowed to the last read
+    CHECK_EQ(planner.getFinalState(1), PIXEL_SHADER_RESOURCE | NON_PIXEL_SHADER_RESOURCE);
+    CHECK_EQ(planner.getFinalState(2), RENDER_TARGET);
+
+    // A read the combined state doesn't include does need a barrier, to the new read state
+    planner.reset(1);
+    planner.registerResource(1, PIXEL_SHADER_RESOURCE);
+    planner.use(0, 1, COPY_SOURCE);
+    planner.plan();
+    CHECK(isBarrier(planner.getBarriers(0), 0, 1, ALL, PIXEL_SHADER_RESOURCE, COPY_SOURCE, BarrierSplit::None));
+}
+
+TEST(BarrierPlanner_ReadStatesMergeWithinAPass)
+{
+    Planner planner{ READ_ONLY_STATES };
+    planner.reset(2);
+    planner.registerResource(7, COPY_DEST);
+    planner.use(0, 7, PIXEL_SHADER_RESOURCE);
+    planner.use(0, 7, NON_PIXEL_SHADER_RESOURCE);
+    planner.use(1, 7, PIXEL_SHADER_RESOURCE);
+    planner.plan();
+
+    // One transition into both read states, and the second pass is already covered
+    const std::vector<Planner::Barrier>& barriers = planner.getBarriers(0);
+    CHECK_EQ(barriers.size(), size_t(1));
+    CHECK(isBarrier(barriers, 0, 7, ALL, COPY_DEST, PIXEL_SHADER_RESOURCE | NON_PIXEL_SHADER_RESOURCE, BarrierSplit::None));
+    CHECK(planner.getBarriers(1).empty());
+    CHECK_EQ(planner.getFinalState(7), PIXEL_SHADER_RESOURCE | NON_PIXEL_SHADER_RESOURCE);
+}
+
+// A pass in between that doesn't touch the resource lets the transition be split around it. Adjacent uses
+// get a plain barrier.
+TEST(BarrierPlanner_SplitsAcrossUntouchedPasses)
+{
+    Planner planner{ READ_ONLY_STATES };
+    planner.reset(4);
+    planner.registerResource(1, COMMON);
+    planner.registerResource(2, COMMON);
+    planner.use(0, 1, RENDER_TARGET);
+    planner.use(2, 1, PIXEL_SHADER_RESOURCE);
+    planner.use(3, 1, UNORDERED_ACCESS);
+    // Not used until the third pass, so its transition can begin with the first
+    planner.use(2, 2, DEPTH_WRITE);
+    planner.plan();
+
+    const std::vector<Planner::Barrier>& first = planner.getBarriers(0);
+    CHECK_EQ(first.size(), size_t(2));
+    CHECK(isBarrier(first, 0, 1, ALL, COMMON, RENDER_TARGET, BarrierSplit::None));
+    CHECK(isBarrier(first, 1, 2, ALL, COMMON, DEPTH_WRITE, BarrierSplit::Begin));
+
+    const std::vector<Planner::Barrier>& second = planner.getBarriers(1);
+    CHECK_EQ(second.size(), size_t(1));
+    CHECK(isBarrier(second, 0, 1, ALL, RENDER_TARGET, PIXEL_SHADER_RESOURCE, BarrierSplit::Begin));
+
+    const std::vector<Planner::Barrier>& third = planner.getBarriers(2);
+    CHECK_EQ(third.size(), size_t(2));
+    CHECK(isBarrier(third, 0, 1, ALL, RENDER_TARGET, PIXEL_SHADER_RESOURCE, BarrierSplit::End));
+    CHECK(isBarrier(third, 1, 2, ALL, COMMON, DEPTH_WRITE, BarrierSplit::End));
+
+    CHECK_EQ(planner.getBarriers(3).size(), size_t(1));
+    CHECK(isBarrier(planner.getBarriers(3), 0, 1, ALL, PIXEL_SHADER_RESOURCE, UNORDERED_ACCESS, BarrierSplit::None));
+    CHECK_EQ(planner.getFinalState(1), UNORDERED_ACCESS);
+}
+
+// Single-subresource uses split a resource's tracking; once a whole-resource use brings them back into line
+// it goes back to ALL_SUBRESOURCES barriers
+TEST(BarrierPlanner_SubresourcesSplitAndCollapse)
+{
+    Planner planner{ READ_ONLY_STATES };
+    planner.reset(4);
+    planner.registerResource(3, PIXEL_SHADER_RESOURCE, 4);
+    planner.use(0, 3, RENDER_TARGET, 1);
+    planner.use(1, 3, PIXEL_SHADER_RESOURCE);
+    planner.use(2, 3, COPY_DEST);
+    planner.use(3, 3, COPY_DEST, 2);
+    planner.plan();
+
+    CHECK_EQ(planner.getBarriers(0).size(), size_t(1));
+    CHECK(isBarrier(planner.getBarriers(0), 0, 3, 1, PIXEL_SHADER_RESOURCE, RENDER_TARGET, BarrierSplit::None));
+
+    // Only the diverged subresource needs bringing back
+    CHECK_EQ(planner.getBarriers(1).size(), size_t(1));
+    CHECK(isBarrier(planner.getBarriers(1), 0, 3, 1, RENDER_TARGET, PIXEL_SHADER_RESOURCE, BarrierSplit::None));
+
+    // All subresources agree again, so one barrier covers them
+    CHECK_EQ(planner.getBarriers(2).size(), size_t(1));
+    CHECK(isBarrier(planner.getBarriers(2), 0, 3, ALL, PIXEL_SHADER_RESOURCE, COPY_DEST, BarrierSplit::None));
+    CHECK(planner.getBarriers(3).empty());
+    for (uint32_t subresource = 0; subresource < 4; subresource++) {
+        CHECK_EQ(planner.getFinalState(3, subresource), COPY_DEST);
+    }
+
+    // A whole-resource use while subresources disagree transitions each one that needs it
+    planner.reset(2);
+    planner.registerResource(3, COPY_DEST, 3);
+    planner.use(0, 3, COPY_SOURCE, 0);
+    planner.use(0, 3, RENDER_TARGET, 2);
+    planner.use(1, 3, PIXEL_SHADER_RESOURCE);
+    planner.plan();
+    // The untouched subresource can begin its transition with the first pass
+    CHECK_EQ(planner.getBarriers(0).size(), size_t(3));
+    CHECK(isBarrier(planner.getBarriers(0), 2, 3, 1, COPY_DEST, PIXEL_SHADER_RESOURCE, BarrierSplit::Begin));
+    const std::vector<Planner::Barrier>& barriers = planner.getBarriers(1);
+    CHECK_EQ(barriers.size(), size_t(3));
+    CHECK(isBarrier(barriers, 0, 3, 0, COPY_SOURCE, PIXEL_SHADER_RESOURCE, BarrierSplit::None));
+    CHECK(isBarrier(barriers, 1, 3, 1, COPY_DEST, PIXEL_SHADER_RESOURCE, BarrierSplit::End));
+    CHECK(isBarrier(barriers, 2, 3, 2, RENDER_TARGET, PIXEL_SHADER_RESOURCE, BarrierSplit::None));
+}
+
+// Random frames replayed against a model of the GPU's view of each subresource: every barrier must start from
+// the state the subresource is actually in and change it, split halves must pair up, nothing may be used
+// mid-transition, and every use must find its state satisfied
+TEST(BarrierPlanner_RandomReplay)
+{
+    const uint32_t writeStates[] = { COMMON, RENDER_TARGET, UNORDERED_ACCESS, DEPTH_WRITE, COPY_DEST };
+    const uint32_t readStates[] = { DEPTH_READ, NON_PIXEL_SHADER_RESOURCE, PIXEL_SHADER_RESOURCE, COPY_SOURCE };
+    const uint32_t resourceCount = 4;
+    const uint32_t subresourceCounts[resourceCount] = { 1, 4, 1, 3 };
+    const uint32_t passCount = 8;
+
+    auto isSatisfied = [](const uint32_t current, const uint32_t needed) {
+        const bool isCurrentRead = current != 0 && (current & ~READ_ONLY_STATES) == 0;
+        const bool isNeededRead = needed != 0 && (needed & ~READ_ONLY_STATES) == 0;
+        return current == needed || (isCurrentRead && isNeededRead && (current & needed) == needed);
+    };
+
+    uint32_t seed = 3;
+    auto next = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return seed >> 8;
+    };
+
+    Planner planner{ READ_ONLY_STATES };
+    std::vector<uint32_t> states[resourceCount];
+    for (uint32_t r = 0; r < resourceCount; r++) {
+        states[r].assign(subresourceCounts[r], COMMON);
+    }
+
+    uint32_t errorCount = 0;
+    size_t barrierCount = 0;
+    size_t splitCount = 0;
+    for (uint32_t frame = 0; frame < 2000; frame++) {
+        planner.reset(passCount);
+        // The last pass of the previous frame left every subresource in the same state
+        for (uint32_t r = 0; r < resourceCount; r++) {
+            planner.registerResource(r, states[r][0], subresourceCounts[r]);
+        }
+
+        struct ExpectedUse
+        {
+            uint32_t pass;
+            uint32_t resource;
+            uint32_t subresource;
+            uint32_t state;
+        };
+        std::vector<ExpectedUse> uses;
+        for (uint32_t pass = 0; pass + 1 < passCount; pass++) {
+            for (uint32_t r = 0; r < resourceCount; r++) {
+                if (next() % 3 != 0) {
+                    continue;
+                }
+                const uint32_t subresource = subresourceCounts[r] > 1 && next() % 2 == 0 ? next() % subresourceCounts[r] : ALL;
+                uint32_t state;
+                if (next() % 2 == 0) {
+                    state = writeStates[next() % 5];
+                    planner.use(pass, r, state, subresource);
+                }
+                else {
+                    const uint32_t first = readStates[next() % 4];
+                    const uint32_t second = readStates[next() % 4];
+                    planner.use(pass, r, first, subresource);
+                    planner.use(pass, r, second, subresource);
+                    state = first | second;
+                }
+                uses.push_back(ExpectedUse{ pass, r, subresource, state });
+            }
+        }
+        // The last pass takes everything back to COMMON, so the next frame starts with uniform subresources
+        for (uint32_t r = 0; r < resourceCount; r++) {
+            planner.use(passCount - 1, r, COMMON);
+            uses.push_back(ExpectedUse{ passCount - 1, r, ALL, COMMON });
+        }
+        planner.plan();
+
+        std::map<std::pair<uint32_t, uint32_t>, Planner::Barrier> pendingSplits;
+        for (uint32_t pass = 0; pass < passCount; pass++) {
+            for (const Planner::Barrier& barrier : planner.getBarriers(pass)) {
+                barrierCount++;
+                errorCount += barrier.stateBefore == barrier.stateAfter ? 1 : 0;
+                const uint32_t first = barrier.subresource == ALL ? 0 : barrier.subresource;
+                const uint32_t last = barrier.subresource == ALL ? subresourceCounts[barrier.resource] - 1 : barrier.subresource;
+                for (uint32_t s = first; s <= last; s++) {
+                    const std::pair<uint32_t, uint32_t> key{ barrier.resource, s };
+                    if (barrier.split == BarrierSplit::End) {
+                        auto it = pendingSplits.find(key);
+                        const bool isPaired = it != pendingSplits.end() && it->second.stateAfter == barrier.stateAfter
+                            && it->second.subresource == barrier.subresource;
+                        errorCount += isPaired ? 0 : 1;
+                        if (it != pendingSplits.end()) {
+                            pendingSplits.erase(it);
+                        }
+                        states[barrier.resource][s] = barrier.stateAfter;
+                        continue;
+                    }
+                    errorCount += states[barrier.resource][s] == barrier.stateBefore && pendingSplits.count(key) == 0 ? 0 : 1;
+                    if (barrier.split == BarrierSplit::Begin) {
+                        pendingSplits[key] = barrier;
+                        splitCount++;
+                    }
+                    else {
+                        states[barrier.resource][s] = barrier.stateAfter;
+                    }
+                }
+            }
+
+            for (const ExpectedUse& use : uses) {
+                if (use.pass != pass) {
+                    continue;
+                }
+                const uint32_t first = use.subresource == ALL ? 0 : use.subresource;
+                const uint32_t last = use.subresource == ALL ? subresourceCounts[use.resource] - 1 : use.subresource;
+                for (uint32_t s = first; s <= last; s++) {
+                    errorCount += pendingSplits.count({ use.resource, s }) == 0 && isSatisfied(states[use.resource][s], use.state) ? 0 : 1;
+                }
+            }
+        }
+        errorCount += pendingSplits.empty() ? 0 : 1;
+        for (uint32_t r = 0; r < resourceCount; r++) {
+            for (uint32_t s = 0; s < subresourceCounts[r]; s++) {
+                errorCount += planner.getFinalState(r, s) == states[r][s] ? 0 : 1;
+            }
+        }
+    }
+
+    CHECK_EQ(errorCount, 0u);
+    CHECK(barrierCount > 0);
+    CHECK(splitCount > 0);
+}
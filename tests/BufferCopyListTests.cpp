@@ -0,0 +1,104 @@
+#include "TestHarness.h"
+
+#include "BufferCopyList.h"
+#include "DirtyRangeSet.h"
+
+using namespace bdr;
+
+namespace
+{
+    struct FakeResource
+    {
+        int id;
+    };
+
+    constexpr uint64_t ALIGNMENT = 256;
+    using CopyList = BufferCopyListT<FakeResource>;
+}
+
+TEST(BufferCopyList_WholeBuffersMergeOverTheirPadding)
+{
+    FakeResource heap{ 0 };
+    CopyList copies{ ALIGNMENT };
+
+    // Two buffers of 100 and 50 bytes placed back to back in both the heap and the ring
+    copies.add(&heap, 0, 1024, 100, true);
+    copies.add(&heap, 256, 1280, 50, true);
+    CHECK_EQ(copies.size(), size_t(1));
+    const CopyList::Copy& merged = *copies.begin();
+    CHECK_EQ(merged.destOffset, 0u);
+    CHECK_EQ(merged.srcOffset, 1024u);
+    CHECK_EQ(merged.size, 306u);
+    CHECK(merged.ownsTrailingPadding);
+
+    // Different gaps on each side, a gap a whole alignment wide, or another resource never merge
+    copies.add(&heap, 512, 1792, 10, true);
+    copies.add(&heap, 778, 2058, 10, true);
+    FakeResource otherHeap{ 1 };
+    copies.add(&otherHeap, 1280, 2304, 10, true);
+    CHECK_EQ(copies.size(), size_t(4));
+}
+
+// The bug this guards against: two dirty ranges of one buffer with a gap between them that happens to match
+// the ring padding. Copying the gap would overwrite bytes on the GPU with whatever is in the ring.
+TEST(BufferCopyList_PartialUpdatesDoNotCopyTheGap)
+{
+    FakeResource heap{ 0 };
+    CopyList copies{ ALIGNMENT };
+
+    DirtyRangeSet dirty;
+    dirty.add(0, 100);
+    dirty.add(256, 44);
+    dirty.add(300, 20);
+    const std::vector<DirtyRangeSet::Range>& ranges = dirty.merge();
+    CHECK_EQ(ranges.size(), size_t(2));
+
+    uint64_t srcOffset = 0;
+    for (const DirtyRangeSet::Range& range : ranges) {
+        copies.add(&heap, range.begin, srcOffset, range.end - range.begin, false);
+        srcOffset += ALIGNMENT;
+    }
+    CHECK_EQ(copies.size(), size_t(2));
+
+    // A whole buffer right after a partial update isn't merged across the gap either
+    copies.add(&heap, 512, 512, 64, true);
+    CHECK_EQ(copies.size(), size_t(3));
+}
+
+// Chunks of one large upload are contiguous on both sides and merge whatever they own
+TEST(BufferCopyList_ContiguousCopiesAlwaysMerge)
+{
+    FakeResource heap{ 0 };
+    CopyList copies{ ALIGNMENT };
+
+    copies.add(&heap, 4096, 0, 1000, false);
+    copies.add(&heap, 5096, 1000, 1000, false);
+    copies.add(&heap, 6096, 2000, 500, true);
+    CHECK_EQ(copies.size(), size_t(1));
+    CHECK_EQ(copies.begin()->size, 2500u);
+    CHECK(copies.begin()->ownsTrailingPadding);
+
+    copies.clear();
+    CHECK(copies.empty());
+}
+
+TEST(DirtyRangeSet_MergesOverlappingAndTouchingRanges)
+{
+    DirtyRangeSet dirty;
+    dirty.add(100, 10);
+    dirty.add(105, 10);
+    dirty.add(0, 50);
+    dirty.add(50, 10);
+    dirty.add(200, 0);
+    dirty.add(300, 8);
+
+    const std::vector<DirtyRangeSet::Range>& ranges = dirty.merge();
+    CHECK_EQ(ranges.size(), size_t(3));
+    CHECK(ranges[0].begin == 0 && ranges[0].end == 60);
+    CHECK(ranges[1].begin == 100 && ranges[1].end == 115);
+    CHECK(ranges[2].begin == 300 && ranges[2].end == 308);
+    CHECK_EQ(dirty.getDirtyBytes(), 83u);
+
+    // With a merge gap, close ranges are joined too
+    CHECK_EQ(dirty.merge(64).size(), size_t(2));
+}
@@ -0,0 +1,181 @@
+#include "TestHarness.h"
+#include <cstring>
+
+#include "BufferSuballocator.h"
+
+using namespace bdr;
+
+namespace
+{
+    constexpr uint64_t HEAP_SIZE = 64 * 1024;
+    constexpr uint64_t GRANULARITY = 256;
+
+    // Stands in for the ID3D12Resource heaps GPUBufferManager creates: backing memory is added whenever the
+    // suballocator reports a new heap, and every allocation gets filled so overlaps show up as corruption
+    struct SimulatedHeaps
+    {
+        BufferSuballocator allocator{ HEAP_SIZE, GRANULARITY };
+        std::vector<std::vector<uint8_t>> heaps;
+
+        BufferSuballocator::Allocation allocate(const uint64_t size, const uint64_t alignment = 0)
+        {
+            bool isCreated = false;
+            const BufferSuballocator::Allocation allocation = allocator.allocate(size, alignment, &isCreated);
+            if (isCreated) {
+                CHECK_EQ(allocation.heapIndex, uint32_t(heaps.size()));
+                heaps.emplace_back(size_t(allocator.getHeapSize(allocation.heapIndex)));
+            }
+            return allocation;
+        }
+
+        uint8_t* getData(const BufferSuballocator::Allocation& allocation)
+        {
+            return heaps[allocation.heapIndex].data() + allocation.range.offset;
+        }
+    };
+}
+
+TEST(BufferSuballocator_AllocatesAndGrowsHeaps)
+{
+    SimulatedHeaps heaps;
+
+    // Sizes round up to the granularity, and allocations pack into the first heap
+    const BufferSuballocator::Allocation first = heaps.allocate(100);
+    const BufferSuballocator::Allocation second = heaps.allocate(300);
+    CHECK(first.isValid() && second.isValid());
+    CHECK(first.heapIndex == 0 && second.heapIndex == 0);
+    CHECK_EQ(first.range.size, GRANULARITY);
+    CHECK_EQ(second.range.size, 2 * GRANULARITY);
+    CHECK_EQ(second.range.offset, GRANULARITY);
+    CHECK_EQ(heaps.allocator.getHeapCount(), 1u);
+
+    // What doesn't fit in the first heap goes into a new one of the same size
+    const BufferSuballocator::Allocation large = heaps.allocate(HEAP_SIZE - 512);
+    CHECK_EQ(large.heapIndex, 1u);
+    CHECK_EQ(heaps.allocator.getHeapSize(1), HEAP_SIZE);
+
+    // Existing heaps are tried in order before another is added
+    const BufferSuballocator::Allocation refill = heaps.allocate(1024);
+    CHECK_EQ(refill.heapIndex, 0u);
+
+    // Alignment is honoured within a heap
+    const BufferSuballocator::Allocation aligned = heaps.allocate(512, 4096);
+    CHECK_EQ(aligned.range.offset % 4096, 0u);
+
+    heaps.allocator.reset();
+    CHECK_EQ(heaps.allocator.getHeapCount(), 0u);
+}
+
+// Requests larger than the heap size get a heap of their own, rounded up to a multiple of the heap size
+TEST(BufferSuballocator_DedicatedHeapsForOversizedRequests)
+{
+    SimulatedHeaps heaps;
+    const BufferSuballocator::Allocation small = heaps.allocate(256);
+    const BufferSuballocator::Allocation oversized = heaps.allocate(HEAP_SIZE * 2 + 1);
+    CHECK_EQ(oversized.heapIndex, 1u);
+    CHECK_EQ(oversized.range.offset, 0u);
+    CHECK_EQ(heaps.allocator.getHeapSize(1), HEAP_SIZE * 3);
+
+    // An oversized request that also needs more than the granularity's alignment still fits its heap
+    const BufferSuballocator::Allocation alignedOversized = heaps.allocate(HEAP_SIZE * 3, 64 * 1024);
+    CHECK(alignedOversized.isValid());
+    CHECK_EQ(alignedOversized.heapIndex, 2u);
+    CHECK_EQ(alignedOversized.range.offset % (64 * 1024), 0u);
+    CHECK(heaps.allocator.getHeapSize(2) >= HEAP_SIZE * 3);
+
+    // Small requests keep going to the shared heap
+    CHECK_EQ(heaps.allocate(256).heapIndex, small.heapIndex);
+}
+
+TEST(BufferSuballocator_FreeCoalescesAndReportsStats)
+{
+    SimulatedHeaps heaps;
+    std::vector<BufferSuballocator::Allocation> blocks;
+    for (uint32_t i = 0; i < 16; i++) {
+        blocks.push_back(heaps.allocate(4096));
+    }
+    // The first heap is full; one more block fills part of a second
+    blocks.push_back(heaps.allocate(4096));
+    CHECK_EQ(blocks.back().heapIndex, 1u);
+
+    BufferSuballocator::Stats stats = heaps.allocator.getStats();
+    CHECK_EQ(stats.heapCount, 2u);
+    CHECK_EQ(stats.allocationCount, 17u);
+    CHECK_EQ(stats.totalSize, 2 * HEAP_SIZE);
+    CHECK_EQ(stats.usedSize, 17u * 4096u);
+    CHECK_EQ(stats.freeSize, 2 * HEAP_SIZE - 17 * 4096);
+    CHECK_EQ(stats.freeBlockCount, 1u);
+    CHECK_EQ(stats.largestFreeBlock, HEAP_SIZE - 4096);
+    CHECK(stats.getUtilization() == float(17 * 4096) / float(2 * HEAP_SIZE));
+
+    // Every other block of the first heap freed: scattered 4 KB holes
+    for (uint32_t i = 0; i < 16; i += 2) {
+        heaps.allocator.free(blocks[i]);
+    }
+    stats = heaps.allocator.getStats();
+    CHECK_EQ(stats.allocationCount, 9u);
+    CHECK_EQ(stats.freeBlockCount, 9u);
+    CHECK_EQ(stats.largestFreeBlock, HEAP_SIZE - 4096);
+    const float expectedFragmentation = 1.0f - float(HEAP_SIZE - 4096) / float(stats.freeSize);
+    CHECK(stats.getFragmentation() == expectedFragmentation);
+
+    // An 8 KB request can't use the holes, so it goes to the second heap
+    CHECK_EQ(heaps.allocate(8192).heapIndex, 1u);
+
+    // Freeing the rest coalesces the first heap back into one block
+    for (uint32_t i = 1; i < 16; i += 2) {
+        heaps.allocator.free(blocks[i]);
+    }
+    const BufferSuballocator::Allocation whole = heaps.allocate(HEAP_SIZE);
+    CHECK_EQ(whole.heapIndex, 0u);
+    CHECK_EQ(whole.range.offset, 0u);
+}
+
+// Random allocations and frees against simulated heap memory: every live allocation keeps its contents
+TEST(BufferSuballocator_RandomSoakKeepsContents)
+{
+    SimulatedHeaps heaps;
+    struct Live
+    {
+        BufferSuballocator::Allocation allocation;
+        uint64_t size;
+        uint8_t pattern;
+    };
+    std::vector<Live> live;
+    uint32_t seed = 99;
+    bool isIntact = true;
+    for (uint32_t i = 0; i < 5000; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        if (!live.empty() && (seed >> 28) < 7) {
+            const size_t index = (seed >> 8) % live.size();
+            const Live& freed = live[index];
+            const uint8_t* pData = heaps.getData(freed.allocation);
+            for (uint64_t b = 0; b < freed.size; b++) {
+                isIntact &= pData[b] == freed.pattern;
+            }
+            heaps.allocator.free(freed.allocation);
+            live[index] = live.back();
+            live.pop_back();
+            continue;
+        }
+
+        const uint64_t size = 1 + (seed >> 10) % (HEAP_SIZE / 4);
+        const uint64_t alignment = uint64_t(256) << ((seed >> 4) % 4);
+        const BufferSuballocator::Allocation allocation = heaps.allocate(size, alignment);
+        isIntact &= allocation.isValid() && allocation.range.offset % alignment == 0;
+        const uint8_t pattern = uint8_t(i);
+        std::memset(heaps.getData(allocation), pattern, size_t(size));
+        live.push_back(Live{ allocation, size, pattern });
+    }
+    CHECK(isIntact);
+
+    for (const Live& entry : live) {
+        heaps.allocator.free(entry.allocation);
+    }
+    const BufferSuballocator::Stats stats = heaps.allocator.getStats();
+    CHECK_EQ(stats.allocationCount, 0u);
+    CHECK_EQ(stats.usedSize, 0u);
+    CHECK_EQ(stats.freeSize, stats.totalSize);
+    CHECK_EQ(stats.freeBlockCount, stats.heapCount);
+    CHECK_EQ(stats.largestFreeBlock, HEAP_SIZE);
+}
@@ -0,0 +1,112 @@
+#include "TestHarness.h"
+#include <algorithm>
+
+#include "CommandStream.h"
+
+using namespace bdr;
+
+namespace
+{
+    struct NullTranslator
+    {
+        uint64_t drawCount = 0;
+        uint64_t stateChanges = 0;
+        uint32_t boundPipelineId = 0;
+        uint32_t boundMeshId = UINT32_MAX;
+        uint64_t boundConstants = 0;
+
+        void operator()(const SetPipelinePacket& packet)
+        {
+            stateChanges += packet.pipelineId != boundPipelineId ? 1 : 0;
+            boundPipelineId = packet.pipelineId;
+        }
+
+        void operator()(const SetMeshPacket& packet)
+        {
+            stateChanges += packet.meshId != boundMeshId ? 1 : 0;
+            boundMeshId = packet.meshId;
+        }
+
+        void operator()(const SetConstantsPacket& packet)
+        {
+            stateChanges += packet.gpuAddress != boundConstants ? 1 : 0;
+            boundConstants = packet.gpuAddress;
+        }
+
+        void operator()(const DrawIndexedPacket& packet)
+        {
+            drawCount += packet.indexCount != 0 ? 1 : 0;
+        }
+    };
+}
+
+// Recording, sorting and translating a million draw commands without a device, with sort keys spread over
+// two passes, 64 pipelines, 4096 materials and random depths. The radix sort is compared against
+// std::stable_sort on the same keys.
+BENCH(CommandStream_MillionCommands)
+{
+    const uint32_t commandCount = test::isQuickRun() ? 100000 : 1000000;
+    const uint32_t repeatCount = test::isQuickRun() ? 1 : 5;
+
+    std::vector<uint64_t> keys(commandCount);
+    uint32_t seed = 7;
+    for (uint32_t i = 0; i < commandCount; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        const uint32_t material = (seed >> 8) % 4096;
+        keys[i] = SortKey::make(i % 2, material % 64, material, float(seed >> 12) / 1048576.0f);
+    }
+
+    double recordMs = 0.0;
+    double sortMs = 0.0;
+    double stdSortMs = 0.0;
+    double translateMs = 0.0;
+    bool isSorted = true;
+    CommandStream stream;
+    for (uint32_t repeat = 0; repeat < repeatCount; repeat++) {
+        stream.clear();
+        stream.reserve(commandCount, size_t(commandCount) * 40);
+
+        test::Timer timer;
+        for (uint32_t i = 0; i < commandCount; i++) {
+            stream.beginCommand(keys[i]);
+            stream.push(SetPipelinePacket{ SetPipelinePacket::TYPE, SortKey::getPipeline(keys[i]) });
+            stream.push(SetMeshPacket{ SetMeshPacket::TYPE, i % 256 });
+            SetConstantsPacket constants;
+            constants.gpuAddress = 256ull * i;
+            stream.push(constants);
+            DrawIndexedPacket draw;
+            draw.indexCount = 36;
+            stream.push(draw);
+            stream.endCommand();
+        }
+        recordMs += timer.getElapsedMs();
+
+        timer = test::Timer{};
+        stream.sort();
+        sortMs += timer.getElapsedMs();
+
+        for (uint32_t i = 1; i < commandCount; i++) {
+            isSorted &= stream.getSortKey(i - 1) <= stream.getSortKey(i);
+        }
+
+        NullTranslator translator;
+        timer = test::Timer{};
+        stream.translate(0, stream.getCommandCount(), translator);
+        translateMs += timer.getElapsedMs();
+        CHECK_EQ(translator.drawCount, uint64_t(commandCount));
+        test::doNotOptimize(translator.stateChanges);
+
+        std::vector<uint64_t> stdKeys = keys;
+        timer = test::Timer{};
+        std::stable_sort(stdKeys.begin(), stdKeys.end());
+        stdSortMs += timer.getElapsedMs();
+        test::doNotOptimize(stdKeys.data());
+    }
+    CHECK(isSorted);
+
+    std::printf("  %u commands, %.1f MB of packets\n", commandCount, double(stream.getPacketBytes()) / (1024.0 * 1024.0));
+    std::printf("  record:           %8.2f ms\n", recordMs / repeatCount);
+    std::printf("  radix sort:       %8.2f ms\n", sortMs / repeatCount);
+    std::printf("  std::stable_sort: %8.2f ms (keys only)\n", stdSortMs / repeatCount);
+    std::printf("  translate:        %8.2f ms\n", translateMs / repeatCount);
+}
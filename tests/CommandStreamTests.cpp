@@ -0,0 +1,81 @@
+#include "TestHarness.h"
+
+#include "CommandStream.h"
+
+using namespace bdr;
+
+namespace
+{
+    struct CountingTranslator
+    {
+        std::vector<uint32_t> drawOrder;
+        uint32_t pipelineChanges = 0;
+        uint32_t boundPipelineId = 0;
+
+        void operator()(const SetPipelinePacket& packet)
+        {
+            if (packet.pipelineId != boundPipelineId) {
+                pipelineChanges++;
+                boundPipelineId = packet.pipelineId;
+            }
+        }
+
+        void operator()(const SetMeshPacket&) { }
+        void operator()(const SetConstantsPacket&) { }
+
+        void operator()(const DrawIndexedPacket& packet)
+        {
+            drawOrder.push_back(uint32_t(packet.baseVertex));
+        }
+    };
+
+    void recordDraw(CommandStream& stream, const uint64_t sortKey, const uint32_t pipelineId, const uint32_t id, const bool hasConstants)
+    {
+        stream.beginCommand(sortKey);
+        stream.push(SetPipelinePacket{ SetPipelinePacket::TYPE, pipelineId });
+        if (hasConstants) {
+            SetConstantsPacket constants;
+            constants.gpuAddress = 256ull * id;
+            stream.push(constants);
+        }
+        DrawIndexedPacket draw;
+        draw.indexCount = 3;
+        draw.baseVertex = int32_t(id);
+        stream.push(draw);
+        stream.endCommand();
+    }
+}
+
+TEST(CommandStream_SortKeyFieldOrder)
+{
+    // Pass beats pipeline beats material beats depth
+    CHECK(SortKey::make(0, 5, 5, 1.0f) < SortKey::make(1, 0, 0, 0.0f));
+    CHECK(SortKey::make(0, 0, 5, 1.0f) < SortKey::make(0, 1, 0, 0.0f));
+    CHECK(SortKey::make(0, 0, 0, 1.0f) < SortKey::make(0, 0, 1, 0.0f));
+    CHECK(SortKey::make(0, 0, 0, 0.25f) < SortKey::make(0, 0, 0, 0.5f));
+    CHECK(SortKey::make(0, 0, 0, 0.5f, true) < SortKey::make(0, 0, 0, 0.25f, true));
+    CHECK_EQ(SortKey::getPass(SortKey::make(7, 300, 9, 0.5f)), 7u);
+    CHECK_EQ(SortKey::getPipeline(SortKey::make(7, 300, 9, 0.5f)), 300u);
+}
+
+// Commands come out in key order, equal keys in recording order, with their packets intact
+TEST(CommandStream_SortIsStableAndKeepsPackets)
+{
+    CommandStream stream;
+    const uint32_t pipelines[] = { 3, 1, 2, 1, 3, 1 };
+    for (uint32_t i = 0; i < 6; i++) {
+        recordDraw(stream, SortKey::make(0, pipelines[i], 0, 0.5f), pipelines[i], i, i % 2 == 0);
+    }
+    stream.sort();
+
+    CountingTranslator translator;
+    stream.translate(0, stream.getCommandCount(), translator);
+    CHECK(translator.drawOrder == std::vector<uint32_t>({ 1, 3, 5, 2, 0, 4 }));
+    CHECK_EQ(translator.pipelineChanges, 3u);
+
+    // Only the even draws set constants
+    const size_t withoutConstants = sizeof(SetPipelinePacket) + sizeof(DrawIndexedPacket);
+    CHECK_EQ(stream.getPacketBytes(0, 3), 3 * withoutConstants);
+    CHECK_EQ(stream.getPacketBytes(3, 1), withoutConstants + sizeof(SetConstantsPacket));
+    CHECK_EQ(stream.getPacketBytes(0, stream.getCommandCount()), stream.getPacketBytes());
+}
@@ -0,0 +1,105 @@
+#include "TestHarness.h"
+#include <algorithm>
+#include <vector>
+
+#include "DeferredReleaseQueue.h"
+#include "SimulatedFence.h"
+
+using namespace bdr;
+
+namespace
+{
+    auto getCompleted(SimulatedFence& fence)
+    {
+        return [&fence](const uint32_t timeline) { return fence.getCompletedFenceValue(timeline); };
+    }
+}
+
+// An object handed over with an older fence than the one before it is released as soon as its own fence passes
+TEST(DeferredReleaseQueue_OutOfOrderFencesDoNotHoldBackReadyObjects)
+{
+    SimulatedFence fence;
+    DeferredReleaseQueueT<uint32_t> queue;
+
+    const uint64_t first = fence.incrementFence(1);
+    const uint64_t second = fence.incrementFence(1);
+    const uint64_t third = fence.incrementFence(1);
+    queue.release(3, third);
+    queue.release(1, first);
+    queue.release(2, second);
+
+    std::vector<uint32_t> destroyed;
+    const auto destroy = [&destroyed](const uint32_t item) { destroyed.push_back(item); };
+
+    CHECK_EQ(queue.collect(getCompleted(fence), destroy), 0u);
+    fence.complete(first);
+    CHECK_EQ(queue.collect(getCompleted(fence), destroy), 1u);
+    fence.complete(second);
+    CHECK_EQ(queue.collect(getCompleted(fence), destroy), 1u);
+    CHECK_EQ(queue.getPendingCount(), size_t(1));
+    fence.complete(third);
+    CHECK_EQ(queue.collect(getCompleted(fence), destroy), 1u);
+    CHECK(destroyed == std::vector<uint32_t>({ 1, 2, 3 }));
+}
+
+// Objects handed over on three timelines with fences up to a few submissions old, while the timelines complete
+// at their own pace. Nothing may be destroyed before its fence, everything whose fence has passed must be gone
+// after each collect, and everything has to be destroyed exactly once in the end.
+TEST(DeferredReleaseQueue_StressAgainstSimulatedFence)
+{
+    const uint32_t timelineCount = 3;
+    SimulatedFence fence;
+    DeferredReleaseQueueT<uint32_t> queue;
+
+    std::vector<uint64_t> fenceValues;
+    std::vector<uint32_t> destroyCounts;
+    uint32_t prematureCount = 0;
+    uint32_t lateCount = 0;
+    uint32_t seed = 99;
+    const auto random = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return seed >> 8;
+    };
+    const auto destroy = [&](const uint32_t item) {
+        prematureCount += fence.isFenceComplete(fenceValues[item]) ? 0 : 1;
+        destroyCounts[item]++;
+    };
+
+    for (uint32_t frame = 0; frame < 20000; frame++) {
+        for (uint32_t i = random() % 8; i > 0; i--) {
+            const uint32_t timeline = random() % timelineCount;
+            fence.incrementFence(timeline);
+            // Tagged with a fence up to three submissions old, so they arrive out of order
+            const uint64_t newest = fence.getNextFenceValue(timeline) - 1;
+            const uint64_t age = std::min<uint64_t>(random() % 4, newest - getFenceTimelineBase(timeline) - 1);
+            fenceValues.push_back(newest - age);
+            destroyCounts.push_back(0);
+            queue.release(uint32_t(fenceValues.size() - 1), fenceValues.back());
+        }
+
+        for (uint32_t timeline = 0; timeline < timelineCount; timeline++) {
+            const uint64_t next = fence.getNextFenceValue(timeline);
+            if (random() % 3 == 0 && next - getFenceTimelineBase(timeline) > 4) {
+                fence.complete(next - 1 - random() % 4);
+            }
+        }
+        queue.collect(getCompleted(fence), destroy);
+
+        // Spot check that nothing ready was left behind
+        if (frame % 500 == 0) {
+            for (size_t item = 0; item < fenceValues.size(); item++) {
+                lateCount += destroyCounts[item] == 0 && fence.isFenceComplete(fenceValues[item]) ? 1 : 0;
+            }
+        }
+    }
+
+    for (uint32_t timeline = 0; timeline < timelineCount; timeline++) {
+        fence.completeAll(timeline);
+    }
+    queue.collect(getCompleted(fence), destroy);
+
+    CHECK_EQ(prematureCount, 0u);
+    CHECK_EQ(lateCount, 0u);
+    CHECK_EQ(queue.getPendingCount(), size_t(0));
+    CHECK(std::all_of(destroyCounts.begin(), destroyCounts.end(), [](const uint32_t count) { return count == 1; }));
+}
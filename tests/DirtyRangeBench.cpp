@@ -0,0 +1,95 @@
+#include "TestHarness.h"
+#include <algorithm>
+
+#include "BufferCopyList.h"
+#include "DirtyRangeSet.h"
+
+using namespace bdr;
+
+namespace
+{
+    struct FakeResource
+    {
+        int id;
+    };
+
+    constexpr uint64_t UPLOAD_ALIGNMENT = 256;
+    constexpr uint64_t BUFFER_SIZE = 64 * 1024;
+}
+
+// Throughput of tracking and merging dirty ranges the way GPUBufferManager::update and stageBufferUpdates do:
+// a batch of buffers each gets a number of small writes, either walking forward through the buffer (e.g. per
+// object data rewritten in order) or at random offsets, then every buffer's ranges are merged and turned into
+// copies. The merged ranges are checked against a byte map of what was written.
+BENCH(DirtyRange_MergeThroughput)
+{
+    const uint32_t bufferCount = 256;
+    const uint32_t writesPerBuffer = test::isQuickRun() ? 64 : 1024;
+    const uint32_t repeatCount = test::isQuickRun() ? 1 : 20;
+
+    FakeResource heap{ 0 };
+    std::vector<DirtyRangeSet> dirtyRanges(bufferCount);
+    std::vector<uint8_t> written(BUFFER_SIZE);
+
+    std::printf("  %10s %12s %14s %12s\n", "pattern", "ms/batch", "Mwrites/s", "copies");
+    for (const bool isRandom : { false, true }) {
+        double totalMs = 0.0;
+        size_t copyCount = 0;
+        bool isExact = true;
+        for (uint32_t repeat = 0; repeat < repeatCount; repeat++) {
+            uint32_t seed = 17 + repeat;
+            BufferCopyListT<FakeResource> copies{ UPLOAD_ALIGNMENT };
+
+            uint64_t srcOffset = 0;
+            const test::Timer timer;
+            for (uint32_t buffer = 0; buffer < bufferCount; buffer++) {
+                DirtyRangeSet& dirty = dirtyRanges[buffer];
+                uint64_t offset = 0;
+                for (uint32_t i = 0; i < writesPerBuffer; i++) {
+                    seed = seed * 1664525u + 1013904223u;
+                    const uint64_t size = 16 + (seed >> 8) % 48;
+                    offset = isRandom ? (seed >> 12) % (BUFFER_SIZE - size) : (offset + (seed >> 20) % 64) % (BUFFER_SIZE - size);
+                    dirty.add(offset, size);
+                    offset += size;
+                }
+
+                for (const DirtyRangeSet::Range& range : dirty.merge()) {
+                    copies.add(&heap, buffer * BUFFER_SIZE + range.begin, srcOffset, range.end - range.begin, false);
+                    srcOffset += (range.end - range.begin + UPLOAD_ALIGNMENT - 1) & ~(UPLOAD_ALIGNMENT - 1);
+                }
+            }
+            totalMs += timer.getElapsedMs();
+            copyCount = copies.size();
+
+            // Replay the first buffer's writes into a byte map and compare it against its merged ranges
+            seed = 17 + repeat;
+            std::fill(written.begin(), written.end(), uint8_t(0));
+            uint64_t offset = 0;
+            for (uint32_t i = 0; i < writesPerBuffer; i++) {
+                seed = seed * 1664525u + 1013904223u;
+                const uint64_t size = 16 + (seed >> 8) % 48;
+                offset = isRandom ? (seed >> 12) % (BUFFER_SIZE - size) : (offset + (seed >> 20) % 64) % (BUFFER_SIZE - size);
+                std::fill(written.begin() + offset, written.begin() + offset + size, uint8_t(1));
+                offset += size;
+            }
+            std::vector<uint8_t> merged(BUFFER_SIZE, 0);
+            uint64_t previousEnd = 0;
+            for (const DirtyRangeSet::Range& range : dirtyRanges[0].merge()) {
+                // Sorted, and separated by at least one byte that wasn't written
+                isExact &= range.begin > previousEnd || (range.begin == 0 && previousEnd == 0);
+                std::fill(merged.begin() + range.begin, merged.begin() + range.end, uint8_t(1));
+                previousEnd = range.end;
+            }
+            isExact &= merged == written;
+
+            for (DirtyRangeSet& dirty : dirtyRanges) {
+                dirty.clear();
+            }
+        }
+        CHECK(isExact);
+
+        const double msPerBatch = totalMs / repeatCount;
+        const double writesPerSecond = double(bufferCount) * writesPerBuffer / (msPerBatch / 1000.0);
+        std::printf("  %10s %12.3f %14.1f %12zu\n", isRandom ? "random" : "forward", msPerBatch, writesPerSecond / 1.0e6, copyCount);
+    }
+}
@@ -0,0 +1,114 @@
+#include "TestHarness.h"
+#include <atomic>
+#include <thread>
+
+#include "FenceCompletionCache.h"
+#include "SimulatedFence.h"
+
+using namespace bdr;
+
+TEST(FenceCompletionCache_OnlyPollsWhenItHasTo)
+{
+    FenceCompletionCache cache{ 10 };
+    uint32_t pollCount = 0;
+    auto pollFence = [&pollCount]() {
+        pollCount++;
+        return uint64_t(20);
+    };
+
+    CHECK(cache.isComplete(5, pollFence));
+    CHECK(cache.isComplete(10, pollFence));
+    CHECK_EQ(pollCount, 0u);
+
+    CHECK(cache.isComplete(15, pollFence));
+    CHECK_EQ(pollCount, 1u);
+    CHECK_EQ(cache.get(), 20u);
+
+    // Answered from the value the last poll brought in
+    CHECK(cache.isComplete(20, pollFence));
+    CHECK_EQ(pollCount, 1u);
+    CHECK(!cache.isComplete(21, pollFence));
+    CHECK_EQ(pollCount, 2u);
+
+    // A stale reading never moves the cache backwards
+    CHECK_EQ(cache.advance(12), 20u);
+    CHECK_EQ(cache.get(), 20u);
+}
+
+// One thread plays the GPU and completes fence values in order, others poll random values through the cache
+// and feed it readings they took a while ago. No query may ever report a fence that hasn't completed, and no
+// thread may ever see the cached value go down.
+TEST(FenceCompletionCache_StressAgainstSimulatedFence)
+{
+    const uint32_t timeline = 2;
+    const uint32_t fenceCount = 200000;
+    const uint32_t pollerCount = 6;
+
+    SimulatedFence fence;
+    FenceCompletionCache cache{ getFenceTimelineBase(timeline) };
+    std::atomic<bool> isDone{ false };
+    std::atomic<uint64_t> queryCount{ 0 };
+    std::atomic<uint64_t> pollCount{ 0 };
+    std::atomic<uint32_t> prematureCount{ 0 };
+    std::atomic<uint32_t> backwardsCount{ 0 };
+
+    std::thread gpu([&]() {
+        for (uint32_t i = 0; i < fenceCount; i++) {
+            fence.complete(fence.incrementFence(timeline));
+        }
+        isDone.store(true);
+    });
+
+    std::vector<std::thread> pollers;
+    for (uint32_t t = 0; t < pollerCount; t++) {
+        pollers.emplace_back([&, t]() {
+            uint32_t seed = t + 1;
+            uint64_t lastSeen = 0;
+            uint64_t staleReading = fence.getCompletedFenceValue(timeline);
+            uint64_t queries = 0;
+            uint64_t polls = 0;
+            // A minimum number of queries, in case the GPU thread gets through everything before this one runs
+            while (!isDone.load() || queries < 1000) {
+                seed = seed * 1664525u + 1013904223u;
+                const uint64_t query = getFenceTimelineBase(timeline) + 1 + (seed >> 8) % fenceCount;
+                const bool isComplete = cache.isComplete(query, [&]() {
+                    polls++;
+                    return fence.getCompletedFenceValue(timeline);
+                });
+                queries++;
+                if (isComplete && !fence.isFenceComplete(query)) {
+                    prematureCount.fetch_add(1);
+                }
+
+                // Half the pollers push readings that are a few hundred queries old
+                if (t % 2 == 0) {
+                    cache.advance(staleReading);
+                    if (queries % 256 == 0) {
+                        staleReading = fence.getCompletedFenceValue(timeline);
+                    }
+                }
+
+                const uint64_t seen = cache.get();
+                if (seen < lastSeen) {
+                    backwardsCount.fetch_add(1);
+                }
+                lastSeen = seen;
+            }
+            queryCount.fetch_add(queries);
+            pollCount.fetch_add(polls);
+        });
+    }
+
+    gpu.join();
+    for (std::thread& poller : pollers) {
+        poller.join();
+    }
+
+    CHECK_EQ(prematureCount.load(), 0u);
+    CHECK_EQ(backwardsCount.load(), 0u);
+    CHECK(queryCount.load() > 0);
+    // Queries below the cached value are answered without touching the fence, and with random queries over
+    // the whole range plenty of them are
+    CHECK(pollCount.load() < queryCount.load());
+    CHECK_EQ(cache.refresh([&]() { return fence.getCompletedFenceValue(timeline); }), getFenceTimelineBase(timeline) + fenceCount);
+}
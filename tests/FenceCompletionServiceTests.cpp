@@ -0,0 +1,180 @@
+#include "TestHarness.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include "FenceCompletionService.h"
+#include "SimulatedFence.h"
+
+using namespace bdr;
+
+namespace
+{
+    using FenceCompletionService = FenceCompletionServiceT<SimulatedFence>;
+
+    // The waiter thread runs callbacks asynchronously; gives it a generous while to get there
+    template <typename Predicate>
+    bool waitUntil(const Predicate& predicate)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!predicate()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    struct CallbackLog
+    {
+        std::mutex mutex;
+        std::vector<uint32_t> order;
+        std::atomic<uint32_t> prematureCount{ 0 };
+
+        size_t size()
+        {
+            std::lock_guard<std::mutex> lockGuard{ mutex };
+            return order.size();
+        }
+    };
+}
+
+// Callbacks are registered out of order on two timelines, several per fence value. Each one checks that its
+// fence had completed by the time it ran, and they come out in fence order per timeline, registration order
+// within a value.
+TEST(FenceCompletionService_CallbacksRunInFenceOrderAndNeverEarly)
+{
+    SimulatedFence fence;
+    FenceCompletionService service{ fence };
+    service.start();
+
+    const uint32_t valueCount = 20;
+    uint64_t values[2][valueCount];
+    for (uint32_t timeline = 0; timeline < 2; timeline++) {
+        for (uint32_t i = 0; i < valueCount; i++) {
+            values[timeline][i] = fence.incrementFence(timeline);
+        }
+    }
+
+    CallbackLog logs[2];
+    for (uint32_t i = 0; i < valueCount; i++) {
+        // Walk the values in a scrambled order, two callbacks per value
+        const uint32_t index = (i * 7) % valueCount;
+        for (uint32_t timeline = 0; timeline < 2; timeline++) {
+            for (uint32_t copy = 0; copy < 2; copy++) {
+                const uint64_t value = values[timeline][index];
+                CallbackLog& log = logs[timeline];
+                service.onComplete(value, [&fence, &log, value, id = index * 2 + copy]() {
+                    if (!fence.isFenceComplete(value)) {
+                        log.prematureCount.fetch_add(1);
+                    }
+                    std::lock_guard<std::mutex> lockGuard{ log.mutex };
+                    log.order.push_back(id);
+                });
+            }
+        }
+    }
+    CHECK_EQ(service.getPendingCount(), size_t(4 * valueCount));
+
+    // Nothing has completed, so nothing runs
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK_EQ(logs[0].size() + logs[1].size(), size_t(0));
+
+    // Completing part of one timeline runs exactly its callbacks up to that value
+    fence.complete(values[0][4]);
+    CHECK(waitUntil([&]() { return logs[0].size() == 10; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK_EQ(logs[0].size(), size_t(10));
+    CHECK_EQ(logs[1].size(), size_t(0));
+
+    // The rest, in a few steps
+    for (uint32_t step = 9; step < valueCount; step += 5) {
+        fence.complete(values[1][step]);
+        fence.complete(values[0][step]);
+    }
+    CHECK(waitUntil([&]() { return logs[0].size() == 2 * valueCount && logs[1].size() == 2 * valueCount; }));
+    CHECK_EQ(service.getPendingCount(), size_t(0));
+
+    for (CallbackLog& log : logs) {
+        CHECK_EQ(log.prematureCount.load(), 0u);
+        bool isOrdered = true;
+        for (uint32_t i = 0; i < log.order.size(); i++) {
+            isOrdered &= log.order[i] == i;
+        }
+        CHECK(isOrdered);
+    }
+}
+
+// A value that has already completed doesn't go through the waiter: the callback runs before onComplete
+// returns, on the calling thread, whether or not the service has been started
+TEST(FenceCompletionService_CompletedValuesRunInline)
+{
+    SimulatedFence fence;
+    FenceCompletionService service{ fence };
+    const uint64_t value = fence.incrementFence(1);
+    fence.complete(value);
+    CHECK(service.isComplete(value));
+    CHECK(!service.isComplete(fence.getNextFenceValue(1)));
+
+    std::thread::id callbackThread;
+    service.onComplete(value, [&callbackThread]() { callbackThread = std::this_thread::get_id(); });
+    CHECK(callbackThread == std::this_thread::get_id());
+
+    service.start();
+    bool hasRun = false;
+    service.onComplete(value - 1, [&hasRun]() { hasRun = true; });
+    CHECK(hasRun);
+    CHECK(service.whenComplete(value).wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    CHECK_EQ(service.getPendingCount(), size_t(0));
+}
+
+// Futures become ready once their fence completes. Stopping drops whatever is still pending, so its futures
+// report a broken promise instead of hanging, and the service can be started again afterwards.
+TEST(FenceCompletionService_FuturesResolveAndStopDrainsPending)
+{
+    SimulatedFence fence;
+    FenceCompletionService service{ fence };
+    service.start();
+
+    const uint64_t first = fence.incrementFence(0);
+    const uint64_t second = fence.incrementFence(0);
+    std::future<void> firstFuture = service.whenComplete(first);
+    std::future<void> secondFuture = service.whenComplete(second);
+    CHECK(firstFuture.wait_for(std::chrono::milliseconds(20)) == std::future_status::timeout);
+
+    // Completed from another thread, as the GPU would
+    std::thread gpu([&fence, first]() { fence.complete(first); });
+    CHECK(firstFuture.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+    gpu.join();
+    CHECK(secondFuture.wait_for(std::chrono::milliseconds(0)) == std::future_status::timeout);
+
+    std::atomic<bool> hasDroppedRun{ false };
+    service.onComplete(second, [&hasDroppedRun]() { hasDroppedRun.store(true); });
+    CHECK_EQ(service.getPendingCount(), size_t(2));
+
+    service.stop();
+    CHECK_EQ(service.getPendingCount(), size_t(0));
+    CHECK(secondFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    bool isBroken = false;
+    try {
+        secondFuture.get();
+    }
+    catch (const std::future_error& error) {
+        isBroken = error.code() == std::future_errc::broken_promise;
+    }
+    CHECK(isBroken);
+
+    // Completing the fence after the stop runs nothing
+    fence.complete(second);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CHECK(!hasDroppedRun.load());
+
+    service.start();
+    const uint64_t third = fence.incrementFence(0);
+    std::future<void> thirdFuture = service.whenComplete(third);
+    fence.complete(third);
+    CHECK(thirdFuture.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+    service.stop();
+}
@@ -0,0 +1,85 @@
+#include "TestHarness.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "MappedFile.h"
+
+using namespace bdr;
+
+namespace
+{
+    // What the removed ReadDataFromFile did, with stdio in place of ReadFile: a heap buffer the size of the file,
+    // one blocking read, then the copy into staging
+    bool readWholeFile(const std::filesystem::path& path, uint8_t* pStaging, const size_t size)
+    {
+        std::FILE* pFile = std::fopen(path.string().c_str(), "rb");
+        if (pFile == nullptr) {
+            return false;
+        }
+        uint8_t* pData = static_cast<uint8_t*>(std::malloc(size));
+        const bool isRead = std::fread(pData, 1, size, pFile) == size;
+        std::fclose(pFile);
+        if (isRead) {
+            std::memcpy(pStaging, pData, size);
+        }
+        std::free(pData);
+        return isRead;
+    }
+
+    // Copies straight from the view in chunks, prefetching the next chunk ahead of the copy
+    bool copyMappedFile(const std::filesystem::path& path, uint8_t* pStaging)
+    {
+        constexpr uint64_t CHUNK_SIZE = 8ull << 20;
+        MappedFile mapped;
+        if (!mapped.open(path, FileAccessHint::Sequential)) {
+            return false;
+        }
+        for (uint64_t offset = 0; offset < mapped.getSize(); offset += CHUNK_SIZE) {
+            mapped.prefetch(offset + CHUNK_SIZE, CHUNK_SIZE);
+            std::memcpy(pStaging + offset, mapped.getData() + offset, size_t(std::min(CHUNK_SIZE, mapped.getSize() - offset)));
+        }
+        return true;
+    }
+}
+
+// Getting a large asset file into staging memory: the old read-into-a-heap-buffer path against copying from a
+// mapped view. The file was just written, so this measures a warm page cache, which is the common case for
+// assets loaded again and again during development.
+BENCH(FileRead_LargeFileIntoStaging)
+{
+    const size_t fileSize = test::isQuickRun() ? 16u << 20 : 512u << 20;
+    const uint32_t repeatCount = test::isQuickRun() ? 1 : 5;
+
+    std::vector<uint8_t> contents(fileSize);
+    for (size_t i = 0; i < fileSize; i += sizeof(uint32_t)) {
+        const uint32_t value = uint32_t(i * 2654435761u);
+        std::memcpy(contents.data() + i, &value, sizeof(value));
+    }
+    const test::TempFile file{ "large.bin" };
+    CHECK(file.write(contents.data(), contents.size()));
+
+    std::vector<uint8_t> staging(fileSize);
+    double readMs = 1.0e30;
+    double mappedMs = 1.0e30;
+    bool isIntact = true;
+    for (uint32_t repeat = 0; repeat < repeatCount; repeat++) {
+        std::memset(staging.data(), 0, fileSize);
+        test::Timer timer;
+        CHECK(readWholeFile(file.getPath(), staging.data(), fileSize));
+        readMs = std::min(readMs, timer.getElapsedMs());
+        isIntact &= staging == contents;
+
+        std::memset(staging.data(), 0, fileSize);
+        timer = test::Timer{};
+        CHECK(copyMappedFile(file.getPath(), staging.data()));
+        mappedMs = std::min(mappedMs, timer.getElapsedMs());
+        isIntact &= staging == contents;
+    }
+    CHECK(isIntact);
+
+    const double gigabytes = double(fileSize) / (1024.0 * 1024.0 * 1024.0);
+    std::printf("  %zu MB file\n", fileSize >> 20);
+    std::printf("  read + copy:  %8.2f ms, %6.2f GB/s\n", readMs, gigabytes / (readMs / 1000.0));
+    std::printf("  mapped copy:  %8.2f ms, %6.2f GB/s\n", mappedMs, gigabytes / (mappedMs / 1000.0));
+}
@@ -0,0 +1,141 @@
+#include "TestHarness.h"
+#include <algorithm>
+#include <sstream>
+
+#include "FramePacer.h"
+#include "SimulatedFence.h"
+
+using namespace bdr;
+
+namespace
+{
+    // Time only moves when the test says so
+    struct ManualClock
+    {
+        static inline double s_nowMs = 0.0;
+
+        static double nowMs()
+        {
+            return s_nowMs;
+        }
+    };
+
+    using TestFramePacer = FramePacerT<ManualClock>;
+    constexpr uint32_t TIMELINE = 0;
+}
+
+// A GPU that never finishes anything on its own: frames only complete when beginFrame waits on them. The CPU
+// must then stay exactly `maxFramesInFlight` frames ahead, waiting on the frame that used the slot before.
+TEST(FramePacer_BoundsFramesInFlight)
+{
+    for (uint32_t maxFramesInFlight = 1; maxFramesInFlight <= TestFramePacer::MAX_FRAMES_IN_FLIGHT; maxFramesInFlight++) {
+        SimulatedFence fence;
+        TestFramePacer pacer{ maxFramesInFlight };
+        CHECK_EQ(pacer.getMaxFramesInFlight(), maxFramesInFlight);
+
+        std::vector<uint64_t> submitted;
+        uint32_t maxInFlight = 0;
+        bool isBounded = true;
+        bool waitsOnTheRightFrame = true;
+        for (uint32_t frame = 0; frame < 50; frame++) {
+            bool hasWaited = false;
+            pacer.beginFrame([&](const uint64_t fenceValue) {
+                hasWaited = true;
+                waitsOnTheRightFrame &= frame >= maxFramesInFlight && fenceValue == submitted[frame - maxFramesInFlight];
+                fence.complete(fenceValue);
+            });
+            waitsOnTheRightFrame &= hasWaited == (frame >= maxFramesInFlight);
+            CHECK_EQ(pacer.getFrameSlot(), frame % maxFramesInFlight);
+
+            // Every earlier frame that hasn't completed is still queued on the GPU
+            uint32_t inFlight = 0;
+            for (const uint64_t fenceValue : submitted) {
+                inFlight += fence.isFenceComplete(fenceValue) ? 0 : 1;
+            }
+            isBounded &= inFlight < maxFramesInFlight;
+
+            if (pacer.hasCompletedFrame()) {
+                pacer.completeFrame(0.0, 0.0);
+            }
+            const uint64_t fenceValue = fence.incrementFence(TIMELINE);
+            pacer.endFrame(fenceValue);
+            submitted.push_back(fenceValue);
+            maxInFlight = std::max(maxInFlight, inFlight + 1);
+        }
+        CHECK(isBounded);
+        CHECK(waitsOnTheRightFrame);
+        // The CPU gets all the way ahead, not just part of it
+        CHECK_EQ(maxInFlight, maxFramesInFlight);
+        CHECK_EQ(pacer.getFrameNumber(), 50u);
+    }
+}
+
+// Two frames in flight and a GPU slower than the CPU: once the queue is full the CPU waits every frame, the GPU
+// never idles, and latency covers the whole time a frame spent queued
+TEST(FramePacer_FrameTimings)
+{
+    ManualClock::s_nowMs = 1000.0;
+    SimulatedFence fence;
+    TestFramePacer pacer{ 2, 3 };
+
+    std::vector<double> gpuEndMs;
+    for (uint32_t frame = 0; frame < 6; frame++) {
+        pacer.beginFrame([&](const uint64_t fenceValue) {
+            // Blocks until the GPU is done with the frame two back
+            ManualClock::s_nowMs = std::max(ManualClock::s_nowMs, gpuEndMs[frame - 2]);
+            fence.complete(fenceValue);
+        });
+        if (pacer.hasCompletedFrame()) {
+            pacer.completeFrame(gpuEndMs[frame - 2] - 10.0, gpuEndMs[frame - 2]);
+        }
+
+        // 4 ms of recording, then the GPU starts 2 ms after submission (or once it's free) and takes 10 ms
+        ManualClock::s_nowMs += 4.0;
+        pacer.endFrame(fence.incrementFence(TIMELINE));
+        const double gpuBeginMs = std::max(ManualClock::s_nowMs + 2.0, gpuEndMs.empty() ? 0.0 : gpuEndMs.back());
+        gpuEndMs.push_back(gpuBeginMs + 10.0);
+    }
+
+    // Frames 0 and 1 begin at 1000 and 1004 without waiting and finish on the GPU at 1016 and 1026. Frame 2
+    // begins at 1008 and waits for frame 0 until 1016; frame 3 begins at 1020, waits for frame 1 until 1026
+    // and runs on the GPU from 1036 to 1046, straight after frame 2. Frame 5's beginFrame completes it.
+    const FrameTimings& timings = pacer.getLastFrameTimings();
+    CHECK_EQ(timings.frameNumber, 3u);
+    CHECK(timings.cpuWaitMs == 6.0);
+    CHECK(timings.gpuWaitMs == 0.0);
+    CHECK(timings.latencyMs == 1046.0 - 1026.0);
+
+    // Only the last three completed frames are kept, oldest first
+    std::ostringstream csv;
+    pacer.writeCsv(csv);
+    std::istringstream lines{ csv.str() };
+    std::string line;
+    std::vector<std::string> rows;
+    while (std::getline(lines, line)) {
+        rows.push_back(line);
+    }
+    CHECK_EQ(rows.size(), size_t(4));
+    CHECK(rows[0] == "frame,cpuWaitMs,gpuWaitMs,latencyMs");
+    CHECK(rows[1].rfind("1,", 0) == 0);
+    CHECK(rows[3].rfind("3,", 0) == 0);
+}
+
+// The GPU sat idle between two frames: the gap shows up as GPU wait time, and only between consecutive frames
+TEST(FramePacer_GpuIdleTime)
+{
+    ManualClock::s_nowMs = 0.0;
+    SimulatedFence fence;
+    TestFramePacer pacer{ 1 };
+
+    pacer.beginFrame([](uint64_t) {});
+    pacer.endFrame(fence.incrementFence(TIMELINE));
+    pacer.beginFrame([&fence](const uint64_t fenceValue) { fence.complete(fenceValue); });
+    pacer.completeFrame(1.0, 5.0);
+    CHECK(pacer.getLastFrameTimings().gpuWaitMs == 0.0);
+    pacer.endFrame(fence.incrementFence(TIMELINE));
+
+    pacer.beginFrame([&fence](const uint64_t fenceValue) { fence.complete(fenceValue); });
+    pacer.completeFrame(8.0, 9.0);
+    CHECK(pacer.getLastFrameTimings().gpuWaitMs == 3.0);
+    CHECK_EQ(pacer.getLastFrameTimings().frameNumber, 1u);
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Builds glTF test inputs in memory, so the loader tests and benchmark don't depend on files lying around
+namespace bdr::test
+{
+    template <typename T>
+    inline void appendBytes(std::vector<uint8_t>& bytes, const T& value)
+    {
+        const size_t offset = bytes.size();
+        bytes.resize(offset + sizeof(T));
+        std::memcpy(bytes.data() + offset, &value, sizeof(T));
+    }
+
+    inline void padTo4(std::vector<uint8_t>& bytes, const uint8_t padding = 0)
+    {
+        while (bytes.size() % 4 != 0) {
+            bytes.push_back(padding);
+        }
+    }
+
+    inline std::string encodeBase64(const std::vector<uint8_t>& bytes)
+    {
+        static const char s_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string encoded;
+        for (size_t i = 0; i < bytes.size(); i += 3) {
+            const size_t remaining = bytes.size() - i;
+            const uint32_t triple = (uint32_t(bytes[i]) << 16)
+                | (remaining > 1 ? uint32_t(bytes[i + 1]) << 8 : 0u)
+                | (remaining > 2 ? uint32_t(bytes[i + 2]) : 0u);
+            encoded += s_alphabet[(triple >> 18) & 63];
+            encoded += s_alphabet[(triple >> 12) & 63];
+            encoded += remaining > 1 ? s_alphabet[(triple >> 6) & 63] : '=';
+            encoded += remaining > 2 ? s_alphabet[triple & 63] : '=';
+        }
+        return encoded;
+    }
+
+    // A GLB container: header, JSON chunk padded with spaces, BIN chunk padded with zeros
+    inline std::vector<uint8_t> makeGlb(std::string json, std::vector<uint8_t> bin)
+    {
+        while (json.size() % 4 != 0) {
+            json += ' ';
+        }
+        padTo4(bin);
+
+        std::vector<uint8_t> glb;
+        appendBytes(glb, uint32_t(0x46546C67));
+        appendBytes(glb, uint32_t(2));
+        appendBytes(glb, uint32_t(12 + 8 + json.size() + 8 + bin.size()));
+        appendBytes(glb, uint32_t(json.size()));
+        appendBytes(glb, uint32_t(0x4E4F534A));
+        glb.insert(glb.end(), json.begin(), json.end());
+        appendBytes(glb, uint32_t(bin.size()));
+        appendBytes(glb, uint32_t(0x004E4942));
+        glb.insert(glb.end(), bin.begin(), bin.end());
+        return glb;
+    }
+
+    // Position x of vertex `vertex` of mesh `mesh` in makeGlbModel's output
+    inline float getGlbModelPositionX(const uint32_t mesh, const uint32_t vertex)
+    {
+        return float((mesh + vertex) % 997);
+    }
+
+    // `meshCount` meshes of one indexed triangle primitive each, with `vertexCount` float3 positions, float4
+    // colors and twice as many uint32 indices as vertices, all in the GLB's BIN chunk
+    inline std::vector<uint8_t> makeGlbModel(const uint32_t meshCount, const uint32_t vertexCount)
+    {
+        const uint32_t indexCount = vertexCount / 3 * 3 * 2;
+        std::vector<uint8_t> bin;
+        std::string views;
+        std::string accessors;
+        std::string meshes;
+        for (uint32_t mesh = 0; mesh < meshCount; mesh++) {
+            const size_t positionOffset = bin.size();
+            for (uint32_t i = 0; i < vertexCount; i++) {
+                appendBytes(bin, getGlbModelPositionX(mesh, i));
+                appendBytes(bin, float(i % 100));
+                appendBytes(bin, float(mesh));
+            }
+            const size_t colorOffset = bin.size();
+            for (uint32_t i = 0; i < vertexCount; i++) {
+                for (uint32_t component = 0; component < 4; component++) {
+                    appendBytes(bin, float((i * 7 + component) % 256) / 255.0f);
+                }
+            }
+            const size_t indexOffset = bin.size();
+            for (uint32_t i = 0; i < indexCount; i++) {
+                appendBytes(bin, uint32_t((i * 31u) % vertexCount));
+            }
+
+            const uint32_t firstView = mesh * 3;
+            const std::string separator = mesh == 0 ? "" : ",";
+            views += separator + "{\"buffer\":0,\"byteOffset\":" + std::to_string(positionOffset) + ",\"byteLength\":" + std::to_string(colorOffset - positionOffset) + "},"
+                + "{\"buffer\":0,\"byteOffset\":" + std::to_string(colorOffset) + ",\"byteLength\":" + std::to_string(indexOffset - colorOffset) + "},"
+                + "{\"buffer\":0,\"byteOffset\":" + std::to_string(indexOffset) + ",\"byteLength\":" + std::to_string(bin.size() - indexOffset) + "}";
+            accessors += separator + "{\"bufferView\":" + std::to_string(firstView) + ",\"componentType\":5126,\"count\":" + std::to_string(vertexCount) + ",\"type\":\"VEC3\"},"
+                + "{\"bufferView\":" + std::to_string(firstView + 1) + ",\"componentType\":5126,\"count\":" + std::to_string(vertexCount) + ",\"type\":\"VEC4\"},"
+                + "{\"bufferView\":" + std::to_string(firstView + 2) + ",\"componentType\":5125,\"count\":" + std::to_string(indexCount) + ",\"type\":\"SCALAR\"}";
+            meshes += separator + "{\"name\":\"m" + std::to_string(mesh) + "\",\"primitives\":[{\"attributes\":{\"POSITION\":" + std::to_string(firstView)
+                + ",\"COLOR_0\":" + std::to_string(firstView + 1) + "},\"indices\":" + std::to_string(firstView + 2) + "}]}";
+        }
+
+        const std::string json = "{\"asset\":{\"version\":\"2.0\"},\"buffers\":[{\"byteLength\":" + std::to_string(bin.size()) + "}],"
+            + "\"bufferViews\":[" + views + "],\"accessors\":[" + accessors + "],\"meshes\":[" + meshes + "]}";
+        return makeGlb(json, std::move(bin));
+    }
+}
@@ -0,0 +1,75 @@
+#include "TestHarness.h"
+#include <algorithm>
+
+#include "GltfFixtures.h"
+#include "GltfLoader.h"
+
+using namespace bdr;
+
+// Loading a generated GLB and decoding every primitive into one staging-sized block, with the decode split
+// across pools of different sizes (0 workers decodes on the calling thread only). Prints the time each stage
+// of the load takes; the best of a few runs is kept, so the file is warm in the page cache after the first.
+BENCH(GltfLoad_StageTimings)
+{
+    const uint32_t meshCount = test::isQuickRun() ? 8 : 64;
+    const uint32_t vertexCount = test::isQuickRun() ? 5000 : 50000;
+    const uint32_t repeatCount = test::isQuickRun() ? 1 : 5;
+
+    const test::TempFile glb{ "bench.glb" };
+    {
+        const std::vector<uint8_t> glbBytes = test::makeGlbModel(meshCount, vertexCount);
+        CHECK(glb.write(glbBytes.data(), glbBytes.size()));
+        std::printf("  %u meshes of %u vertices, %.1f MB\n", meshCount, vertexCount, double(glbBytes.size()) / (1024.0 * 1024.0));
+    }
+
+    std::printf("  %8s %10s %10s %12s %12s %12s\n", "workers", "map ms", "parse ms", "resolve ms", "decode ms", "decode GB/s");
+    for (const uint32_t workerCount : { 0u, 1u, 3u, 7u }) {
+        ThreadPool pool{ workerCount };
+        GltfLoadTimings best{ 1.0e30, 1.0e30, 1.0e30, 1.0e30 };
+        uint64_t decodedBytes = 0;
+        bool isCorrect = true;
+        for (uint32_t repeat = 0; repeat < repeatCount; repeat++) {
+            GltfAsset asset;
+            std::string error;
+            if (!asset.load(glb.getPath(), &error)) {
+                CHECK(false);
+                std::printf("  %s\n", error.c_str());
+                return;
+            }
+
+            // One block for everything, the way the sample stages a model for upload
+            const std::vector<GltfPrimitive>& primitives = asset.getPrimitives();
+            std::vector<uint64_t> offsets;
+            uint64_t totalBytes = 0;
+            for (const GltfPrimitive& primitive : primitives) {
+                offsets.push_back(totalBytes);
+                totalBytes += primitive.getVertexBytes();
+                offsets.push_back(totalBytes);
+                totalBytes += primitive.getIndexBytes();
+            }
+            std::vector<uint8_t> staging(static_cast<size_t>(totalBytes));
+            std::vector<GltfVertex*> vertexPointers;
+            std::vector<void*> indexPointers;
+            for (size_t i = 0; i < primitives.size(); i++) {
+                vertexPointers.push_back(reinterpret_cast<GltfVertex*>(staging.data() + offsets[2 * i]));
+                indexPointers.push_back(staging.data() + offsets[2 * i + 1]);
+            }
+            asset.decode(pool, 0, uint32_t(primitives.size()), vertexPointers.data(), indexPointers.data());
+            test::doNotOptimize(staging.data());
+
+            isCorrect &= primitives.size() == meshCount && vertexPointers[7][5].position[0] == test::getGlbModelPositionX(7, 5);
+            decodedBytes = totalBytes;
+
+            const GltfLoadTimings& timings = asset.getTimings();
+            best.mapMs = std::min(best.mapMs, timings.mapMs);
+            best.parseMs = std::min(best.parseMs, timings.parseMs);
+            best.resolveMs = std::min(best.resolveMs, timings.resolveMs);
+            best.decodeMs = std::min(best.decodeMs, timings.decodeMs);
+        }
+        CHECK(isCorrect);
+
+        const double gigabytes = double(decodedBytes) / (1024.0 * 1024.0 * 1024.0);
+        std::printf("  %8u %10.3f %10.3f %12.3f %12.3f %12.2f\n", workerCount, best.mapMs, best.parseMs, best.resolveMs, best.decodeMs,
+            gigabytes / (best.decodeMs / 1000.0));
+    }
+}
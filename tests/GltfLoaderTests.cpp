@@ -0,0 +1,240 @@
+#include "TestHarness.h"
+#include <cstring>
+
+#include "GltfFixtures.h"
+#include "GltfLoader.h"
+
+using namespace bdr;
+
+namespace
+{
+    // Two buffers: an embedded base64 one with five interleaved vertices and 8 bit indices, and an external file
+    // with planar float3 positions and colors and 32 bit indices. Mesh 0 has an indexed primitive and a point
+    // list, which is skipped; mesh 1 has no name, a non-indexed primitive and one without colors.
+    std::string makeGltf(const std::string& externalUri, const uint32_t firstAccessorCount = 5)
+    {
+        std::vector<uint8_t> embedded;
+        for (uint32_t i = 0; i < 5; i++) {
+            test::appendBytes(embedded, float(i));
+            test::appendBytes(embedded, float(2 * i));
+            test::appendBytes(embedded, float(3 * i));
+            const uint8_t color[] = { uint8_t(i * 10), 20, 30, 255 };
+            test::appendBytes(embedded, color);
+        }
+        const uint8_t indices[] = { 0, 1, 2, 2, 3, 4 };
+        test::appendBytes(embedded, indices);
+        test::padTo4(embedded);
+
+        return "{\"asset\":{\"version\":\"2.0\"},"
+            "\"buffers\":[{\"byteLength\":" + std::to_string(embedded.size()) + ",\"uri\":\"data:application/octet-stream;base64," + test::encodeBase64(embedded) + "\"},"
+            "{\"byteLength\":112,\"uri\":\"" + externalUri + "\"}],"
+            "\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":80,\"byteStride\":16},{\"buffer\":0,\"byteOffset\":80,\"byteLength\":6},"
+            "{\"buffer\":1,\"byteOffset\":0,\"byteLength\":48},{\"buffer\":1,\"byteOffset\":48,\"byteLength\":48},{\"buffer\":1,\"byteOffset\":96,\"byteLength\":16}],"
+            "\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":" + std::to_string(firstAccessorCount) + ",\"type\":\"VEC3\"},"
+            "{\"bufferView\":0,\"byteOffset\":12,\"componentType\":5121,\"normalized\":true,\"count\":5,\"type\":\"VEC4\"},"
+            "{\"bufferView\":1,\"componentType\":5121,\"count\":6,\"type\":\"SCALAR\"},"
+            "{\"bufferView\":2,\"componentType\":5126,\"count\":4,\"type\":\"VEC3\"},"
+            "{\"bufferView\":3,\"componentType\":5126,\"count\":4,\"type\":\"VEC3\"},"
+            "{\"bufferView\":4,\"componentType\":5125,\"count\":4,\"type\":\"SCALAR\"}],"
+            "\"meshes\":[{\"name\":\"first \\u00e9\",\"primitives\":[{\"attributes\":{\"POSITION\":0,\"COLOR_0\":1},\"indices\":2,\"mode\":4},"
+            "{\"attributes\":{\"POSITION\":0},\"mode\":0}]},"
+            "{\"primitives\":[{\"attributes\":{\"POSITION\":3,\"COLOR_0\":4}},{\"attributes\":{\"POSITION\":3},\"indices\":5}]}]}";
+    }
+
+    std::vector<uint8_t> makeExternalBuffer()
+    {
+        std::vector<uint8_t> bytes;
+        for (uint32_t i = 0; i < 4; i++) {
+            test::appendBytes(bytes, -float(i));
+            test::appendBytes(bytes, 0.5f);
+            test::appendBytes(bytes, float(i));
+        }
+        for (uint32_t i = 0; i < 4; i++) {
+            test::appendBytes(bytes, 0.25f);
+            test::appendBytes(bytes, 0.5f);
+            test::appendBytes(bytes, 1.0f);
+        }
+        for (uint32_t i = 0; i < 4; i++) {
+            test::appendBytes(bytes, i);
+        }
+        return bytes;
+    }
+
+    // Percent-encodes spaces, the only character the temporary file names need escaped
+    std::string getUri(const std::filesystem::path& path)
+    {
+        std::string uri;
+        for (const char c : path.filename().string()) {
+            uri += c == ' ' ? std::string("%20") : std::string(1, c);
+        }
+        return uri;
+    }
+
+    struct DecodedAsset
+    {
+        std::vector<std::vector<GltfVertex>> vertices;
+        std::vector<std::vector<uint8_t>> indices;
+    };
+
+    DecodedAsset decodeAll(GltfAsset& asset, ThreadPool& pool)
+    {
+        const std::vector<GltfPrimitive>& primitives = asset.getPrimitives();
+        DecodedAsset decoded;
+        std::vector<GltfVertex*> vertexPointers;
+        std::vector<void*> indexPointers;
+        for (const GltfPrimitive& primitive : primitives) {
+            decoded.vertices.emplace_back(primitive.vertexCount);
+            decoded.indices.emplace_back(size_t(primitive.getIndexBytes()));
+        }
+        for (size_t i = 0; i < primitives.size(); i++) {
+            vertexPointers.push_back(decoded.vertices[i].data());
+            indexPointers.push_back(decoded.indices[i].data());
+        }
+        asset.decode(pool, 0, uint32_t(primitives.size()), vertexPointers.data(), indexPointers.data());
+        return decoded;
+    }
+
+    template <typename T>
+    T readIndex(const std::vector<uint8_t>& indices, const size_t i)
+    {
+        T index;
+        std::memcpy(&index, indices.data() + i * sizeof(T), sizeof(T));
+        return index;
+    }
+}
+
+TEST(GltfLoader_LoadsEmbeddedAndExternalBuffers)
+{
+    const test::TempFile external{ "ext data.bin" };
+    const std::vector<uint8_t> externalBytes = makeExternalBuffer();
+    CHECK(external.write(externalBytes.data(), externalBytes.size()));
+    const test::TempFile gltf{ "small.gltf" };
+    const std::string json = makeGltf(getUri(external.getPath()));
+    CHECK(gltf.write(json.data(), json.size()));
+
+    GltfAsset asset;
+    std::string error;
+    CHECK(asset.load(gltf.getPath(), &error));
+    CHECK(error.empty());
+
+    const std::vector<GltfPrimitive>& primitives = asset.getPrimitives();
+    CHECK_EQ(primitives.size(), size_t(3));
+    CHECK_EQ(asset.getMeshNames().size(), size_t(2));
+    CHECK(asset.getMeshNames()[0] == "first \xc3\xa9");
+    CHECK(asset.getMeshNames()[1] == "mesh 1");
+    if (primitives.size() != 3) {
+        return;
+    }
+    CHECK(primitives[0].meshIndex == 0 && primitives[1].meshIndex == 1 && primitives[2].meshIndex == 1);
+    CHECK(primitives[0].vertexCount == 5 && primitives[0].indexCount == 6 && primitives[0].indexSize == 2);
+    CHECK(primitives[1].vertexCount == 4 && primitives[1].indexCount == 4 && primitives[1].indexSize == 2);
+    CHECK(primitives[2].vertexCount == 4 && primitives[2].indexCount == 4 && primitives[2].indexSize == 4);
+
+    ThreadPool pool{ 2 };
+    const DecodedAsset decoded = decodeAll(asset, pool);
+
+    // Interleaved positions with normalized 8 bit colors, and 8 bit indices widened to 16
+    bool isExpected = true;
+    for (uint32_t i = 0; i < 5; i++) {
+        const GltfVertex& vertex = decoded.vertices[0][i];
+        isExpected &= vertex.position[0] == float(i) && vertex.position[1] == float(2 * i) && vertex.position[2] == float(3 * i);
+        isExpected &= vertex.color == (0xff1e1400u | (i * 10));
+    }
+    CHECK(isExpected);
+    const uint16_t expectedIndices[] = { 0, 1, 2, 2, 3, 4 };
+    CHECK(std::memcmp(decoded.indices[0].data(), expectedIndices, sizeof(expectedIndices)) == 0);
+
+    // Float colors are rounded to 8 bits with opaque alpha; non-indexed primitives get a 16 bit list
+    CHECK(decoded.vertices[1][2].position[0] == -2.0f && decoded.vertices[1][2].position[1] == 0.5f);
+    CHECK_EQ(decoded.vertices[1][2].color, 0xffff8040u);
+    for (uint32_t i = 0; i < 4; i++) {
+        CHECK_EQ(readIndex<uint16_t>(decoded.indices[1], i), uint16_t(i));
+    }
+
+    // No COLOR_0 is white
+    CHECK_EQ(decoded.vertices[2][3].color, 0xffffffffu);
+    CHECK_EQ(readIndex<uint32_t>(decoded.indices[2], 3), 3u);
+}
+
+TEST(GltfLoader_LoadsGlb)
+{
+    const uint32_t vertexCount = 100;
+    const std::vector<uint8_t> glbBytes = test::makeGlbModel(3, vertexCount);
+    const test::TempFile glb{ "model.glb" };
+    CHECK(glb.write(glbBytes.data(), glbBytes.size()));
+
+    GltfAsset asset;
+    std::string error;
+    CHECK(asset.load(glb.getPath(), &error));
+    const std::vector<GltfPrimitive>& primitives = asset.getPrimitives();
+    CHECK_EQ(primitives.size(), size_t(3));
+    if (primitives.size() != 3) {
+        return;
+    }
+    CHECK(asset.getMeshNames()[2] == "m2");
+    CHECK(primitives[2].vertexCount == vertexCount && primitives[2].indexCount == 198 && primitives[2].indexSize == 4);
+
+    ThreadPool pool{ 3 };
+    const DecodedAsset decoded = decodeAll(asset, pool);
+    bool isExpected = true;
+    for (uint32_t mesh = 0; mesh < 3; mesh++) {
+        for (uint32_t i = 0; i < vertexCount; i++) {
+            const GltfVertex& vertex = decoded.vertices[mesh][i];
+            isExpected &= vertex.position[0] == test::getGlbModelPositionX(mesh, i) && vertex.position[2] == float(mesh);
+            const uint32_t first = i * 7;
+            isExpected &= vertex.color == ((first % 256) | ((first + 1) % 256) << 8 | ((first + 2) % 256) << 16 | ((first + 3) % 256) << 24);
+        }
+        for (uint32_t i = 0; i < primitives[mesh].indexCount; i++) {
+            isExpected &= readIndex<uint32_t>(decoded.indices[mesh], i) == (i * 31) % vertexCount;
+        }
+    }
+    CHECK(isExpected);
+
+    // Decoding a single range without the pool writes the same vertices
+    std::vector<GltfVertex> vertices(vertexCount);
+    asset.decodeVertices(primitives[1], 10, 50, vertices.data());
+    CHECK(std::memcmp(vertices.data() + 10, decoded.vertices[1].data() + 10, 50 * sizeof(GltfVertex)) == 0);
+}
+
+TEST(GltfLoader_RejectsInvalidFiles)
+{
+    const test::TempFile external{ "ext data.bin" };
+    const std::vector<uint8_t> externalBytes = makeExternalBuffer();
+    CHECK(external.write(externalBytes.data(), externalBytes.size()));
+
+    // An accessor that reads past the end of its buffer view
+    {
+        const test::TempFile gltf{ "range.gltf" };
+        const std::string json = makeGltf(getUri(external.getPath()), 6);
+        CHECK(gltf.write(json.data(), json.size()));
+        GltfAsset asset;
+        std::string error;
+        CHECK(!asset.load(gltf.getPath(), &error));
+        CHECK(!error.empty());
+    }
+
+    // Truncated JSON
+    {
+        const test::TempFile gltf{ "truncated.gltf" };
+        const std::string json = makeGltf(getUri(external.getPath()));
+        CHECK(gltf.write(json.data(), json.size() / 2));
+        GltfAsset asset;
+        std::string error;
+        CHECK(!asset.load(gltf.getPath(), &error));
+        CHECK(!error.empty());
+    }
+
+    // A missing external buffer, and a missing file
+    {
+        const test::TempFile gltf{ "missing.gltf" };
+        const std::string json = makeGltf("does%20not%20exist.bin");
+        CHECK(gltf.write(json.data(), json.size()));
+        GltfAsset asset;
+        std::string error;
+        CHECK(!asset.load(gltf.getPath(), &error));
+        CHECK(!error.empty());
+
+        const test::TempFile nothing{ "nothing.gltf" };
+        CHECK(!asset.load(nothing.getPath(), &error));
+    }
+}
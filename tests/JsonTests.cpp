@@ -0,0 +1,73 @@
+#include "TestHarness.h"
+#include <cstring>
+
+#include "Json.h"
+
+using namespace bdr;
+
+namespace
+{
+    bool parse(const char* pText, JsonValue& out)
+    {
+        return parseJson(pText, std::strlen(pText), out);
+    }
+}
+
+TEST(Json_ParsesValues)
+{
+    JsonValue document;
+    std::string error;
+    const char* pText = "{\"a\":[1,2.5e2,-0.5,true,null],\"s\":\"x\\u00e9\\ud83d\\ude00\\n\",\"o\":{}}";
+    CHECK(parseJson(pText, std::strlen(pText), document, &error));
+    CHECK(error.empty());
+    CHECK(document.isObject());
+
+    const JsonValue& array = document["a"];
+    CHECK(array.isArray());
+    CHECK_EQ(array.getSize(), size_t(5));
+    CHECK_EQ(array[0].getUint(), 1u);
+    CHECK_EQ(array[1].getUint(), 250u);
+    CHECK(array[2].getNumber() == -0.5);
+    // Negative and fractional numbers aren't valid unsigned integers
+    CHECK_EQ(array[2].getUint(7), 7u);
+    CHECK(array[3].getBool());
+    CHECK(array[4].isNull());
+
+    // \u escapes, including surrogate pairs, come out as UTF-8
+    CHECK(document["s"].getString() == "x\xc3\xa9\xf0\x9f\x98\x80\n");
+    CHECK(document["o"].isObject());
+    CHECK(document["o"].getMembers().empty());
+
+    // Missing members and out of range indices are null all the way down
+    CHECK(document["missing"][3]["deeper"].isNull());
+    CHECK(array[99].isNull());
+}
+
+TEST(Json_RejectsInvalidDocuments)
+{
+    const char* invalid[] = { "{", "[1,]", "{\"a\" 1}", "01", "1.", "\"\\x\"", "tru", "[1] 2", "\"\\ud800\"", "-", "1e", "" };
+    for (const char* pText : invalid) {
+        JsonValue value;
+        std::string error;
+        const bool isParsed = parseJson(pText, std::strlen(pText), value, &error);
+        CHECK(!isParsed);
+        CHECK(!error.empty());
+    }
+
+    // Deep nesting fails instead of overflowing the stack
+    const std::string nested = std::string(1000, '[') + std::string(1000, ']');
+    JsonValue value;
+    CHECK(!parseJson(nested.data(), nested.size(), value));
+}
+
+// Only `length` bytes are read, the text doesn't have to be null terminated
+TEST(Json_ReadsOnlyLength)
+{
+    const char text[] = { '1', '2', '3', '4' };
+    JsonValue value;
+    CHECK(parseJson(text, 2, value));
+    CHECK_EQ(value.getUint(), 12u);
+
+    CHECK(parse(" [ ] ", value));
+    CHECK(value.isArray() && value.getSize() == 0);
+}
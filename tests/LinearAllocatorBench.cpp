@@ -0,0 +1,110 @@
+#include "TestHarness.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "HostMemoryBacking.h"
+
+using namespace bdr;
+
+namespace
+{
+    const uint32_t THREAD_COUNTS[] = { 1, 2, 4, 8, 16, 32 };
+
+    // Runs `frameCount` frames of `threadCount` threads each making `allocationsPerThread` allocations, with
+    // every thread started together so they actually contend. `getAllocator(t)` picks thread t's allocator.
+    // Returns the mean time per allocation in nanoseconds and raises `peakBytes` to the largest pool size seen
+    // at the end of a frame.
+    template <typename GetAllocator>
+    double runFrames(SimulatedFence& fence, const uint32_t threadCount, const uint32_t frameCount,
+        const uint32_t allocationsPerThread, std::vector<std::unique_ptr<HostLinearAllocator>>& allocators,
+        GetAllocator getAllocator, uint64_t& peakBytes)
+    {
+        double totalMs = 0.0;
+        std::atomic<uint32_t> failedCount{ 0 };
+        for (uint32_t frame = 0; frame < frameCount; frame++) {
+            std::atomic<uint32_t> readyCount{ 0 };
+            std::atomic<bool> isStarted{ false };
+            std::vector<std::thread> threads;
+            for (uint32_t t = 0; t < threadCount; t++) {
+                threads.emplace_back([&, t]() {
+                    HostLinearAllocator& allocator = getAllocator(t);
+                    readyCount.fetch_add(1);
+                    while (!isStarted.load(std::memory_order_acquire)) {
+                        std::this_thread::yield();
+                    }
+                    uint32_t failed = 0;
+                    for (uint32_t i = 0; i < allocationsPerThread; i++) {
+                        // Constant-buffer sized, like most per-draw allocations
+                        HostDynAlloc allocation = allocator.Allocate(256 + (i & 3) * 256);
+                        failed += allocation.DataPtr == nullptr ? 1 : 0;
+                        *static_cast<uint32_t*>(allocation.DataPtr) = i;
+                    }
+                    failedCount.fetch_add(failed);
+                });
+            }
+            while (readyCount.load() != threadCount) {
+                std::this_thread::yield();
+            }
+
+            const test::Timer timer;
+            isStarted.store(true, std::memory_order_release);
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+            totalMs += timer.getElapsedMs();
+            peakBytes = std::max(peakBytes, HostLinearAllocator::GetStats(kCpuWritable).CurrentBytes);
+
+            // Retire this frame and let the GPU "finish" it, so later frames recycle through the magazines
+            const uint64_t fenceValue = fence.incrementFence(0);
+            for (std::unique_ptr<HostLinearAllocator>& allocator : allocators) {
+                allocator->CleanupUsedPages(fenceValue);
+            }
+            fence.complete(fenceValue);
+        }
+        CHECK_EQ(failedCount.load(), 0u);
+        return totalMs * 1.0e6 / (double(frameCount) * threadCount * allocationsPerThread);
+    }
+}
+
+// Contention on the lock-free Suballocate CAS (one shared allocator) and on page turnover through the
+// per-thread magazines (one allocator per thread), from 1 to 32 threads. The hardware thread count is printed
+// because scaling beyond it only measures oversubscription.
+BENCH(LinearAllocator_Contention)
+{
+    const uint32_t frameCount = test::isQuickRun() ? 2 : 20;
+    const uint32_t allocationsPerFrame = test::isQuickRun() ? 1u << 14 : 1u << 18;
+
+    std::printf("  hardware threads: %u, %u allocations per frame\n", std::thread::hardware_concurrency(), allocationsPerFrame);
+    std::printf("  %8s %16s %16s %14s\n", "threads", "shared ns/alloc", "per-thread ns", "peak MB");
+
+    for (const uint32_t threadCount : THREAD_COUNTS) {
+        const uint32_t allocationsPerThread = allocationsPerFrame / threadCount;
+
+        SimulatedFence fence;
+        uint64_t peakBytes = 0;
+        HostLinearAllocator::InitAll(HostMemoryBacking{}, SimulatedFencePolicy{ &fence });
+
+        std::vector<std::unique_ptr<HostLinearAllocator>> shared;
+        shared.emplace_back(new HostLinearAllocator{ kCpuWritable });
+        const double sharedNs = runFrames(fence, threadCount, frameCount, allocationsPerThread, shared,
+            [&](uint32_t) -> HostLinearAllocator& { return *shared[0]; }, peakBytes);
+
+        std::vector<std::unique_ptr<HostLinearAllocator>> perThread;
+        for (uint32_t t = 0; t < threadCount; t++) {
+            perThread.emplace_back(new HostLinearAllocator{ kCpuWritable });
+        }
+        const double perThreadNs = runFrames(fence, threadCount, frameCount, allocationsPerThread, perThread,
+            [&](uint32_t t) -> HostLinearAllocator& { return *perThread[t]; }, peakBytes);
+
+        // Every frame's pages come back, so the pool stays at roughly one frame's worth (plus each thread's
+        // magazine) no matter how many frames run. The manager's own PeakBytes survives DestroyAll and would
+        // include earlier runs, hence sampling CurrentBytes instead.
+        const uint64_t frameBytes = uint64_t(allocationsPerFrame) * 1024u;
+        CHECK(peakBytes <= 2 * frameBytes + uint64_t(threadCount + 1) * (kPageMagazineSize + 2) * kCpuAllocatorPageSize);
+
+        std::printf("  %8u %16.1f %16.1f %14.1f\n", threadCount, sharedNs, perThreadNs, double(peakBytes) / (1024.0 * 1024.0));
+        HostLinearAllocator::DestroyAll();
+    }
+}
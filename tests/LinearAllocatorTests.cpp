@@ -0,0 +1,242 @@
+#include "TestHarness.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#include "HostMemoryBacking.h"
+
+using namespace bdr;
+
+namespace
+{
+    // The page managers are static, so every test brings them up and tears them down around itself
+    struct HostAllocatorScope
+    {
+        explicit HostAllocatorScope(const SimulatedFence& fence)
+        {
+            HostLinearAllocator::InitAll(HostMemoryBacking{}, SimulatedFencePolicy{ &fence });
+        }
+
+        ~HostAllocatorScope()
+        {
+            HostLinearAllocator::DestroyAll();
+        }
+    };
+}
+
+TEST(LinearAllocator_AllocationsAreAlignedAndDisjoint)
+{
+    SimulatedFence fence;
+    HostAllocatorScope scope{ fence };
+    HostLinearAllocator allocator{ kCpuWritable };
+
+    std::vector<std::pair<uintptr_t, size_t>> ranges;
+    for (size_t i = 1; i <= 2000; i++) {
+        const size_t size = (i * 37) % 3000 + 1;
+        HostDynAlloc allocation = allocator.Allocate(size);
+        CHECK(allocation.DataPtr != nullptr);
+        CHECK(allocation.Size >= size);
+        CHECK(allocation.Offset % DEFAULT_ALIGN == 0);
+        CHECK(reinterpret_cast<uint64_t>(allocation.DataPtr) == allocation.GpuAddress);
+        CHECK(allocation.Offset + allocation.Size <= kCpuAllocatorPageSize);
+        std::memset(allocation.DataPtr, 0xCD, allocation.Size);
+        ranges.emplace_back(reinterpret_cast<uintptr_t>(allocation.DataPtr), allocation.Size);
+    }
+
+    std::sort(ranges.begin(), ranges.end());
+    for (size_t i = 1; i < ranges.size(); i++) {
+        CHECK(ranges[i - 1].first + ranges[i - 1].second <= ranges[i].first);
+    }
+
+    allocator.CleanupUsedPages(fence.incrementFence(0));
+}
+
+TEST(LinearAllocator_PagesRecycleOnlyAfterTheirFence)
+{
+    SimulatedFence fence;
+    HostAllocatorScope scope{ fence };
+    HostLinearAllocator allocator{ kCpuWritable };
+
+    // Fill a few pages and retire them behind a fence that hasn't completed
+    const size_t allocationSize = kCpuAllocatorPageSize / 4;
+    for (uint32_t i = 0; i < 16; i++) {
+        allocator.Allocate(allocationSize);
+    }
+    const uint64_t firstFence = fence.incrementFence(0);
+    allocator.CleanupUsedPages(firstFence);
+    const uint64_t bytesAfterFirstFrame = HostLinearAllocator::GetStats(kCpuWritable).CurrentBytes;
+    CHECK(bytesAfterFirstFrame >= 4 * kCpuAllocatorPageSize);
+
+    // Still in flight: the second frame can't reuse anything
+    for (uint32_t i = 0; i < 16; i++) {
+        allocator.Allocate(allocationSize);
+    }
+    allocator.CleanupUsedPages(fence.incrementFence(0));
+    const uint64_t bytesAfterSecondFrame = HostLinearAllocator::GetStats(kCpuWritable).CurrentBytes;
+    CHECK(bytesAfterSecondFrame >= 2 * bytesAfterFirstFrame);
+
+    // Once both fences pass, a third frame of the same size is served entirely from recycled pages
+    fence.completeAll(0);
+    for (uint32_t i = 0; i < 16; i++) {
+        allocator.Allocate(allocationSize);
+    }
+    allocator.CleanupUsedPages(fence.incrementFence(0));
+    CHECK_EQ(HostLinearAllocator::GetStats(kCpuWritable).CurrentBytes, bytesAfterSecondFrame);
+}
+
+TEST(LinearAllocator_LargeAllocationsReuseTheirHeap)
+{
+    SimulatedFence fence;
+    HostAllocatorScope scope{ fence };
+    HostLinearAllocator allocator{ kCpuWritable };
+
+    const size_t largeSize = 3 * kCpuAllocatorPageSize;
+    HostDynAlloc first = allocator.Allocate(largeSize);
+    CHECK(first.DataPtr != nullptr);
+    CHECK(first.Size >= largeSize);
+    std::memset(first.DataPtr, 0xAB, largeSize);
+    const uint64_t heapBytes = HostLinearAllocator::GetStats(kCpuWritable).CurrentBytes;
+    CHECK(heapBytes >= kLargeHeapSize);
+
+    const uint64_t fenceValue = fence.incrementFence(1);
+    allocator.CleanupUsedPages(fenceValue);
+    fence.complete(fenceValue);
+
+    // The freed range goes back to the same heap rather than a new one being created
+    for (uint32_t i = 0; i < 8; i++) {
+        HostDynAlloc allocation = allocator.Allocate(largeSize);
+        CHECK(allocation.DataPtr != nullptr);
+        const uint64_t loopFence = fence.incrementFence(1);
+        allocator.CleanupUsedPages(loopFence);
+        fence.complete(loopFence);
+    }
+    CHECK_EQ(HostLinearAllocator::GetStats(kCpuWritable).CurrentBytes, heapBytes);
+}
+
+TEST(LinearAllocator_TrimIdleReleasesUnusedMemory)
+{
+    SimulatedFence fence;
+    HostAllocatorScope scope{ fence };
+    HostLinearAllocator allocator{ kCpuWritable };
+
+    for (uint32_t i = 0; i < 8; i++) {
+        allocator.Allocate(kCpuAllocatorPageSize / 2);
+    }
+    allocator.Allocate(2 * kCpuAllocatorPageSize);
+    const uint64_t fenceValue = fence.incrementFence(0);
+    allocator.CleanupUsedPages(fenceValue);
+
+    // Nothing can go while its fence is pending
+    HostLinearAllocator::TrimIdleAll(0);
+    const LinearAllocatorStats busyStats = HostLinearAllocator::GetStats(kCpuWritable);
+    CHECK(busyStats.CurrentBytes > 0);
+
+    // The first trim after the fence sees the memory come free; it then has to sit idle for the full limit
+    fence.complete(fenceValue);
+    const uint32_t idleFrameLimit = 3;
+    for (uint32_t frame = 0; frame < idleFrameLimit; frame++) {
+        HostLinearAllocator::TrimIdleAll(idleFrameLimit);
+    }
+    CHECK_EQ(HostLinearAllocator::GetStats(kCpuWritable).CurrentBytes, busyStats.CurrentBytes);
+    HostLinearAllocator::TrimIdleAll(idleFrameLimit);
+
+    // Pages parked in this thread's magazine aren't seen by TrimIdle, so at most those remain
+    const LinearAllocatorStats idleStats = HostLinearAllocator::GetStats(kCpuWritable);
+    CHECK(idleStats.CurrentBytes <= uint64_t(kPageMagazineSize) * kCpuAllocatorPageSize);
+    CHECK(idleStats.TrimmedBytes - busyStats.TrimmedBytes >= kLargeHeapSize);
+    CHECK(idleStats.PeakBytes >= busyStats.CurrentBytes);
+}
+
+TEST(LinearAllocator_SharedAcrossThreads)
+{
+    SimulatedFence fence;
+    HostAllocatorScope scope{ fence };
+    HostLinearAllocator allocator{ kCpuWritable };
+
+    // Every thread stamps its allocations with its own byte; any overlap shows up as a foreign byte
+    const uint32_t threadCount = 4;
+    const uint32_t allocationCount = 5000;
+    const size_t allocationSize = 1000;
+    std::vector<std::vector<uint8_t*>> allocations(threadCount);
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t]() {
+            for (uint32_t i = 0; i < allocationCount; i++) {
+                uint8_t* pData = static_cast<uint8_t*>(allocator.Allocate(allocationSize).DataPtr);
+                std::memset(pData, int(t + 1), allocationSize);
+                allocations[t].push_back(pData);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    bool isIntact = true;
+    for (uint32_t t = 0; t < threadCount; t++) {
+        for (const uint8_t* pData : allocations[t]) {
+            isIntact &= pData[0] == t + 1 && pData[allocationSize - 1] == t + 1;
+        }
+    }
+    CHECK(isIntact);
+
+    allocator.CleanupUsedPages(fence.incrementFence(0));
+}
+
+TEST(LinearAllocator_SlowQueueDoesNotHoldBackFastOne)
+{
+    SimulatedFence fence;
+    HostAllocatorScope scope{ fence };
+    HostLinearAllocator graphics{ kCpuWritable };
+    HostLinearAllocator compute{ kCpuWritable };
+
+    // Graphics retires a handful of pages every frame and its fences complete a frame later. Compute only
+    // retires one page per frame but its fences lag far behind. With a single FIFO, every graphics page queued
+    // behind a compute page would wait for compute too and the pool would grow to about
+    // computeLag * graphicsPagesPerFrame pages.
+    const uint32_t frameCount = 200;
+    const uint32_t computeLag = 16;
+    const uint32_t graphicsPagesPerFrame = 8;
+    const uint32_t graphicsTimeline = 0;
+    const uint32_t computeTimeline = 2;
+
+    std::vector<uint64_t> computeFences;
+    uint64_t previousGraphicsFence = 0;
+    uint64_t peakBytes = 0;
+    for (uint32_t frame = 0; frame < frameCount; frame++) {
+        for (uint32_t i = 0; i < graphicsPagesPerFrame; i++) {
+            graphics.Allocate(kCpuAllocatorPageSize);
+        }
+        compute.Allocate(kCpuAllocatorPageSize / 2);
+
+        // Alternate which allocator retires first so the two timelines interleave in both orders
+        const uint64_t graphicsFence = fence.incrementFence(graphicsTimeline);
+        const uint64_t computeFence = fence.incrementFence(computeTimeline);
+        if (frame % 2 == 0) {
+            compute.CleanupUsedPages(computeFence);
+            graphics.CleanupUsedPages(graphicsFence);
+        }
+        else {
+            graphics.CleanupUsedPages(graphicsFence);
+            compute.CleanupUsedPages(computeFence);
+        }
+        computeFences.push_back(computeFence);
+
+        if (previousGraphicsFence != 0) {
+            fence.complete(previousGraphicsFence);
+        }
+        previousGraphicsFence = graphicsFence;
+        if (frame >= computeLag) {
+            fence.complete(computeFences[frame - computeLag]);
+        }
+        // Sampled here because the manager's PeakBytes also remembers the tests that ran before this one
+        peakBytes = std::max(peakBytes, HostLinearAllocator::GetStats(kCpuWritable).CurrentBytes);
+    }
+
+    // Two frames of graphics pages, the compute pages in flight and whatever sits in the magazine
+    const uint64_t expectedPages = 2 * (graphicsPagesPerFrame + 1) + computeLag + 1 + kPageMagazineSize;
+    const uint64_t fifoPages = uint64_t(computeLag) * graphicsPagesPerFrame;
+    const uint64_t peakPages = peakBytes / kCpuAllocatorPageSize;
+    CHECK(peakPages <= expectedPages);
+    CHECK(peakPages < fifoPages);
+}
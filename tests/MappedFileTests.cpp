@@ -0,0 +1,64 @@
+#include "TestHarness.h"
+#include <cstring>
+#include <utility>
+
+#include "MappedFile.h"
+
+using namespace bdr;
+
+TEST(MappedFile_MapsWholeFile)
+{
+    std::vector<uint8_t> contents(3 * 4096 + 123);
+    for (size_t i = 0; i < contents.size(); i++) {
+        contents[i] = uint8_t(i * 7 + 3);
+    }
+    const test::TempFile file{ "mapped.bin" };
+    CHECK(file.write(contents.data(), contents.size()));
+
+    for (const FileAccessHint hint : { FileAccessHint::Normal, FileAccessHint::Sequential, FileAccessHint::Random }) {
+        MappedFile mapped;
+        CHECK(mapped.open(file.getPath(), hint));
+        CHECK(mapped.isOpen());
+        CHECK_EQ(mapped.getSize(), uint64_t(contents.size()));
+        CHECK(mapped.getData() != nullptr && std::memcmp(mapped.getData(), contents.data(), contents.size()) == 0);
+
+        // Hints only: unaligned, clamped at the end, past the end, empty and huge ranges are all fine
+        mapped.prefetch(100, 5000);
+        mapped.prefetch(4096, UINT64_MAX);
+        mapped.prefetch(contents.size(), 10);
+        mapped.prefetch(0, 0);
+    }
+}
+
+TEST(MappedFile_EmptyAndMissingFiles)
+{
+    const test::TempFile empty{ "empty.bin" };
+    CHECK(empty.write(nullptr, 0));
+    MappedFile mapped;
+    CHECK(mapped.open(empty.getPath()));
+    CHECK(mapped.isOpen());
+    CHECK(mapped.getData() == nullptr);
+    CHECK_EQ(mapped.getSize(), 0u);
+
+    // A failed open closes the previous view
+    const test::TempFile missing{ "missing.bin" };
+    CHECK(!mapped.open(missing.getPath()));
+    CHECK(!mapped.isOpen());
+}
+
+TEST(MappedFile_MovesOwnership)
+{
+    const test::TempFile file{ "small.bin" };
+    CHECK(file.write("hello", 5));
+
+    MappedFile first;
+    CHECK(first.open(file.getPath(), FileAccessHint::Random));
+    MappedFile second{ std::move(first) };
+    CHECK(!first.isOpen() && first.getData() == nullptr);
+    CHECK(second.isOpen() && second.getSize() == 5 && std::memcmp(second.getData(), "hello", 5) == 0);
+
+    first = std::move(second);
+    CHECK(first.isOpen() && !second.isOpen());
+    first.close();
+    CHECK(!first.isOpen() && first.getData() == nullptr && first.getSize() == 0);
+}
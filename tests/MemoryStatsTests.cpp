@@ -0,0 +1,164 @@
+#include "TestHarness.h"
+#include <sstream>
+#include <thread>
+
+#include "Json.h"
+#include "MemoryStats.h"
+
+using namespace bdr;
+
+namespace
+{
+    using Clock = MemoryStatsRegistry::Clock;
+
+    const MemoryStatsRegistry::Snapshot* findSnapshot(const std::vector<MemoryStatsRegistry::Snapshot>& snapshots, const std::string& name)
+    {
+        for (const MemoryStatsRegistry::Snapshot& snapshot : snapshots) {
+            if (snapshot.name == name) {
+                return &snapshot;
+            }
+        }
+        return nullptr;
+    }
+}
+
+TEST(MemoryStats_TracksLiveTotalAndPeak)
+{
+    MemoryStatsRegistry registry;
+    MemoryStatsRegistry::Category* pPages = registry.getCategory("Pages");
+    CHECK(registry.getCategory("Pages") == pPages);
+    MemoryStatsRegistry::Category* pPools = registry.getCategory("Pools");
+    CHECK(pPools != pPages);
+
+    pPages->onAllocate(100);
+    pPages->onAllocate(200);
+    pPages->onFree(100);
+    pPages->onAllocate(50);
+    // Owners that can't size what they hold still count it
+    pPools->onAllocate(0, 5);
+    pPools->onFree(0, 2);
+
+    const std::vector<MemoryStatsRegistry::Snapshot> snapshots = registry.getSnapshots();
+    CHECK_EQ(snapshots.size(), size_t(2));
+    const MemoryStatsRegistry::Snapshot* pPageStats = findSnapshot(snapshots, "Pages");
+    const MemoryStatsRegistry::Snapshot* pPoolStats = findSnapshot(snapshots, "Pools");
+    CHECK(pPageStats != nullptr && pPoolStats != nullptr);
+    if (pPageStats == nullptr || pPoolStats == nullptr) {
+        return;
+    }
+    CHECK_EQ(pPageStats->liveBytes, 250u);
+    CHECK_EQ(pPageStats->peakBytes, 300u);
+    CHECK_EQ(pPageStats->liveAllocations, 2u);
+    CHECK_EQ(pPageStats->totalAllocations, 3u);
+    CHECK_EQ(pPoolStats->liveBytes, 0u);
+    CHECK_EQ(pPoolStats->liveAllocations, 3u);
+    CHECK_EQ(pPoolStats->totalAllocations, 5u);
+}
+
+// The peak is the largest live total any single allocation produced, even with threads racing to raise it
+TEST(MemoryStats_PeakUnderContention)
+{
+    MemoryStatsRegistry registry;
+    MemoryStatsRegistry::Category* pCategory = registry.getCategory("Contended");
+    const uint32_t threadCount = 4;
+    const uint32_t iterationCount = 20000;
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < threadCount; t++) {
+        threads.emplace_back([pCategory]() {
+            for (uint32_t i = 0; i < iterationCount; i++) {
+                pCategory->onAllocate(64);
+                pCategory->onFree(64);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    const MemoryStatsRegistry::Snapshot snapshot = registry.getSnapshots()[0];
+    CHECK_EQ(snapshot.liveBytes, 0u);
+    CHECK_EQ(snapshot.liveAllocations, 0u);
+    CHECK_EQ(snapshot.totalAllocations, uint64_t(threadCount) * iterationCount);
+    CHECK(snapshot.peakBytes >= 64 && snapshot.peakBytes <= 64 * threadCount);
+}
+
+// Per-frame counts roll on every endFrame; the per-second rate only once a window of at least a second has
+// passed, over everything allocated in that window
+TEST(MemoryStats_FrameAndSecondRollups)
+{
+    MemoryStatsRegistry registry;
+    MemoryStatsRegistry::Category* pCategory = registry.getCategory("Frames");
+    const Clock::time_point start{};
+
+    pCategory->onAllocate(16, 3);
+    registry.endFrame(start);
+    CHECK_EQ(registry.getFrameCount(), 1u);
+    CHECK_EQ(registry.getSnapshots()[0].allocationsLastFrame, 3u);
+    CHECK(registry.getSnapshots()[0].allocationsPerSecond == 0.0);
+
+    pCategory->onAllocate(16, 2);
+    registry.endFrame(start + std::chrono::milliseconds(500));
+    CHECK_EQ(registry.getSnapshots()[0].allocationsLastFrame, 2u);
+    CHECK(registry.getSnapshots()[0].allocationsPerSecond == 0.0);
+
+    pCategory->onAllocate(16, 5);
+    registry.endFrame(start + std::chrono::milliseconds(1250));
+    CHECK_EQ(registry.getSnapshots()[0].allocationsLastFrame, 5u);
+    CHECK(registry.getSnapshots()[0].allocationsPerSecond == 10.0 / 1.25);
+
+    // A frame without allocations reads 0 for the frame, and the rate holds until the next window closes
+    registry.endFrame(start + std::chrono::milliseconds(1500));
+    CHECK_EQ(registry.getSnapshots()[0].allocationsLastFrame, 0u);
+    CHECK(registry.getSnapshots()[0].allocationsPerSecond == 8.0);
+
+    pCategory->onAllocate(16, 4);
+    registry.endFrame(start + std::chrono::milliseconds(3250));
+    CHECK(registry.getSnapshots()[0].allocationsPerSecond == 2.0);
+    CHECK_EQ(registry.getFrameCount(), 5u);
+}
+
+// The dump is valid JSON with one object per category, names escaped
+TEST(MemoryStats_WriteJsonParses)
+{
+    MemoryStatsRegistry registry;
+    {
+        std::ostringstream out;
+        registry.writeJson(out);
+        JsonValue document;
+        const std::string text = out.str();
+        CHECK(parseJson(text.data(), text.size(), document));
+        CHECK_EQ(document["frames"].getUint(99), 0u);
+        CHECK(document["categories"].isArray() && document["categories"].getSize() == 0);
+    }
+
+    const std::string awkwardName = "Quote\" back\\slash\ttab";
+    registry.getCategory("Plain")->onAllocate(4096, 2);
+    registry.getCategory(awkwardName)->onAllocate(100);
+    registry.endFrame(Clock::time_point{});
+    registry.getCategory("Plain")->onFree(2048);
+    registry.getCategory("Plain")->onAllocate(1024);
+    registry.endFrame(Clock::time_point{} + std::chrono::seconds(2));
+
+    std::ostringstream out;
+    registry.writeJson(out);
+    const std::string text = out.str();
+    JsonValue document;
+    std::string error;
+    CHECK(parseJson(text.data(), text.size(), document, &error));
+    CHECK(error.empty());
+    CHECK_EQ(document["frames"].getUint(), 2u);
+
+    const JsonValue& categories = document["categories"];
+    CHECK_EQ(categories.getSize(), size_t(2));
+    const JsonValue& plain = categories[0];
+    CHECK(plain["name"].getString() == "Plain");
+    CHECK_EQ(plain["liveBytes"].getUint64(), 3072u);
+    CHECK_EQ(plain["peakBytes"].getUint64(), 4096u);
+    CHECK_EQ(plain["liveAllocations"].getUint64(), 2u);
+    CHECK_EQ(plain["totalAllocations"].getUint64(), 3u);
+    CHECK_EQ(plain["allocationsLastFrame"].getUint64(), 1u);
+    CHECK(plain["allocationsPerSecond"].getNumber() == 1.5);
+    CHECK(categories[1]["name"].getString() == awkwardName);
+    CHECK_EQ(categories[1]["liveBytes"].getUint64(), 100u);
+}
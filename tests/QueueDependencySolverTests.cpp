@@ -0,0 +1,257 @@
+#include "TestHarness.h"
+#include <algorithm>
+
+#include "QueueDependencySolver.h"
+
+using namespace bdr;
+
+namespace
+{
+    constexpr uint32_t GRAPHICS = 0;
+    constexpr uint32_t COMPUTE = 1;
+    constexpr uint32_t COPY = 2;
+
+    // Hands out fence values per timeline and plays the GPU's completed values
+    struct Queues
+    {
+        QueueDependencySolver solver;
+        uint64_t nextValues[MAX_FENCE_TIMELINES];
+        uint64_t completedValues[MAX_FENCE_TIMELINES];
+
+        Queues()
+        {
+            for (uint32_t i = 0; i < MAX_FENCE_TIMELINES; i++) {
+                nextValues[i] = getFenceTimelineBase(i) + 1;
+                completedValues[i] = getFenceTimelineBase(i);
+            }
+        }
+
+        std::vector<QueueDependencySolver::Wait> resolve(const uint32_t timeline, const std::vector<uint64_t>& dependencies)
+        {
+            QueueDependencySolver::Wait waits[MAX_FENCE_TIMELINES];
+            const uint32_t waitCount = solver.resolve(timeline, dependencies.data(), uint32_t(dependencies.size()),
+                [this](const uint32_t i) { return completedValues[i]; }, waits);
+            return std::vector<QueueDependencySolver::Wait>(waits, waits + waitCount);
+        }
+
+        uint64_t submit(const uint32_t timeline)
+        {
+            const uint64_t fenceValue = nextValues[timeline]++;
+            solver.recordSubmission(fenceValue);
+            return fenceValue;
+        }
+
+        // resolve followed by submit, for queues that don't care which waits went in
+        uint64_t submit(const uint32_t timeline, const std::vector<uint64_t>& dependencies)
+        {
+            resolve(timeline, dependencies);
+            return submit(timeline);
+        }
+    };
+
+    bool isWait(const std::vector<QueueDependencySolver::Wait>& waits, const size_t index, const uint32_t timeline, const uint64_t fenceValue)
+    {
+        return index < waits.size() && waits[index].timeline == timeline && waits[index].fenceValue == fenceValue;
+    }
+}
+
+TEST(QueueDependencySolver_DropsWhatTheQueueAlreadyWaitedOn)
+{
+    Queues queues;
+    const uint64_t upload = queues.submit(COPY);
+    const uint64_t graphics = queues.submit(GRAPHICS);
+
+    std::vector<QueueDependencySolver::Wait> waits = queues.resolve(COMPUTE, { upload, graphics });
+    CHECK_EQ(waits.size(), size_t(2));
+    CHECK(isWait(waits, 0, GRAPHICS, graphics));
+    CHECK(isWait(waits, 1, COPY, upload));
+    queues.submit(COMPUTE);
+
+    // The compute queue's clock covers both now, and anything older on the same timelines
+    CHECK(queues.resolve(COMPUTE, { upload, graphics }).empty());
+    CHECK(queues.resolve(COMPUTE, { upload - 1 }).empty());
+
+    // Dependencies on the queue's own timeline are ordered already
+    CHECK(queues.resolve(GRAPHICS, { graphics, queues.nextValues[GRAPHICS] - 1 }).empty());
+}
+
+// Waiting on a submission inherits everything that submission waited on
+TEST(QueueDependencySolver_TransitiveReduction)
+{
+    Queues queues;
+    const uint64_t upload = queues.submit(COPY);
+    const uint64_t compute = queues.submit(COMPUTE, { upload });
+
+    // Compute already waited for the upload, so graphics only needs to wait for compute
+    std::vector<QueueDependencySolver::Wait> waits = queues.resolve(GRAPHICS, { upload, compute });
+    CHECK_EQ(waits.size(), size_t(1));
+    CHECK(isWait(waits, 0, COMPUTE, compute));
+    queues.submit(GRAPHICS);
+    CHECK(queues.resolve(GRAPHICS, { upload }).empty());
+
+    // A later upload isn't covered by the compute submission's snapshot
+    const uint64_t laterUpload = queues.submit(COPY);
+    const uint64_t laterCompute = queues.submit(COMPUTE);
+    waits = queues.resolve(GRAPHICS, { laterUpload, laterCompute });
+    CHECK_EQ(waits.size(), size_t(2));
+    CHECK(isWait(waits, 0, COMPUTE, laterCompute));
+    CHECK(isWait(waits, 1, COPY, laterUpload));
+}
+
+TEST(QueueDependencySolver_OneWaitPerSourceQueue)
+{
+    Queues queues;
+    const uint64_t first = queues.submit(COPY);
+    const uint64_t second = queues.submit(COPY);
+    const uint64_t third = queues.submit(COPY);
+
+    const std::vector<QueueDependencySolver::Wait> waits = queues.resolve(GRAPHICS, { second, third, first, second });
+    CHECK_EQ(waits.size(), size_t(1));
+    CHECK(isWait(waits, 0, COPY, third));
+}
+
+TEST(QueueDependencySolver_DropsCompletedFences)
+{
+    Queues queues;
+    const uint64_t upload = queues.submit(COPY);
+    const uint64_t compute = queues.submit(COMPUTE);
+    queues.completedValues[COPY] = upload;
+
+    std::vector<QueueDependencySolver::Wait> waits = queues.resolve(GRAPHICS, { upload, compute });
+    CHECK_EQ(waits.size(), size_t(1));
+    CHECK(isWait(waits, 0, COMPUTE, compute));
+
+    // Stale completed values only cost a wait, never skip one
+    const uint64_t laterUpload = queues.submit(COPY);
+    waits = queues.resolve(GRAPHICS, { laterUpload });
+    CHECK(isWait(waits, 0, COPY, laterUpload));
+}
+
+TEST(QueueDependencySolver_PruneKeepsTheNewestCompletedSubmission)
+{
+    Queues queues;
+    uint64_t uploads[10];
+    for (uint64_t& upload : uploads) {
+        upload = queues.submit(COPY);
+    }
+    const uint64_t compute = queues.submit(COMPUTE, { uploads[9] });
+    CHECK_EQ(queues.solver.getRecordedSubmissionCount(COPY), size_t(10));
+
+    // Everything up to the seventh upload has completed; its submission stays as the lower bound
+    queues.completedValues[COPY] = uploads[6];
+    queues.solver.prune(uploads[6]);
+    CHECK_EQ(queues.solver.getRecordedSubmissionCount(COPY), size_t(4));
+    queues.solver.prune(uploads[6]);
+    CHECK_EQ(queues.solver.getRecordedSubmissionCount(COPY), size_t(4));
+
+    // Completed uploads are skipped, and the compute submission's snapshot still covers the later ones
+    std::vector<QueueDependencySolver::Wait> waits = queues.resolve(GRAPHICS, { uploads[3], uploads[8], compute });
+    CHECK_EQ(waits.size(), size_t(1));
+    CHECK(isWait(waits, 0, COMPUTE, compute));
+
+    // A submission that went around the solver falls back to the newest recorded one before it
+    queues.nextValues[COPY]++;
+    const uint64_t unrecorded = queues.nextValues[COPY] - 1;
+    waits = queues.resolve(COMPUTE, { unrecorded });
+    CHECK_EQ(waits.size(), size_t(1));
+    CHECK(isWait(waits, 0, COPY, unrecorded));
+}
+
+// Random submissions on three queues against a ground truth happens-before model. Every dependency must end
+// up satisfied (by a wait, transitively, or by having completed), and with every submission recorded no wait
+// may be redundant. Pruning as completed values move on must not change either.
+TEST(QueueDependencySolver_MatchesGroundTruth)
+{
+    using Clock = std::vector<uint64_t>;
+    const uint32_t timelineCount = 3;
+    const uint32_t submissionCount = 20000;
+
+    Queues queues;
+    // Per timeline, what each of its submissions happened after, itself included
+    std::vector<Clock> happenedAfter[timelineCount];
+    Clock queueClocks[timelineCount];
+    for (uint32_t t = 0; t < timelineCount; t++) {
+        queueClocks[t] = Clock(timelineCount);
+        for (uint32_t u = 0; u < timelineCount; u++) {
+            queueClocks[t][u] = getFenceTimelineBase(u);
+        }
+    }
+    auto getHappenedAfter = [&](const uint64_t fenceValue) -> const Clock& {
+        const uint32_t timeline = getFenceTimeline(fenceValue);
+        return happenedAfter[timeline][fenceValue - getFenceTimelineBase(timeline) - 1];
+    };
+
+    uint32_t seed = 7;
+    auto next = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return seed >> 8;
+    };
+
+    uint32_t unsatisfiedCount = 0;
+    uint32_t redundantCount = 0;
+    uint64_t waitCount = 0;
+    uint64_t dependencyCount = 0;
+    for (uint32_t i = 0; i < submissionCount; i++) {
+        const uint32_t timeline = next() % timelineCount;
+
+        std::vector<uint64_t> dependencies;
+        const uint32_t wanted = next() % 4;
+        for (uint32_t d = 0; d < wanted; d++) {
+            const uint32_t source = next() % timelineCount;
+            const uint64_t submitted = happenedAfter[source].size();
+            if (submitted == 0) {
+                continue;
+            }
+            const uint64_t back = std::min<uint64_t>(next() % 8, submitted - 1);
+            dependencies.push_back(getFenceTimelineBase(source) + submitted - back);
+        }
+        dependencyCount += dependencies.size();
+
+        // The GPU gets through some work now and then
+        const uint32_t completing = next() % timelineCount;
+        if (next() % 4 == 0 && queues.nextValues[completing] - 1 > queues.completedValues[completing]) {
+            queues.completedValues[completing] += 1 + next() % (queues.nextValues[completing] - 1 - queues.completedValues[completing]);
+        }
+
+        const std::vector<QueueDependencySolver::Wait> waits = queues.resolve(timeline, dependencies);
+        waitCount += waits.size();
+        Clock clock = queueClocks[timeline];
+        for (const QueueDependencySolver::Wait& wait : waits) {
+            if (wait.timeline == timeline || wait.fenceValue <= queues.completedValues[wait.timeline] || queueClocks[timeline][wait.timeline] >= wait.fenceValue) {
+                redundantCount++;
+            }
+            for (const QueueDependencySolver::Wait& other : waits) {
+                if (&other != &wait && getHappenedAfter(other.fenceValue)[wait.timeline] >= wait.fenceValue) {
+                    redundantCount++;
+                }
+            }
+            const Clock& inherited = getHappenedAfter(wait.fenceValue);
+            for (uint32_t u = 0; u < timelineCount; u++) {
+                clock[u] = std::max(clock[u], inherited[u]);
+            }
+        }
+
+        for (const uint64_t dependency : dependencies) {
+            const uint32_t source = getFenceTimeline(dependency);
+            if (source != timeline && dependency > queues.completedValues[source] && clock[source] < dependency) {
+                unsatisfiedCount++;
+            }
+        }
+
+        clock[timeline] = queues.submit(timeline);
+        happenedAfter[timeline].push_back(clock);
+        queueClocks[timeline] = clock;
+
+        if (i % 1000 == 999) {
+            for (uint32_t u = 0; u < timelineCount; u++) {
+                queues.solver.prune(queues.completedValues[u]);
+            }
+        }
+    }
+
+    CHECK_EQ(unsatisfiedCount, 0u);
+    CHECK_EQ(redundantCount, 0u);
+    // Far fewer waits than declared dependencies
+    CHECK(waitCount < dependencyCount / 2);
+    CHECK(queues.solver.getRecordedSubmissionCount(GRAPHICS) < submissionCount / timelineCount);
+}
@@ -0,0 +1,160 @@
+#include "TestHarness.h"
+#include <algorithm>
+#include <thread>
+
+#include "CommandStream.h"
+#include "SubmissionBatch.h"
+#include "ThreadPool.h"
+
+using namespace bdr;
+
+namespace
+{
+    // Same job split as Renderer::populateCommandLists
+    constexpr uint32_t MAX_DRAW_JOBS = 8u;
+    constexpr uint32_t MIN_DRAWS_PER_JOB = 64u;
+
+    // Stands in for ID3D12GraphicsCommandList: every call appends a few words, about what the runtime writes
+    struct HostCommandList
+    {
+        std::vector<uint64_t> words;
+
+        void append(const uint64_t a, const uint64_t b, const uint64_t c)
+        {
+            words.push_back(a);
+            words.push_back(b);
+            words.push_back(c);
+        }
+    };
+
+    // Same redundant state filtering as the renderer's CommandListTranslator
+    struct HostTranslator
+    {
+        HostCommandList* pCommandList;
+        uint32_t boundPipelineId = 0;
+        uint32_t boundMeshId = UINT32_MAX;
+        uint64_t boundConstants = 0;
+
+        void operator()(const SetPipelinePacket& packet)
+        {
+            if (packet.pipelineId != boundPipelineId) {
+                pCommandList->append(1, packet.pipelineId, 0);
+                boundPipelineId = packet.pipelineId;
+            }
+        }
+
+        void operator()(const SetMeshPacket& packet)
+        {
+            if (packet.meshId != boundMeshId) {
+                pCommandList->append(2, packet.meshId, 0);
+                pCommandList->append(3, packet.meshId, 0);
+                boundMeshId = packet.meshId;
+            }
+        }
+
+        void operator()(const SetConstantsPacket& packet)
+        {
+            if (packet.gpuAddress != boundConstants) {
+                pCommandList->append(4, packet.gpuAddress, 0);
+                boundConstants = packet.gpuAddress;
+            }
+        }
+
+        void operator()(const DrawIndexedPacket& packet)
+        {
+            pCommandList->append(5, packet.indexCount, uint64_t(packet.baseVertex));
+        }
+    };
+
+    void recordScene(CommandStream& stream, const uint32_t drawCount)
+    {
+        stream.clear();
+        uint32_t seed = 2024;
+        for (uint32_t draw = 0; draw < drawCount; draw++) {
+            seed = seed * 1664525u + 1013904223u;
+            const uint32_t pipelineId = 1 + (seed >> 8) % 4;
+            const uint32_t meshId = (seed >> 12) % 64;
+            stream.beginCommand(SortKey::make(0, pipelineId, meshId, float(seed >> 16) / 65536.0f));
+            stream.push(SetPipelinePacket{ SetPipelinePacket::TYPE, pipelineId });
+            stream.push(SetMeshPacket{ SetMeshPacket::TYPE, meshId });
+            SetConstantsPacket constants;
+            constants.gpuAddress = 0x10000ull + uint64_t(draw) * 256ull;
+            stream.push(constants);
+            DrawIndexedPacket drawPacket;
+            drawPacket.indexCount = 36;
+            drawPacket.baseVertex = int32_t(draw);
+            stream.push(drawPacket);
+            stream.endCommand();
+        }
+        stream.sort();
+    }
+}
+
+// Recording time for a frame against draw count and recording thread count, split into jobs the way
+// Renderer::populateCommandLists does and submitted through a SubmissionBatch. The lists, concatenated in
+// submission order, are checked against recording the whole frame on one thread.
+BENCH(Recording_DrawsAgainstThreads)
+{
+    const uint32_t drawCounts[] = { 1000, 10000, 100000 };
+    const uint32_t threadCounts[] = { 1, 2, 4, 8 };
+    const uint32_t frameCount = test::isQuickRun() ? 2 : 50;
+
+    CommandStream stream;
+    // Speedups are capped by the cores the machine actually has
+    std::printf("  %u hardware threads\n", std::thread::hardware_concurrency());
+    std::printf("  %8s %8s %12s %10s\n", "draws", "threads", "ms/frame", "speedup");
+    for (const uint32_t drawCount : drawCounts) {
+        recordScene(stream, drawCount);
+        const uint32_t drawJobCount = std::max(1u, std::min(MAX_DRAW_JOBS, (drawCount + MIN_DRAWS_PER_JOB - 1u) / MIN_DRAWS_PER_JOB));
+
+        // Reference: every draw into one list, with the per-list state reset at each job boundary
+        HostCommandList reference;
+        for (uint32_t job = 0; job < drawJobCount; job++) {
+            const uint32_t firstDraw = uint32_t(uint64_t(drawCount) * job / drawJobCount);
+            const uint32_t endDraw = uint32_t(uint64_t(drawCount) * (job + 1u) / drawJobCount);
+            stream.translate(firstDraw, endDraw - firstDraw, HostTranslator{ &reference });
+        }
+
+        double singleThreadMs = 0.0;
+        for (const uint32_t threadCount : threadCounts) {
+            // The calling thread records too
+            ThreadPool pool{ threadCount - 1u };
+            std::vector<HostCommandList> lists(drawJobCount);
+            SubmissionBatchT<HostCommandList> batch;
+            std::vector<HostCommandList*> submittedLists;
+            double totalMs = 0.0;
+
+            for (uint32_t frame = 0; frame < frameCount; frame++) {
+                const test::Timer timer;
+                std::vector<uint32_t> slots(drawJobCount);
+                for (uint32_t job = 0; job < drawJobCount; job++) {
+                    slots[job] = batch.reserve();
+                }
+                pool.parallelFor(drawJobCount, [&](const uint32_t job) {
+                    const uint32_t firstDraw = uint32_t(uint64_t(drawCount) * job / drawJobCount);
+                    const uint32_t endDraw = uint32_t(uint64_t(drawCount) * (job + 1u) / drawJobCount);
+                    HostCommandList& list = lists[job];
+                    list.words.clear();
+                    stream.translate(firstDraw, endDraw - firstDraw, HostTranslator{ &list });
+                    batch.set(slots[job], &list);
+                });
+                batch.flush([&](HostCommandList* const* ppLists, const uint32_t count) {
+                    submittedLists.assign(ppLists, ppLists + count);
+                });
+                totalMs += timer.getElapsedMs();
+            }
+
+            std::vector<uint64_t> submitted;
+            for (const HostCommandList* pList : submittedLists) {
+                submitted.insert(submitted.end(), pList->words.begin(), pList->words.end());
+            }
+            CHECK(submitted == reference.words);
+
+            const double msPerFrame = totalMs / frameCount;
+            if (threadCount == 1) {
+                singleThreadMs = msPerFrame;
+            }
+            std::printf("  %8u %8u %12.3f %10.2f\n", drawCount, threadCount, msPerFrame, singleThreadMs / msPerFrame);
+        }
+    }
+}
@@ -0,0 +1,93 @@
+#include "TestHarness.h"
+#include <cstring>
+#include <new>
+
+#include "StreamingWriter.h"
+
+using namespace bdr;
+
+namespace
+{
+    constexpr size_t DEST_ALIGNMENT = 4096;
+
+    struct AlignedBuffer
+    {
+        explicit AlignedBuffer(const size_t size) :
+            pData{ static_cast<uint8_t*>(::operator new(size, std::align_val_t{ DEST_ALIGNMENT })) },
+            size{ size }
+        {
+            // Fault the pages in up front so neither side pays for it
+            std::memset(pData, 0, size);
+        }
+
+        ~AlignedBuffer()
+        {
+            ::operator delete(pData, std::align_val_t{ DEST_ALIGNMENT });
+        }
+
+        uint8_t* pData;
+        size_t size;
+    };
+
+    // Streams `elementCount` elements of `elementSize` bytes from a small source pool, one write per element
+    template <typename Write>
+    double timeWrites(const uint32_t repeatCount, Write write)
+    {
+        double bestMs = 1.0e30;
+        for (uint32_t repeat = 0; repeat < repeatCount; repeat++) {
+            const test::Timer timer;
+            write();
+            const double ms = timer.getElapsedMs();
+            bestMs = ms < bestMs ? ms : bestMs;
+        }
+        return bestMs;
+    }
+}
+
+// StreamingWriter against plain memcpy for the element sizes we upload: 12 byte positions, 16 byte vertices,
+// 256 byte constants and whole 64 KB blocks. The host has no write-combined memory, so this only shows the
+// cost of the staging line and non-temporal stores on cached memory; on an UPLOAD heap memcpy's partial-line
+// writes are what get slow. Both outputs are compared byte for byte.
+BENCH(StreamingWriter_AgainstMemcpy)
+{
+    const size_t destSize = test::isQuickRun() ? 4u << 20 : 64u << 20;
+    const uint32_t repeatCount = test::isQuickRun() ? 1 : 5;
+    const size_t elementSizes[] = { 12, 16, 256, 64 * 1024 };
+
+    AlignedBuffer source{ 128 * 1024 };
+    for (size_t i = 0; i < source.size; i++) {
+        source.pData[i] = uint8_t(i * 131 + 17);
+    }
+    AlignedBuffer memcpyDest{ destSize };
+    AlignedBuffer streamedDest{ destSize };
+
+    std::printf("  %10s %12s %12s %14s\n", "element", "memcpy GB/s", "writer GB/s", "writer/memcpy");
+    for (const size_t elementSize : elementSizes) {
+        const size_t elementCount = destSize / elementSize;
+        const size_t bytes = elementCount * elementSize;
+        // Cycle through the source so the copies aren't all of the same cached bytes
+        const size_t sourceSpan = source.size - elementSize;
+
+        const double memcpyMs = timeWrites(repeatCount, [&]() {
+            uint8_t* pDest = memcpyDest.pData;
+            for (size_t i = 0; i < elementCount; i++) {
+                std::memcpy(pDest, source.pData + (i * elementSize) % sourceSpan, elementSize);
+                pDest += elementSize;
+            }
+            test::doNotOptimize(pDest);
+        });
+
+        const double writerMs = timeWrites(repeatCount, [&]() {
+            StreamingWriter writer{ streamedDest.pData, bytes };
+            for (size_t i = 0; i < elementCount; i++) {
+                writer.write(source.pData + (i * elementSize) % sourceSpan, elementSize);
+            }
+        });
+
+        CHECK(std::memcmp(memcpyDest.pData, streamedDest.pData, bytes) == 0);
+
+        const double gigabytes = double(bytes) / (1024.0 * 1024.0 * 1024.0);
+        std::printf("  %10zu %12.2f %12.2f %14.2f\n", elementSize, gigabytes / (memcpyMs / 1000.0),
+            gigabytes / (writerMs / 1000.0), memcpyMs / writerMs);
+    }
+}
@@ -0,0 +1,63 @@
+#include "TestHarness.h"
+#include <cstring>
+
+#include "StreamingWriter.h"
+
+using namespace bdr;
+
+namespace
+{
+    uint32_t nextRandom(uint32_t& state)
+    {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+}
+
+// Random mixes of small and bulk writes, forward seeks and early flushes at every destination alignment,
+// checked against the same writes done with memcpy. Bytes the writer was never asked to touch must survive.
+TEST(StreamingWriter_MatchesMemcpy)
+{
+    uint32_t seed = 1;
+    bool isMatching = true;
+    for (uint32_t iteration = 0; iteration < 5000; iteration++) {
+        const size_t capacity = 1 + nextRandom(seed) % 12000;
+        const size_t destOffset = nextRandom(seed) % 64;
+        std::vector<uint8_t> source(capacity + 64);
+        for (uint8_t& value : source) {
+            value = uint8_t(nextRandom(seed));
+        }
+
+        alignas(64) static uint8_t s_dest[12000 + 128];
+        alignas(64) static uint8_t s_expected[12000 + 128];
+        std::memset(s_dest, 0xAA, sizeof(s_dest));
+        std::memset(s_expected, 0xAA, sizeof(s_expected));
+
+        {
+            StreamingWriter writer{ s_dest + destOffset, capacity };
+            size_t position = 0;
+            while (position < capacity) {
+                const uint32_t choice = nextRandom(seed) % 20;
+                if (choice == 0) {
+                    const size_t skip = std::min<size_t>(capacity - position, nextRandom(seed) % 20);
+                    writer.seek(position + skip);
+                    position += skip;
+                    continue;
+                }
+                if (choice == 1) {
+                    writer.flush();
+                }
+
+                const size_t maxSize = choice < 5 ? 6000 : 40;
+                const size_t size = std::min<size_t>(capacity - position, nextRandom(seed) % maxSize);
+                const size_t sourceOffset = nextRandom(seed) % 32;
+                writer.write(source.data() + sourceOffset, size);
+                std::memcpy(s_expected + destOffset + position, source.data() + sourceOffset, size);
+                position += size;
+                isMatching &= writer.getOffset() == position;
+            }
+        }
+        isMatching &= std::memcmp(s_dest, s_expected, sizeof(s_dest)) == 0;
+    }
+    CHECK(isMatching);
+}
@@ -0,0 +1,176 @@
+#include "TestHarness.h"
+#include <algorithm>
+
+#include "TLSFAllocator.h"
+
+using namespace bdr;
+
+namespace
+{
+    void checkClass(const uint64_t size, const uint32_t expectedFl, const uint32_t expectedSl)
+    {
+        uint32_t fl, sl;
+        TLSFAllocator::mapping(size, fl, sl);
+        CHECK_EQ(fl, expectedFl);
+        CHECK_EQ(sl, expectedSl);
+    }
+}
+
+// Sizes below SL_COUNT map linearly into the first level; from there every power of two starts a new first
+// level, split into SL_COUNT equal second-level classes
+TEST(TLSFAllocator_SizeClassBoundaries)
+{
+    checkClass(0, 0, 0);
+    checkClass(15, 0, 15);
+    checkClass(16, 1, 0);
+    checkClass(31, 1, 15);
+    checkClass(32, 2, 0);
+    checkClass(33, 2, 0);
+    checkClass(34, 2, 1);
+    checkClass(63, 2, 15);
+    checkClass(64, 3, 0);
+    checkClass(4096, 9, 0);
+    checkClass(4096 + 255, 9, 0);
+    checkClass(4096 + 256, 9, 1);
+    checkClass(8191, 9, 15);
+    checkClass(uint64_t(1) << 63, TLSFAllocator::FL_COUNT - 1, 0);
+    checkClass(UINT64_MAX, TLSFAllocator::FL_COUNT - 1, TLSFAllocator::SL_COUNT - 1);
+}
+
+TEST(TLSFAllocator_AlignedAllocations)
+{
+    TLSFAllocator allocator{ 1024 * 1024, 256 };
+
+    // Sizes round up to the granularity
+    const TLSFAllocator::Allocation small = allocator.allocate(100);
+    CHECK(small.isValid());
+    CHECK_EQ(small.offset, 0u);
+    CHECK_EQ(small.size, 256u);
+
+    // The padding in front of an aligned block goes back on the free lists and can be handed out again
+    const TLSFAllocator::Allocation aligned = allocator.allocate(1000, 64 * 1024);
+    CHECK(aligned.isValid());
+    CHECK_EQ(aligned.offset, 64u * 1024u);
+    CHECK_EQ(aligned.size, 1024u);
+    CHECK_EQ(allocator.getStats().freeBlockCount, 2u);
+
+    const TLSFAllocator::Allocation filler = allocator.allocate(512);
+    CHECK(filler.isValid());
+    CHECK(filler.offset >= 256 && filler.offset + filler.size <= 64 * 1024);
+
+    // Alignments below the granularity are the granularity
+    const TLSFAllocator::Allocation loose = allocator.allocate(10, 16);
+    CHECK_EQ(loose.offset % 256, 0u);
+}
+
+TEST(TLSFAllocator_SplitsAndCoalesces)
+{
+    const uint64_t size = 64 * 1024;
+    TLSFAllocator allocator{ size, 256 };
+    const TLSFAllocator::Allocation a = allocator.allocate(4096);
+    const TLSFAllocator::Allocation b = allocator.allocate(4096);
+    const TLSFAllocator::Allocation c = allocator.allocate(4096);
+    CHECK(a.offset == 0 && b.offset == 4096 && c.offset == 8192);
+    CHECK_EQ(allocator.getStats().freeBlockCount, 1u);
+
+    // A hole between two allocations stays separate from the tail
+    allocator.free(b);
+    TLSFAllocator::Stats stats = allocator.getStats();
+    CHECK_EQ(stats.freeBlockCount, 2u);
+    CHECK_EQ(stats.largestFreeBlock, size - 3 * 4096);
+
+    // Freeing its neighbour merges the two, and the merged block takes an allocation of both sizes
+    allocator.free(a);
+    stats = allocator.getStats();
+    CHECK_EQ(stats.freeBlockCount, 2u);
+    const TLSFAllocator::Allocation ab = allocator.allocate(8192);
+    CHECK_EQ(ab.offset, 0u);
+
+    // Freeing everything leaves one block covering the whole range
+    allocator.free(ab);
+    allocator.free(c);
+    stats = allocator.getStats();
+    CHECK(allocator.isEmpty());
+    CHECK_EQ(stats.freeBlockCount, 1u);
+    CHECK_EQ(stats.largestFreeBlock, size);
+    CHECK_EQ(allocator.allocate(size).offset, 0u);
+}
+
+TEST(TLSFAllocator_ExhaustionAndStats)
+{
+    const uint64_t size = 64 * 1024;
+    TLSFAllocator allocator{ size, 256 };
+    CHECK(!allocator.allocate(size + 1).isValid());
+
+    const TLSFAllocator::Allocation whole = allocator.allocate(size);
+    CHECK(whole.isValid());
+    CHECK(!allocator.allocate(256).isValid());
+    CHECK_EQ(allocator.getStats().getFragmentation(), 0.0f);
+    allocator.free(whole);
+
+    // Sixteen 4 KB blocks with every other one freed: half the space is free but no 8 KB block fits
+    std::vector<TLSFAllocator::Allocation> blocks;
+    for (uint32_t i = 0; i < 16; i++) {
+        blocks.push_back(allocator.allocate(4096));
+    }
+    for (uint32_t i = 0; i < 16; i += 2) {
+        allocator.free(blocks[i]);
+    }
+    const TLSFAllocator::Stats stats = allocator.getStats();
+    CHECK_EQ(stats.totalSize, size);
+    CHECK_EQ(stats.usedSize, size / 2);
+    CHECK_EQ(stats.freeSize, size / 2);
+    CHECK_EQ(stats.allocationCount, 8u);
+    CHECK_EQ(stats.freeBlockCount, 8u);
+    CHECK_EQ(stats.largestFreeBlock, 4096u);
+    CHECK(stats.getFragmentation() == 1.0f - 4096.0f / 32768.0f);
+    CHECK(!allocator.allocate(8192).isValid());
+    CHECK(allocator.allocate(4096).isValid());
+
+    // The size is trimmed to the granularity
+    CHECK_EQ(TLSFAllocator(1000, 256).getSize(), 768u);
+}
+
+// Random allocations and frees never overlap, stay aligned, and coalesce back to a single block
+TEST(TLSFAllocator_RandomSoak)
+{
+    const uint64_t size = 16 * 1024 * 1024;
+    TLSFAllocator allocator{ size, 256 };
+    std::vector<TLSFAllocator::Allocation> live;
+    uint32_t seed = 12345;
+    bool isConsistent = true;
+    for (uint32_t i = 0; i < 20000; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        if (!live.empty() && (seed >> 28) < 7) {
+            const size_t index = (seed >> 8) % live.size();
+            allocator.free(live[index]);
+            live[index] = live.back();
+            live.pop_back();
+            continue;
+        }
+        const uint64_t alignment = uint64_t(256) << ((seed >> 4) % 6);
+        const TLSFAllocator::Allocation allocation = allocator.allocate(1 + (seed >> 12) % 200000, alignment);
+        if (allocation.isValid()) {
+            isConsistent &= allocation.offset % alignment == 0 && allocation.offset + allocation.size <= size;
+            live.push_back(allocation);
+        }
+    }
+
+    std::vector<TLSFAllocator::Allocation> sorted = live;
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.offset < b.offset; });
+    uint64_t usedSize = 0;
+    for (size_t i = 0; i < sorted.size(); i++) {
+        isConsistent &= i == 0 || sorted[i - 1].offset + sorted[i - 1].size <= sorted[i].offset;
+        usedSize += sorted[i].size;
+    }
+    CHECK(isConsistent);
+    CHECK_EQ(allocator.getUsedSize(), usedSize);
+
+    for (const TLSFAllocator::Allocation& allocation : live) {
+        allocator.free(allocation);
+    }
+    const TLSFAllocator::Stats stats = allocator.getStats();
+    CHECK(allocator.isEmpty());
+    CHECK_EQ(stats.freeBlockCount, 1u);
+    CHECK_EQ(stats.largestFreeBlock, size);
+}
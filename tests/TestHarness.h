@@ -0,0 +1,124 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+// A minimal registry shared by the host test and benchmark executables. TEST bodies report failures with
+// CHECK, which logs and carries on so one run shows every broken expectation. BENCH bodies time themselves
+// and print a line per measurement; they should still CHECK their results so a broken fast path can't pass
+// as a fast one.
+namespace bdr::test
+{
+    using TestFunction = void (*)();
+
+    struct TestCase
+    {
+        const char* name;
+        TestFunction function;
+    };
+
+    std::vector<TestCase>& getTestCases();
+
+    void reportFailure(const char* file, const int line, const char* expression);
+
+    // Benchmarks started with --quick (as ctest does) should cut their iteration counts right down
+    bool isQuickRun();
+
+    struct TestRegistrar
+    {
+        TestRegistrar(const char* name, const TestFunction function)
+        {
+            getTestCases().push_back(TestCase{ name, function });
+        }
+    };
+
+    class Timer
+    {
+    public:
+        Timer() : m_start{ std::chrono::steady_clock::now() }
+        { }
+
+        double getElapsedMs() const
+        {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    // A file in the temp directory, unique to this process, deleted again when it goes out of scope. Tests
+    // generate their inputs into these rather than relying on files lying around.
+    class TempFile
+    {
+    public:
+        explicit TempFile(const std::string& name) :
+            m_path{ std::filesystem::temp_directory_path() / ("bdr_test_" + std::to_string(getProcessId()) + "_" + name) }
+        { }
+
+        ~TempFile()
+        {
+            std::error_code error;
+            std::filesystem::remove(m_path, error);
+        }
+
+        TempFile(const TempFile&) = delete;
+        TempFile& operator=(const TempFile&) = delete;
+
+        // Returns false if the file couldn't be written
+        bool write(const void* pData, const size_t size) const
+        {
+            std::FILE* pFile = std::fopen(m_path.string().c_str(), "wb");
+            if (pFile == nullptr) {
+                return false;
+            }
+            const bool isWritten = size == 0 || std::fwrite(pData, 1, size, pFile) == size;
+            return std::fclose(pFile) == 0 && isWritten;
+        }
+
+        inline const std::filesystem::path& getPath() const
+        {
+            return m_path;
+        }
+
+    private:
+        static uint64_t getProcessId();
+
+        std::filesystem::path m_path;
+    };
+
+    // Keeps the optimizer from discarding a value a benchmark computes but never uses
+    template <typename T>
+    inline void doNotOptimize(const T& value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const T* s_pSink;
+        s_pSink = &value;
+#endif
+    }
+}
+
+#define BDR_TEST_CONCAT_INNER(a, b) a##b
+#define BDR_TEST_CONCAT(a, b) BDR_TEST_CONCAT_INNER(a, b)
+
+#define TEST(name) \
+    static void name(); \
+    static const bdr::test::TestRegistrar BDR_TEST_CONCAT(s_registrar_, name){ #name, name }; \
+    static void name()
+
+#define BENCH(name) TEST(name)
+
+#define CHECK(expression) \
+    do { \
+        if (!(expression)) { \
+            bdr::test::reportFailure(__FILE__, __LINE__, #expression); \
+        } \
+    } while (false)
+
+#define CHECK_EQ(a, b) CHECK((a) == (b))
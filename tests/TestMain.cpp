@@ -0,0 +1,80 @@
+#include "TestHarness.h"
+#include <cstring>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace bdr::test
+{
+    namespace
+    {
+        uint32_t s_failureCount = 0;
+        bool s_isQuickRun = false;
+    }
+
+    std::vector<TestCase>& getTestCases()
+    {
+        static std::vector<TestCase> s_testCases;
+        return s_testCases;
+    }
+
+    void reportFailure(const char* file, const int line, const char* expression)
+    {
+        std::fprintf(stderr, "%s(%d): CHECK failed: %s\n", file, line, expression);
+        s_failureCount++;
+    }
+
+    bool isQuickRun()
+    {
+        return s_isQuickRun;
+    }
+
+    uint64_t TempFile::getProcessId()
+    {
+    #ifdef _WIN32
+        return uint64_t(_getpid());
+    #else
+        return uint64_t(getpid());
+    #endif
+    }
+}
+
+// Usage: <executable> [--quick] [name filter]. The filter is a substring of the test names to run.
+int main(int argc, char** argv)
+{
+    using namespace bdr::test;
+
+    const char* pFilter = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--quick") == 0) {
+            s_isQuickRun = true;
+        }
+        else {
+            pFilter = argv[i];
+        }
+    }
+
+    uint32_t runCount = 0;
+    uint32_t failedCount = 0;
+    for (const TestCase& testCase : getTestCases()) {
+        if (pFilter != nullptr && std::strstr(testCase.name, pFilter) == nullptr) {
+            continue;
+        }
+
+        std::printf("[ RUN  ] %s\n", testCase.name);
+        std::fflush(stdout);
+        const uint32_t failuresBefore = s_failureCount;
+        const Timer timer;
+        testCase.function();
+        const bool hasPassed = s_failureCount == failuresBefore;
+        std::printf("[ %s ] %s (%.1f ms)\n", hasPassed ? " OK " : "FAIL", testCase.name, timer.getElapsedMs());
+        runCount++;
+        failedCount += hasPassed ? 0 : 1;
+    }
+
+    std::printf("%u run, %u failed\n", runCount, failedCount);
+    return failedCount == 0 && runCount > 0 ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+#include "TestHarness.h"
+#include <cstring>
+#include <new>
+
+#include "TextureLayout.h"
+
+using namespace bdr;
+
+namespace
+{
+    constexpr size_t STAGING_ALIGNMENT = 64 * 1024;
+
+    struct StagingBuffer
+    {
+        explicit StagingBuffer(const size_t size) :
+            pData{ static_cast<uint8_t*>(::operator new(size, std::align_val_t{ STAGING_ALIGNMENT })) },
+            size{ size }
+        {
+            std::memset(pData, 0xcd, size);
+        }
+
+        ~StagingBuffer()
+        {
+            ::operator delete(pData, std::align_val_t{ STAGING_ALIGNMENT });
+        }
+
+        uint8_t* pData;
+        size_t size;
+    };
+}
+
+// The values GetCopyableFootprints reports for an RGBA8 100x100 texture with a full mip chain
+TEST(TextureLayout_FootprintsMatchCopyableFootprints)
+{
+    TextureLayoutDesc desc;
+    desc.width = 100;
+    desc.height = 100;
+    desc.mipCount = getFullMipCount(100, 100);
+    desc.format = TextureFormatInfo{ 4, 1, 1 };
+    CHECK_EQ(desc.mipCount, 7u);
+
+    SubresourceFootprint footprints[7];
+    const uint64_t totalSize = computeSubresourceFootprints(desc, 0, desc.mipCount, footprints);
+    const uint32_t rowPitches[] = { 512, 256, 256, 256, 256, 256, 256 };
+    const uint32_t rowCounts[] = { 100, 50, 25, 12, 6, 3, 1 };
+    for (uint32_t mip = 0; mip < 7; mip++) {
+        CHECK_EQ(footprints[mip].rowPitch, rowPitches[mip]);
+        CHECK_EQ(footprints[mip].rowCount, rowCounts[mip]);
+        CHECK_EQ(footprints[mip].offset % TEXTURE_PLACEMENT_ALIGNMENT, 0u);
+    }
+    CHECK_EQ(footprints[0].offset, 0u);
+    CHECK_EQ(footprints[1].offset, 51200u);
+    CHECK_EQ(footprints[2].offset, 64000u);
+    CHECK_EQ(footprints[3].offset, 70656u);
+    CHECK_EQ(footprints[4].offset, 73728u);
+    CHECK_EQ(totalSize, footprints[6].offset + footprints[6].getTotalBytes());
+
+    // Packing from a base offset keeps every subresource placement aligned
+    SubresourceFootprint offsetFootprints[7];
+    computeSubresourceFootprints(desc, 0, desc.mipCount, offsetFootprints, 1000);
+    CHECK_EQ(offsetFootprints[0].offset, 1024u);
+}
+
+TEST(TextureLayout_BlockCompressedArraysAndVolumes)
+{
+    // BC1: 4x4 blocks of 8 bytes, two array slices
+    TextureLayoutDesc bc1;
+    bc1.width = 64;
+    bc1.height = 64;
+    bc1.arraySize = 2;
+    bc1.mipCount = getFullMipCount(64, 64);
+    bc1.format = TextureFormatInfo{ 8, 4, 4 };
+    CHECK_EQ(bc1.mipCount, 7u);
+
+    SubresourceFootprint footprint = getSubresourceFootprint(bc1, 0);
+    CHECK(footprint.rowSizeInBytes == 128 && footprint.rowPitch == 256 && footprint.rowCount == 16 && footprint.width == 64);
+    // The 2x2 mip still takes a whole block
+    footprint = getSubresourceFootprint(bc1, 5);
+    CHECK(footprint.width == 4 && footprint.height == 4 && footprint.rowCount == 1 && footprint.rowSizeInBytes == 8);
+    // Mip 0 of the second slice
+    footprint = getSubresourceFootprint(bc1, 7);
+    CHECK(footprint.width == 64 && footprint.rowCount == 16);
+
+    // R32F volume: depth halves with every mip too
+    TextureLayoutDesc volume;
+    volume.width = 32;
+    volume.height = 16;
+    volume.depth = 8;
+    volume.mipCount = getFullMipCount(32, 16, 8);
+    volume.format = TextureFormatInfo{ 4, 1, 1 };
+    CHECK_EQ(volume.mipCount, 6u);
+    footprint = getSubresourceFootprint(volume, 1);
+    CHECK(footprint.depth == 4 && footprint.rowCount == 8 && footprint.rowPitch == 256);
+    CHECK_EQ(footprint.getTotalBytes(), uint64_t(256 * 8 * 4));
+    footprint = getSubresourceFootprint(volume, 5);
+    CHECK(footprint.depth == 1 && footprint.width == 1);
+}
+
+// Every slice and row lands at its pitch-aligned place, the padding is left alone, and a band of rows from the
+// middle of a slice (as streamed uploads do) is packed from the writer's position
+TEST(TextureLayout_WriteSubresourceRows)
+{
+    const uint32_t width = 1000;
+    const uint32_t height = 37;
+    const uint32_t depth = 3;
+    const size_t sourceRowPitch = width * 4;
+    std::vector<uint8_t> image(sourceRowPitch * height * depth);
+    for (size_t i = 0; i < image.size(); i++) {
+        image[i] = uint8_t((i * 2654435761u) >> 13);
+    }
+
+    TextureLayoutDesc desc;
+    desc.width = width;
+    desc.height = height;
+    desc.depth = depth;
+    desc.format = TextureFormatInfo{ 4, 1, 1 };
+    const SubresourceFootprint footprint = getSubresourceFootprint(desc, 0);
+    CHECK_EQ(footprint.rowPitch, 4096u);
+
+    const SubresourceData source{ image.data(), sourceRowPitch, sourceRowPitch * height };
+    StagingBuffer staging{ size_t(footprint.getTotalBytes()) };
+    {
+        StreamingWriter writer{ staging.pData, staging.size };
+        writeSubresourceRows(writer, footprint, source, 0, depth, 0, height);
+    }
+
+    bool isIntact = true;
+    for (uint32_t row = 0; row < depth * height; row++) {
+        const uint8_t* pStaged = staging.pData + size_t(row) * footprint.rowPitch;
+        isIntact &= std::memcmp(pStaged, image.data() + row * sourceRowPitch, sourceRowPitch) == 0;
+        for (size_t i = sourceRowPitch; i < footprint.rowPitch; i++) {
+            isIntact &= pStaged[i] == 0xcd;
+        }
+    }
+    CHECK(isIntact);
+
+    // Rows 10 to 19 of the middle slice
+    {
+        StreamingWriter writer{ staging.pData, staging.size };
+        writeSubresourceRows(writer, footprint, source, 1, 1, 10, 10);
+    }
+    for (uint32_t row = 0; row < 10; row++) {
+        const uint8_t* pExpected = image.data() + (height + 10 + row) * sourceRowPitch;
+        isIntact &= std::memcmp(staging.pData + size_t(row) * footprint.rowPitch, pExpected, sourceRowPitch) == 0;
+    }
+    CHECK(isIntact);
+}
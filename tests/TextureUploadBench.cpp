@@ -0,0 +1,79 @@
+#include "TestHarness.h"
+#include <cstring>
+#include <new>
+
+#include "TextureLayout.h"
+
+using namespace bdr;
+
+namespace
+{
+    constexpr size_t STAGING_ALIGNMENT = 64 * 1024;
+}
+
+// Copying an image into pitch-aligned staging with writeSubresourceRows against a memcpy per row, for a
+// tightly packed texture, one whose rows need padding and a wide float format. Both outputs are compared.
+BENCH(TextureUpload_RowCopies)
+{
+    struct Case
+    {
+        const char* name;
+        uint32_t width;
+        uint32_t height;
+        uint32_t bytesPerTexel;
+    };
+    const Case cases[] = {
+        { "4096^2 RGBA8", 4096, 4096, 4 },
+        { "1000^2 RGBA8", 1000, 1000, 4 },
+        { "2048^2 RGBA32F", 2048, 2048, 16 },
+    };
+    const uint32_t repeatCount = test::isQuickRun() ? 1 : 8;
+    const uint32_t sizeDivisor = test::isQuickRun() ? 4 : 1;
+
+    std::printf("  %-16s %14s %14s\n", "texture", "rows GB/s", "memcpy GB/s");
+    for (const Case& testCase : cases) {
+        TextureLayoutDesc desc;
+        desc.width = testCase.width / sizeDivisor;
+        desc.height = testCase.height / sizeDivisor;
+        desc.format = TextureFormatInfo{ testCase.bytesPerTexel, 1, 1 };
+        const SubresourceFootprint footprint = getSubresourceFootprint(desc, 0);
+
+        const size_t sourceRowPitch = size_t(desc.width) * testCase.bytesPerTexel;
+        std::vector<uint8_t> image(sourceRowPitch * desc.height);
+        for (size_t i = 0; i < image.size(); i++) {
+            image[i] = uint8_t(i * 131 + 7);
+        }
+        const SubresourceData source{ image.data(), sourceRowPitch, 0 };
+
+        const size_t stagingSize = size_t(footprint.getTotalBytes());
+        uint8_t* pRows = static_cast<uint8_t*>(::operator new(stagingSize, std::align_val_t{ STAGING_ALIGNMENT }));
+        uint8_t* pMemcpy = static_cast<uint8_t*>(::operator new(stagingSize, std::align_val_t{ STAGING_ALIGNMENT }));
+        std::memset(pRows, 0, stagingSize);
+        std::memset(pMemcpy, 0, stagingSize);
+
+        double rowsMs = 1.0e30;
+        double memcpyMs = 1.0e30;
+        for (uint32_t repeat = 0; repeat < repeatCount; repeat++) {
+            test::Timer timer;
+            {
+                StreamingWriter writer{ pRows, stagingSize };
+                writeSubresourceRows(writer, footprint, source, 0, 1, 0, footprint.rowCount);
+            }
+            rowsMs = std::min(rowsMs, timer.getElapsedMs());
+
+            timer = test::Timer{};
+            for (uint32_t row = 0; row < footprint.rowCount; row++) {
+                std::memcpy(pMemcpy + size_t(row) * footprint.rowPitch, image.data() + row * sourceRowPitch, footprint.rowSizeInBytes);
+            }
+            test::doNotOptimize(pMemcpy);
+            memcpyMs = std::min(memcpyMs, timer.getElapsedMs());
+        }
+        CHECK(std::memcmp(pRows, pMemcpy, stagingSize) == 0);
+
+        const double gigabytes = double(image.size()) / (1024.0 * 1024.0 * 1024.0);
+        std::printf("  %-16s %14.2f %14.2f\n", testCase.name, gigabytes / (rowsMs / 1000.0), gigabytes / (memcpyMs / 1000.0));
+
+        ::operator delete(pRows, std::align_val_t{ STAGING_ALIGNMENT });
+        ::operator delete(pMemcpy, std::align_val_t{ STAGING_ALIGNMENT });
+    }
+}
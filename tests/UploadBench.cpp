@@ -0,0 +1,106 @@
+#include "TestHarness.h"
+#include <cstring>
+#include <new>
+
+#include "BufferCopyList.h"
+#include "BufferSuballocator.h"
+#include "UploadRing.h"
+
+using namespace bdr;
+
+namespace
+{
+    // Same constants as GPUBufferManager, which needs a device so can't be used here directly
+    constexpr uint64_t UPLOAD_RING_SIZE = 32ull * 1024ull * 1024ull;
+    constexpr uint64_t UPLOAD_ALIGNMENT = BufferSuballocator::DEFAULT_GRANULARITY;
+    // D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT: what a committed UPLOAD resource of any size occupies
+    constexpr uint64_t COMMITTED_RESOURCE_ALIGNMENT = 64ull * 1024ull;
+
+    using CopyList = BufferCopyListT<std::vector<uint8_t>>;
+
+    // Stands in for the copy queue: "executes" the recorded copies from the ring into the simulated heaps
+    void executeCopies(const uint8_t* pRing, CopyList& copies)
+    {
+        for (const CopyList::Copy& copy : copies) {
+            std::memcpy(copy.pDest->data() + copy.destOffset, pRing + copy.srcOffset, copy.size);
+        }
+        copies.clear();
+    }
+}
+
+// Load time for 10k small buffers: the old path's per-buffer staging resource (stood in for by a fresh
+// 64 KB-aligned system allocation, mapped, written and released) against bump allocating from the upload ring
+// and coalescing the copies. The ring path's results are checked by replaying its copies into simulated heaps.
+BENCH(Upload_TenThousandSmallBuffers)
+{
+    const uint32_t bufferCount = 10000;
+    const uint32_t repeatCount = test::isQuickRun() ? 1 : 10;
+
+    std::vector<uint32_t> sizes(bufferCount);
+    uint64_t totalBytes = 0;
+    for (uint32_t i = 0; i < bufferCount; i++) {
+        sizes[i] = 64 + (i * 7919u) % 4032u;
+        totalBytes += sizes[i];
+    }
+    std::vector<uint8_t> source(4096);
+    for (size_t i = 0; i < source.size(); i++) {
+        source[i] = uint8_t(i * 31 + 7);
+    }
+
+    double perBufferMs = 0.0;
+    for (uint32_t repeat = 0; repeat < repeatCount; repeat++) {
+        const test::Timer timer;
+        for (uint32_t i = 0; i < bufferCount; i++) {
+            const size_t stagingSize = size_t((sizes[i] + COMMITTED_RESOURCE_ALIGNMENT - 1) & ~(COMMITTED_RESOURCE_ALIGNMENT - 1));
+            void* pStaging = ::operator new(stagingSize, std::align_val_t{ COMMITTED_RESOURCE_ALIGNMENT });
+            std::memcpy(pStaging, source.data(), sizes[i]);
+            test::doNotOptimize(pStaging);
+            ::operator delete(pStaging, std::align_val_t{ COMMITTED_RESOURCE_ALIGNMENT });
+        }
+        perBufferMs += timer.getElapsedMs();
+    }
+
+    // Persistently mapped, like the real ring
+    std::vector<uint8_t> ring(UPLOAD_RING_SIZE);
+    double ringMs = 0.0;
+    size_t copyCount = 0;
+    bool isIntact = true;
+    for (uint32_t repeat = 0; repeat < repeatCount; repeat++) {
+        BufferSuballocator heapAllocator;
+        std::vector<std::vector<uint8_t>> heaps;
+        std::vector<BufferSuballocator::Allocation> allocations(bufferCount);
+        UploadRing uploadRing{ UPLOAD_RING_SIZE };
+        CopyList copies{ UPLOAD_ALIGNMENT };
+
+        const test::Timer timer;
+        for (uint32_t i = 0; i < bufferCount; i++) {
+            bool createdHeap = false;
+            allocations[i] = heapAllocator.allocate(sizes[i], 0, &createdHeap);
+            if (createdHeap) {
+                heaps.emplace_back(heapAllocator.getHeapSize(allocations[i].heapIndex));
+            }
+
+            const uint64_t srcOffset = uploadRing.allocate(sizes[i], UPLOAD_ALIGNMENT);
+            CHECK(srcOffset != UploadRing::INVALID_OFFSET);
+            std::memcpy(ring.data() + srcOffset, source.data(), sizes[i]);
+
+            // Whole buffers, so neighbours in both the ring and the heap become one copy
+            copies.add(&heaps[allocations[i].heapIndex], allocations[i].range.offset, srcOffset, sizes[i], true);
+        }
+        uploadRing.submit(1);
+        ringMs += timer.getElapsedMs();
+
+        copyCount = copies.size();
+        executeCopies(ring.data(), copies);
+        for (uint32_t i = 0; i < bufferCount; i++) {
+            const uint8_t* pData = heaps[allocations[i].heapIndex].data() + allocations[i].range.offset;
+            isIntact &= std::memcmp(pData, source.data(), sizes[i]) == 0;
+        }
+    }
+    CHECK(isIntact);
+    CHECK(copyCount < bufferCount);
+
+    std::printf("  %u buffers, %.1f MB\n", bufferCount, double(totalBytes) / (1024.0 * 1024.0));
+    std::printf("  per-buffer staging: %8.2f ms, %u copies\n", perBufferMs / repeatCount, bufferCount);
+    std::printf("  upload ring:        %8.2f ms, %zu copies\n", ringMs / repeatCount, copyCount);
+}
@@ -0,0 +1,140 @@
+#include "TestHarness.h"
+#include <deque>
+
+#include "UploadRing.h"
+
+using namespace bdr;
+
+namespace
+{
+    struct LiveRange
+    {
+        uint64_t fenceValue;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    bool overlaps(const LiveRange& a, const uint64_t offset, const uint64_t size)
+    {
+        return offset < a.offset + a.size && a.offset < offset + size;
+    }
+}
+
+TEST(UploadRing_EmptyRingFitsFullCapacity)
+{
+    UploadRing ring{ 1024 };
+
+    // Leave the head mid-buffer, then let everything complete
+    CHECK_EQ(ring.allocate(100, 256), 0u);
+    ring.submit(1);
+    ring.reclaim([](uint64_t) { return true; });
+    CHECK(!ring.hasPendingSubmissions());
+    CHECK_EQ(ring.getUsedSize(), 0u);
+
+    // Without restarting at a capacity boundary this would never fit, however long the caller waited
+    CHECK_EQ(ring.allocate(1024, 256), 0u);
+    ring.submit(2);
+    ring.reclaim([](uint64_t) { return true; });
+
+    CHECK_EQ(ring.allocate(100, 256), 0u);
+    ring.submit(3);
+    ring.reclaim([](uint64_t) { return true; });
+    CHECK_EQ(ring.allocate(768, 256), 0u);
+}
+
+TEST(UploadRing_WrapSkipsTheTail)
+{
+    UploadRing ring{ 1024 };
+
+    CHECK_EQ(ring.allocate(512, 256), 0u);
+    CHECK_EQ(ring.allocate(256, 256), 512u);
+    ring.submit(1);
+    CHECK_EQ(ring.allocate(256, 256), 768u);
+    ring.submit(2);
+
+    // The first submission is done, the second isn't: [0, 768) is free again but [768, 1024) isn't
+    ring.reclaim([](const uint64_t fenceValue) { return fenceValue <= 1; });
+    CHECK_EQ(ring.allocate(512, 256), 0u);
+    CHECK_EQ(ring.allocate(256, 256), 512u);
+    CHECK_EQ(ring.allocate(256, 256), UploadRing::INVALID_OFFSET);
+    CHECK_EQ(ring.getOldestPendingFence(), 2u);
+}
+
+TEST(UploadRing_EmptySubmitIsDropped)
+{
+    UploadRing ring{ 1024 };
+    ring.submit(1);
+    CHECK(!ring.hasPendingSubmissions());
+
+    ring.allocate(64, 64);
+    ring.submit(2);
+    ring.submit(3);
+    CHECK(ring.hasPendingSubmissions());
+    CHECK_EQ(ring.getOldestPendingFence(), 2u);
+    ring.reclaim([](const uint64_t fenceValue) { return fenceValue <= 2; });
+    CHECK(!ring.hasPendingSubmissions());
+}
+
+// Drives the ring the way GPUBufferManager::allocateUploadSpace does, with requests up to the full capacity,
+// and checks that no allocation ever lands on bytes an unfinished submission still owns
+TEST(UploadRing_StressNeverOverwritesPendingData)
+{
+    const uint64_t capacity = 64 * 1024;
+    const uint64_t alignment = 256;
+    UploadRing ring{ capacity };
+
+    std::deque<LiveRange> live;
+    std::vector<LiveRange> unsubmitted;
+    uint64_t nextFence = 1;
+    uint64_t completedFence = 0;
+    uint32_t seed = 12345;
+    bool isValid = true;
+
+    for (uint32_t i = 0; i < 20000; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        // Mostly small uploads with the occasional one of up to the whole ring
+        const uint64_t size = (seed >> 8) % 64 == 0 ? 1 + (seed >> 4) % capacity : 1 + (seed >> 4) % 3000;
+
+        uint64_t offset = ring.allocate(size, alignment);
+        while (offset == UploadRing::INVALID_OFFSET) {
+            if (ring.hasUnsubmittedAllocations()) {
+                for (LiveRange& range : unsubmitted) {
+                    range.fenceValue = nextFence;
+                    live.push_back(range);
+                }
+                unsubmitted.clear();
+                ring.submit(nextFence++);
+            }
+            CHECK(ring.hasPendingSubmissions());
+            if (!ring.hasPendingSubmissions()) {
+                return;
+            }
+            completedFence = ring.getOldestPendingFence();
+            ring.reclaim([&](const uint64_t fenceValue) { return fenceValue <= completedFence; });
+            while (!live.empty() && live.front().fenceValue <= completedFence) {
+                live.pop_front();
+            }
+            offset = ring.allocate(size, alignment);
+        }
+
+        isValid &= offset % alignment == 0 && offset + size <= capacity;
+        for (const LiveRange& range : live) {
+            isValid &= !overlaps(range, offset, size);
+        }
+        for (const LiveRange& range : unsubmitted) {
+            isValid &= !overlaps(range, offset, size);
+        }
+        isValid &= ring.getUsedSize() <= capacity;
+        unsubmitted.push_back(LiveRange{ 0, offset, size });
+
+        if (i % 7 == 0) {
+            for (LiveRange& range : unsubmitted) {
+                range.fenceValue = nextFence;
+                live.push_back(range);
+            }
+            unsubmitted.clear();
+            ring.submit(nextFence++);
+        }
+    }
+    CHECK(isValid);
+}
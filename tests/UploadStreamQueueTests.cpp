@@ -0,0 +1,201 @@
+#include "TestHarness.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include "UploadStreamQueue.h"
+
+using namespace bdr;
+
+namespace
+{
+    struct Request
+    {
+        uint32_t producer;
+        uint32_t index;
+    };
+
+    using UploadStreamQueue = UploadStreamQueueT<Request>;
+
+    template <typename Predicate>
+    bool waitUntil(const Predicate& predicate)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!predicate()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+}
+
+// The background thread is held inside the first batch while more requests come in: they stay queued and
+// report NOT_SUBMITTED (as does the batch being recorded) until their own batch has gone out
+TEST(UploadStreamQueue_TicketsReportNotSubmittedWhileQueued)
+{
+    std::atomic<bool> isBatchEntered{ false };
+    std::atomic<bool> isReleased{ false };
+    std::atomic<uint32_t> emptyBatchCount{ 0 };
+    uint64_t nextFence = 100;
+
+    UploadStreamQueue queue;
+    queue.start([&](std::vector<Request>& batch) -> uint64_t {
+        isBatchEntered.store(true);
+        while (!isReleased.load()) {
+            std::this_thread::yield();
+        }
+        if (batch.empty()) {
+            emptyBatchCount.fetch_add(1);
+            return UploadStreamQueue::NOT_SUBMITTED;
+        }
+        return nextFence++;
+    });
+    CHECK(queue.isRunning());
+
+    const uint64_t first = queue.push(Request{ 0, 0 });
+    CHECK_EQ(first, 1u);
+    CHECK(waitUntil([&]() { return isBatchEntered.load(); }));
+    const uint64_t second = queue.push(Request{ 0, 1 });
+    const uint64_t third = queue.push(Request{ 0, 2 });
+    CHECK(second == 2 && third == 3);
+    CHECK_EQ(queue.getQueuedCount(), size_t(2));
+    CHECK_EQ(queue.getFence(first), UploadStreamQueue::NOT_SUBMITTED);
+    CHECK_EQ(queue.getFence(third), UploadStreamQueue::NOT_SUBMITTED);
+
+    isReleased.store(true);
+    queue.flush();
+    CHECK_EQ(queue.getQueuedCount(), size_t(0));
+    CHECK_EQ(queue.getFence(first), 100u);
+    CHECK_EQ(queue.getFence(second), 101u);
+    CHECK_EQ(queue.getFence(third), 101u);
+
+    // A wake with nothing queued still runs the callback, and doesn't make a batch of its own
+    queue.wake();
+    CHECK(waitUntil([&]() { return emptyBatchCount.load() == 1; }));
+    const uint64_t fourth = queue.push(Request{ 0, 3 });
+    queue.flush();
+    CHECK_EQ(queue.getFence(fourth), 102u);
+    CHECK_EQ(queue.getFence(third), 101u);
+
+    // Pruned tickets report the fence pruned up to, which covers them
+    queue.prune(101);
+    CHECK_EQ(queue.getFence(first), 101u);
+    CHECK_EQ(queue.getFence(third), 101u);
+    CHECK_EQ(queue.getFence(fourth), 102u);
+
+    // Stopping submits anything still queued
+    const uint64_t last = queue.push(Request{ 0, 4 });
+    queue.stop();
+    CHECK(!queue.isRunning());
+    CHECK_EQ(queue.getFence(last), 103u);
+}
+
+// Producers push concurrently and poll their own tickets while the queue is pruned behind them. A ticket may
+// read NOT_SUBMITTED until its batch goes out and from then on the batch's fence, or a later one once pruned;
+// never an earlier fence, and never a fence before the request was actually processed.
+TEST(UploadStreamQueue_TicketsMapToTheirBatchFence)
+{
+    const uint32_t producerCount = 4;
+    const uint32_t requestsPerProducer = 100000;
+
+    // Written on the background thread before the batch is marked submitted, so readable after getFence
+    std::vector<uint64_t> processedFences[producerCount];
+    std::vector<uint64_t> tickets[producerCount];
+    for (uint32_t p = 0; p < producerCount; p++) {
+        processedFences[p].assign(requestsPerProducer, UploadStreamQueue::NOT_SUBMITTED);
+        tickets[p].assign(requestsPerProducer, UploadStreamQueue::INVALID_TICKET);
+    }
+
+    std::atomic<uint64_t> lastFence{ 0 };
+    uint64_t batchCount = 0;
+    UploadStreamQueue queue;
+    queue.start([&](std::vector<Request>& batch) -> uint64_t {
+        if (batch.empty()) {
+            return UploadStreamQueue::NOT_SUBMITTED;
+        }
+        const uint64_t fenceValue = lastFence.load() + 1;
+        for (const Request& request : batch) {
+            processedFences[request.producer][request.index] = fenceValue;
+        }
+        batchCount++;
+        lastFence.store(fenceValue);
+        return fenceValue;
+    });
+
+    std::atomic<uint32_t> earlyCount{ 0 };
+    std::atomic<uint32_t> wrongFenceCount{ 0 };
+    std::atomic<uint32_t> unorderedTicketCount{ 0 };
+    std::atomic<uint32_t> finishedProducers{ 0 };
+    std::vector<std::thread> producers;
+    for (uint32_t p = 0; p < producerCount; p++) {
+        producers.emplace_back([&, p]() {
+            uint64_t previousTicket = UploadStreamQueue::INVALID_TICKET;
+            for (uint32_t i = 0; i < requestsPerProducer; i++) {
+                const uint64_t ticket = queue.push(Request{ p, i });
+                if (ticket <= previousTicket) {
+                    unorderedTicketCount.fetch_add(1);
+                }
+                previousTicket = ticket;
+                tickets[p][i] = ticket;
+
+                // Poll a recent ticket of this producer
+                const uint32_t polled = i - (i % 64);
+                const uint64_t fenceValue = queue.getFence(tickets[p][polled]);
+                if (fenceValue == UploadStreamQueue::NOT_SUBMITTED) {
+                    continue;
+                }
+                const uint64_t processedFence = processedFences[p][polled];
+                if (processedFence == UploadStreamQueue::NOT_SUBMITTED) {
+                    earlyCount.fetch_add(1);
+                }
+                else if (fenceValue < processedFence) {
+                    wrongFenceCount.fetch_add(1);
+                }
+            }
+            finishedProducers.fetch_add(1);
+        });
+    }
+
+    // Plays the GPU finishing batches a little behind the recording
+    std::thread pruner([&]() {
+        while (finishedProducers.load() < producerCount) {
+            const uint64_t submitted = lastFence.load();
+            if (submitted > 2) {
+                queue.prune(submitted - 2);
+            }
+            std::this_thread::yield();
+        }
+    });
+
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+    pruner.join();
+    queue.flush();
+    CHECK_EQ(earlyCount.load(), 0u);
+    CHECK_EQ(wrongFenceCount.load(), 0u);
+    CHECK_EQ(unorderedTicketCount.load(), 0u);
+    // Requests were actually batched
+    CHECK(batchCount < uint64_t(producerCount) * requestsPerProducer);
+
+    // Every ticket resolves to its batch's fence, or to a later one if its batch was pruned
+    bool isMapped = true;
+    for (uint32_t p = 0; p < producerCount; p++) {
+        for (uint32_t i = 0; i < requestsPerProducer; i++) {
+            const uint64_t fenceValue = queue.getFence(tickets[p][i]);
+            isMapped &= processedFences[p][i] != UploadStreamQueue::NOT_SUBMITTED && fenceValue >= processedFences[p][i];
+        }
+    }
+    CHECK(isMapped);
+
+    // With everything pruned, a new ticket still maps to its own batch
+    const uint64_t prunedFence = lastFence.load();
+    queue.prune(prunedFence);
+    const uint64_t ticket = queue.push(Request{ 0, 0 });
+    queue.flush();
+    CHECK_EQ(queue.getFence(ticket), prunedFence + 1);
+    queue.stop();
+}
@@ -0,0 +1,18 @@
+// Host stand-in for include/Utils.h, which pulls in stdafx.h and the Windows-only ASSERT family. It is found
+// first on the host build's include path, so src/Utils.cpp builds unchanged against it.
+
+#pragma once
+
+#include <cassert>
+#include <string>
+#include <xmmintrin.h>
+#include <emmintrin.h>
+
+#include "MathCommon.h"
+
+#define ASSERT( isTrue, ... ) assert(isTrue)
+
+void SIMDMemCopy(void* __restrict Dest, const void* __restrict Source, size_t NumQuadwords);
+void SIMDMemFill(void* __restrict Dest, __m128 FillVector, size_t NumQuadwords);
+
+std::wstring MakeWStr(const std::string& str);